@@ -7,6 +7,7 @@ CONFIG_SPECTRA_TFE := y
 CONFIG_SPECTRA_JPEG := y
 CONFIG_SPECTRA_CRE := y
 CONFIG_SPECTRA_SENSOR := y
+CONFIG_SPECTRA_KUNIT_TEST := y
 
 # Flags to pass into C preprocessor
 ccflags-y += -DCONFIG_SPECTRA_ISP=1
@@ -15,3 +16,4 @@ ccflags-y += -DCONFIG_SPECTRA_TFE=1
 ccflags-y += -DCONFIG_SPECTRA_JPEG=1
 ccflags-y += -DCONFIG_SPECTRA_CRE=1
 ccflags-y += -DCONFIG_SPECTRA_SENSOR=1
+ccflags-y += -DCONFIG_SPECTRA_KUNIT_TEST=1
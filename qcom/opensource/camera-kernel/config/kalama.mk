@@ -7,6 +7,7 @@ CONFIG_SPECTRA_JPEG := y
 CONFIG_SPECTRA_CUSTOM := y
 CONFIG_SPECTRA_SENSOR := y
 CONFIG_USE_RPMH_DRV_API := y
+CONFIG_SPECTRA_KUNIT_TEST := y
 
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 CONFIG_SPECTRA_OPLUS := y
@@ -20,6 +21,7 @@ ccflags-y += -DCONFIG_SPECTRA_JPEG=1
 ccflags-y += -DCONFIG_SPECTRA_CUSTOM=1
 ccflags-y += -DCONFIG_SPECTRA_SENSOR=1
 ccflags-y += -DCONFIG_USE_RPMH_DRV_API=1
+ccflags-y += -DCONFIG_SPECTRA_KUNIT_TEST=1
 
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 ccflags-y += -DCONFIG_SPECTRA_OPLUS=1
@@ -8,11 +8,13 @@
 #include <linux/kernel.h>
 #include <linux/errno.h>
 #include <linux/bug.h>
+#include <linux/string.h>
 
 #include "cam_cdm_intf_api.h"
 #include "cam_cdm_util.h"
 #include "cam_cdm.h"
 #include "cam_io_util.h"
+#include "cam_common_util.h"
 
 #define CAM_CDM_DWORD 4
 
@@ -25,6 +27,9 @@
 #define CAM_CDM_DMI_DATA_OFFSET      8
 #define CAM_CDM_DMI_DATA_LO_OFFSET   12
 
+/* Shortest register run worth a reg-continuous command */
+#define CAM_CDM_REG_CONT_MIN_RUN     4
+
 static unsigned int CDMCmdHeaderSizes[
 	CAM_CDM_CMD_PRIVATE_BASE + CAM_CDM_SW_CMD_COUNT] = {
 	0, /* UNUSED*/
@@ -441,6 +446,130 @@ uint32_t *cam_cdm_write_wait_prefetch_disable(
 	return pCmdBuffer;
 }
 
+void cam_cdm_util_reset_reg_dedup(struct cam_cdm_reg_dedup *dedup)
+{
+	memset(dedup->slots, 0xff, sizeof(dedup->slots));
+}
+CAM_EXPORT_FOR_KUNIT(cam_cdm_util_reset_reg_dedup);
+
+static inline struct cam_cdm_reg_dedup_slot *cam_cdm_util_dedup_slot(
+	struct cam_cdm_reg_dedup *dedup, uint32_t reg)
+{
+	return &dedup->slots[(reg >> 2) % CAM_CDM_REG_DEDUP_SLOTS];
+}
+
+static uint32_t cam_cdm_util_build_reg_pairs(uint32_t *pCmdBuffer,
+	uint32_t numRegVals, uint32_t *pRegVals,
+	struct cam_cdm_reg_dedup *dedup)
+{
+	struct cam_cdm_reg_dedup_slot *slot;
+	struct cdm_regrandom_cmd dry_hdr;
+	struct cdm_regrandom_cmd *rand_hdr = NULL;
+	struct cdm_regcontinuous_cmd *cont_hdr;
+	uint32_t i, k, run, reg, val;
+	uint32_t used = 0;
+
+	for (i = 0; i < numRegVals; i += run) {
+		reg = pRegVals[2 * i];
+
+		/*
+		 * Order of writes is preserved, only runs that are already
+		 * adjacent in the input are folded into a reg-continuous
+		 * command. Such a run is never larger than the same pairs
+		 * in a reg-random command.
+		 */
+		for (run = 1; (i + run < numRegVals) &&
+			(run < CAM_CMD_LENGTH_MASK) &&
+			(pRegVals[2 * (i + run)] == reg + (run * CAM_CDM_DWORD));
+			run++)
+			;
+
+		if (run >= CAM_CDM_REG_CONT_MIN_RUN) {
+			rand_hdr = NULL;
+			if (pCmdBuffer) {
+				cont_hdr = (struct cdm_regcontinuous_cmd *)
+					(pCmdBuffer + used);
+				cont_hdr->count = run;
+				cont_hdr->cmd = CAM_CDM_CMD_REG_CONT;
+				cont_hdr->reserved0 = 0;
+				cont_hdr->reserved1 = 0;
+				cont_hdr->offset = reg;
+			}
+			used += cam_cdm_get_cmd_header_size(
+				CAM_CDM_CMD_REG_CONT);
+
+			for (k = 0; k < run; k++) {
+				val = pRegVals[(2 * (i + k)) + 1];
+				if (pCmdBuffer)
+					pCmdBuffer[used] = val;
+				used++;
+
+				if (dedup) {
+					slot = cam_cdm_util_dedup_slot(dedup,
+						reg + (k * CAM_CDM_DWORD));
+					slot->reg = reg + (k * CAM_CDM_DWORD);
+					slot->val = val;
+				}
+			}
+			continue;
+		}
+
+		run = 1;
+		val = pRegVals[(2 * i) + 1];
+		if (dedup) {
+			slot = cam_cdm_util_dedup_slot(dedup, reg);
+			if ((slot->reg == reg) && (slot->val == val))
+				continue;
+
+			slot->reg = reg;
+			slot->val = val;
+		}
+
+		if (!rand_hdr || (rand_hdr->count == CAM_CMD_LENGTH_MASK)) {
+			/* Dry runs only track the count */
+			rand_hdr = pCmdBuffer ? (struct cdm_regrandom_cmd *)
+				(pCmdBuffer + used) : &dry_hdr;
+			if (pCmdBuffer) {
+				rand_hdr->cmd = CAM_CDM_CMD_REG_RANDOM;
+				rand_hdr->reserved = 0;
+			}
+			rand_hdr->count = 0;
+			used += cam_cdm_get_cmd_header_size(
+				CAM_CDM_CMD_REG_RANDOM);
+		}
+
+		if (pCmdBuffer) {
+			pCmdBuffer[used] = reg;
+			pCmdBuffer[used + 1] = val;
+		}
+		rand_hdr->count++;
+		used += 2;
+	}
+
+	return used;
+}
+
+uint32_t cam_cdm_required_size_reg_pairs(uint32_t numRegVals,
+	uint32_t *pRegVals, const struct cam_cdm_reg_dedup *dedup)
+{
+	struct cam_cdm_reg_dedup dry_dedup;
+
+	if (!dedup)
+		return cam_cdm_util_build_reg_pairs(NULL, numRegVals,
+			pRegVals, NULL);
+
+	/* Sizing must not record the writes, the real pass will */
+	dry_dedup = *dedup;
+	return cam_cdm_util_build_reg_pairs(NULL, numRegVals, pRegVals,
+		&dry_dedup);
+}
+
+uint32_t *cam_cdm_write_reg_pairs(uint32_t *pCmdBuffer, uint32_t numRegVals,
+	uint32_t *pRegVals, struct cam_cdm_reg_dedup *dedup)
+{
+	return pCmdBuffer + cam_cdm_util_build_reg_pairs(pCmdBuffer,
+		numRegVals, pRegVals, dedup);
+}
 
 struct cam_cdm_utils_ops CDM170_ops = {
 	.cdm_get_cmd_header_size              = cam_cdm_get_cmd_header_size,
@@ -454,6 +583,7 @@ struct cam_cdm_utils_ops CDM170_ops = {
 	.cdm_required_size_comp_wait          = cam_cdm_required_size_comp_wait,
 	.cdm_required_size_clear_comp_event   = cam_cdm_required_size_clear_comp_event,
 	.cdm_required_size_prefetch_disable   = cam_cdm_required_size_prefetch_disable,
+	.cdm_required_size_reg_pairs          = cam_cdm_required_size_reg_pairs,
 	.cdm_offsetof_dmi_addr                = cam_cdm_offsetof_dmi_addr,
 	.cdm_offsetof_indirect_addr           = cam_cdm_offsetof_indirect_addr,
 	.cdm_write_dmi                        = cam_cdm_write_dmi,
@@ -466,6 +596,7 @@ struct cam_cdm_utils_ops CDM170_ops = {
 	.cdm_write_wait_comp_event            = cam_cdm_write_wait_comp_event,
 	.cdm_write_clear_comp_event           = cam_cdm_write_clear_comp_event,
 	.cdm_write_wait_prefetch_disable      = cam_cdm_write_wait_prefetch_disable,
+	.cdm_write_reg_pairs                  = cam_cdm_write_reg_pairs,
 };
 
 int cam_cdm_get_ioremap_from_base(uint32_t hw_base,
@@ -697,6 +828,7 @@ int cam_cdm_util_cmd_buf_write(void __iomem **current_device_base,
 
 	return ret;
 }
+CAM_EXPORT_FOR_KUNIT(cam_cdm_util_cmd_buf_write);
 
 static long cam_cdm_util_dump_dmi_cmd(uint32_t *cmd_buf_addr,
 	uint32_t *cmd_buf_addr_end)
@@ -33,6 +33,33 @@ enum cam_cdm_command {
 	CAM_CDM_CMD_PRIVATE_BASE_MAX = 0x7F,
 };
 
+#define CAM_CDM_REG_DEDUP_SLOTS 32
+
+/**
+ * struct cam_cdm_reg_dedup_slot - Last value written to a register
+ * @reg: Register offset, U32_MAX if the slot is empty
+ * @val: Value last written to @reg
+ */
+struct cam_cdm_reg_dedup_slot {
+	uint32_t reg;
+	uint32_t val;
+};
+
+/**
+ * struct cam_cdm_reg_dedup - Register values written so far by the command
+ *                            buffers of one frame
+ *
+ * The owner resets it with cam_cdm_util_reset_reg_dedup() when it starts
+ * building a frame, and whenever the registers may have been written by
+ * anything else. Slots are direct mapped by register offset, so a
+ * collision only costs a redundant write.
+ *
+ * @slots: Last value per register slot
+ */
+struct cam_cdm_reg_dedup {
+	struct cam_cdm_reg_dedup_slot slots[CAM_CDM_REG_DEDUP_SLOTS];
+};
+
 /**
  * struct cam_cdm_utils_ops - Camera CDM util ops
  *
@@ -73,6 +100,16 @@ enum cam_cdm_command {
  *                                in dwords.
  *      @return Size in dwords
  *
+ * @cdm_required_size_reg_pairs: Calculates the exact size in dwords of the
+ *                               stream cdm_write_reg_pairs generates for
+ *                               the same pairs. Never larger than
+ *                               cdm_required_size_reg_random(numRegVals).
+ *      @numRegVals  Number of register/value pairs
+ *      @pRegVals    Array of register/value pairs
+ *      @dedup       Frame dedup state the write will use, or NULL. It is
+ *                   not updated.
+ *      @return Size in dwords
+ *
  * @cdm_offsetof_dmi_addr: Returns the offset of address field in the DMI
  *                         command header.
  *      @return Offset of addr field
@@ -98,6 +135,20 @@ enum cam_cdm_command {
  *                 arevalues, e.g., {reg1, val1, reg2, val2, ...}.
  *      @return Pointer in command buffer pointing past the written commands
  *
+ * @cdm_write_reg_pairs: Writes register/value pairs in their given order,
+ *                       folding runs of adjacent registers into
+ *                       reg-continuous commands and the rest into
+ *                       reg-random commands.
+ *      @pCmdBuffer: Pointer to command buffer
+ *      @numRegVals: Number of register/value pairs that will be written
+ *      @pRegVals: An array of register/value pairs, same layout as for
+ *                 cdm_write_regrandom.
+ *      @dedup: Per frame dedup state, or NULL to write every pair. Writes
+ *              that repeat a register's last value in the frame are
+ *              skipped and the state is updated with the new values.
+ *              Must not be used for registers with write side effects.
+ *      @return Pointer in command buffer pointing past the written commands
+ *
  * @cdm_write_dmi: Writes a DMI command into the command bufferM.
  *      @pCmdBuffer: Pointer to command buffer
  *      @dmiCmd: DMI command
@@ -146,6 +197,10 @@ uint32_t (*cdm_required_size_changebase)(void);
 uint32_t (*cdm_required_size_comp_wait)(void);
 uint32_t (*cdm_required_size_clear_comp_event)(void);
 uint32_t (*cdm_required_size_prefetch_disable)(void);
+uint32_t (*cdm_required_size_reg_pairs)(
+	uint32_t  numRegVals,
+	uint32_t *pRegVals,
+	const struct cam_cdm_reg_dedup *dedup);
 uint32_t (*cdm_offsetof_dmi_addr)(void);
 uint32_t (*cdm_offsetof_indirect_addr)(void);
 uint32_t *(*cdm_write_dmi)(
@@ -196,6 +251,11 @@ uint32_t *(*cdm_write_wait_prefetch_disable)(
 	uint32_t  id,
 	uint32_t  mask1,
 	uint32_t  mask2);
+uint32_t *(*cdm_write_reg_pairs)(
+	uint32_t *pCmdBuffer,
+	uint32_t  numRegVals,
+	uint32_t *pRegVals,
+	struct cam_cdm_reg_dedup *dedup);
 };
 
 /**
@@ -226,6 +286,16 @@ struct cam_cdm_cmd_dump_header {
 	uint32_t  word_size;
 };
 
+/**
+ * cam_cdm_util_reset_reg_dedup()
+ *
+ * @brief:  Forgets all register values recorded for dedup, called at the
+ *          start of each frame
+ *
+ * @dedup:  Dedup state to reset
+ */
+void cam_cdm_util_reset_reg_dedup(struct cam_cdm_reg_dedup *dedup);
+
 /**
  * cam_cdm_util_log_cmd_bufs()
  *
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/module.h>
+#include <linux/prandom.h>
+#include <linux/string.h>
+
+#include "cam_cdm_intf_api.h"
+#include "cam_cdm_util.h"
+#include "cam_cdm_virtual.h"
+
+#define CAM_CDM_TEST_NUM_REGS   1024
+#define CAM_CDM_TEST_MAX_PAIRS  256
+#define CAM_CDM_TEST_MAX_RUN    8
+
+struct cam_cdm_test_stream {
+	uint32_t pairs[2 * CAM_CDM_TEST_MAX_PAIRS];
+	uint32_t num_pairs;
+	uint32_t cmd[4 * CAM_CDM_TEST_MAX_PAIRS];
+	uint32_t regs[CAM_CDM_TEST_NUM_REGS];
+	uint32_t ref_regs[CAM_CDM_TEST_NUM_REGS];
+};
+
+static struct cam_cdm_test_stream *cam_cdm_test_stream_alloc(
+	struct kunit *test)
+{
+	struct cam_cdm_test_stream *s;
+
+	s = kunit_kzalloc(test, sizeof(*s), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, s);
+
+	return s;
+}
+
+/*
+ * Mix of adjacent runs, single writes and rewrites of earlier registers,
+ * in the proportions a WM or module update produces.
+ */
+static void cam_cdm_test_fill_pairs(struct cam_cdm_test_stream *s,
+	struct rnd_state *rnd)
+{
+	uint32_t run, reg, k, prev;
+
+	s->num_pairs = 0;
+	while (s->num_pairs < CAM_CDM_TEST_MAX_PAIRS) {
+		run = prandom_u32_state(rnd) % CAM_CDM_TEST_MAX_RUN + 1;
+		run = min(run, CAM_CDM_TEST_MAX_PAIRS - s->num_pairs);
+
+		if (s->num_pairs && !(prandom_u32_state(rnd) % 4)) {
+			/* Rewrite an earlier register, often with its value */
+			prev = prandom_u32_state(rnd) % s->num_pairs;
+			s->pairs[2 * s->num_pairs] = s->pairs[2 * prev];
+			s->pairs[2 * s->num_pairs + 1] =
+				(prandom_u32_state(rnd) % 2) ?
+				s->pairs[2 * prev + 1] :
+				prandom_u32_state(rnd);
+			s->num_pairs++;
+			continue;
+		}
+
+		reg = (prandom_u32_state(rnd) %
+			(CAM_CDM_TEST_NUM_REGS - run)) * sizeof(uint32_t);
+		for (k = 0; k < run; k++) {
+			s->pairs[2 * s->num_pairs] = reg + k * sizeof(uint32_t);
+			s->pairs[2 * s->num_pairs + 1] = prandom_u32_state(rnd);
+			s->num_pairs++;
+		}
+	}
+}
+
+/* Runs a command stream through the virtual CDM into a register file */
+static void cam_cdm_test_execute(struct kunit *test, uint32_t *cmd,
+	uint32_t dwords, uint32_t *regs)
+{
+	void __iomem *base = (void __iomem *)regs;
+
+	KUNIT_ASSERT_EQ(test, 0, cam_cdm_util_cmd_buf_write(&base, cmd,
+		dwords * sizeof(uint32_t), NULL, 0, 0));
+}
+
+static void cam_cdm_test_pairs_vs_regrandom(struct kunit *test)
+{
+	struct cam_cdm_utils_ops *ops = cam_cdm_publish_ops();
+	struct cam_cdm_test_stream *s = cam_cdm_test_stream_alloc(test);
+	struct rnd_state rnd;
+	uint32_t size, used, iter;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ops);
+	prandom_seed_state(&rnd, 34);
+
+	for (iter = 0; iter < 32; iter++) {
+		cam_cdm_test_fill_pairs(s, &rnd);
+		memset(s->regs, 0, sizeof(s->regs));
+		memset(s->ref_regs, 0, sizeof(s->ref_regs));
+
+		used = ops->cdm_write_regrandom(s->cmd, s->num_pairs,
+			s->pairs) - s->cmd;
+		KUNIT_EXPECT_EQ(test, used,
+			ops->cdm_required_size_reg_random(s->num_pairs));
+		cam_cdm_test_execute(test, s->cmd, used, s->ref_regs);
+
+		size = ops->cdm_required_size_reg_pairs(s->num_pairs,
+			s->pairs, NULL);
+		used = ops->cdm_write_reg_pairs(s->cmd, s->num_pairs,
+			s->pairs, NULL) - s->cmd;
+		KUNIT_EXPECT_EQ(test, size, used);
+		KUNIT_EXPECT_LE(test, used,
+			ops->cdm_required_size_reg_random(s->num_pairs));
+		cam_cdm_test_execute(test, s->cmd, used, s->regs);
+
+		KUNIT_EXPECT_EQ(test, 0,
+			memcmp(s->regs, s->ref_regs, sizeof(s->regs)));
+	}
+}
+
+static void cam_cdm_test_pairs_vs_regcontinuous(struct kunit *test)
+{
+	struct cam_cdm_utils_ops *ops = cam_cdm_publish_ops();
+	struct cam_cdm_test_stream *s = cam_cdm_test_stream_alloc(test);
+	uint32_t vals[16], ref[32];
+	uint32_t i, used, ref_used;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ops);
+
+	for (i = 0; i < ARRAY_SIZE(vals); i++) {
+		vals[i] = 0x1000 + i;
+		s->pairs[2 * i] = 0x200 + i * sizeof(uint32_t);
+		s->pairs[2 * i + 1] = vals[i];
+	}
+
+	/* A fully adjacent run is exactly one reg-continuous command */
+	ref_used = ops->cdm_write_regcontinuous(ref, 0x200, ARRAY_SIZE(vals),
+		vals) - ref;
+	used = ops->cdm_write_reg_pairs(s->cmd, ARRAY_SIZE(vals), s->pairs,
+		NULL) - s->cmd;
+	KUNIT_EXPECT_EQ(test, ref_used, used);
+	KUNIT_EXPECT_EQ(test, 0, memcmp(ref, s->cmd, used * sizeof(uint32_t)));
+
+	/* Below the minimum run the pairs stay reg-random */
+	ref_used = ops->cdm_write_regrandom(ref, 3, s->pairs) - ref;
+	used = ops->cdm_write_reg_pairs(s->cmd, 3, s->pairs, NULL) - s->cmd;
+	KUNIT_EXPECT_EQ(test, ref_used, used);
+	KUNIT_EXPECT_EQ(test, 0, memcmp(ref, s->cmd, used * sizeof(uint32_t)));
+}
+
+/* Several update calls build one frame, dedup spans all of them */
+static void cam_cdm_test_frame_dedup(struct kunit *test)
+{
+	struct cam_cdm_utils_ops *ops = cam_cdm_publish_ops();
+	struct cam_cdm_test_stream *s = cam_cdm_test_stream_alloc(test);
+	struct cam_cdm_reg_dedup *dedup;
+	uint32_t pairs[] = {
+		0x10, 1, 0x40, 2, 0x80, 3,
+	};
+	uint32_t size, used, plain;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ops);
+	dedup = kunit_kzalloc(test, sizeof(*dedup), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dedup);
+
+	cam_cdm_util_reset_reg_dedup(dedup);
+	plain = ops->cdm_required_size_reg_pairs(3, pairs, NULL);
+
+	/* First update of the frame writes everything */
+	size = ops->cdm_required_size_reg_pairs(3, pairs, dedup);
+	KUNIT_EXPECT_EQ(test, plain, size);
+	KUNIT_EXPECT_EQ(test, size,
+		ops->cdm_required_size_reg_pairs(3, pairs, dedup));
+	used = ops->cdm_write_reg_pairs(s->cmd, 3, pairs, dedup) - s->cmd;
+	KUNIT_EXPECT_EQ(test, size, used);
+	cam_cdm_test_execute(test, s->cmd, used, s->regs);
+
+	/* A later update in the same frame only writes what changed */
+	pairs[3] = 5;
+	size = ops->cdm_required_size_reg_pairs(3, pairs, dedup);
+	used = ops->cdm_write_reg_pairs(s->cmd, 3, pairs, dedup) - s->cmd;
+	KUNIT_EXPECT_EQ(test, size, used);
+	KUNIT_EXPECT_EQ(test, ops->cdm_required_size_reg_random(1), used);
+	cam_cdm_test_execute(test, s->cmd, used, s->regs);
+	KUNIT_EXPECT_EQ(test, 1U, s->regs[0x10 / 4]);
+	KUNIT_EXPECT_EQ(test, 5U, s->regs[0x40 / 4]);
+	KUNIT_EXPECT_EQ(test, 3U, s->regs[0x80 / 4]);
+
+	/* The next frame starts from scratch */
+	cam_cdm_util_reset_reg_dedup(dedup);
+	KUNIT_EXPECT_EQ(test, plain,
+		ops->cdm_required_size_reg_pairs(3, pairs, dedup));
+}
+
+/* With dedup the final register state still matches reg-random */
+static void cam_cdm_test_frame_dedup_random(struct kunit *test)
+{
+	struct cam_cdm_utils_ops *ops = cam_cdm_publish_ops();
+	struct cam_cdm_test_stream *s = cam_cdm_test_stream_alloc(test);
+	struct cam_cdm_reg_dedup *dedup;
+	struct rnd_state rnd;
+	uint32_t used, update, saved = 0, total = 0;
+
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ops);
+	dedup = kunit_kzalloc(test, sizeof(*dedup), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dedup);
+	prandom_seed_state(&rnd, 340);
+
+	cam_cdm_util_reset_reg_dedup(dedup);
+	for (update = 0; update < 8; update++) {
+		cam_cdm_test_fill_pairs(s, &rnd);
+
+		used = ops->cdm_write_regrandom(s->cmd, s->num_pairs,
+			s->pairs) - s->cmd;
+		cam_cdm_test_execute(test, s->cmd, used, s->ref_regs);
+		total += used;
+
+		used = ops->cdm_write_reg_pairs(s->cmd, s->num_pairs,
+			s->pairs, dedup) - s->cmd;
+		if (used)
+			cam_cdm_test_execute(test, s->cmd, used, s->regs);
+		saved += ops->cdm_required_size_reg_random(s->num_pairs) -
+			used;
+	}
+
+	KUNIT_EXPECT_EQ(test, 0,
+		memcmp(s->regs, s->ref_regs, sizeof(s->regs)));
+	kunit_info(test, "reg-pairs with frame dedup saved %u of %u dwords\n",
+		saved, total);
+}
+
+static struct kunit_case cam_cdm_util_test_cases[] = {
+	KUNIT_CASE(cam_cdm_test_pairs_vs_regrandom),
+	KUNIT_CASE(cam_cdm_test_pairs_vs_regcontinuous),
+	KUNIT_CASE(cam_cdm_test_frame_dedup),
+	KUNIT_CASE(cam_cdm_test_frame_dedup_random),
+	{}
+};
+
+static struct kunit_suite cam_cdm_util_test_suite = {
+	.name = "cam_cdm_util",
+	.test_cases = cam_cdm_util_test_cases,
+};
+
+kunit_test_suite(cam_cdm_util_test_suite);
+
+MODULE_DESCRIPTION("Camera CDM command builder KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -12,6 +12,8 @@
 #define HFI_CMD_Q_MINI_DUMP_SIZE_IN_BYTES      4096
 #define HFI_MSG_Q_MINI_DUMP_SIZE_IN_BYTES      4096
 
+struct hfi_q_hdr;
+
 /**
  * struct hfi_mem
  * @len: length of memory
@@ -86,6 +88,34 @@ struct hfi_mini_dump_info {
  */
 int hfi_write_cmd(void *cmd_ptr);
 
+/**
+ * hfi_write_cmd_batch() - function for batched hfi write
+ * @cmd_ptrs: array of pointers to command data, written in order
+ * @num_cmds: number of commands in @cmd_ptrs
+ *
+ * Either all commands are queued or none are. The write index is
+ * published and the interrupt raised once for the whole batch.
+ *
+ * Returns success(zero)/failure(non zero)
+ */
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds);
+
+/**
+ * hfi_queue_write_cmds() - copy commands into a host to FW queue
+ * @q: header of the queue
+ * @write_q: queue memory, q->qhdr_q_size words
+ * @cmd_ptrs: array of pointers to command data, written in order
+ * @num_cmds: number of commands in @cmd_ptrs
+ *
+ * Checks space for the whole batch against one sample of the read index
+ * and publishes the write index once. Callers serialize writers and raise
+ * the interrupt.
+ *
+ * Returns success(zero)/failure(non zero)
+ */
+int hfi_queue_write_cmds(struct hfi_q_hdr *q, uint32_t *write_q,
+	void **cmd_ptrs, uint32_t num_cmds);
+
 /**
  * hfi_read_message() - function for hfi read
  * @pmsg: buffer to place read message for hfi queue
@@ -23,6 +23,7 @@
 #include "cam_debug_util.h"
 #include "cam_compat.h"
 #include "cam_soc_util.h"
+#include "cam_common_util.h"
 
 #define HFI_VERSION_INFO_MAJOR_VAL  1
 #define HFI_VERSION_INFO_MINOR_VAL  1
@@ -172,20 +173,91 @@ void cam_hfi_queue_dump(bool dump_queue_data)
 		hfi_queue_dump(dwords, num_dwords);
 }
 
+int hfi_queue_write_cmds(struct hfi_q_hdr *q, uint32_t *write_q,
+	void **cmd_ptrs, uint32_t num_cmds)
+{
+	uint32_t size_in_words, total_words, empty_space, write_idx, read_idx;
+	uint32_t new_write_idx, temp, i;
+	uint32_t *write_ptr;
+
+	if (!cmd_ptrs || !num_cmds) {
+		CAM_ERR(CAM_HFI, "Invalid batch %pK num_cmds %u",
+			cmd_ptrs, num_cmds);
+		return -EINVAL;
+	}
+
+	total_words = 0;
+	for (i = 0; i < num_cmds; i++) {
+		if (!cmd_ptrs[i]) {
+			CAM_ERR(CAM_HFI, "command %u is null", i);
+			return -EINVAL;
+		}
+
+		size_in_words = (*(uint32_t *)cmd_ptrs[i]) >> BYTE_WORD_SHIFT;
+		if (!size_in_words || (size_in_words >= q->qhdr_q_size)) {
+			CAM_DBG(CAM_HFI, "failed: cmd %u size_in_words %u",
+				i, size_in_words);
+			return -EINVAL;
+		}
+		total_words += size_in_words;
+	}
+
+	/* Firmware only moves the read index, sample it once per batch */
+	read_idx = READ_ONCE(q->qhdr_read_idx);
+	write_idx = q->qhdr_write_idx;
+	empty_space = (write_idx >= read_idx) ?
+		(q->qhdr_q_size - (write_idx - read_idx)) :
+		(read_idx - write_idx);
+	if (empty_space <= total_words) {
+		CAM_ERR(CAM_HFI,
+			"failed: empty space %u, size_in_words %u num_cmds %u",
+			empty_space, total_words, num_cmds);
+		return -EIO;
+	}
+
+	for (i = 0; i < num_cmds; i++) {
+		size_in_words = (*(uint32_t *)cmd_ptrs[i]) >> BYTE_WORD_SHIFT;
+		new_write_idx = write_idx + size_in_words;
+		write_ptr = (uint32_t *)(write_q + write_idx);
+
+		if (new_write_idx < q->qhdr_q_size) {
+			memcpy(write_ptr, (uint8_t *)cmd_ptrs[i],
+				size_in_words << BYTE_WORD_SHIFT);
+		} else {
+			new_write_idx -= q->qhdr_q_size;
+			temp = (size_in_words - new_write_idx) <<
+				BYTE_WORD_SHIFT;
+			memcpy(write_ptr, (uint8_t *)cmd_ptrs[i], temp);
+			memcpy(write_q, (uint8_t *)cmd_ptrs[i] + temp,
+				new_write_idx << BYTE_WORD_SHIFT);
+		}
+		write_idx = new_write_idx;
+	}
+
+	/*
+	 * To make sure command data in a command queue before
+	 * updating write index
+	 */
+	wmb();
+
+	/* Publish the whole batch with a single index update */
+	q->qhdr_write_idx = write_idx;
+
+	return 0;
+}
+CAM_EXPORT_FOR_KUNIT(hfi_queue_write_cmds);
+
 #ifndef CONFIG_CAM_PRESIL
 int hfi_write_cmd(void *cmd_ptr)
 {
-	uint32_t size_in_words, empty_space, new_write_idx, read_idx, temp;
-	uint32_t *write_q, *write_ptr;
+	return hfi_write_cmd_batch(&cmd_ptr, 1);
+}
+
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds)
+{
 	struct hfi_qtbl *q_tbl;
-	struct hfi_q_hdr *q;
 	int rc = 0;
 
-	if (!cmd_ptr) {
-		CAM_ERR(CAM_HFI, "command is null");
-		return -EINVAL;
-	}
-
 	mutex_lock(&hfi_cmd_q_mutex);
 	if (!g_hfi) {
 		CAM_ERR(CAM_HFI, "HFI interface not setup");
@@ -202,49 +274,10 @@ int hfi_write_cmd(void *cmd_ptr)
 	}
 
 	q_tbl = (struct hfi_qtbl *)g_hfi->map.qtbl.kva;
-	q = &q_tbl->q_hdr[Q_CMD];
-
-	write_q = (uint32_t *)g_hfi->map.cmd_q.kva;
-
-	size_in_words = (*(uint32_t *)cmd_ptr) >> BYTE_WORD_SHIFT;
-	if (!size_in_words) {
-		CAM_DBG(CAM_HFI, "failed");
-		rc = -EINVAL;
+	rc = hfi_queue_write_cmds(&q_tbl->q_hdr[Q_CMD],
+		(uint32_t *)g_hfi->map.cmd_q.kva, cmd_ptrs, num_cmds);
+	if (rc)
 		goto err;
-	}
-
-	read_idx = q->qhdr_read_idx;
-	empty_space = (q->qhdr_write_idx >= read_idx) ?
-		(q->qhdr_q_size - (q->qhdr_write_idx - read_idx)) :
-		(read_idx - q->qhdr_write_idx);
-	if (empty_space <= size_in_words) {
-		CAM_ERR(CAM_HFI, "failed: empty space %u, size_in_words %u",
-			empty_space, size_in_words);
-		rc = -EIO;
-		goto err;
-	}
-
-	new_write_idx = q->qhdr_write_idx + size_in_words;
-	write_ptr = (uint32_t *)(write_q + q->qhdr_write_idx);
-
-	if (new_write_idx < q->qhdr_q_size) {
-		memcpy(write_ptr, (uint8_t *)cmd_ptr,
-			size_in_words << BYTE_WORD_SHIFT);
-	} else {
-		new_write_idx -= q->qhdr_q_size;
-		temp = (size_in_words - new_write_idx) << BYTE_WORD_SHIFT;
-		memcpy(write_ptr, (uint8_t *)cmd_ptr, temp);
-		memcpy(write_q, (uint8_t *)cmd_ptr + temp,
-			new_write_idx << BYTE_WORD_SHIFT);
-	}
-
-	/*
-	 * To make sure command data in a command queue before
-	 * updating write index
-	 */
-	wmb();
-
-	q->qhdr_write_idx = new_write_idx;
 
 	/*
 	 * Before raising interrupt make sure command data is ready for
@@ -1050,24 +1083,43 @@ static int cam_hfi_presil_set_init_request(void)
 }
 
 int hfi_write_cmd(void *cmd_ptr)
+{
+	return hfi_write_cmd_batch(&cmd_ptr, 1);
+}
+
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds)
 {
 	int presil_rc = CAM_PRESIL_BLOCKED;
 	int rc = 0;
+	uint32_t i;
 
-	if (!cmd_ptr) {
-		CAM_ERR(CAM_HFI, "command is null");
+	if (!cmd_ptrs || !num_cmds) {
+		CAM_ERR(CAM_HFI, "Invalid batch %pK num_cmds %u",
+			cmd_ptrs, num_cmds);
 		return -EINVAL;
 	}
 
-	mutex_lock(&hfi_cmd_q_mutex);
+	for (i = 0; i < num_cmds; i++) {
+		if (!cmd_ptrs[i]) {
+			CAM_ERR(CAM_HFI, "command %u is null", i);
+			return -EINVAL;
+		}
+	}
 
-	presil_rc = cam_presil_hfi_write_cmd(cmd_ptr, (*(uint32_t *)cmd_ptr),
-		CAM_PRESIL_CLIENT_ID_CAMERA);
+	mutex_lock(&hfi_cmd_q_mutex);
 
-	if ((presil_rc != CAM_PRESIL_SUCCESS) && (presil_rc != CAM_PRESIL_BLOCKED)) {
-		CAM_ERR(CAM_HFI, "failed presil rc %d", presil_rc);
-		rc = -EINVAL;
-	} else {
+	/* Presil host consumes commands one at a time */
+	for (i = 0; i < num_cmds; i++) {
+		presil_rc = cam_presil_hfi_write_cmd(cmd_ptrs[i],
+			(*(uint32_t *)cmd_ptrs[i]), CAM_PRESIL_CLIENT_ID_CAMERA);
+
+		if ((presil_rc != CAM_PRESIL_SUCCESS) &&
+			(presil_rc != CAM_PRESIL_BLOCKED)) {
+			CAM_ERR(CAM_HFI, "failed presil rc %d cmd %u",
+				presil_rc, i);
+			rc = -EINVAL;
+			break;
+		}
 		CAM_DBG(CAM_HFI, "presil rc %d", presil_rc);
 	}
 
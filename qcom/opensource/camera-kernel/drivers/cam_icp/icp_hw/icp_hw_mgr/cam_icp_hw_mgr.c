@@ -2089,6 +2089,49 @@ static int cam_icp_mgr_process_cmd(void *priv, void *data)
 	return rc;
 }
 
+static int cam_icp_mgr_process_cmd_batch(void *priv, void *data)
+{
+	struct cam_icp_hw_mgr *hw_mgr;
+	struct icp_cmd_batch *batch;
+	uint32_t i, num_cmds;
+	int rc;
+
+	if (!data || !priv) {
+		CAM_ERR(CAM_ICP, "Invalid params%pK %pK", data, priv);
+		return -EINVAL;
+	}
+
+	hw_mgr = priv;
+	batch = &hw_mgr->cmd_batch;
+
+	spin_lock_bh(&batch->lock);
+	num_cmds = batch->num_cmds;
+	memcpy(batch->write_cmds, batch->cmds, num_cmds * sizeof(void *));
+	batch->num_cmds = 0;
+	batch->task_queued = false;
+	spin_unlock_bh(&batch->lock);
+
+	if (!num_cmds)
+		return 0;
+
+	rc = hfi_write_cmd_batch(batch->write_cmds, num_cmds);
+	if (rc != -EIO || num_cmds == 1)
+		return rc;
+
+	/* No room for the whole batch, queue what fits in order */
+	CAM_WARN(CAM_ICP, "Writing %u batched commands one by one", num_cmds);
+	for (i = 0; i < num_cmds; i++) {
+		rc = hfi_write_cmd(batch->write_cmds[i]);
+		if (rc) {
+			CAM_ERR(CAM_ICP, "Dropped %u of %u batched commands",
+				num_cmds - i, num_cmds);
+			break;
+		}
+	}
+
+	return rc;
+}
+
 static int cam_icp_mgr_cleanup_ctx(struct cam_icp_hw_ctx_data *ctx_data)
 {
 	int i;
@@ -4649,37 +4692,69 @@ static int cam_icp_mgr_handle_config_err(
 	return 0;
 }
 
+/*
+ * Frames configured while an earlier batch still waits for the cmd workq
+ * join that batch, so one workq pass writes all of them with a single
+ * queue update and interrupt. An IO reconfig stays in front of its frame.
+ */
 static int cam_icp_mgr_enqueue_config(struct cam_icp_hw_mgr *hw_mgr,
-	struct cam_hw_config_args *config_args)
+	struct cam_hw_config_args *config_args,
+	struct hfi_cmd_ipebps_async *ioconfig_cmd)
 {
 	int rc = 0;
 	uint64_t request_id = 0;
+	uint32_t num_cmds;
 	struct crm_workq_task *task;
 	struct hfi_cmd_work_data *task_data;
-	struct hfi_cmd_ipebps_async *hfi_cmd;
 	struct cam_hw_update_entry *hw_update_entries;
 	struct icp_frame_info *frame_info = NULL;
+	struct icp_cmd_batch *batch = &hw_mgr->cmd_batch;
 
 	frame_info = (struct icp_frame_info *)config_args->priv;
 	request_id = frame_info->request_id;
 	hw_update_entries = config_args->hw_update_entries;
 	CAM_DBG(CAM_ICP, "req_id = %lld %pK", request_id, config_args->priv);
 
+	num_cmds = ioconfig_cmd ? 2 : 1;
+
+	spin_lock_bh(&batch->lock);
+	if (batch->num_cmds + num_cmds > ICP_WORKQ_CMD_BATCH_MAX) {
+		spin_unlock_bh(&batch->lock);
+		CAM_ERR(CAM_ICP, "cmd batch full, req_id %lld", request_id);
+		return -ENOMEM;
+	}
+
+	if (ioconfig_cmd)
+		batch->cmds[batch->num_cmds++] = ioconfig_cmd;
+	batch->cmds[batch->num_cmds++] = (void *)hw_update_entries->addr;
+
+	if (batch->task_queued)
+		goto end;
+
 	task = cam_req_mgr_workq_get_task(icp_hw_mgr.cmd_work);
 	if (!task) {
 		CAM_ERR(CAM_ICP, "no empty task");
-		return -ENOMEM;
+		rc = -ENOMEM;
+		goto undo;
 	}
 
 	task_data = (struct hfi_cmd_work_data *)task->payload;
-	task_data->data = (void *)hw_update_entries->addr;
-	hfi_cmd = (struct hfi_cmd_ipebps_async *)hw_update_entries->addr;
+	task_data->data = NULL;
 	task_data->request_id = request_id;
 	task_data->type = ICP_WORKQ_TASK_CMD_TYPE;
-	task->process_cb = cam_icp_mgr_process_cmd;
+	task->process_cb = cam_icp_mgr_process_cmd_batch;
 	rc = cam_req_mgr_workq_enqueue_task(task, &icp_hw_mgr,
 		CRM_TASK_PRIORITY_0);
+	if (rc)
+		goto undo;
+
+	batch->task_queued = true;
+	goto end;
 
+undo:
+	batch->num_cmds -= num_cmds;
+end:
+	spin_unlock_bh(&batch->lock);
 	return rc;
 }
 
@@ -4750,30 +4825,6 @@ static int cam_icp_mgr_send_config_io(struct cam_icp_hw_ctx_data *ctx_data,
 	return rc;
 }
 
-static int cam_icp_mgr_send_recfg_io(struct cam_icp_hw_ctx_data *ctx_data,
-	struct hfi_cmd_ipebps_async *ioconfig_cmd, uint64_t req_id)
-{
-	int rc = 0;
-	struct hfi_cmd_work_data *task_data;
-	struct crm_workq_task *task;
-
-	task = cam_req_mgr_workq_get_task(icp_hw_mgr.cmd_work);
-	if (!task)
-		return -ENOMEM;
-
-	task_data = (struct hfi_cmd_work_data *)task->payload;
-	task_data->data = (void *)ioconfig_cmd;
-	task_data->request_id = req_id;
-	task_data->type = ICP_WORKQ_TASK_CMD_TYPE;
-	task->process_cb = cam_icp_mgr_process_cmd;
-	rc = cam_req_mgr_workq_enqueue_task(task, &icp_hw_mgr,
-		CRM_TASK_PRIORITY_0);
-	if (rc)
-		return rc;
-
-	return rc;
-}
-
 static int cam_icp_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 {
 	int rc = 0;
@@ -4783,6 +4834,7 @@ static int cam_icp_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 	struct cam_hw_config_args *config_args = config_hw_args;
 	struct cam_icp_hw_ctx_data *ctx_data = NULL;
 	struct icp_frame_info *frame_info = NULL;
+	struct hfi_cmd_ipebps_async *ioconfig_cmd = NULL;
 
 	if (!hw_mgr || !config_args) {
 		CAM_ERR(CAM_ICP, "Invalid arguments %pK %pK",
@@ -4837,10 +4889,7 @@ static int cam_icp_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 
 	if (frame_info->io_config != 0) {
 		CAM_INFO(CAM_ICP, "Send recfg io");
-		rc = cam_icp_mgr_send_recfg_io(ctx_data,
-			&frame_info->hfi_cfg_io_cmd, req_id);
-		if (rc)
-			CAM_ERR(CAM_ICP, "Fail to send reconfig io cmd");
+		ioconfig_cmd = &frame_info->hfi_cfg_io_cmd;
 	}
 
 	if (req_id <= ctx_data->last_flush_req)
@@ -4850,7 +4899,7 @@ static int cam_icp_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 
 	cam_cpas_notify_event(ctx_data->ctx_id_string, req_id);
 
-	rc = cam_icp_mgr_enqueue_config(hw_mgr, config_args);
+	rc = cam_icp_mgr_enqueue_config(hw_mgr, config_args, ioconfig_cmd);
 	if (rc)
 		goto config_err;
 	CAM_DBG(CAM_REQ,
@@ -7083,6 +7132,7 @@ int cam_icp_hw_mgr_init(struct device_node *of_node, uint64_t *hw_mgr_hdl,
 	icp_hw_mgr.mini_dump_cb = mini_dump_cb;
 	mutex_init(&icp_hw_mgr.hw_mgr_mutex);
 	spin_lock_init(&icp_hw_mgr.hw_mgr_lock);
+	spin_lock_init(&icp_hw_mgr.cmd_batch.lock);
 
 	atomic_set(&icp_hw_mgr.frame_in_process, 0);
 	icp_hw_mgr.frame_in_process_ctx_id = -1;
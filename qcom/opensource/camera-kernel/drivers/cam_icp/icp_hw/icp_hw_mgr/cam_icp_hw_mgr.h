@@ -33,6 +33,7 @@
 #define ICP_WORKQ_NUM_TASK      100
 #define ICP_WORKQ_TASK_CMD_TYPE 1
 #define ICP_WORKQ_TASK_MSG_TYPE 2
+#define ICP_WORKQ_CMD_BATCH_MAX ICP_WORKQ_NUM_TASK
 
 #define ICP_PACKET_SIZE         0
 #define ICP_PACKET_TYPE         1
@@ -119,6 +120,22 @@ struct hfi_cmd_work_data {
 	int32_t request_id;
 };
 
+/**
+ * struct icp_cmd_batch
+ * @lock: Protects @cmds, @num_cmds and @task_queued
+ * @cmds: Frame commands waiting for the cmd workq, in submission order
+ * @num_cmds: Number of valid entries in @cmds
+ * @task_queued: A cmd workq task that will write @cmds is pending
+ * @write_cmds: Commands the cmd workq is writing, only used by the workq
+ */
+struct icp_cmd_batch {
+	spinlock_t lock;
+	void *cmds[ICP_WORKQ_CMD_BATCH_MAX];
+	uint32_t num_cmds;
+	bool task_queued;
+	void *write_cmds[ICP_WORKQ_CMD_BATCH_MAX];
+};
+
 /**
  * struct hfi_msg_work_data
  * @type: Task type
@@ -414,6 +431,7 @@ struct cam_icp_clk_info {
  *            re-downloaded for new camera session.
  * @frame_in_process: Counter for frames in process
  * @frame_in_process_ctx_id: Contxt id processing frame
+ * @cmd_batch: Frame commands written by the next cmd workq pass
  */
 struct cam_icp_hw_mgr {
 	struct mutex hw_mgr_mutex;
@@ -467,6 +485,7 @@ struct cam_icp_hw_mgr {
 	uint64_t icp_svs_clk;
 	atomic_t frame_in_process;
 	int frame_in_process_ctx_id;
+	struct icp_cmd_batch cmd_batch;
 };
 
 /**
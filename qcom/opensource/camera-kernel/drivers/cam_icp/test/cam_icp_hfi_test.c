@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+#include "hfi_intf.h"
+#include "hfi_reg.h"
+
+#define CAM_ICP_TEST_Q_WORDS     256
+#define CAM_ICP_TEST_MAX_CMDS    16
+#define CAM_ICP_TEST_BENCH_LOOPS 2000
+
+struct cam_icp_test_queue {
+	struct hfi_q_hdr hdr;
+	uint32_t words[CAM_ICP_TEST_Q_WORDS];
+	uint32_t cmds[CAM_ICP_TEST_MAX_CMDS][CAM_ICP_TEST_Q_WORDS];
+	void *cmd_ptrs[CAM_ICP_TEST_MAX_CMDS];
+};
+
+static struct cam_icp_test_queue *cam_icp_test_queue_alloc(struct kunit *test,
+	uint32_t write_idx)
+{
+	struct cam_icp_test_queue *tq;
+
+	tq = kunit_kzalloc(test, sizeof(*tq), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, tq);
+
+	tq->hdr.qhdr_q_size = CAM_ICP_TEST_Q_WORDS;
+	tq->hdr.qhdr_read_idx = write_idx;
+	tq->hdr.qhdr_write_idx = write_idx;
+
+	return tq;
+}
+
+/* Commands start with their size in bytes, like every HFI packet */
+static void cam_icp_test_fill_cmd(struct cam_icp_test_queue *tq, uint32_t i,
+	uint32_t words)
+{
+	uint32_t k;
+
+	tq->cmds[i][0] = words * sizeof(uint32_t);
+	for (k = 1; k < words; k++)
+		tq->cmds[i][k] = (i << 16) | k;
+	tq->cmd_ptrs[i] = tq->cmds[i];
+}
+
+static void cam_icp_test_expect_cmd(struct kunit *test,
+	struct cam_icp_test_queue *tq, uint32_t idx, uint32_t i)
+{
+	uint32_t k, words = tq->cmds[i][0] / sizeof(uint32_t);
+
+	for (k = 0; k < words; k++)
+		KUNIT_EXPECT_EQ(test, tq->cmds[i][k],
+			tq->words[(idx + k) % CAM_ICP_TEST_Q_WORDS]);
+}
+
+/* A batch leaves the queue exactly as the same commands written one by one */
+static void cam_icp_test_batch_matches_single(struct kunit *test)
+{
+	struct cam_icp_test_queue *batch = cam_icp_test_queue_alloc(test, 200);
+	struct cam_icp_test_queue *single = cam_icp_test_queue_alloc(test, 200);
+	uint32_t i, idx;
+
+	for (i = 0; i < 4; i++) {
+		cam_icp_test_fill_cmd(batch, i, 10 + 7 * i);
+		cam_icp_test_fill_cmd(single, i, 10 + 7 * i);
+	}
+
+	KUNIT_ASSERT_EQ(test, 0, hfi_queue_write_cmds(&batch->hdr,
+		batch->words, batch->cmd_ptrs, 4));
+	for (i = 0; i < 4; i++)
+		KUNIT_ASSERT_EQ(test, 0, hfi_queue_write_cmds(&single->hdr,
+			single->words, &single->cmd_ptrs[i], 1));
+
+	/* 200 + 82 words wraps past the end of the queue */
+	KUNIT_EXPECT_EQ(test, 26U, batch->hdr.qhdr_write_idx);
+	KUNIT_EXPECT_EQ(test, single->hdr.qhdr_write_idx,
+		batch->hdr.qhdr_write_idx);
+	KUNIT_EXPECT_EQ(test, 0,
+		memcmp(batch->words, single->words, sizeof(batch->words)));
+
+	for (i = 0, idx = 200; i < 4; i++) {
+		cam_icp_test_expect_cmd(test, batch, idx, i);
+		idx = (idx + 10 + 7 * i) % CAM_ICP_TEST_Q_WORDS;
+	}
+}
+
+/* Without room for all commands nothing is written */
+static void cam_icp_test_batch_all_or_nothing(struct kunit *test)
+{
+	struct cam_icp_test_queue *tq = cam_icp_test_queue_alloc(test, 0);
+	uint32_t i;
+
+	for (i = 0; i < 3; i++)
+		cam_icp_test_fill_cmd(tq, i, 100);
+
+	/* FW has not consumed anything, 300 words do not fit in 256 */
+	KUNIT_EXPECT_EQ(test, -EIO, hfi_queue_write_cmds(&tq->hdr, tq->words,
+		tq->cmd_ptrs, 3));
+	KUNIT_EXPECT_EQ(test, 0U, tq->hdr.qhdr_write_idx);
+	KUNIT_EXPECT_TRUE(test, !memchr_inv(tq->words, 0, sizeof(tq->words)));
+
+	/* The queue keeps one word free to tell full from empty */
+	cam_icp_test_fill_cmd(tq, 0, CAM_ICP_TEST_Q_WORDS - 56);
+	cam_icp_test_fill_cmd(tq, 1, 56);
+	KUNIT_EXPECT_EQ(test, -EIO, hfi_queue_write_cmds(&tq->hdr, tq->words,
+		tq->cmd_ptrs, 2));
+	cam_icp_test_fill_cmd(tq, 1, 55);
+	KUNIT_EXPECT_EQ(test, 0, hfi_queue_write_cmds(&tq->hdr, tq->words,
+		tq->cmd_ptrs, 2));
+	KUNIT_EXPECT_EQ(test, CAM_ICP_TEST_Q_WORDS - 1U,
+		tq->hdr.qhdr_write_idx);
+
+	/* Once FW reads, the space behind the read index is reused */
+	tq->hdr.qhdr_read_idx = 200;
+	cam_icp_test_fill_cmd(tq, 2, 100);
+	KUNIT_EXPECT_EQ(test, 0, hfi_queue_write_cmds(&tq->hdr, tq->words,
+		&tq->cmd_ptrs[2], 1));
+	cam_icp_test_expect_cmd(test, tq, CAM_ICP_TEST_Q_WORDS - 1, 2);
+}
+
+static void cam_icp_test_batch_invalid(struct kunit *test)
+{
+	struct cam_icp_test_queue *tq = cam_icp_test_queue_alloc(test, 0);
+
+	cam_icp_test_fill_cmd(tq, 0, 8);
+	tq->cmd_ptrs[1] = NULL;
+	KUNIT_EXPECT_EQ(test, -EINVAL, hfi_queue_write_cmds(&tq->hdr,
+		tq->words, tq->cmd_ptrs, 2));
+	KUNIT_EXPECT_EQ(test, -EINVAL, hfi_queue_write_cmds(&tq->hdr,
+		tq->words, tq->cmd_ptrs, 0));
+
+	tq->cmds[1][0] = 0;
+	tq->cmd_ptrs[1] = tq->cmds[1];
+	KUNIT_EXPECT_EQ(test, -EINVAL, hfi_queue_write_cmds(&tq->hdr,
+		tq->words, tq->cmd_ptrs, 2));
+
+	tq->cmds[1][0] = CAM_ICP_TEST_Q_WORDS * sizeof(uint32_t);
+	KUNIT_EXPECT_EQ(test, -EINVAL, hfi_queue_write_cmds(&tq->hdr,
+		tq->words, tq->cmd_ptrs, 2));
+	KUNIT_EXPECT_EQ(test, 0U, tq->hdr.qhdr_write_idx);
+}
+
+/*
+ * Host side cost of writing frame sized commands one call each versus one
+ * batch. The interrupt and HFI mutex that batching also saves per frame
+ * are not part of this measurement.
+ */
+static void cam_icp_test_batch_bench(struct kunit *test)
+{
+	struct cam_icp_test_queue *tq = cam_icp_test_queue_alloc(test, 0);
+	uint32_t n, i, loop;
+	u64 start, single_ns, batch_ns;
+
+	for (i = 0; i < CAM_ICP_TEST_MAX_CMDS; i++)
+		cam_icp_test_fill_cmd(tq, i, 14);
+
+	for (n = 1; n <= CAM_ICP_TEST_MAX_CMDS; n *= 2) {
+		start = ktime_get_ns();
+		for (loop = 0; loop < CAM_ICP_TEST_BENCH_LOOPS; loop++) {
+			for (i = 0; i < n; i++)
+				hfi_queue_write_cmds(&tq->hdr, tq->words,
+					&tq->cmd_ptrs[i], 1);
+			tq->hdr.qhdr_read_idx = tq->hdr.qhdr_write_idx;
+		}
+		single_ns = ktime_get_ns() - start;
+
+		start = ktime_get_ns();
+		for (loop = 0; loop < CAM_ICP_TEST_BENCH_LOOPS; loop++) {
+			KUNIT_ASSERT_EQ(test, 0, hfi_queue_write_cmds(&tq->hdr,
+				tq->words, tq->cmd_ptrs, n));
+			tq->hdr.qhdr_read_idx = tq->hdr.qhdr_write_idx;
+		}
+		batch_ns = ktime_get_ns() - start;
+
+		kunit_info(test, "%2u cmds: single %llu ns, batch %llu ns per pass\n",
+			n, div_u64(single_ns, CAM_ICP_TEST_BENCH_LOOPS),
+			div_u64(batch_ns, CAM_ICP_TEST_BENCH_LOOPS));
+	}
+}
+
+static struct kunit_case cam_icp_hfi_test_cases[] = {
+	KUNIT_CASE(cam_icp_test_batch_matches_single),
+	KUNIT_CASE(cam_icp_test_batch_all_or_nothing),
+	KUNIT_CASE(cam_icp_test_batch_invalid),
+	KUNIT_CASE(cam_icp_test_batch_bench),
+	{}
+};
+
+static struct kunit_suite cam_icp_hfi_test_suite = {
+	.name = "cam_icp_hfi",
+	.test_cases = cam_icp_hfi_test_cases,
+};
+
+kunit_test_suite(cam_icp_hfi_test_suite);
+
+MODULE_DESCRIPTION("Camera ICP HFI command queue KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -3680,8 +3680,9 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 
 	num_regval_pairs = j / 2;
 	if (num_regval_pairs) {
-		size = cdm_util_ops->cdm_required_size_reg_random(
-			num_regval_pairs);
+		/* Adjacent WM registers go out as reg-continuous runs */
+		size = cdm_util_ops->cdm_required_size_reg_pairs(
+			num_regval_pairs, reg_val_pair, NULL);
 
 		/* cdm util returns dwords, need to convert to bytes */
 		if ((size * 4) > update_buf->cmd.size) {
@@ -3691,9 +3692,9 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 			return -ENOMEM;
 		}
 
-		cdm_util_ops->cdm_write_regrandom(
+		cdm_util_ops->cdm_write_reg_pairs(
 			update_buf->cmd.cmd_buf_addr,
-			num_regval_pairs, reg_val_pair);
+			num_regval_pairs, reg_val_pair, NULL);
 
 		/* cdm util returns dwords, need to convert to bytes */
 		update_buf->cmd.used_bytes = size * 4;
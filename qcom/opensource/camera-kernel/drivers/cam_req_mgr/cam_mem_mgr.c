@@ -11,6 +11,7 @@
 #include <linux/dma-buf.h>
 #include <linux/version.h>
 #include <linux/debugfs.h>
+#include <linux/percpu.h>
 #if IS_REACHABLE(CONFIG_DMABUF_HEAPS)
 #include <linux/mem-buf.h>
 #include <soc/qcom/secure_buffer.h>
@@ -31,6 +32,9 @@
 static struct cam_mem_table tbl;
 static atomic_t cam_mem_mgr_state = ATOMIC_INIT(CAM_MEM_MGR_UNINITIALIZED);
 
+/* Per CPU index where the next free slot search starts */
+static DEFINE_PER_CPU(int32_t, cam_mem_slot_hint);
+
 /* cam_mem_mgr_debug - global struct to keep track of debug settings for mem mgr
  *
  * @dentry                  : Directory entry to the mem mgr root folder
@@ -243,6 +247,7 @@ int cam_mem_mgr_init(void)
 	for (i = 1; i < CAM_MEM_BUFQ_MAX; i++) {
 		tbl.bufq[i].fd = -1;
 		tbl.bufq[i].buf_handle = -1;
+		mutex_init(&tbl.bufq[i].q_lock);
 		cam_mem_mgr_reset_presil_params(i);
 	}
 	mutex_init(&tbl.m_lock);
@@ -261,23 +266,61 @@ put_heaps:
 	return rc;
 }
 
-static int32_t cam_mem_get_slot(void)
+/*
+ * Claim the first free slot at or after start, wrapping around to slot 1
+ * once; slot 0 is never handed out. The caller owns the slot once
+ * test_and_set_bit() succeeds on it, so concurrent callers need no lock.
+ */
+int32_t cam_mem_claim_slot(unsigned long *bitmap, int32_t nbits,
+	int32_t start)
 {
 	int32_t idx;
+	bool wrapped = false;
+
+	if (start <= 0 || start >= nbits)
+		start = 1;
+
+	idx = start;
+	for (;;) {
+		idx = find_next_zero_bit(bitmap, nbits, idx);
+		if (idx >= nbits) {
+			if (wrapped)
+				return -ENOMEM;
+			wrapped = true;
+			idx = 1;
+			continue;
+		}
 
-	mutex_lock(&tbl.m_lock);
-	idx = find_first_zero_bit(tbl.bitmap, tbl.bits);
-	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0) {
-		mutex_unlock(&tbl.m_lock);
-		return -ENOMEM;
+		if (wrapped && idx >= start)
+			return -ENOMEM;
+
+		if (!test_and_set_bit(idx, bitmap))
+			return idx;
+
+		idx++;
 	}
+}
+CAM_EXPORT_FOR_KUNIT(cam_mem_claim_slot);
+
+/*
+ * The free slot search starts at a per CPU hint so that concurrent
+ * allocations spread over the bitmap. Slot locks live as long as the
+ * table, so lookups racing with a claim always find a valid q_lock.
+ */
+static int32_t cam_mem_get_slot(void)
+{
+	int32_t idx;
+
+	idx = cam_mem_claim_slot(tbl.bitmap, CAM_MEM_BUFQ_MAX,
+		this_cpu_read(cam_mem_slot_hint));
+	if (idx < 0)
+		return idx;
+
+	this_cpu_write(cam_mem_slot_hint, idx + 1);
 
-	set_bit(idx, tbl.bitmap);
 	tbl.bufq[idx].active = true;
 	tbl.bufq[idx].release_deferred = false;
 	CAM_GET_TIMESTAMP((tbl.bufq[idx].timestamp));
-	mutex_init(&tbl.bufq[idx].q_lock);
-	mutex_unlock(&tbl.m_lock);
 
 	return idx;
 }
@@ -293,8 +336,7 @@ static void cam_mem_put_slot(int32_t idx)
 	kref_init(&tbl.bufq[idx].krefcount);
 	kref_init(&tbl.bufq[idx].urefcount);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
-	mutex_destroy(&tbl.bufq[idx].q_lock);
-	clear_bit(idx, tbl.bitmap);
+	clear_bit_unlock(idx, tbl.bitmap);
 	mutex_unlock(&tbl.m_lock);
 }
 
@@ -1492,7 +1534,6 @@ static int cam_mem_mgr_cleanup_table(void)
 		kref_init(&tbl.bufq[i].krefcount);
 		kref_init(&tbl.bufq[i].urefcount);
 		mutex_unlock(&tbl.bufq[i].q_lock);
-		mutex_destroy(&tbl.bufq[i].q_lock);
 	}
 
 	bitmap_zero(tbl.bitmap, tbl.bits);
@@ -1505,11 +1546,15 @@ static int cam_mem_mgr_cleanup_table(void)
 
 void cam_mem_mgr_deinit(void)
 {
+	int i;
+
 	if (!atomic_read(&cam_mem_mgr_state))
 		return;
 
 	atomic_set(&cam_mem_mgr_state, CAM_MEM_MGR_UNINITIALIZED);
 	cam_mem_mgr_cleanup_table();
+	for (i = 1; i < CAM_MEM_BUFQ_MAX; i++)
+		mutex_destroy(&tbl.bufq[i].q_lock);
 	mutex_lock(&tbl.m_lock);
 	bitmap_zero(tbl.bitmap, tbl.bits);
 	kfree(tbl.bitmap);
@@ -1611,8 +1656,7 @@ static void cam_mem_util_unmap(int32_t idx)
 	memset(&tbl.bufq[idx].krefcount, 0, sizeof(struct kref));
 	memset(&tbl.bufq[idx].urefcount, 0, sizeof(struct kref));
 	mutex_unlock(&tbl.bufq[idx].q_lock);
-	mutex_destroy(&tbl.bufq[idx].q_lock);
-	clear_bit(idx, tbl.bitmap);
+	clear_bit_unlock(idx, tbl.bitmap);
 	mutex_unlock(&tbl.m_lock);
 
 }
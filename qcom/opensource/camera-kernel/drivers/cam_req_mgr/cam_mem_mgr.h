@@ -93,7 +93,8 @@ struct cam_mem_buf_queue {
 /**
  * struct cam_mem_table
  *
- * @m_lock: mutex lock for table
+ * @m_lock: mutex lock for table, serialises slot release against lookups
+ *          that test the bitmap; slot claims are lock free
  * @bitmap: bitmap of the mem mgr utility
  * @bits: max bits of the utility
  * @bufq: array of buffers
@@ -212,6 +213,18 @@ int cam_mem_mgr_init(void);
  */
 void cam_mem_mgr_deinit(void);
 
+/**
+ * @brief: Claims a free slot in a buffer table bitmap without locking
+ *
+ * @bitmap: Slot bitmap, bit 0 is reserved
+ * @nbits:  Number of slots in the bitmap
+ * @start:  Slot to start the search from, the search wraps around once
+ *
+ * @return Claimed slot index, -ENOMEM if every slot is taken
+ */
+int32_t cam_mem_claim_slot(unsigned long *bitmap, int32_t nbits,
+	int32_t start);
+
 #ifdef CONFIG_CAM_PRESIL
 /**
  * @brief: Put dma-buf for input dmabuf
@@ -4643,10 +4643,31 @@ static void cam_req_mgr_process_workq_link_worker(struct work_struct *w)
 	cam_req_mgr_process_workq(w);
 }
 
+static int __cam_req_mgr_create_link_workq(struct cam_req_mgr_core_link *link,
+	char *name)
+{
+	int rc, wq_flag;
+
+	wq_flag = CAM_WORKQ_FLAG_HIGH_PRIORITY | CAM_WORKQ_FLAG_SERIAL;
+	if (g_crm_core_dev->link_rt_workq)
+		wq_flag |= CAM_WORKQ_FLAG_RT_THREAD;
+
+	rc = cam_req_mgr_workq_create(name, CRM_WORKQ_NUM_TASKS,
+		&link->workq, CRM_WORKQ_USAGE_NON_IRQ, wq_flag,
+		cam_req_mgr_process_workq_link_worker);
+	if (rc)
+		return rc;
+
+	if (g_crm_core_dev->link_rt_workq && g_crm_core_dev->link_rt_cpu_mask)
+		cam_req_mgr_workq_set_cpu_affinity(link->workq,
+			g_crm_core_dev->link_rt_cpu_mask);
+
+	return 0;
+}
+
 int cam_req_mgr_link(struct cam_req_mgr_ver_info *link_info)
 {
 	int                                     rc = 0;
-	int                                     wq_flag = 0;
 	char                                    buf[128];
 	struct cam_create_dev_hdl               root_dev = {0};
 	struct cam_req_mgr_core_session        *cam_session;
@@ -4725,10 +4746,7 @@ int cam_req_mgr_link(struct cam_req_mgr_ver_info *link_info)
 	snprintf(buf, sizeof(buf), "CRMCORE_%x-%x",
 		link_info->u.link_info_v1.session_hdl, link->link_hdl);
 #endif
-	wq_flag = CAM_WORKQ_FLAG_HIGH_PRIORITY | CAM_WORKQ_FLAG_SERIAL;
-	rc = cam_req_mgr_workq_create(buf, CRM_WORKQ_NUM_TASKS,
-		&link->workq, CRM_WORKQ_USAGE_NON_IRQ, wq_flag,
-		cam_req_mgr_process_workq_link_worker);
+	rc = __cam_req_mgr_create_link_workq(link, buf);
 	if (rc < 0) {
 		CAM_ERR(CAM_CRM, "FATAL: unable to create worker");
 		__cam_req_mgr_destroy_link_info(link);
@@ -4761,7 +4779,6 @@ link_hdl_fail:
 int cam_req_mgr_link_v2(struct cam_req_mgr_ver_info *link_info)
 {
 	int                                     rc = 0;
-	int                                     wq_flag = 0;
 	char                                    buf[128];
 	struct cam_create_dev_hdl               root_dev = {0};
 	struct cam_req_mgr_core_session        *cam_session;
@@ -4841,10 +4858,7 @@ int cam_req_mgr_link_v2(struct cam_req_mgr_ver_info *link_info)
 	snprintf(buf, sizeof(buf), "CRMCORE_%x-%x",
 		link_info->u.link_info_v2.session_hdl, link->link_hdl);
 #endif
-	wq_flag = CAM_WORKQ_FLAG_HIGH_PRIORITY | CAM_WORKQ_FLAG_SERIAL;
-	rc = cam_req_mgr_workq_create(buf, CRM_WORKQ_NUM_TASKS,
-		&link->workq, CRM_WORKQ_USAGE_NON_IRQ, wq_flag,
-		cam_req_mgr_process_workq_link_worker);
+	rc = __cam_req_mgr_create_link_workq(link, buf);
 	if (rc < 0) {
 		CAM_ERR(CAM_CRM, "FATAL: unable to create worker");
 		__cam_req_mgr_destroy_link_info(link);
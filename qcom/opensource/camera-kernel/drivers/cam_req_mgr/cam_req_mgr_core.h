@@ -509,11 +509,16 @@ struct cam_req_mgr_core_session {
  * @session_head : list head holding sessions
  * @crm_lock     : mutex lock to protect session creation & destruction
  * @recovery_on_apply_fail : Recovery on apply failure using debugfs.
+ * @link_rt_workq : Process link tasks on a dedicated RT thread, set
+ *                  using debugfs and applied to links created afterwards
+ * @link_rt_cpu_mask : CPUs the link RT thread may run on, 0 for all
  */
 struct cam_req_mgr_core_device {
 	struct list_head             session_head;
 	struct mutex                 crm_lock;
 	bool                         recovery_on_apply_fail;
+	bool                         link_rt_workq;
+	uint32_t                     link_rt_cpu_mask;
 };
 
 /**
@@ -3,6 +3,7 @@
  * Copyright (c) 2016-2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/seq_file.h>
 #include "cam_req_mgr_debug.h"
 
 #define MAX_SESS_INFO_LINE_BUFF_LEN 256
@@ -111,6 +112,43 @@ static const struct file_operations session_info = {
 	.write = session_info_write,
 };
 
+static int link_workq_delay_show(struct seq_file *m, void *unused)
+{
+	int i, j;
+	uint32_t hist[CAM_WORKQ_DELAY_HIST_BUCKETS];
+	struct cam_req_mgr_core_device *core_dev = m->private;
+	struct cam_req_mgr_core_session *session;
+	struct cam_req_mgr_core_link *link;
+
+	seq_puts(m, "link_hdl: <50us <100us <200us <500us <1ms <2ms <5ms >=5ms\n");
+
+	mutex_lock(&core_dev->crm_lock);
+	list_for_each_entry(session, &core_dev->session_head, entry) {
+		mutex_lock(&session->lock);
+		for (i = 0; i < MAXIMUM_LINKS_PER_SESSION; i++) {
+			link = session->links[i];
+			/* Unlink drops session lock while holding link lock */
+			if (!link || !mutex_trylock(&link->lock))
+				continue;
+
+			if (link->workq) {
+				cam_req_mgr_workq_get_delay_hist(link->workq,
+					hist);
+				seq_printf(m, "0x%x:", link->link_hdl);
+				for (j = 0; j < CAM_WORKQ_DELAY_HIST_BUCKETS; j++)
+					seq_printf(m, " %u", hist[j]);
+				seq_puts(m, "\n");
+			}
+			mutex_unlock(&link->lock);
+		}
+		mutex_unlock(&session->lock);
+	}
+	mutex_unlock(&core_dev->crm_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(link_workq_delay);
+
 static struct dentry *debugfs_root;
 int cam_req_mgr_debug_register(struct cam_req_mgr_core_device *core_dev)
 {
@@ -137,6 +175,12 @@ int cam_req_mgr_debug_register(struct cam_req_mgr_core_device *core_dev)
 		debugfs_root, &core_dev->recovery_on_apply_fail);
 	debugfs_create_u32("delay_detect_count", 0644, debugfs_root,
 		&cam_debug_mgr_delay_detect);
+	debugfs_create_bool("link_rt_workq", 0644,
+		debugfs_root, &core_dev->link_rt_workq);
+	debugfs_create_x32("link_rt_cpu_mask", 0644,
+		debugfs_root, &core_dev->link_rt_cpu_mask);
+	debugfs_create_file("link_workq_delay", 0444, debugfs_root,
+		core_dev, &link_workq_delay_fops);
 end:
 	return rc;
 }
@@ -4,6 +4,7 @@
  * Copyright (c) 2022-2023, Qualcomm Innovation Center, Inc. All rights reserved.
  */
 
+#include <linux/rcupdate.h>
 #include "cam_req_mgr_workq.h"
 #include "cam_debug_util.h"
 #include "cam_common_util.h"
@@ -28,12 +29,43 @@ struct sched_param {
 		spin_unlock_bh(&(workq)->lock_bh); \
 }
 
+/* Upper bounds in us of all but the last delay histogram bucket */
+static const uint32_t cam_workq_delay_hist_us[CAM_WORKQ_DELAY_HIST_BUCKETS - 1] = {
+	50, 100, 200, 500, 1000, 2000, 5000,
+};
+
+static void cam_req_mgr_workq_record_delay(
+	struct cam_req_mgr_core_workq *workq, ktime_t scheduled_ts)
+{
+	s64 delay_us = ktime_us_delta(ktime_get(), scheduled_ts);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cam_workq_delay_hist_us); i++) {
+		if (delay_us < cam_workq_delay_hist_us[i])
+			break;
+	}
+
+	atomic_inc(&workq->delay_hist[i]);
+}
+
+static void cam_req_mgr_workq_rt_work(struct kthread_work *work)
+{
+	struct cam_req_mgr_core_workq *workq =
+		container_of(work, struct cam_req_mgr_core_workq, rt_work);
+
+	workq->process_func(&workq->work);
+}
+
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 static int cam_req_mgr_thread(void *data)
 {
 	struct cam_req_mgr_core_workq *workq = (struct cam_req_mgr_core_workq *)data;
 	struct sched_param param = { .sched_priority = 1 };//prio=98
-	sched_setscheduler_nocheck(current, SCHED_FIFO, &param);
+
+	if (workq->rt_prio)
+		sched_set_fifo(current);
+	else
+		sched_setscheduler_nocheck(current, SCHED_FIFO, &param);
 	set_current_state(TASK_INTERRUPTIBLE);
 	schedule();
 
@@ -54,6 +86,17 @@ static int cam_req_mgr_thread(void *data)
 }
 #endif
 
+/* Dedicated thread processing the workq, if any */
+static struct task_struct *cam_req_mgr_workq_thread(
+	struct cam_req_mgr_core_workq *workq)
+{
+#ifdef OPLUS_FEATURE_CAMERA_COMMON
+	if (workq->thread)
+		return workq->thread;
+#endif
+	return workq->rt_worker ? workq->rt_worker->task : NULL;
+}
+
 struct crm_workq_task *cam_req_mgr_workq_get_task(
 	struct cam_req_mgr_core_workq *workq)
 {
@@ -106,9 +149,52 @@ void cam_req_mgr_workq_flush(struct cam_req_mgr_core_workq *workq)
 
 	atomic_set(&workq->flush, 1);
 	cancel_work_sync(&workq->work);
+	if (workq->rt_worker)
+		kthread_cancel_work_sync(&workq->rt_work);
 	atomic_set(&workq->flush, 0);
 }
 
+int cam_req_mgr_workq_set_cpu_affinity(struct cam_req_mgr_core_workq *workq,
+	uint32_t cpu_mask)
+{
+	struct task_struct *thread;
+	cpumask_var_t mask;
+	int cpu, rc;
+
+	if (!workq)
+		return -EINVAL;
+
+	thread = cam_req_mgr_workq_thread(workq);
+	if (!thread)
+		return -EINVAL;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	cpumask_clear(mask);
+	for_each_possible_cpu(cpu) {
+		if ((cpu < 32) && (cpu_mask & BIT(cpu)))
+			cpumask_set_cpu(cpu, mask);
+	}
+
+	rc = set_cpus_allowed_ptr(thread, mask);
+	if (rc)
+		CAM_WARN(CAM_CRM, "workq %s failed to set affinity 0x%x rc %d",
+			workq->workq_name, cpu_mask, rc);
+
+	free_cpumask_var(mask);
+	return rc;
+}
+
+void cam_req_mgr_workq_get_delay_hist(struct cam_req_mgr_core_workq *workq,
+	uint32_t *hist)
+{
+	int i;
+
+	for (i = 0; i < CAM_WORKQ_DELAY_HIST_BUCKETS; i++)
+		hist[i] = atomic_read(&workq->delay_hist[i]);
+}
+
 /**
  * cam_req_mgr_process_task() - Process the enqueued task
  * @task: pointer to task workq thread shall process
@@ -137,9 +223,9 @@ static int cam_req_mgr_process_task(struct crm_workq_task *task)
 void cam_req_mgr_process_workq(struct work_struct *w)
 {
 	struct cam_req_mgr_core_workq *workq = NULL;
-	struct crm_workq_task         *task;
+	struct crm_workq_task         *task, *next;
+	struct llist_node             *batch;
 	int32_t                        i = CRM_TASK_PRIORITY_0;
-	unsigned long                  flags = 0;
 	ktime_t                        sched_start_time;
 	void                          *cb = NULL;
 
@@ -151,30 +237,31 @@ void cam_req_mgr_process_workq(struct work_struct *w)
 		container_of(w, struct cam_req_mgr_core_workq, work);
 
 	while (i < CRM_TASK_PRIORITY_MAX) {
-		WORKQ_ACQUIRE_LOCK(workq, flags);
-		while (!list_empty(&workq->task.process_head[i])) {
-			task = list_first_entry(&workq->task.process_head[i],
-				struct crm_workq_task, entry);
-			cb = (void *)task->process_cb;
-			cam_common_util_thread_switch_delay_detect(
-				workq->workq_name, "schedule", cb,
-				task->task_scheduled_ts,
-				CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
-			sched_start_time = ktime_get();
-			atomic_sub(1, &workq->task.pending_cnt);
-			list_del_init(&task->entry);
-			WORKQ_RELEASE_LOCK(workq, flags);
-			if (!unlikely(atomic_read(&workq->flush)))
-				cam_req_mgr_process_task(task);
-			cam_common_util_thread_switch_delay_detect(
-				workq->workq_name, "execution", cb,
-				sched_start_time,
-				CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
-			CAM_DBG(CAM_CRM, "processed task %pK free_cnt %d",
-				task, atomic_read(&workq->task.free_cnt));
-			WORKQ_ACQUIRE_LOCK(workq, flags);
+		/* Take all tasks queued so far and run them in enqueue order */
+		while ((batch = llist_del_all(&workq->task.process_head[i]))) {
+			batch = llist_reverse_order(batch);
+			llist_for_each_entry_safe(task, next, batch, process_node) {
+				cb = (void *)task->process_cb;
+				cam_common_util_thread_switch_delay_detect(
+					workq->workq_name, "schedule", cb,
+					task->task_scheduled_ts,
+					CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
+				cam_req_mgr_workq_record_delay(workq,
+					task->task_scheduled_ts);
+				sched_start_time = ktime_get();
+				atomic_sub(1, &workq->task.pending_cnt);
+				if (!unlikely(atomic_read(&workq->flush)))
+					cam_req_mgr_process_task(task);
+				else
+					cam_req_mgr_workq_put_task(task);
+				cam_common_util_thread_switch_delay_detect(
+					workq->workq_name, "execution", cb,
+					sched_start_time,
+					CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
+				CAM_DBG(CAM_CRM, "processed task %pK free_cnt %d",
+					task, atomic_read(&workq->task.free_cnt));
+			}
 		}
-		WORKQ_RELEASE_LOCK(workq, flags);
 		i++;
 	}
 }
@@ -184,7 +271,6 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 {
 	int rc = 0;
 	struct cam_req_mgr_core_workq *workq = NULL;
-	unsigned long flags = 0;
 
 	if (!task) {
 		CAM_WARN(CAM_CRM, "NULL task pointer can not schedule");
@@ -206,30 +292,39 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 		? prio : CRM_TASK_PRIORITY_0;
 	task->task_scheduled_ts = ktime_get();
 
-	WORKQ_ACQUIRE_LOCK(workq, flags);
-	if (!workq->job) {
+	/*
+	 * The RCU read section keeps the workq alive until the task is
+	 * queued, destroy waits for it after clearing job.
+	 */
+	rcu_read_lock();
+	if (!READ_ONCE(workq->job)) {
+		rcu_read_unlock();
 		rc = -EINVAL;
-		WORKQ_RELEASE_LOCK(workq, flags);
 		goto abort;
 	}
 
-	list_add_tail(&task->entry,
+	atomic_add(1, &workq->task.pending_cnt);
+	llist_add(&task->process_node,
 		&workq->task.process_head[task->priority]);
 
-	atomic_add(1, &workq->task.pending_cnt);
 	CAM_DBG(CAM_CRM, "enq task %pK pending_cnt %d",
 		task, atomic_read(&workq->task.pending_cnt));
 
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 	if (workq->thread) {
 		wake_up_process(workq->thread);
+	} else if (workq->rt_worker) {
+		kthread_queue_work(workq->rt_worker, &workq->rt_work);
 	} else {
 		queue_work(workq->job, &workq->work);
 	}
 #else
-	queue_work(workq->job, &workq->work);
+	if (workq->rt_worker)
+		kthread_queue_work(workq->rt_worker, &workq->rt_work);
+	else
+		queue_work(workq->job, &workq->work);
 #endif
-	WORKQ_RELEASE_LOCK(workq, flags);
+	rcu_read_unlock();
 
 	return rc;
 abort:
@@ -272,11 +367,14 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 		/* Workq attributes initialization */
 		strlcpy(crm_workq->workq_name, buf, sizeof(crm_workq->workq_name));
 		INIT_WORK(&crm_workq->work, func);
+		crm_workq->process_func = func;
+		kthread_init_work(&crm_workq->rt_work, cam_req_mgr_workq_rt_work);
 		spin_lock_init(&crm_workq->lock_bh);
 		CAM_DBG(CAM_CRM, "LOCK_DBG workq %s lock %pK",
 			name, &crm_workq->lock_bh);
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 		mutex_init(&crm_workq->rt_lock);
+		crm_workq->rt_prio = !!(flags & CAM_WORKQ_FLAG_RT_THREAD);
 		if (strstr(crm_workq->workq_name, "CRMCORE")) {
 			mutex_lock(&crm_workq->rt_lock);
 			crm_workq->thread = kthread_run(cam_req_mgr_thread, crm_workq, "%s",
@@ -295,11 +393,24 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 			mutex_unlock(&crm_workq->rt_lock);
 		}
 #endif
+		/* An existing processing thread takes the RT role itself */
+		if ((flags & CAM_WORKQ_FLAG_RT_THREAD) &&
+			!cam_req_mgr_workq_thread(crm_workq)) {
+			crm_workq->rt_worker = kthread_create_worker(0, "%s", buf);
+			if (IS_ERR(crm_workq->rt_worker)) {
+				CAM_WARN(CAM_CRM,
+					"RT thread for %s failed rc %ld, using workqueue",
+					buf, PTR_ERR(crm_workq->rt_worker));
+				crm_workq->rt_worker = NULL;
+			} else {
+				sched_set_fifo(crm_workq->rt_worker->task);
+			}
+		}
 		/* Task attributes initialization */
 		atomic_set(&crm_workq->task.pending_cnt, 0);
 		atomic_set(&crm_workq->task.free_cnt, 0);
 		for (i = CRM_TASK_PRIORITY_0; i < CRM_TASK_PRIORITY_MAX; i++)
-			INIT_LIST_HEAD(&crm_workq->task.process_head[i]);
+			init_llist_head(&crm_workq->task.process_head[i]);
 		INIT_LIST_HEAD(&crm_workq->task.empty_head);
 		atomic_set(&crm_workq->flush, 0);
 		crm_workq->in_irq = in_irq;
@@ -310,6 +421,9 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 			CAM_WARN(CAM_CRM, "Insufficient memory %zu",
 				sizeof(struct crm_workq_task) *
 				crm_workq->task.num_task);
+			if (crm_workq->rt_worker)
+				kthread_destroy_worker(crm_workq->rt_worker);
+			destroy_workqueue(crm_workq->job);
 			kfree(crm_workq);
 			return -ENOMEM;
 		}
@@ -351,13 +465,19 @@ void cam_req_mgr_workq_destroy(struct cam_req_mgr_core_workq **crm_workq)
 		WORKQ_ACQUIRE_LOCK(workq, flags);
 		/* prevent any processing of callbacks */
 		atomic_set(&workq->flush, 1);
-		if (workq->job) {
-			job = workq->job;
-			workq->job = NULL;
-			WORKQ_RELEASE_LOCK(workq, flags);
+		job = workq->job;
+		WRITE_ONCE(workq->job, NULL);
+		WORKQ_RELEASE_LOCK(workq, flags);
+
+		/* Wait for enqueuers that still saw the job */
+		synchronize_rcu();
+		if (job)
 			destroy_workqueue(job);
-			WORKQ_ACQUIRE_LOCK(workq, flags);
+		if (workq->rt_worker) {
+			kthread_destroy_worker(workq->rt_worker);
+			workq->rt_worker = NULL;
 		}
+		WORKQ_ACQUIRE_LOCK(workq, flags);
 		/* Destroy workq payload data */
 		kfree(workq->task.pool[0].payload);
 		workq->task.pool[0].payload = NULL;
@@ -366,7 +486,7 @@ void cam_req_mgr_workq_destroy(struct cam_req_mgr_core_workq **crm_workq)
 		/* Leave lists in stable state after freeing pool */
 		INIT_LIST_HEAD(&workq->task.empty_head);
 		for (i = 0; i < CRM_TASK_PRIORITY_MAX; i++)
-			INIT_LIST_HEAD(&workq->task.process_head[i]);
+			init_llist_head(&workq->task.process_head[i]);
 		WORKQ_RELEASE_LOCK(workq, flags);
 		kfree(workq);
 		*crm_workq = NULL;
@@ -12,6 +12,8 @@
 #include<linux/init.h>
 #include<linux/sched.h>
 #include <linux/workqueue.h>
+#include <linux/kthread.h>
+#include <linux/llist.h>
 #include <linux/slab.h>
 #include <linux/timer.h>
 
@@ -31,6 +33,20 @@
  */
 #define CAM_WORKQ_FLAG_SERIAL                    (1 << 1)
 
+/*
+ * Process tasks on a dedicated SCHED_FIFO kthread instead of
+ * the workqueue, falls back to the workqueue if the thread
+ * can not be created.
+ */
+#define CAM_WORKQ_FLAG_RT_THREAD                 (1 << 2)
+
+/*
+ * Buckets of the task queueing delay histogram, upper bounds are
+ * 50us, 100us, 200us, 500us, 1ms, 2ms, 5ms and the last bucket
+ * counts everything above.
+ */
+#define CAM_WORKQ_DELAY_HIST_BUCKETS             8
+
 /* Task priorities, lower the number higher the priority*/
 enum crm_task_priority {
 	CRM_TASK_PRIORITY_0,
@@ -52,6 +68,7 @@ enum crm_workq_context {
  *                     ready for processing in workq thread context
  * @parent           : workq's parent is link which is enqqueing taks to this workq
  * @entry            : list head of this list entry is worker's empty_head
+ * @process_node     : node in the worker's process_head of its priority
  * @cancel           : if caller has got free task from pool but wants to abort
  *                     or put back without using it
  * @priv             : when task is enqueuer caller can attach priv along which
@@ -66,6 +83,7 @@ struct crm_workq_task {
 	int32_t                  (*process_cb)(void *priv, void *data);
 	void                      *parent;
 	struct list_head           entry;
+	struct llist_node          process_node;
 	uint8_t                    cancel;
 	void                      *priv;
 	ktime_t                    task_scheduled_ts;
@@ -79,11 +97,18 @@ struct crm_workq_task {
  * @flush       : used to track if flush has been called on workqueue
  * @work_q_name : name of the workq
  * @workq_scheduled_ts: enqueue time of workq
+ * @rt_worker   : dedicated RT kthread worker, if created with
+ *                CAM_WORKQ_FLAG_RT_THREAD and no other thread
+ *                processes the workq
+ * @rt_work     : work item queued on rt_worker
+ * @process_func: process function the workq was created with
+ * @delay_hist  : histogram of task queueing delays
  * task -
  * @lock        : Current task's lock handle
  * @pending_cnt : # of tasks left in queue
  * @free_cnt    : # of free/available tasks
- * @process_head:
+ * @process_head: lock free lists of enqueued tasks, one per priority,
+ *                filled by any context and drained in batch by the worker
  * @empty_head  : list  head of available taska which can be used
  *                or acquired in order to enqueue a task to workq
  * @pool        : pool of tasks used for handling events in workq context
@@ -97,6 +122,10 @@ struct cam_req_mgr_core_workq {
 	ktime_t                    workq_scheduled_ts;
 	atomic_t                   flush;
 	char                       workq_name[128];
+	struct kthread_worker     *rt_worker;
+	struct kthread_work        rt_work;
+	void                     (*process_func)(struct work_struct *w);
+	atomic_t                   delay_hist[CAM_WORKQ_DELAY_HIST_BUCKETS];
 
 	/* tasks */
 	struct {
@@ -104,7 +133,7 @@ struct cam_req_mgr_core_workq {
 		atomic_t               pending_cnt;
 		atomic_t               free_cnt;
 
-		struct list_head       process_head[CRM_TASK_PRIORITY_MAX];
+		struct llist_head      process_head[CRM_TASK_PRIORITY_MAX];
 		struct list_head       empty_head;
 		struct crm_workq_task *pool;
 		uint32_t               num_task;
@@ -112,6 +141,7 @@ struct cam_req_mgr_core_workq {
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 	struct task_struct   *thread;
 	struct mutex         rt_lock;
+	bool                  rt_prio;
 #endif
 };
 
@@ -191,4 +221,24 @@ struct crm_workq_task *cam_req_mgr_workq_get_task(
  */
 void cam_req_mgr_workq_flush(struct cam_req_mgr_core_workq *workq);
 
+/**
+ * cam_req_mgr_workq_set_cpu_affinity()
+ * @brief   : Restrict the RT thread of the workq to a set of CPUs
+ * @workq   : pointer to worker data struct
+ * @cpu_mask: bitmask of allowed CPUs
+ *
+ * Only valid for workqs processed by a dedicated thread.
+ */
+int cam_req_mgr_workq_set_cpu_affinity(struct cam_req_mgr_core_workq *workq,
+	uint32_t cpu_mask);
+
+/**
+ * cam_req_mgr_workq_get_delay_hist()
+ * @brief: Copy the task queueing delay histogram of the workq
+ * @workq: pointer to worker data struct
+ * @hist : array of CAM_WORKQ_DELAY_HIST_BUCKETS counters to fill
+ */
+void cam_req_mgr_workq_get_delay_hist(struct cam_req_mgr_core_workq *workq,
+	uint32_t *hist);
+
 #endif
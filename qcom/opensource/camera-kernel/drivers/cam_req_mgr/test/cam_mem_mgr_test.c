@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/bitmap.h>
+#include <linux/completion.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+
+#include "cam_mem_mgr.h"
+
+#define CAM_MEM_TEST_SLOTS      64
+#define CAM_MEM_TEST_HELD       4
+#define CAM_MEM_TEST_ITERATIONS 20000
+
+struct cam_mem_test_ctx {
+	unsigned long *bitmap;
+	atomic_t owners[CAM_MEM_TEST_SLOTS];
+	struct mutex lock;
+	bool locked;
+	atomic_t double_owned;
+	atomic_t no_slot;
+	atomic_t running;
+	struct completion done;
+};
+
+/* The claim cam_mem_get_slot() did under tbl.m_lock before */
+static int32_t cam_mem_test_claim_locked(struct cam_mem_test_ctx *ctx)
+{
+	int32_t idx;
+
+	mutex_lock(&ctx->lock);
+	idx = find_first_zero_bit(ctx->bitmap, CAM_MEM_TEST_SLOTS);
+	if (idx >= CAM_MEM_TEST_SLOTS || idx <= 0) {
+		mutex_unlock(&ctx->lock);
+		return -ENOMEM;
+	}
+	set_bit(idx, ctx->bitmap);
+	mutex_unlock(&ctx->lock);
+
+	return idx;
+}
+
+static void cam_mem_test_release(struct cam_mem_test_ctx *ctx, int32_t idx)
+{
+	atomic_dec(&ctx->owners[idx]);
+	clear_bit_unlock(idx, ctx->bitmap);
+}
+
+/*
+ * Each thread keeps up to CAM_MEM_TEST_HELD slots and releases the oldest
+ * before claiming a new one, so claims and releases race on the bitmap.
+ */
+static int cam_mem_test_thread(void *data)
+{
+	struct cam_mem_test_ctx *ctx = data;
+	int32_t held[CAM_MEM_TEST_HELD];
+	int32_t idx, hint = 1;
+	int i, n = 0;
+
+	for (i = 0; i < CAM_MEM_TEST_ITERATIONS; i++) {
+		if (n == CAM_MEM_TEST_HELD) {
+			cam_mem_test_release(ctx, held[0]);
+			memmove(held, held + 1, sizeof(held[0]) * --n);
+		}
+
+		if (ctx->locked)
+			idx = cam_mem_test_claim_locked(ctx);
+		else
+			idx = cam_mem_claim_slot(ctx->bitmap,
+				CAM_MEM_TEST_SLOTS, hint);
+		if (idx < 0) {
+			atomic_inc(&ctx->no_slot);
+			cond_resched();
+			continue;
+		}
+
+		if (atomic_inc_return(&ctx->owners[idx]) != 1)
+			atomic_inc(&ctx->double_owned);
+		held[n++] = idx;
+		hint = idx + 1;
+	}
+
+	while (n)
+		cam_mem_test_release(ctx, held[--n]);
+
+	if (atomic_dec_and_test(&ctx->running))
+		complete(&ctx->done);
+
+	return 0;
+}
+
+static u64 cam_mem_test_run(struct kunit *test, struct cam_mem_test_ctx *ctx,
+	int nr_threads, bool locked)
+{
+	struct task_struct *task;
+	u64 start;
+	int i;
+
+	bitmap_zero(ctx->bitmap, CAM_MEM_TEST_SLOTS);
+	for (i = 0; i < CAM_MEM_TEST_SLOTS; i++)
+		atomic_set(&ctx->owners[i], 0);
+	atomic_set(&ctx->double_owned, 0);
+	atomic_set(&ctx->no_slot, 0);
+	atomic_set(&ctx->running, nr_threads);
+	init_completion(&ctx->done);
+	ctx->locked = locked;
+
+	start = ktime_get_ns();
+	for (i = 0; i < nr_threads; i++) {
+		task = kthread_run(cam_mem_test_thread, ctx, "cam_mem_test/%d",
+			i);
+		if (IS_ERR(task)) {
+			KUNIT_FAIL(test, "kthread_run failed %ld",
+				PTR_ERR(task));
+			if (atomic_sub_and_test(nr_threads - i, &ctx->running))
+				complete(&ctx->done);
+			break;
+		}
+	}
+	wait_for_completion(&ctx->done);
+
+	return ktime_get_ns() - start;
+}
+
+static struct cam_mem_test_ctx *cam_mem_test_ctx_alloc(struct kunit *test)
+{
+	struct cam_mem_test_ctx *ctx;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx);
+	ctx->bitmap = kunit_kcalloc(test, BITS_TO_LONGS(CAM_MEM_TEST_SLOTS),
+		sizeof(long), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx->bitmap);
+	mutex_init(&ctx->lock);
+
+	return ctx;
+}
+
+static void cam_mem_test_claim_full(struct kunit *test)
+{
+	struct cam_mem_test_ctx *ctx = cam_mem_test_ctx_alloc(test);
+	int32_t idx;
+	int i;
+
+	/* Starting past the middle must still hand out the low slots */
+	for (i = 1; i < CAM_MEM_TEST_SLOTS; i++) {
+		idx = cam_mem_claim_slot(ctx->bitmap, CAM_MEM_TEST_SLOTS, 40);
+		KUNIT_ASSERT_GT(test, idx, 0);
+		KUNIT_EXPECT_EQ(test, 1, atomic_inc_return(&ctx->owners[idx]));
+	}
+
+	KUNIT_EXPECT_EQ(test, -ENOMEM,
+		cam_mem_claim_slot(ctx->bitmap, CAM_MEM_TEST_SLOTS, 40));
+	KUNIT_EXPECT_EQ(test, 0, (int)test_bit(0, ctx->bitmap));
+
+	clear_bit_unlock(7, ctx->bitmap);
+	KUNIT_EXPECT_EQ(test, 7,
+		cam_mem_claim_slot(ctx->bitmap, CAM_MEM_TEST_SLOTS, 40));
+	KUNIT_EXPECT_EQ(test, CAM_MEM_TEST_SLOTS,
+		(int)find_first_zero_bit(ctx->bitmap, CAM_MEM_TEST_SLOTS));
+}
+
+static void cam_mem_test_claim_stress(struct kunit *test)
+{
+	struct cam_mem_test_ctx *ctx = cam_mem_test_ctx_alloc(test);
+	int nr_threads = clamp_t(int, num_online_cpus() * 2, 4, 32);
+	u64 lockless_ns, locked_ns;
+
+	lockless_ns = cam_mem_test_run(test, ctx, nr_threads, false);
+	KUNIT_EXPECT_EQ(test, 0, atomic_read(&ctx->double_owned));
+	KUNIT_EXPECT_TRUE(test, bitmap_empty(ctx->bitmap, CAM_MEM_TEST_SLOTS));
+	kunit_info(test, "%d threads lock free: %llu us, %d claims found no slot\n",
+		nr_threads, div_u64(lockless_ns, NSEC_PER_USEC),
+		atomic_read(&ctx->no_slot));
+
+	locked_ns = cam_mem_test_run(test, ctx, nr_threads, true);
+	KUNIT_EXPECT_EQ(test, 0, atomic_read(&ctx->double_owned));
+	kunit_info(test, "%d threads table lock: %llu us, %d claims found no slot\n",
+		nr_threads, div_u64(locked_ns, NSEC_PER_USEC),
+		atomic_read(&ctx->no_slot));
+}
+
+/* More slots held than the table has, so claims must fail cleanly */
+static void cam_mem_test_claim_exhausted(struct kunit *test)
+{
+	struct cam_mem_test_ctx *ctx = cam_mem_test_ctx_alloc(test);
+	int nr_threads = CAM_MEM_TEST_SLOTS / CAM_MEM_TEST_HELD + 4;
+
+	cam_mem_test_run(test, ctx, nr_threads, false);
+	KUNIT_EXPECT_EQ(test, 0, atomic_read(&ctx->double_owned));
+	KUNIT_EXPECT_TRUE(test, bitmap_empty(ctx->bitmap, CAM_MEM_TEST_SLOTS));
+}
+
+static struct kunit_case cam_mem_mgr_test_cases[] = {
+	KUNIT_CASE(cam_mem_test_claim_full),
+	KUNIT_CASE(cam_mem_test_claim_stress),
+	KUNIT_CASE(cam_mem_test_claim_exhausted),
+	{}
+};
+
+static struct kunit_suite cam_mem_mgr_test_suite = {
+	.name = "cam_mem_mgr",
+	.test_cases = cam_mem_mgr_test_cases,
+};
+
+kunit_test_suite(cam_mem_mgr_test_suite);
+
+MODULE_DESCRIPTION("Camera memory manager slot claim KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -24,6 +24,7 @@
 
 #include "cam_compat.h"
 #include "cam_smmu_api.h"
+#include "cam_smmu_buf_index.h"
 #include "cam_debug_util.h"
 #include "camera_main.h"
 #include "cam_trace.h"
@@ -163,6 +164,8 @@ struct cam_context_bank_info {
 
 	struct list_head smmu_buf_list;
 	struct list_head smmu_buf_kernel_list;
+	/* lookup indexes over the buffer lists, protected by lock */
+	struct cam_smmu_buf_index buf_index;
 	struct mutex lock;
 	int handle;
 	enum cam_smmu_ops_param state;
@@ -207,24 +210,6 @@ static const struct of_device_id msm_cam_smmu_dt_match[] = {
 	{}
 };
 
-struct cam_dma_buff_info {
-	struct dma_buf *buf;
-	struct dma_buf_attachment *attach;
-	struct sg_table *table;
-	enum dma_data_direction dir;
-	enum cam_smmu_region_id region_id;
-	int iommu_dir;
-	int ref_count;
-	dma_addr_t paddr;
-	struct list_head list;
-	int ion_fd;
-	unsigned long i_ino;
-	size_t len;
-	size_t phys_len;
-	bool is_internal;
-	struct timespec64 ts;
-};
-
 struct cam_sec_buff_info {
 	struct dma_buf *buf;
 	struct dma_buf_attachment *attach;
@@ -361,6 +346,186 @@ static int cam_smmu_probe(struct platform_device *pdev);
 
 static uint32_t cam_smmu_find_closest_mapping(int idx, void *vaddr, bool *in_map_region);
 
+static inline unsigned long cam_smmu_buf_hash_key(int ion_fd,
+	unsigned long i_ino)
+{
+	return (i_ino << 16) ^ (unsigned int)ion_fd;
+}
+
+void cam_smmu_buf_index_init(struct cam_smmu_buf_index *index)
+{
+	hash_init(index->fd_hash);
+	hash_init(index->dma_buf_hash);
+	index->iova_tree = RB_ROOT;
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_init);
+
+void cam_smmu_buf_index_add_user(struct cam_smmu_buf_index *index,
+	struct cam_dma_buff_info *mapping)
+{
+	struct rb_node **link = &index->iova_tree.rb_node;
+	struct rb_node *parent = NULL;
+	struct cam_dma_buff_info *entry;
+
+	hash_add(index->fd_hash, &mapping->hnode,
+		cam_smmu_buf_hash_key(mapping->ion_fd, mapping->i_ino));
+
+	while (*link) {
+		parent = *link;
+		entry = rb_entry(parent, struct cam_dma_buff_info, iova_node);
+		if (mapping->paddr < entry->paddr)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	rb_link_node(&mapping->iova_node, parent, link);
+	rb_insert_color(&mapping->iova_node, &index->iova_tree);
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_add_user);
+
+void cam_smmu_buf_index_add_kernel(struct cam_smmu_buf_index *index,
+	struct cam_dma_buff_info *mapping)
+{
+	hash_add(index->dma_buf_hash, &mapping->hnode,
+		(unsigned long)mapping->buf);
+	/* kernel mappings are not part of the fault lookup tree */
+	RB_CLEAR_NODE(&mapping->iova_node);
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_add_kernel);
+
+void cam_smmu_buf_index_remove(struct cam_smmu_buf_index *index,
+	struct cam_dma_buff_info *mapping)
+{
+	hash_del(&mapping->hnode);
+
+	if (!RB_EMPTY_NODE(&mapping->iova_node)) {
+		rb_erase(&mapping->iova_node, &index->iova_tree);
+		RB_CLEAR_NODE(&mapping->iova_node);
+	}
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_remove);
+
+struct cam_dma_buff_info *cam_smmu_buf_index_find_fd(
+	struct cam_smmu_buf_index *index, int ion_fd, unsigned long i_ino)
+{
+	struct cam_dma_buff_info *mapping;
+
+	hash_for_each_possible(index->fd_hash, mapping, hnode,
+		cam_smmu_buf_hash_key(ion_fd, i_ino)) {
+		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino))
+			return mapping;
+	}
+
+	return NULL;
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_find_fd);
+
+struct cam_dma_buff_info *cam_smmu_buf_index_find_dma_buf(
+	struct cam_smmu_buf_index *index, struct dma_buf *buf)
+{
+	struct cam_dma_buff_info *mapping;
+
+	hash_for_each_possible(index->dma_buf_hash, mapping, hnode,
+		(unsigned long)buf) {
+		if (mapping->buf == buf)
+			return mapping;
+	}
+
+	return NULL;
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_find_dma_buf);
+
+/*
+ * IOVA ranges within a context bank never overlap, so the mapping with the
+ * highest start address not above @addr is the only one that can contain it.
+ */
+struct cam_dma_buff_info *cam_smmu_buf_index_floor(
+	struct cam_smmu_buf_index *index, unsigned long addr)
+{
+	struct rb_node *node = index->iova_tree.rb_node;
+	struct cam_dma_buff_info *entry, *floor = NULL;
+
+	while (node) {
+		entry = rb_entry(node, struct cam_dma_buff_info, iova_node);
+		if (addr < (unsigned long)entry->paddr) {
+			node = node->rb_left;
+		} else {
+			floor = entry;
+			node = node->rb_right;
+		}
+	}
+
+	return floor;
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_floor);
+
+/*
+ * Mapping containing @addr, or the closest one to it. Only the floor mapping
+ * and the one right after it can be closest.
+ */
+struct cam_dma_buff_info *cam_smmu_buf_index_closest(
+	struct cam_smmu_buf_index *index, unsigned long addr,
+	bool *in_map_region)
+{
+	struct cam_dma_buff_info *mapping, *closest = NULL;
+	unsigned long end_addr, lowest_delta = 0;
+	struct rb_node *next;
+
+	*in_map_region = false;
+
+	mapping = cam_smmu_buf_index_floor(index, addr);
+	if (mapping) {
+		end_addr = (unsigned long)mapping->paddr + mapping->len;
+		if (addr <= end_addr) {
+			*in_map_region = true;
+			return mapping;
+		}
+
+		lowest_delta = addr - end_addr - 1;
+		closest = mapping;
+		next = rb_next(&mapping->iova_node);
+	} else {
+		next = rb_first(&index->iova_tree);
+	}
+
+	if (next) {
+		mapping = rb_entry(next, struct cam_dma_buff_info, iova_node);
+		if (!closest ||
+			(unsigned long)mapping->paddr - addr < lowest_delta)
+			closest = mapping;
+	}
+
+	return closest;
+}
+CAM_EXPORT_FOR_KUNIT(cam_smmu_buf_index_closest);
+
+static void cam_smmu_add_user_mapping(int idx,
+	struct cam_dma_buff_info *mapping_info)
+{
+	struct cam_context_bank_info *cb_info = &iommu_cb_set.cb_info[idx];
+
+	list_add(&mapping_info->list, &cb_info->smmu_buf_list);
+	cam_smmu_buf_index_add_user(&cb_info->buf_index, mapping_info);
+}
+
+static void cam_smmu_add_kernel_mapping(int idx,
+	struct cam_dma_buff_info *mapping_info)
+{
+	struct cam_context_bank_info *cb_info = &iommu_cb_set.cb_info[idx];
+
+	list_add(&mapping_info->list, &cb_info->smmu_buf_kernel_list);
+	cam_smmu_buf_index_add_kernel(&cb_info->buf_index, mapping_info);
+}
+
+static void cam_smmu_remove_mapping(int idx,
+	struct cam_dma_buff_info *mapping_info)
+{
+	list_del_init(&mapping_info->list);
+	cam_smmu_buf_index_remove(&iommu_cb_set.cb_info[idx].buf_index,
+		mapping_info);
+}
+
 static void cam_smmu_update_monitor_array(
 	struct cam_context_bank_info *cb_info,
 	bool is_map,
@@ -689,59 +854,41 @@ static void cam_smmu_print_table(void)
 
 static uint32_t cam_smmu_find_closest_mapping(int idx, void *vaddr, bool *in_map_region)
 {
-	struct cam_dma_buff_info *mapping, *closest_mapping =  NULL;
+	struct cam_dma_buff_info *closest_mapping;
+	struct cam_context_bank_info *cb_info = &iommu_cb_set.cb_info[idx];
 	unsigned long start_addr, end_addr, current_addr;
 	uint32_t buf_info = 0;
 
-	long delta = 0, lowest_delta = 0;
-
 	current_addr = (unsigned long)vaddr;
-	*in_map_region = false;
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		start_addr = (unsigned long)mapping->paddr;
-		end_addr = (unsigned long)mapping->paddr + mapping->len;
 
-		if (start_addr <= current_addr && current_addr <= end_addr) {
-			closest_mapping = mapping;
-			*in_map_region = true;
+	closest_mapping = cam_smmu_buf_index_closest(&cb_info->buf_index,
+		current_addr, in_map_region);
+	if (closest_mapping) {
+		start_addr = (unsigned long)closest_mapping->paddr;
+		end_addr = start_addr + closest_mapping->len;
+
+		if (*in_map_region)
 			CAM_INFO(CAM_SMMU,
 				"Found va 0x%lx in:0x%lx-0x%lx, fd %d i_ino %lu cb:%s",
-				current_addr, start_addr,
-				end_addr, mapping->ion_fd, mapping->i_ino,
-				iommu_cb_set.cb_info[idx].name[0]);
-			goto end;
-		} else {
-			if (start_addr > current_addr)
-				delta =  start_addr - current_addr;
-			else
-				delta = current_addr - end_addr - 1;
-
-			if (delta < lowest_delta || lowest_delta == 0) {
-				lowest_delta = delta;
-				closest_mapping = mapping;
-			}
+				current_addr, start_addr, end_addr,
+				closest_mapping->ion_fd, closest_mapping->i_ino,
+				cb_info->name[0]);
+		else
 			CAM_DBG(CAM_SMMU,
 				"approx va %lx not in range: %lx-%lx fd = %0x i_ino %lu",
-				current_addr, start_addr,
-				end_addr, mapping->ion_fd, mapping->i_ino);
-		}
-	}
+				current_addr, start_addr, end_addr,
+				closest_mapping->ion_fd, closest_mapping->i_ino);
 
-end:
-	if (closest_mapping) {
 		buf_info = closest_mapping->ion_fd;
 		CAM_INFO(CAM_SMMU,
-			"Closest map fd %d i_ino %lu 0x%lx %llu-%llu 0x%lx-0x%lx buf=%pK",
+			"Closest map fd %d i_ino %lu 0x%lx %zu 0x%lx-0x%lx buf=%pK",
 			closest_mapping->ion_fd, closest_mapping->i_ino, current_addr,
-			mapping->len, closest_mapping->len,
-			(unsigned long)closest_mapping->paddr,
-			(unsigned long)closest_mapping->paddr + mapping->len,
+			closest_mapping->len, start_addr, end_addr,
 			closest_mapping->buf);
 	} else
 		CAM_ERR(CAM_SMMU,
 			"Cannot find vaddr:%lx in SMMU %s virt address",
-			current_addr, iommu_cb_set.cb_info[idx].name[0]);
+			current_addr, cb_info->name[0]);
 
 	return buf_info;
 }
@@ -985,6 +1132,7 @@ void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_kernel_list);
+		cam_smmu_buf_index_init(&iommu_cb_set.cb_info[i].buf_index);
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -1221,13 +1369,12 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_virt_address(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping, &iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->paddr == virt_addr) {
-			CAM_DBG(CAM_SMMU, "Found virtual address %lx",
-				 (unsigned long)virt_addr);
-			return mapping;
-		}
+	mapping = cam_smmu_buf_index_floor(&iommu_cb_set.cb_info[idx].buf_index,
+		(unsigned long)virt_addr);
+	if (mapping && (mapping->paddr == virt_addr)) {
+		CAM_DBG(CAM_SMMU, "Found virtual address %lx",
+			 (unsigned long)virt_addr);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find virtual address %lx by index %d",
@@ -1248,13 +1395,11 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_ion_index(int idx,
 
 	i_ino = file_inode(dmabuf->file)->i_ino;
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino)) {
-			CAM_DBG(CAM_SMMU, "find ion_fd %d i_ino %lu", ion_fd, i_ino);
-			return mapping;
-		}
+	mapping = cam_smmu_buf_index_find_fd(
+		&iommu_cb_set.cb_info[idx].buf_index, ion_fd, i_ino);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find ion_fd %d i_ino %lu", ion_fd, i_ino);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d, fd %d i_ino %lu",
@@ -1273,13 +1418,11 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_dma_buf(int idx,
 		return NULL;
 	}
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list,
-			list) {
-		if (mapping->buf == buf) {
-			CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
-			return mapping;
-		}
+	mapping = cam_smmu_buf_index_find_dma_buf(
+		&iommu_cb_set.cb_info[idx].buf_index, buf);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d", idx);
@@ -2347,8 +2490,7 @@ static int cam_smmu_map_buffer_and_add_to_list(int idx, int ion_fd,
 	mapping_info->is_internal = is_internal;
 	CAM_GET_TIMESTAMP(mapping_info->ts);
 	/* add to the list */
-	list_add(&mapping_info->list,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list);
+	cam_smmu_add_user_mapping(idx, mapping_info);
 
 	CAM_DBG(CAM_SMMU, "fd %d i_ino %lu dmabuf %pK", ion_fd, mapping_info->i_ino, buf);
 
@@ -2379,8 +2521,7 @@ static int cam_smmu_map_kernel_buffer_and_add_to_list(int idx,
 	CAM_GET_TIMESTAMP(mapping_info->ts);
 
 	/* add to the list */
-	list_add(&mapping_info->list,
-		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list);
+	cam_smmu_add_kernel_mapping(idx, mapping_info);
 
 	CAM_DBG(CAM_SMMU, "fd %d i_ino %lu dmabuf %pK",
 		mapping_info->ion_fd, mapping_info->i_ino, buf);
@@ -2474,7 +2615,7 @@ static int cam_smmu_unmap_buf_and_remove_from_list(
 
 	mapping_info->buf = NULL;
 
-	list_del_init(&mapping_info->list);
+	cam_smmu_remove_mapping(idx, mapping_info);
 
 	/* free one buffer */
 	kfree(mapping_info);
@@ -2490,14 +2631,13 @@ static enum cam_smmu_buf_state cam_smmu_check_fd_in_list(int idx,
 
 	i_ino = file_inode(dmabuf->file)->i_ino;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino)) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_buf_index_find_fd(
+		&iommu_cb_set.cb_info[idx].buf_index, ion_fd, i_ino);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		*ts_mapping = &mapping->ts;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2512,15 +2652,14 @@ static enum cam_smmu_buf_state cam_smmu_user_reuse_fd_in_list(int idx,
 
 	i_ino = file_inode(dmabuf->file)->i_ino;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if ((mapping->ion_fd == ion_fd) && (mapping->i_ino == i_ino)) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			mapping->ref_count++;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_buf_index_find_fd(
+		&iommu_cb_set.cb_info[idx].buf_index, ion_fd, i_ino);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		*ts_mapping = &mapping->ts;
+		mapping->ref_count++;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2531,13 +2670,12 @@ static enum cam_smmu_buf_state cam_smmu_check_dma_buf_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list, list) {
-		if (mapping->buf == buf) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_buf_index_find_dma_buf(
+		&iommu_cb_set.cb_info[idx].buf_index, buf);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2751,7 +2889,7 @@ static int cam_smmu_alloc_scratch_buffer_add_to_list(int idx,
 		(void *)mapping_info->paddr,
 		mapping_info->len, mapping_info->phys_len);
 
-	list_add(&mapping_info->list, &iommu_cb_set.cb_info[idx].smmu_buf_list);
+	cam_smmu_add_user_mapping(idx, mapping_info);
 
 	*virt_addr = (dma_addr_t)iova;
 
@@ -2812,7 +2950,7 @@ static int cam_smmu_free_scratch_buffer_remove_from_list(
 			get_order(mapping_info->phys_len));
 	sg_free_table(mapping_info->table);
 	kfree(mapping_info->table);
-	list_del_init(&mapping_info->list);
+	cam_smmu_remove_mapping(idx, mapping_info);
 
 	kfree(mapping_info);
 	mapping_info = NULL;
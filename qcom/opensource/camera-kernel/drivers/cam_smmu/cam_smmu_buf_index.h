@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CAM_SMMU_BUF_INDEX_H_
+#define _CAM_SMMU_BUF_INDEX_H_
+
+#include <linux/dma-buf.h>
+#include <linux/hashtable.h>
+#include <linux/list.h>
+#include <linux/rbtree.h>
+#include <linux/time64.h>
+
+#include "cam_smmu_api.h"
+
+#define CAM_SMMU_BUF_HASH_BITS         7
+
+struct cam_dma_buff_info {
+	struct dma_buf *buf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *table;
+	enum dma_data_direction dir;
+	enum cam_smmu_region_id region_id;
+	int iommu_dir;
+	int ref_count;
+	dma_addr_t paddr;
+	struct list_head list;
+	struct hlist_node hnode;
+	struct rb_node iova_node;
+	int ion_fd;
+	unsigned long i_ino;
+	size_t len;
+	size_t phys_len;
+	bool is_internal;
+	struct timespec64 ts;
+};
+
+/**
+ * struct cam_smmu_buf_index - Lookup indexes over the non secure buffers
+ *                             mapped on a context bank
+ *
+ * @fd_hash      : User mappings keyed by (fd, inode)
+ * @dma_buf_hash : Kernel mappings keyed by dma_buf
+ * @iova_tree    : User mappings ordered by IOVA. IOVA ranges within a bank
+ *                 never overlap, so ordering by start address answers both
+ *                 exact and containing/closest address queries.
+ */
+struct cam_smmu_buf_index {
+	DECLARE_HASHTABLE(fd_hash, CAM_SMMU_BUF_HASH_BITS);
+	DECLARE_HASHTABLE(dma_buf_hash, CAM_SMMU_BUF_HASH_BITS);
+	struct rb_root iova_tree;
+};
+
+void cam_smmu_buf_index_init(struct cam_smmu_buf_index *index);
+
+void cam_smmu_buf_index_add_user(struct cam_smmu_buf_index *index,
+	struct cam_dma_buff_info *mapping);
+
+void cam_smmu_buf_index_add_kernel(struct cam_smmu_buf_index *index,
+	struct cam_dma_buff_info *mapping);
+
+void cam_smmu_buf_index_remove(struct cam_smmu_buf_index *index,
+	struct cam_dma_buff_info *mapping);
+
+struct cam_dma_buff_info *cam_smmu_buf_index_find_fd(
+	struct cam_smmu_buf_index *index, int ion_fd, unsigned long i_ino);
+
+struct cam_dma_buff_info *cam_smmu_buf_index_find_dma_buf(
+	struct cam_smmu_buf_index *index, struct dma_buf *buf);
+
+struct cam_dma_buff_info *cam_smmu_buf_index_floor(
+	struct cam_smmu_buf_index *index, unsigned long addr);
+
+struct cam_dma_buff_info *cam_smmu_buf_index_closest(
+	struct cam_smmu_buf_index *index, unsigned long addr,
+	bool *in_map_region);
+
+#endif /* _CAM_SMMU_BUF_INDEX_H_ */
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+
+#include "cam_smmu_buf_index.h"
+
+#define CAM_SMMU_TEST_IOVA_BASE    0x10000000UL
+#define CAM_SMMU_TEST_IOVA_STRIDE  0x100000UL
+#define CAM_SMMU_TEST_BENCH_ROUNDS 16
+
+struct cam_smmu_test_set {
+	struct cam_smmu_buf_index index;
+	struct list_head list;
+	struct cam_dma_buff_info *mappings;
+	int count;
+};
+
+/*
+ * Mappings are inserted in a scrambled order with half sized buffers every
+ * stride, so the IOVA space has a hole after each buffer. fds repeat every
+ * count / 2 mappings with a distinct inode, as they do after fd reuse.
+ */
+static struct cam_smmu_test_set *cam_smmu_test_build(struct kunit *test,
+	int count)
+{
+	struct cam_smmu_test_set *set;
+	int i, n;
+
+	set = kunit_kzalloc(test, sizeof(*set), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, set);
+	set->mappings = kunit_kcalloc(test, count, sizeof(*set->mappings),
+		GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, set->mappings);
+
+	set->count = count;
+	INIT_LIST_HEAD(&set->list);
+	cam_smmu_buf_index_init(&set->index);
+
+	for (i = 0; i < count; i++) {
+		struct cam_dma_buff_info *mapping;
+
+		n = (i * 7) % count;
+		mapping = &set->mappings[n];
+		mapping->ion_fd = n % (count / 2) + 1;
+		mapping->i_ino = 1000 + n;
+		mapping->paddr = CAM_SMMU_TEST_IOVA_BASE +
+			n * CAM_SMMU_TEST_IOVA_STRIDE;
+		mapping->len = CAM_SMMU_TEST_IOVA_STRIDE / 2;
+		list_add(&mapping->list, &set->list);
+		cam_smmu_buf_index_add_user(&set->index, mapping);
+	}
+
+	return set;
+}
+
+static struct cam_dma_buff_info *cam_smmu_test_walk_fd(
+	struct cam_smmu_test_set *set, int ion_fd, unsigned long i_ino)
+{
+	struct cam_dma_buff_info *mapping;
+
+	list_for_each_entry(mapping, &set->list, list)
+		if (mapping->ion_fd == ion_fd && mapping->i_ino == i_ino)
+			return mapping;
+
+	return NULL;
+}
+
+/* The list walk cam_smmu_find_closest_mapping did before the index */
+static struct cam_dma_buff_info *cam_smmu_test_walk_closest(
+	struct cam_smmu_test_set *set, unsigned long addr, bool *in_region)
+{
+	struct cam_dma_buff_info *mapping, *closest = NULL;
+	unsigned long delta, lowest = ULONG_MAX;
+
+	*in_region = false;
+	list_for_each_entry(mapping, &set->list, list) {
+		unsigned long start = mapping->paddr;
+		unsigned long end = mapping->paddr + mapping->len;
+
+		if (start <= addr && addr <= end) {
+			*in_region = true;
+			return mapping;
+		}
+
+		delta = start > addr ? start - addr : addr - end - 1;
+		if (delta < lowest || (delta == lowest && closest &&
+			mapping->paddr < closest->paddr)) {
+			lowest = delta;
+			closest = mapping;
+		}
+	}
+
+	return closest;
+}
+
+static void cam_smmu_test_find_fd(struct kunit *test)
+{
+	struct cam_smmu_test_set *set = cam_smmu_test_build(test, 64);
+	struct cam_dma_buff_info *mapping;
+	int i;
+
+	for (i = 0; i < set->count; i++) {
+		mapping = &set->mappings[i];
+		KUNIT_EXPECT_PTR_EQ(test, mapping,
+			cam_smmu_buf_index_find_fd(&set->index, mapping->ion_fd,
+			mapping->i_ino));
+	}
+
+	/* Same fd, inode of a different file */
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_find_fd(&set->index, 1, 5000));
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_find_fd(&set->index, 1000, 1000));
+
+	mapping = &set->mappings[3];
+	cam_smmu_buf_index_remove(&set->index, mapping);
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_find_fd(&set->index, mapping->ion_fd,
+		mapping->i_ino));
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_floor(&set->index, mapping->paddr));
+}
+
+static void cam_smmu_test_find_dma_buf(struct kunit *test)
+{
+	struct cam_smmu_buf_index *index;
+	struct cam_dma_buff_info *mappings;
+	struct dma_buf *bufs;
+	int i;
+
+	index = kunit_kzalloc(test, sizeof(*index), GFP_KERNEL);
+	mappings = kunit_kcalloc(test, 32, sizeof(*mappings), GFP_KERNEL);
+	bufs = kunit_kcalloc(test, 33, sizeof(*bufs), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, index);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, mappings);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, bufs);
+
+	cam_smmu_buf_index_init(index);
+	for (i = 0; i < 32; i++) {
+		mappings[i].buf = &bufs[i];
+		mappings[i].ion_fd = -1;
+		cam_smmu_buf_index_add_kernel(index, &mappings[i]);
+	}
+
+	for (i = 0; i < 32; i++)
+		KUNIT_EXPECT_PTR_EQ(test, &mappings[i],
+			cam_smmu_buf_index_find_dma_buf(index, &bufs[i]));
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_find_dma_buf(index, &bufs[32]));
+
+	cam_smmu_buf_index_remove(index, &mappings[5]);
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_find_dma_buf(index, &bufs[5]));
+}
+
+static void cam_smmu_test_closest(struct kunit *test)
+{
+	struct cam_smmu_test_set *set = cam_smmu_test_build(test, 64);
+	unsigned long addr, end;
+	bool in_index, in_walk;
+	struct cam_dma_buff_info *expected, *found;
+
+	end = CAM_SMMU_TEST_IOVA_BASE + (set->count + 1) *
+		CAM_SMMU_TEST_IOVA_STRIDE;
+
+	/* Step through every region, the holes and both ends of the space */
+	for (addr = CAM_SMMU_TEST_IOVA_BASE - CAM_SMMU_TEST_IOVA_STRIDE;
+		addr < end; addr += CAM_SMMU_TEST_IOVA_STRIDE / 8 + 1) {
+		expected = cam_smmu_test_walk_closest(set, addr, &in_walk);
+		found = cam_smmu_buf_index_closest(&set->index, addr,
+			&in_index);
+
+		KUNIT_EXPECT_PTR_EQ(test, expected, found);
+		KUNIT_EXPECT_EQ(test, in_walk, in_index);
+	}
+
+	found = cam_smmu_buf_index_floor(&set->index,
+		set->mappings[10].paddr + 16);
+	KUNIT_EXPECT_PTR_EQ(test, &set->mappings[10], found);
+	KUNIT_EXPECT_PTR_EQ(test, NULL,
+		cam_smmu_buf_index_floor(&set->index,
+		CAM_SMMU_TEST_IOVA_BASE - 1));
+}
+
+static void cam_smmu_test_lookup_bench(struct kunit *test)
+{
+	static const int sizes[] = { 16, 64, 256, 1024 };
+	struct cam_smmu_test_set *set;
+	struct cam_dma_buff_info *mapping;
+	u64 start, index_ns = 0, walk_ns = 0;
+	unsigned long misses = 0;
+	int s, r, i;
+
+	for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+		set = cam_smmu_test_build(test, sizes[s]);
+
+		start = ktime_get_ns();
+		for (r = 0; r < CAM_SMMU_TEST_BENCH_ROUNDS; r++)
+			for (i = 0; i < set->count; i++) {
+				mapping = &set->mappings[i];
+				if (!cam_smmu_buf_index_find_fd(&set->index,
+					mapping->ion_fd, mapping->i_ino))
+					misses++;
+			}
+		index_ns = ktime_get_ns() - start;
+
+		start = ktime_get_ns();
+		for (r = 0; r < CAM_SMMU_TEST_BENCH_ROUNDS; r++)
+			for (i = 0; i < set->count; i++) {
+				mapping = &set->mappings[i];
+				if (!cam_smmu_test_walk_fd(set, mapping->ion_fd,
+					mapping->i_ino))
+					misses++;
+			}
+		walk_ns = ktime_get_ns() - start;
+
+		kunit_info(test,
+			"%4d buffers: index %llu ns/lookup, list %llu ns/lookup\n",
+			set->count,
+			div_u64(index_ns, CAM_SMMU_TEST_BENCH_ROUNDS * set->count),
+			div_u64(walk_ns, CAM_SMMU_TEST_BENCH_ROUNDS * set->count));
+	}
+
+	KUNIT_EXPECT_EQ(test, 0UL, misses);
+	/* At 1024 buffers the walk averages 512 compares per lookup */
+	KUNIT_EXPECT_LT(test, index_ns, walk_ns);
+}
+
+static struct kunit_case cam_smmu_test_cases[] = {
+	KUNIT_CASE(cam_smmu_test_find_fd),
+	KUNIT_CASE(cam_smmu_test_find_dma_buf),
+	KUNIT_CASE(cam_smmu_test_closest),
+	KUNIT_CASE(cam_smmu_test_lookup_bench),
+	{}
+};
+
+static struct kunit_suite cam_smmu_test_suite = {
+	.name = "cam_smmu",
+	.test_cases = cam_smmu_test_cases,
+};
+
+kunit_test_suite(cam_smmu_test_suite);
+
+MODULE_DESCRIPTION("Camera SMMU buffer index KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -10,6 +10,7 @@
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #if IS_REACHABLE(CONFIG_MSM_GLOBAL_SYNX)
 #include <synx_api.h>
 #endif
@@ -336,10 +337,10 @@ static int cam_sync_signal_validate_util(
 	return 0;
 }
 
-int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
+static int cam_sync_signal_obj_util(int32_t sync_obj, uint32_t status,
+	uint32_t event_cause, struct list_head *parents_list)
 {
 	struct sync_table_row *row = NULL;
-	struct list_head parents_list;
 	int rc = 0;
 
 	if (sync_obj >= CAM_SYNC_MAX_OBJS || sync_obj <= 0) {
@@ -380,11 +381,24 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 
 	cam_sync_util_dispatch_signaled_cb(sync_obj, status, event_cause);
 
-	/* copy parent list to local and release child lock */
-	INIT_LIST_HEAD(&parents_list);
-	list_splice_init(&row->parents_list, &parents_list);
+	/* move parent list to the caller and release child lock */
+	list_splice_tail_init(&row->parents_list, parents_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
 
+	return 0;
+}
+
+int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
+{
+	struct list_head parents_list;
+	int rc;
+
+	INIT_LIST_HEAD(&parents_list);
+	rc = cam_sync_signal_obj_util(sync_obj, status, event_cause,
+		&parents_list);
+	if (rc)
+		return rc;
+
 	if (list_empty(&parents_list))
 		return 0;
 
@@ -393,6 +407,110 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 	return 0;
 }
 
+/* Signaled states, in the order their parent lists are resolved */
+static const uint32_t cam_sync_batch_states[] = {
+	CAM_SYNC_STATE_SIGNALED_SUCCESS,
+	CAM_SYNC_STATE_SIGNALED_ERROR,
+	CAM_SYNC_STATE_SIGNALED_CANCEL,
+};
+
+static void cam_sync_signal_parent_batch_util(uint32_t event_cause,
+	struct list_head *parents_lists)
+{
+	int i, j, rc;
+	int32_t parent_id;
+	bool invalid;
+	struct sync_table_row *parent_row = NULL;
+	struct sync_parent_info *parent_info, *temp_parent_info;
+
+	/*
+	 * Every parent is locked once and its remaining count is settled for
+	 * all of its children in the batch before it is dispatched.
+	 */
+	for (i = 0; i < ARRAY_SIZE(cam_sync_batch_states); i++) {
+		while (!list_empty(&parents_lists[i])) {
+			parent_info = list_first_entry(&parents_lists[i],
+				struct sync_parent_info, list);
+			parent_id = parent_info->sync_id;
+			parent_row = sync_dev->sync_table + parent_id;
+			invalid = false;
+
+			spin_lock_bh(&sync_dev->row_spinlocks[parent_id]);
+			for (j = i; j < ARRAY_SIZE(cam_sync_batch_states); j++) {
+				list_for_each_entry_safe(parent_info,
+					temp_parent_info, &parents_lists[j], list) {
+					if (parent_info->sync_id != parent_id)
+						continue;
+
+					parent_row->remaining--;
+					rc = cam_sync_util_update_parent_state(
+						parent_row,
+						cam_sync_batch_states[j]);
+					if (rc)
+						invalid = true;
+
+					list_del_init(&parent_info->list);
+					kfree(parent_info);
+				}
+			}
+
+			if (invalid)
+				CAM_ERR(CAM_SYNC, "Invalid parent state %d",
+					parent_row->state);
+			else if (!parent_row->remaining)
+				cam_sync_util_dispatch_signaled_cb(
+					parent_id, parent_row->state,
+					event_cause);
+			spin_unlock_bh(&sync_dev->row_spinlocks[parent_id]);
+		}
+	}
+}
+
+int cam_sync_signal_batch(struct cam_sync_signal_param *signals,
+	uint32_t num_objs, uint32_t event_cause)
+{
+	struct list_head parents_lists[ARRAY_SIZE(cam_sync_batch_states)];
+	struct list_head obj_parents;
+	bool has_parents = false;
+	uint32_t i;
+	int j, rc = 0, obj_rc;
+
+	if (!signals || !num_objs)
+		return -EINVAL;
+
+	for (j = 0; j < ARRAY_SIZE(cam_sync_batch_states); j++)
+		INIT_LIST_HEAD(&parents_lists[j]);
+
+	for (i = 0; i < num_objs; i++) {
+		INIT_LIST_HEAD(&obj_parents);
+		obj_rc = cam_sync_signal_obj_util(signals[i].sync_obj,
+			signals[i].status, event_cause, &obj_parents);
+		if (obj_rc) {
+			if (!rc)
+				rc = obj_rc;
+			continue;
+		}
+
+		if (list_empty(&obj_parents))
+			continue;
+
+		/* status was validated while signaling the object */
+		for (j = 0; j < ARRAY_SIZE(cam_sync_batch_states); j++) {
+			if (cam_sync_batch_states[j] == signals[i].status) {
+				list_splice_tail_init(&obj_parents,
+					&parents_lists[j]);
+				has_parents = true;
+				break;
+			}
+		}
+	}
+
+	if (has_parents)
+		cam_sync_signal_parent_batch_util(event_cause, parents_lists);
+
+	return rc;
+}
+
 int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 {
 	int rc;
@@ -630,6 +748,77 @@ static int cam_sync_handle_signal(struct cam_private_ioctl_arg *k_ioctl)
 		CAM_SYNC_COMMON_SYNC_SIGNAL_EVENT);
 }
 
+static int cam_sync_handle_signal_batch(struct cam_private_ioctl_arg *k_ioctl)
+{
+	int rc = 0;
+	uint32_t i, num_signals = 0;
+	struct cam_sync_signal_batch signal_batch;
+	struct cam_sync_signal *user_signals;
+	struct cam_sync_signal_param *signals;
+
+	if (k_ioctl->size != sizeof(struct cam_sync_signal_batch))
+		return -EINVAL;
+
+	if (!k_ioctl->ioctl_ptr)
+		return -EINVAL;
+
+	if (copy_from_user(&signal_batch,
+		u64_to_user_ptr(k_ioctl->ioctl_ptr),
+		k_ioctl->size))
+		return -EFAULT;
+
+	if (!signal_batch.num_objs ||
+		signal_batch.num_objs >= CAM_SYNC_MAX_OBJS)
+		return -EINVAL;
+
+	user_signals = kcalloc(signal_batch.num_objs,
+		sizeof(*user_signals), GFP_KERNEL);
+	if (!user_signals)
+		return -ENOMEM;
+
+	signals = kcalloc(signal_batch.num_objs, sizeof(*signals), GFP_KERNEL);
+	if (!signals) {
+		rc = -ENOMEM;
+		goto free_user_signals;
+	}
+
+	if (copy_from_user(user_signals,
+		u64_to_user_ptr(signal_batch.signals),
+		signal_batch.num_objs * sizeof(*user_signals))) {
+		rc = -EFAULT;
+		goto free_signals;
+	}
+
+	for (i = 0; i < signal_batch.num_objs; i++) {
+		/* need to get ref for UMD signaled fences */
+		if (cam_sync_get_obj_ref(user_signals[i].sync_obj)) {
+			CAM_DBG(CAM_SYNC,
+				"Error: cannot signal an uninitialized sync obj = %d",
+				user_signals[i].sync_obj);
+			rc = -EINVAL;
+			continue;
+		}
+
+		signals[num_signals].sync_obj = user_signals[i].sync_obj;
+		signals[num_signals].status = user_signals[i].sync_state;
+		num_signals++;
+	}
+
+	if (num_signals) {
+		int batch_rc = cam_sync_signal_batch(signals, num_signals,
+			CAM_SYNC_COMMON_SYNC_SIGNAL_EVENT);
+
+		if (!rc)
+			rc = batch_rc;
+	}
+
+free_signals:
+	kfree(signals);
+free_user_signals:
+	kfree(user_signals);
+	return rc;
+}
+
 static int cam_sync_handle_merge(struct cam_private_ioctl_arg *k_ioctl)
 {
 	struct cam_sync_merge sync_merge;
@@ -1534,6 +1723,9 @@ static long cam_sync_dev_ioctl(struct file *filep, void *fh,
 	case CAM_SYNC_SIGNAL:
 		rc = cam_sync_handle_signal(&k_ioctl);
 		break;
+	case CAM_SYNC_SIGNAL_BATCH:
+		rc = cam_sync_handle_signal_batch(&k_ioctl);
+		break;
 	case CAM_SYNC_MERGE:
 		rc = cam_sync_handle_merge(&k_ioctl);
 		break;
@@ -1805,6 +1997,20 @@ static void cam_sync_init_entity(struct sync_device *sync_dev)
 }
 #endif
 
+static int cam_sync_cb_latency_show(struct seq_file *m, void *unused)
+{
+	struct cam_sync_cb_latency *stats = &sync_dev->cb_latency;
+	u64 count = atomic64_read(&stats->count);
+	u64 total_us = atomic64_read(&stats->total_us);
+
+	seq_printf(m, "count: %llu avg_us: %llu max_us: %lld\n",
+		count, count ? div64_u64(total_us, count) : 0,
+		atomic64_read(&stats->max_us));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(cam_sync_cb_latency);
+
 static int cam_sync_create_debugfs(void)
 {
 	int rc = 0;
@@ -1824,6 +2030,8 @@ static int cam_sync_create_debugfs(void)
 
 	debugfs_create_bool("trigger_cb_without_switch", 0644,
 		sync_dev->dentry, &trigger_cb_without_switch);
+	debugfs_create_file("cb_latency", 0444,
+		sync_dev->dentry, NULL, &cam_sync_cb_latency_fops);
 
 end:
 	return rc;
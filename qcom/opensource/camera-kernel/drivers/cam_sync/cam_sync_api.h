@@ -82,6 +82,34 @@ int cam_sync_deregister_callback(sync_callback cb_func,
  */
 int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t evt_param);
 
+/**
+ * struct cam_sync_signal_param - Single entry of a batched signal
+ *
+ * @sync_obj: int referencing the sync object
+ * @status:   Status of the signaling
+ */
+struct cam_sync_signal_param {
+	int32_t  sync_obj;
+	uint32_t status;
+};
+
+/**
+ * @brief: Signals multiple sync objects in one call.
+ *
+ * Each object is signaled as with cam_sync_signal(). Merged parents of
+ * the signaled objects are resolved once for the whole batch, so a parent
+ * whose children are all in the batch is locked and dispatched only once.
+ * An object that fails validation does not stop the rest of the batch.
+ *
+ * @param signals:   Array of sync objects and their signal status
+ * @param num_objs:  Number of entries in the array
+ * @param evt_param: Event parameter used for all objects of the batch
+ *
+ * @return Status of operation. First error encountered, zero otherwise.
+ */
+int cam_sync_signal_batch(struct cam_sync_signal_param *signals,
+	uint32_t num_objs, uint32_t evt_param);
+
 /**
  * @brief: Merges multiple sync objects
  *
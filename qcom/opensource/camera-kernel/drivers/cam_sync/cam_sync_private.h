@@ -192,6 +192,19 @@ struct cam_signalable_info {
 	struct list_head list;
 };
 
+/**
+ * struct cam_sync_cb_latency - Kernel callback dispatch latency statistics
+ *
+ * @count    : Number of kernel callbacks dispatched
+ * @total_us : Sum of signal to callback latencies in microseconds
+ * @max_us   : Largest signal to callback latency in microseconds
+ */
+struct cam_sync_cb_latency {
+	atomic64_t count;
+	atomic64_t total_us;
+	atomic64_t max_us;
+};
+
 /**
  * struct sync_device - Internal struct to book keep sync driver details
  *
@@ -207,6 +220,7 @@ struct cam_signalable_info {
  * @bitmap          : Bitmap representation of all sync objects
  * @params          : Parameters for synx call back registration
  * @version         : version support
+ * @cb_latency      : Kernel callback dispatch latency statistics
  */
 struct sync_device {
 	struct video_device *vdev;
@@ -224,6 +238,7 @@ struct sync_device {
 	struct synx_register_params params;
 #endif
 	uint32_t version;
+	struct cam_sync_cb_latency cb_latency;
 };
 
 
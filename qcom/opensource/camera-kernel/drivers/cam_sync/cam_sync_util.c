@@ -307,6 +307,24 @@ int cam_sync_deinit_object(struct sync_table_row *table, uint32_t idx,
 	return 0;
 }
 
+static void cam_sync_util_record_cb_latency(ktime_t scheduled_ts)
+{
+	struct cam_sync_cb_latency *stats = &sync_dev->cb_latency;
+	s64 latency_us = ktime_us_delta(ktime_get(), scheduled_ts);
+	s64 max_us, old;
+
+	atomic64_inc(&stats->count);
+	atomic64_add(latency_us, &stats->total_us);
+
+	max_us = atomic64_read(&stats->max_us);
+	while (latency_us > max_us) {
+		old = atomic64_cmpxchg(&stats->max_us, max_us, latency_us);
+		if (old == max_us)
+			break;
+		max_us = old;
+	}
+}
+
 void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work)
 {
 	struct sync_callback_info *cb_info = container_of(cb_dispatch_work,
@@ -319,6 +337,7 @@ void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work)
 		"cam_sync_workq", "schedule", cb,
 		cb_info->workq_scheduled_ts,
 		CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
+	cam_sync_util_record_cb_latency(cb_info->workq_scheduled_ts);
 	sync_data(cb_info->sync_obj, cb_info->status, cb_info->cb_data);
 
 	kfree(cb_info);
@@ -346,6 +365,7 @@ void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
 		temp_sync_cb, &signalable_row->callback_list, list) {
 		sync_cb->status = status;
 		list_del_init(&sync_cb->list);
+		sync_cb->workq_scheduled_ts = ktime_get();
 		queue_work(sync_dev->work_queue,
 			&sync_cb->cb_dispatch_work);
 	}
@@ -437,7 +457,15 @@ int cam_sync_util_update_parent_state(struct sync_table_row *parent_row,
 		break;
 
 	case CAM_SYNC_STATE_SIGNALED_ERROR:
+		break;
+
 	case CAM_SYNC_STATE_SIGNALED_CANCEL:
+		/*
+		 * An error of any child overrides a cancel, so the final
+		 * parent state does not depend on the order children signal
+		 */
+		if (new_state == CAM_SYNC_STATE_SIGNALED_ERROR)
+			parent_row->state = new_state;
 		break;
 
 	case CAM_SYNC_STATE_INVALID:
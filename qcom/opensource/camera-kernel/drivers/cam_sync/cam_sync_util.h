@@ -129,7 +129,8 @@ void cam_sync_util_send_v4l2_event(uint32_t id,
 
 /**
  * @brief: Function which gets the next state of the sync object based on the
- *         current state and the new state
+ *         current state and the new state. ERROR takes precedence over
+ *         CANCEL, which takes precedence over SUCCESS.
  *
  * @param current_state : Current state of the sync object
  * @param new_state     : New state of the sync object
@@ -9,6 +9,7 @@
 
 #include <linux/types.h>
 #include <linux/kernel.h>
+#include <linux/export.h>
 
 #define CAM_BITS_MASK_SHIFT(x, mask, shift) (((x) & (mask)) >> shift)
 #define CAM_36BIT_INTF_GET_IOVA_BASE(iova) ((iova) >> 8)
@@ -37,6 +38,16 @@
 
 #define CAM_TRIGGER_PANIC(format, args...) panic("CAMERA - " format "\n", ##args)
 
+/*
+ * Internal helpers exercised by the KUnit test modules are only exported
+ * when those modules are built (CONFIG_SPECTRA_KUNIT_TEST).
+ */
+#if IS_ENABLED(CONFIG_SPECTRA_KUNIT_TEST)
+#define CAM_EXPORT_FOR_KUNIT(sym) EXPORT_SYMBOL(sym)
+#else
+#define CAM_EXPORT_FOR_KUNIT(sym)
+#endif
+
 #define CAM_GET_TIMESTAMP(timestamp) ktime_get_real_ts64(&(timestamp))
 #define CAM_GET_TIMESTAMP_DIFF_IN_MICRO(ts_start, ts_end, diff_microsec)                     \
 ({                                                                                           \
@@ -11,8 +11,10 @@
 #include "cam_packet_util.h"
 #include "cam_debug_util.h"
 #include "cam_common_util.h"
+#include "cam_trace.h"
 
 #define CAM_UNIQUE_SRC_HDL_MAX 50
+#define CAM_UNIQUE_DST_HDL_MAX 16
 #define CAM_PRESIL_UNIQUE_HDL_MAX 50
 
 struct cam_patch_unique_src_buf_tbl {
@@ -22,6 +24,12 @@ struct cam_patch_unique_src_buf_tbl {
 	uint32_t      flags;
 };
 
+struct cam_patch_unique_dst_buf_tbl {
+	int32_t       hdl;
+	uintptr_t     cpu_addr;
+	size_t        buf_len;
+};
+
 int cam_packet_util_get_packet_addr(struct cam_packet **packet,
 	uint64_t packet_handle, uint32_t offset)
 {
@@ -360,6 +368,49 @@ static int cam_packet_util_get_patch_iova(
 	return rc;
 }
 
+/*
+ * Resolve the kernel address of a patch destination buffer. Nearly all
+ * patches in a packet target the same few command buffers, so each distinct
+ * handle is looked up once and its reference is held until all patches of
+ * the packet are applied. Handles beyond the table size are not cached and
+ * the caller has to drop the reference itself when @cached is false.
+ */
+static int cam_packet_util_get_patch_dst(
+	struct cam_patch_unique_dst_buf_tbl *tbl, int *num_entries,
+	int32_t buf_hdl, uintptr_t *cpu_addr, size_t *buf_len, bool *cached)
+{
+	int idx;
+	int rc;
+
+	for (idx = 0; idx < *num_entries; idx++) {
+		if (tbl[idx].hdl == buf_hdl) {
+			*cpu_addr = tbl[idx].cpu_addr;
+			*buf_len = tbl[idx].buf_len;
+			*cached = true;
+			return 0;
+		}
+	}
+
+	rc = cam_mem_get_cpu_buf(buf_hdl, cpu_addr, buf_len);
+	if (rc < 0)
+		return rc;
+
+	if (!*cpu_addr || (*buf_len == 0)) {
+		cam_mem_put_cpu_buf(buf_hdl);
+		return -EINVAL;
+	}
+
+	*cached = (*num_entries < CAM_UNIQUE_DST_HDL_MAX);
+	if (*cached) {
+		tbl[*num_entries].hdl = buf_hdl;
+		tbl[*num_entries].cpu_addr = *cpu_addr;
+		tbl[*num_entries].buf_len = *buf_len;
+		(*num_entries)++;
+	}
+
+	return 0;
+}
+
 int cam_packet_util_process_patches(struct cam_packet *packet,
 	int32_t iommu_hdl, int32_t sec_mmu_hdl, bool exp_mem)
 {
@@ -372,10 +423,15 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 	size_t     src_buf_size;
 	int        i  = 0;
 	int        rc = 0;
+	int        num_dst = 0;
+	bool       dst_cached;
 	uint32_t   flags = 0;
 	int32_t    hdl;
+	ktime_t    start = ktime_get();
 	struct cam_patch_unique_src_buf_tbl
 		tbl[CAM_UNIQUE_SRC_HDL_MAX];
+	struct cam_patch_unique_dst_buf_tbl
+		dst_tbl[CAM_UNIQUE_DST_HDL_MAX];
 
 	memset(tbl, 0, CAM_UNIQUE_SRC_HDL_MAX *
 		sizeof(struct cam_patch_unique_src_buf_tbl));
@@ -398,23 +454,25 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 			CAM_ERR(CAM_UTIL,
 				"get_iova failed for patch[%d], src_buf_hdl: 0x%x: rc: %d",
 				i, patch_desc[i].src_buf_hdl, rc);
-			return rc;
+			goto put_dst;
 		}
 
 		if ((size_t)patch_desc[i].src_offset >= src_buf_size) {
 			CAM_ERR(CAM_UTIL,
 				"Invalid src buf patch offset: patch:src_offset: 0x%x, src_buf_size: %zu",
 				patch_desc[i].src_offset, src_buf_size);
-			return -EINVAL;
+			rc = -EINVAL;
+			goto put_dst;
 		}
 
 		temp = iova_addr;
 
-		rc = cam_mem_get_cpu_buf(patch_desc[i].dst_buf_hdl,
-			&cpu_addr, &dst_buf_len);
-		if (rc < 0 || !cpu_addr || (dst_buf_len == 0)) {
+		rc = cam_packet_util_get_patch_dst(dst_tbl, &num_dst,
+			patch_desc[i].dst_buf_hdl, &cpu_addr, &dst_buf_len,
+			&dst_cached);
+		if (rc) {
 			CAM_ERR(CAM_UTIL, "unable to get dst buf address");
-			return rc;
+			goto put_dst;
 		}
 		dst_cpu_addr = (uint32_t *)cpu_addr;
 
@@ -427,8 +485,10 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 			(size_t)patch_desc[i].dst_offset)) {
 			CAM_ERR(CAM_UTIL,
 				"Invalid dst buf patch offset");
-			cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
-			return -EINVAL;
+			if (!dst_cached)
+				cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
+			rc = -EINVAL;
+			goto put_dst;
 		}
 
 		dst_cpu_addr = (uint32_t *)((uint8_t *)dst_cpu_addr +
@@ -457,9 +517,17 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 			CAM_BOOL_TO_YESNO(flags & CAM_MEM_FLAG_HW_SHARED_ACCESS),
 			CAM_BOOL_TO_YESNO(flags & CAM_MEM_FLAG_CMD_BUF_TYPE),
 			CAM_BOOL_TO_YESNO(flags & CAM_MEM_FLAG_HW_AND_CDM_OR_SHARED));
-		cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
+		if (!dst_cached)
+			cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
 	}
 
+put_dst:
+	for (i = 0; i < num_dst; i++)
+		cam_mem_put_cpu_buf(dst_tbl[i].hdl);
+
+	trace_cam_packet_patch(packet->num_patches, num_dst,
+		ktime_us_delta(ktime_get(), start), rc);
+
 	return rc;
 }
 
@@ -402,6 +402,29 @@ TRACE_EVENT(cam_cdm_cb,
 	)
 );
 
+TRACE_EVENT(cam_packet_patch,
+	TP_PROTO(uint32_t num_patches, uint32_t num_dst_bufs,
+		int64_t duration_us, int rc),
+	TP_ARGS(num_patches, num_dst_bufs, duration_us, rc),
+	TP_STRUCT__entry(
+		__field(uint32_t, num_patches)
+		__field(uint32_t, num_dst_bufs)
+		__field(int64_t, duration_us)
+		__field(int, rc)
+	),
+	TP_fast_assign(
+		__entry->num_patches = num_patches;
+		__entry->num_dst_bufs = num_dst_bufs;
+		__entry->duration_us = duration_us;
+		__entry->rc = rc;
+	),
+	TP_printk(
+		"patches=%u dst_bufs=%u duration_us=%lld rc=%d",
+			__entry->num_patches, __entry->num_dst_bufs,
+			__entry->duration_us, __entry->rc
+	)
+);
+
 #ifdef OPLUS_FEATURE_CAMERA_COMMON
 #include "oplus_cam_trace.h"
 #endif
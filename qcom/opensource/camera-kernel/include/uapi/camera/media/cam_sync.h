@@ -202,6 +202,19 @@ struct cam_sync_signal {
 	__u32 sync_state;
 };
 
+/**
+ * struct cam_sync_signal_batch - Batched sync object signaling struct
+ *
+ * @signals:    Pointer to an array of struct cam_sync_signal
+ * @num_objs:   Number of entries in the array
+ * @reserved:   Reserved
+ */
+struct cam_sync_signal_batch {
+	__u64 signals;
+	__u32 num_objs;
+	__u32 reserved;
+};
+
 /**
  * struct cam_sync_merge - Merge information for sync objects
  *
@@ -375,6 +388,7 @@ struct cam_private_ioctl_arg {
 #define CAM_SYNC_REGISTER_PAYLOAD                4
 #define CAM_SYNC_DEREGISTER_PAYLOAD              5
 #define CAM_SYNC_WAIT                            6
+#define CAM_SYNC_SIGNAL_BATCH                    7
 
 /* Generic fence [sync/dma/synx] IOCTL cmds */
 #define CAM_GENERIC_FENCE_CREATE                 11
@@ -17,6 +17,8 @@
 #include "sde_dbg.h"
 #include "sde_dsc_helper.h"
 #include "sde_vdc_helper.h"
+#include "sde_trace.h"
+#include "dsi_ctrl.h"
 
 #ifdef OPLUS_FEATURE_DISPLAY
 #include <soc/oplus/system/boot_mode.h>
@@ -27,7 +29,6 @@
 #include "../oplus/oplus_display_panel_feature.h"
 #include "../oplus/oplus_display_interface.h"
 #include "../oplus/oplus_display_panel_seed.h"
-#include "sde_trace.h"
 #include <soc/oplus/system/oplus_project.h>
 #endif /* OPLUS_FEATURE_DISPLAY */
 
@@ -581,9 +582,10 @@ int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 	int rc = 0, i = 0;
 	ssize_t len;
 	struct dsi_cmd_desc *cmds;
-	u32 count;
+	u32 count, kickoffs = 0;
 	enum dsi_cmd_set_state state;
 	struct dsi_display_mode *mode;
+	ktime_t start = ktime_get();
 
 	if (!panel || !panel->cur_mode)
 		return -EINVAL;
@@ -641,6 +643,9 @@ int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 			DSI_ERR("failed to set cmds(%d), rc=%d\n", type, rc);
 			goto error;
 		}
+
+		if (!(cmds->msg.flags & MIPI_DSI_MSG_BATCH_COMMAND))
+			kickoffs++;
 #ifdef OPLUS_FEATURE_DISPLAY_ONSCREENFINGERPRINT
 		if (oplus_ofp_is_supported() && oplus_ofp_optical_new_solution_is_enabled()) {
 			oplus_ofp_cmd_post_wait(mode, cmds, type);
@@ -665,6 +670,8 @@ int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 	oplus_panel_cmdq_pack_handle(panel, type, false);
 #endif /* OPLUS_FEATURE_DISPLAY */
 
+	trace_dsi_panel_tx_cmd_set(type, count, kickoffs,
+			ktime_to_ns(ktime_sub(ktime_get(), start)));
 error:
 #ifdef OPLUS_FEATURE_DISPLAY
 	if (rc) {
@@ -1395,6 +1402,8 @@ static int dsi_panel_parse_misc_host_config(struct dsi_host_common_cfg *host,
 
 	host->force_hs_clk_lane = utils->read_bool(utils->data,
 					"qcom,mdss-dsi-force-clock-lane-hs");
+	host->cmd_batch = utils->read_bool(utils->data,
+					"qcom,mdss-dsi-cmd-batch-enable");
 	panel_cphy_mode = utils->read_bool(utils->data,
 					"qcom,panel-cphy-mode");
 	host->phy_type = panel_cphy_mode ? DSI_PHY_TYPE_CPHY
@@ -2560,6 +2569,77 @@ int dsi_panel_alloc_cmd_packets(struct dsi_panel_cmd_set *cmd,
 	return 0;
 }
 
+static bool dsi_panel_cmd_is_read(const struct dsi_cmd_desc *cmd)
+{
+	switch (cmd->msg.type) {
+	case MIPI_DSI_DCS_READ:
+	case MIPI_DSI_GENERIC_READ_REQUEST_0_PARAM:
+	case MIPI_DSI_GENERIC_READ_REQUEST_1_PARAM:
+	case MIPI_DSI_GENERIC_READ_REQUEST_2_PARAM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Size a command takes in the DMA command buffer: 4 byte header plus the
+ * payload padded to 4 bytes for long packets.
+ */
+static u32 dsi_panel_cmd_dma_len(const struct dsi_cmd_desc *cmd)
+{
+	if (mipi_dsi_packet_format_is_long(cmd->msg.type))
+		return 4 + ALIGN(cmd->msg.tx_len, 4);
+
+	return 4;
+}
+
+static bool dsi_panel_cmd_can_batch(const struct dsi_cmd_desc *cmd)
+{
+	return !cmd->post_wait_ms && !dsi_panel_cmd_is_read(cmd) &&
+		cmd->msg.tx_len <= DSI_EMBEDDED_MODE_DMA_MAX_SIZE_BYTES;
+}
+
+/**
+ * dsi_panel_batch_cmd_set - mark runs of commands in a set for batching
+ * @set: command set to update
+ *
+ * Consecutive write commands which need no post wait are flagged with
+ * MIPI_DSI_MSG_BATCH_COMMAND so that the controller accumulates them in
+ * the command DMA buffer and triggers a single transfer for the run.
+ * A run ends at the first command with a post wait, a read, a command
+ * targeting a different controller, or when the DMA buffer would
+ * overflow. Commands already batched by the panel dtsi are left alone.
+ */
+static void dsi_panel_batch_cmd_set(struct dsi_panel_cmd_set *set)
+{
+	struct dsi_cmd_desc *cmd, *next;
+	u32 i, batch_len = 0;
+
+	for (i = 0; i + 1 < set->count; i++) {
+		cmd = &set->cmds[i];
+		next = &set->cmds[i + 1];
+
+		batch_len += dsi_panel_cmd_dma_len(cmd);
+		if (cmd->msg.flags & MIPI_DSI_MSG_BATCH_COMMAND)
+			continue;
+
+		if (!dsi_panel_cmd_can_batch(cmd) ||
+				!dsi_panel_cmd_can_batch(next) ||
+				cmd->msg.channel != next->msg.channel ||
+				cmd->ctrl != next->ctrl ||
+				((cmd->msg.flags ^ next->msg.flags) &
+				 MIPI_DSI_MSG_UNICAST_COMMAND) ||
+				(batch_len + dsi_panel_cmd_dma_len(next)) > SZ_4K) {
+			batch_len = 0;
+			continue;
+		}
+
+		cmd->msg.flags |= MIPI_DSI_MSG_BATCH_COMMAND;
+		cmd->last_command = false;
+	}
+}
+
 static int dsi_panel_parse_cmd_sets_sub(struct dsi_panel_cmd_set *cmd,
 					enum dsi_cmd_set_type type,
 					struct dsi_parser_utils *utils)
@@ -2633,7 +2713,7 @@ error:
 
 static int dsi_panel_parse_cmd_sets(
 		struct dsi_display_mode_priv_info *priv_info,
-		struct dsi_parser_utils *utils)
+		struct dsi_parser_utils *utils, bool cmd_batch)
 {
 	int rc = 0;
 	struct dsi_panel_cmd_set *set;
@@ -2659,6 +2739,8 @@ static int dsi_panel_parse_cmd_sets(
 			rc = dsi_panel_parse_cmd_sets_sub(set, i, utils);
 			if (rc)
 				DSI_DEBUG("failed to parse set %d\n", i);
+			else if (cmd_batch)
+				dsi_panel_batch_cmd_set(set);
 		}
 	}
 
@@ -4897,7 +4979,8 @@ int dsi_panel_get_mode(struct dsi_panel *panel,
 			goto parse_fail;
 		}
 
-		rc = dsi_panel_parse_cmd_sets(prv_info, utils);
+		rc = dsi_panel_parse_cmd_sets(prv_info, utils,
+				panel->host_config.cmd_batch);
 		if (rc) {
 			DSI_ERR("failed to parse command sets, rc=%d\n", rc);
 			goto parse_fail;
@@ -1084,11 +1084,48 @@ static int _sde_format_populate_addrs_linear(
 	return 0;
 }
 
-int sde_format_populate_layout(
+static bool _sde_format_layout_cache_hit(
+		struct sde_format_layout_cache *cache,
+		const struct sde_format *fmt,
+		struct drm_framebuffer *fb)
+{
+	int i;
+
+	if (!cache || !cache->valid || cache->format != fmt ||
+			cache->width != fb->width ||
+			cache->height != fb->height)
+		return false;
+
+	for (i = 0; i < SDE_MAX_PLANES; ++i)
+		if (cache->pitches[i] != fb->pitches[i])
+			return false;
+
+	return true;
+}
+
+static void _sde_format_layout_cache_store(
+		struct sde_format_layout_cache *cache,
+		struct drm_framebuffer *fb,
+		const struct sde_hw_fmt_layout *layout)
+{
+	int i;
+
+	cache->format = layout->format;
+	cache->width = fb->width;
+	cache->height = fb->height;
+	for (i = 0; i < SDE_MAX_PLANES; ++i)
+		cache->pitches[i] = fb->pitches[i];
+	cache->sizes = *layout;
+	cache->valid = true;
+}
+
+int sde_format_populate_layout_cached(
 		struct msm_gem_address_space *aspace,
 		struct drm_framebuffer *fb,
-		struct sde_hw_fmt_layout *layout)
+		struct sde_hw_fmt_layout *layout,
+		struct sde_format_layout_cache *cache)
 {
+	const struct sde_format *fmt;
 	uint32_t plane_addr[SDE_MAX_PLANES];
 	int i, ret;
 
@@ -1103,13 +1140,21 @@ int sde_format_populate_layout(
 		return -ERANGE;
 	}
 
-	layout->format = to_sde_format(msm_framebuffer_format(fb));
+	fmt = to_sde_format(msm_framebuffer_format(fb));
 
-	/* Populate the plane sizes etc via get_format */
-	ret = sde_format_get_plane_sizes(layout->format, fb->width, fb->height,
-			layout, fb->pitches);
-	if (ret)
-		return ret;
+	if (_sde_format_layout_cache_hit(cache, fmt, fb)) {
+		/* same fb geometry as last time, reuse the plane sizes */
+		*layout = cache->sizes;
+	} else {
+		/* Populate the plane sizes etc via get_format */
+		ret = sde_format_get_plane_sizes(fmt, fb->width, fb->height,
+				layout, fb->pitches);
+		if (ret)
+			return ret;
+
+		if (cache)
+			_sde_format_layout_cache_store(cache, fb, layout);
+	}
 
 	for (i = 0; i < SDE_MAX_PLANES; ++i)
 		plane_addr[i] = layout->plane_addr[i];
@@ -1128,6 +1173,14 @@ int sde_format_populate_layout(
 	return ret;
 }
 
+int sde_format_populate_layout(
+		struct msm_gem_address_space *aspace,
+		struct drm_framebuffer *fb,
+		struct sde_hw_fmt_layout *layout)
+{
+	return sde_format_populate_layout_cached(aspace, fb, layout, NULL);
+}
+
 int sde_format_check_modified_format(
 		const struct msm_kms *kms,
 		const struct msm_format *msm_fmt,
@@ -10,6 +10,24 @@
 #include "msm_gem.h"
 #include "sde_hw_mdss.h"
 
+/**
+ * struct sde_format_layout_cache - plane sizes derived for a framebuffer shape
+ * @valid:   true if @sizes holds a computed layout
+ * @format:  format the layout was computed for
+ * @width:   framebuffer width the layout was computed for
+ * @height:  framebuffer height the layout was computed for
+ * @pitches: framebuffer pitches the layout was computed for
+ * @sizes:   computed layout, plane addresses are left cleared
+ */
+struct sde_format_layout_cache {
+	bool valid;
+	const struct sde_format *format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t pitches[SDE_MAX_PLANES];
+	struct sde_hw_fmt_layout sizes;
+};
+
 /**
  * sde_get_sde_format_ext() - Returns sde format structure pointer.
  * @format:          DRM FourCC Code
@@ -96,6 +114,23 @@ int sde_format_populate_layout(
 		struct drm_framebuffer *fb,
 		struct sde_hw_fmt_layout *fmtl);
 
+/**
+ * sde_format_populate_layout_cached - populate the given format layout,
+ *                     reusing the plane sizes from @cache when the fb
+ *                     format, dimensions and pitches are unchanged
+ * @aspace:            address space pointer
+ * @fb:                framebuffer pointer
+ * @fmtl:              format layout structure to populate
+ * @cache:             layout cache to look up and update, may be NULL
+ *
+ * Return: same as sde_format_populate_layout
+ */
+int sde_format_populate_layout_cached(
+		struct msm_gem_address_space *aspace,
+		struct drm_framebuffer *fb,
+		struct sde_hw_fmt_layout *fmtl,
+		struct sde_format_layout_cache *cache);
+
 /**
  * sde_format_get_framebuffer_size - get framebuffer memory size
  * @format:            DRM pixel format
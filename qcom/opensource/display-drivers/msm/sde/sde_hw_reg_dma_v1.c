@@ -1219,6 +1219,7 @@ static int dealloc_reg_dma_v1(struct sde_reg_dma_buffer *dma_buf)
 		mutex_unlock(&reg_dma->drm_dev->struct_mutex);
 	}
 
+	sde_reg_dma_lut_cache_free(dma_buf);
 	kfree(dma_buf);
 	return 0;
 }
@@ -1232,6 +1233,7 @@ static int reset_reg_dma_buffer_v1(struct sde_reg_dma_buffer *lut_buf)
 	lut_buf->ops_completed = 0;
 	lut_buf->next_op_allowed = DECODE_SEL_OP;
 	lut_buf->abs_write_cnt = 0;
+	lut_buf->lut_valid = false;
 	return 0;
 }
 
@@ -122,6 +122,9 @@
 #define LOG_FEATURE_OFF SDE_EVT32(ctx->idx, 0)
 #define LOG_FEATURE_ON SDE_EVT32(ctx->idx, 1)
 
+/* Packing inputs besides the blob that the LUT cache must match on */
+#define REG_DMA_LUT_TAG(blk, op_mode) (((u64)(op_mode) << 32) | (u32)(blk))
+
 enum ltm_vlut_ops_bitmask {
 	ltm_unsharp = BIT(0),
 	ltm_dither = BIT(1),
@@ -753,6 +756,10 @@ static void reg_dmav1_setup_dspp_3d_gamutv4_common(struct sde_hw_dspp *ctx,
 	}
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[GAMUT][ctx->idx],
+			REG_DMA_LUT_TAG(blk, op_mode), payload, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[GAMUT][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, GAMUT, dspp_buf[GAMUT][ctx->idx]);
@@ -815,7 +822,10 @@ static void reg_dmav1_setup_dspp_3d_gamutv4_common(struct sde_hw_dspp *ctx,
 		DRM_ERROR("opmode write single reg failed ret %d\n", rc);
 		return;
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[GAMUT][ctx->idx],
+			REG_DMA_LUT_TAG(blk, op_mode));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl, dspp_buf[GAMUT][ctx->idx],
 			REG_DMA_WRITE, DMA_CTL_QUEUE0, WRITE_IMMEDIATE, GAMUT);
 	LOG_FEATURE_ON;
@@ -917,6 +927,10 @@ void reg_dmav1_setup_dspp_gcv18(struct sde_hw_dspp *ctx, void *cfg)
 
 	lut_cfg = hw_cfg->payload;
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[GC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), lut_cfg, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[GC][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, GC, dspp_buf[GC][ctx->idx]);
@@ -975,7 +989,10 @@ void reg_dmav1_setup_dspp_gcv18(struct sde_hw_dspp *ctx, void *cfg)
 		DRM_ERROR("enabling gamma correction failed ret %d\n", rc);
 		return;
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[GC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl, dspp_buf[GC][ctx->idx],
 			REG_DMA_WRITE, DMA_CTL_QUEUE0, WRITE_IMMEDIATE, GC);
 	LOG_FEATURE_ON;
@@ -1086,6 +1103,11 @@ void reg_dmav1_setup_dspp_igcv31(struct sde_hw_dspp *ctx, void *cfg)
 	lut_cfg = hw_cfg->payload;
 
 	dma_ops = sde_reg_dma_get_ops();
+	/* Hash before the LUT is masked in place below */
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[IGC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), lut_cfg, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[IGC][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, DSPP_IGC, IGC, dspp_buf[IGC][ctx->idx]);
@@ -1154,7 +1176,10 @@ void reg_dmav1_setup_dspp_igcv31(struct sde_hw_dspp *ctx, void *cfg)
 		DRM_ERROR("setting opcode failed ret %d\n", rc);
 		return;
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[IGC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl, dspp_buf[IGC][ctx->idx],
 			REG_DMA_WRITE, DMA_CTL_QUEUE0, WRITE_IMMEDIATE, IGC);
 	LOG_FEATURE_ON;
@@ -1336,6 +1361,10 @@ void reg_dmav1_setup_dspp_pcc_common(struct sde_hw_dspp *ctx, void *cfg)
 
 	pcc_cfg = hw_cfg->payload;
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[PCC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), pcc_cfg, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[PCC][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, PCC, dspp_buf[PCC][ctx->idx]);
@@ -1409,7 +1438,10 @@ void reg_dmav1_setup_dspp_pcc_common(struct sde_hw_dspp *ctx, void *cfg)
 		DRM_ERROR("setting opcode failed ret %d\n", rc);
 		goto exit;
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[PCC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl, dspp_buf[PCC][ctx->idx],
 			REG_DMA_WRITE, DMA_CTL_QUEUE0, WRITE_IMMEDIATE, PCC);
 	LOG_FEATURE_ON;
@@ -1675,6 +1707,10 @@ void reg_dmav1_setup_dspp_sixzonev17(struct sde_hw_dspp *ctx, void *cfg)
 	sixzone = hw_cfg->payload;
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[SIX_ZONE][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), sixzone, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[SIX_ZONE][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, SIX_ZONE,
@@ -1766,7 +1802,10 @@ void reg_dmav1_setup_dspp_sixzonev17(struct sde_hw_dspp *ctx, void *cfg)
 			return;
 		}
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[SIX_ZONE][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl,
 		dspp_buf[SIX_ZONE][ctx->idx],
 		REG_DMA_WRITE, DMA_CTL_QUEUE0, WRITE_IMMEDIATE, SIX_ZONE);
@@ -1796,6 +1835,10 @@ void reg_dmav2_setup_dspp_sixzonev2(struct sde_hw_dspp *ctx, void *cfg)
 	sixzone = hw_cfg->payload;
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[SIX_ZONE][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), sixzone, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[SIX_ZONE][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, SIX_ZONE,
@@ -1961,7 +2004,10 @@ void reg_dmav2_setup_dspp_sixzonev2(struct sde_hw_dspp *ctx, void *cfg)
 			goto exit;
 		}
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[SIX_ZONE][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	LOG_FEATURE_ON;
 	_perform_sbdma_kickoff(ctx, hw_cfg, dma_ops, blk, SIX_ZONE);
 
@@ -2044,6 +2090,10 @@ static void __setup_dspp_memcol(struct sde_hw_dspp *ctx,
 	}
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[type][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), hw_cfg->payload, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[type][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, type, dspp_buf[type][ctx->idx]);
@@ -2128,7 +2178,10 @@ static void __setup_dspp_memcol(struct sde_hw_dspp *ctx,
 			return;
 		}
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[type][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl,
 		dspp_buf[type][ctx->idx],
 		REG_DMA_WRITE, DMA_CTL_QUEUE0, WRITE_IMMEDIATE, type);
@@ -2474,6 +2527,7 @@ void reg_dmav1_setup_vig_gamutv5(struct sde_hw_pipe *ctx, void *cfg)
 	u32 gamut_base = ctx->cap->sblk->gamut_blk.regdma_base;
 	bool use_2nd_memory = false;
 	enum sde_sspp_multirect_index idx = SDE_SSPP_RECT_0;
+	u64 lut_tag;
 
 	rc = reg_dma_sspp_check(ctx, cfg, GAMUT, idx);
 	if (rc)
@@ -2493,6 +2547,12 @@ void reg_dmav1_setup_vig_gamutv5(struct sde_hw_pipe *ctx, void *cfg)
 		return;
 	}
 	op_mode = SDE_REG_READ(&ctx->hw, ctx->cap->sblk->gamut_blk.base);
+	/*
+	 * Tables are ping-ponged on every update, so look up the packing of
+	 * the table in use. Rewriting it with the same values is harmless.
+	 */
+	lut_tag = REG_DMA_LUT_TAG(sspp_mapping[ctx->idx],
+			op_mode & (BIT(5) - 1));
 	payload = hw_cfg->payload;
 	rc = sde_gamut_get_mode_info(SSPP, payload, &tbl_len, &tbl_off,
 			&op_mode, &scale_off);
@@ -2502,6 +2562,10 @@ void reg_dmav1_setup_vig_gamutv5(struct sde_hw_pipe *ctx, void *cfg)
 	}
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(sspp_buf[idx][GAMUT][ctx->idx], lut_tag,
+			payload, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(sspp_buf[idx][GAMUT][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, sspp_mapping[ctx->idx], GAMUT,
@@ -2565,7 +2629,10 @@ void reg_dmav1_setup_vig_gamutv5(struct sde_hw_pipe *ctx, void *cfg)
 		DRM_ERROR("opmode write single reg failed ret %d\n", rc);
 		return;
 	}
+	sde_reg_dma_lut_cache_commit(sspp_buf[idx][GAMUT][ctx->idx],
+			REG_DMA_LUT_TAG(sspp_mapping[ctx->idx], op_mode));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl,
 			sspp_buf[idx][GAMUT][ctx->idx], REG_DMA_WRITE,
 			DMA_CTL_QUEUE0, WRITE_IMMEDIATE, GAMUT);
@@ -4422,6 +4489,10 @@ void reg_dmav2_setup_dspp_igcv4(struct sde_hw_dspp *ctx, void *cfg)
 	lut_cfg = hw_cfg->payload;
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[IGC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0), lut_cfg, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[IGC][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, IGC, dspp_buf[IGC][ctx->idx]);
@@ -4496,7 +4567,10 @@ void reg_dmav2_setup_dspp_igcv4(struct sde_hw_dspp *ctx, void *cfg)
 		DRM_ERROR("setting opcode failed ret %d\n", rc);
 		goto exit;
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[IGC][ctx->idx],
+			REG_DMA_LUT_TAG(blk, 0));
 
+kickoff:
 	LOG_FEATURE_ON;
 	_perform_sbdma_kickoff(ctx, hw_cfg, dma_ops, blk, IGC);
 
@@ -4555,7 +4629,7 @@ void reg_dmav2_setup_dspp_3d_gamutv43(struct sde_hw_dspp *ctx, void *cfg)
 	int rc;
 	u32 num_of_mixers, blk = 0, i, j, k = 0, len, tmp;
 	u32 op_mode, scale_offset, scale_tbl_offset, transfer_size_bytes;
-	u16 *data;
+	u16 *data = NULL;
 	u32 scale_off[GAMUT_3D_SCALE_OFF_TBL_NUM][GAMUT_3D_SCALE_OFF_SZ];
 
 	rc = reg_dma_dspp_check(ctx, cfg, GAMUT);
@@ -4603,6 +4677,10 @@ void reg_dmav2_setup_dspp_3d_gamutv43(struct sde_hw_dspp *ctx, void *cfg)
 	op_mode |= GAMUT_EN;
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(dspp_buf[GAMUT][ctx->idx],
+			REG_DMA_LUT_TAG(blk, op_mode), payload, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(dspp_buf[GAMUT][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, blk, GAMUT, dspp_buf[GAMUT][ctx->idx]);
@@ -4692,7 +4770,10 @@ void reg_dmav2_setup_dspp_3d_gamutv43(struct sde_hw_dspp *ctx, void *cfg)
 		DRM_ERROR("opmode write single reg failed ret %d\n", rc);
 		goto exit;
 	}
+	sde_reg_dma_lut_cache_commit(dspp_buf[GAMUT][ctx->idx],
+			REG_DMA_LUT_TAG(blk, op_mode));
 
+kickoff:
 	LOG_FEATURE_ON;
 	_perform_sbdma_kickoff(ctx, hw_cfg, dma_ops, blk, GAMUT);
 
@@ -4713,7 +4794,8 @@ void reg_dmav2_setup_vig_gamutv61(struct sde_hw_pipe *ctx, void *cfg)
 	u32 gamut_base = ctx->cap->sblk->gamut_blk.regdma_base;
 	u32 i, j, k = 0, len, table_select = 0;
 	u32 op_mode, scale_offset, scale_tbl_offset, transfer_size_bytes;
-	u16 *data;
+	u16 *data = NULL;
+	u64 lut_tag;
 
 	rc = reg_dma_sspp_check(ctx, cfg, GAMUT, idx);
 	if (rc)
@@ -4740,6 +4822,12 @@ void reg_dmav2_setup_vig_gamutv61(struct sde_hw_pipe *ctx, void *cfg)
 	}
 
 	op_mode = SDE_REG_READ(&ctx->hw, ctx->cap->sblk->gamut_blk.base);
+	/*
+	 * Tables are ping-ponged on every update, so look up the packing of
+	 * the table in use. Rewriting it with the same values is harmless.
+	 */
+	lut_tag = REG_DMA_LUT_TAG(sspp_mapping[ctx->idx],
+			op_mode & (BIT(5) - 1));
 	op_mode = (op_mode & (BIT(5) - 1)) >> 2;
 	if (op_mode == gamut_mode_17b) {
 		op_mode = gamut_mode_17;
@@ -4757,6 +4845,10 @@ void reg_dmav2_setup_vig_gamutv61(struct sde_hw_pipe *ctx, void *cfg)
 	op_mode |= GAMUT_EN;
 
 	dma_ops = sde_reg_dma_get_ops();
+	if (sde_reg_dma_lut_cache_hit(sspp_buf[idx][GAMUT][ctx->idx], lut_tag,
+			payload, hw_cfg->len))
+		goto kickoff;
+
 	dma_ops->reset_reg_dma_buf(sspp_buf[idx][GAMUT][ctx->idx]);
 
 	REG_DMA_INIT_OPS(dma_write_cfg, sspp_mapping[ctx->idx], GAMUT,
@@ -4830,7 +4922,10 @@ void reg_dmav2_setup_vig_gamutv61(struct sde_hw_pipe *ctx, void *cfg)
 		DRM_ERROR("opmode write single reg failed ret %d\n", rc);
 		goto exit;
 	}
+	sde_reg_dma_lut_cache_commit(sspp_buf[idx][GAMUT][ctx->idx],
+			REG_DMA_LUT_TAG(sspp_mapping[ctx->idx], op_mode));
 
+kickoff:
 	REG_DMA_SETUP_KICKOFF(kick_off, hw_cfg->ctl,
 			sspp_buf[idx][GAMUT][ctx->idx], REG_DMA_WRITE,
 			DMA_CTL_QUEUE0, WRITE_IMMEDIATE, GAMUT);
@@ -812,7 +812,8 @@ static inline void _sde_plane_set_scanout(struct drm_plane *plane,
 	if ((mode == SDE_DRM_FB_SEC) || (mode == SDE_DRM_FB_SEC_DIR_TRANS))
 		secure = true;
 
-	ret = sde_format_populate_layout(aspace, fb, &pipe_cfg->layout);
+	ret = sde_format_populate_layout_cached(aspace, fb, &pipe_cfg->layout,
+			&psde->layout_cache);
 	if (ret == -EAGAIN)
 		SDE_DEBUG_PLANE(psde, "not updating same src addrs\n");
 	else if (ret) {
@@ -1449,6 +1450,58 @@ static void sde_color_process_plane_disable(struct drm_plane *plane)
 	}
 }
 #endif
+/**
+ * _sde_plane_scaler_cache_hit - restore the default scaler config if the
+ *	inputs it depends on are unchanged since it was last computed
+ * @psde: Pointer to SDE plane object
+ * @pstate: Pointer to SDE plane state
+ * @fmt: Pointer to source buffer format
+ * Return: true if psde scaler3_cfg and pixel_ext were restored
+ */
+static bool _sde_plane_scaler_cache_hit(struct sde_plane *psde,
+		struct sde_plane_state *pstate, const struct sde_format *fmt)
+{
+	struct sde_plane_scaler_cache *cache = &psde->scaler_cache;
+
+	if (!cache->valid || cache->format != fmt ||
+			cache->src_w != psde->pipe_cfg.src_rect.w ||
+			cache->src_h != psde->pipe_cfg.src_rect.h ||
+			cache->dst_w != psde->pipe_cfg.dst_rect.w ||
+			cache->dst_h != psde->pipe_cfg.dst_rect.h ||
+			cache->rotation != pstate->rotation ||
+			cache->horz_deci != psde->pipe_cfg.horz_decimation ||
+			cache->vert_deci != psde->pipe_cfg.vert_decimation ||
+			cache->multirect_mode != pstate->multirect_mode)
+		return false;
+
+	memcpy(&psde->scaler3_cfg, &cache->scaler3_cfg,
+			sizeof(psde->scaler3_cfg));
+	memcpy(&psde->pixel_ext, &cache->pixel_ext,
+			sizeof(psde->pixel_ext));
+	return true;
+}
+
+static void _sde_plane_scaler_cache_store(struct sde_plane *psde,
+		struct sde_plane_state *pstate, const struct sde_format *fmt)
+{
+	struct sde_plane_scaler_cache *cache = &psde->scaler_cache;
+
+	cache->format = fmt;
+	cache->src_w = psde->pipe_cfg.src_rect.w;
+	cache->src_h = psde->pipe_cfg.src_rect.h;
+	cache->dst_w = psde->pipe_cfg.dst_rect.w;
+	cache->dst_h = psde->pipe_cfg.dst_rect.h;
+	cache->rotation = pstate->rotation;
+	cache->horz_deci = psde->pipe_cfg.horz_decimation;
+	cache->vert_deci = psde->pipe_cfg.vert_decimation;
+	cache->multirect_mode = pstate->multirect_mode;
+	memcpy(&cache->scaler3_cfg, &psde->scaler3_cfg,
+			sizeof(cache->scaler3_cfg));
+	memcpy(&cache->pixel_ext, &psde->pixel_ext,
+			sizeof(cache->pixel_ext));
+	cache->valid = true;
+}
+
 static void _sde_plane_setup_scaler(struct sde_plane *psde,
 		struct sde_plane_state *pstate,
 		const struct sde_format *fmt, bool color_fill)
@@ -1501,11 +1554,17 @@ static void _sde_plane_setup_scaler(struct sde_plane *psde,
 					pstate->multirect_mode);
 
 			/* calculate default config for QSEED3 */
-			_sde_plane_setup_scaler3(psde, pstate, fmt,
+			if (!_sde_plane_scaler_cache_hit(psde, pstate, fmt)) {
+				_sde_plane_setup_scaler3(psde, pstate, fmt,
 					chroma_subsmpl_h, chroma_subsmpl_v);
+				_sde_plane_scaler_cache_store(psde, pstate,
+						fmt);
+			}
 		}
-	} else if (pstate->scaler_check_state != SDE_PLANE_SCLCHECK_SCALER_V1 ||
-			color_fill || psde->debugfs_default_scale) {
+	} else if ((pstate->scaler_check_state !=
+			SDE_PLANE_SCLCHECK_SCALER_V1 || color_fill ||
+			psde->debugfs_default_scale) &&
+			!_sde_plane_scaler_cache_hit(psde, pstate, fmt)) {
 		uint32_t deci_dim, i;
 
 		/* calculate default configuration for QSEED2 */
@@ -1566,6 +1625,8 @@ static void _sde_plane_setup_scaler(struct sde_plane *psde,
 			else
 				pe->btm_ftch[i] = pe->num_ext_pxls_btm[i];
 		}
+
+		_sde_plane_scaler_cache_store(psde, pstate, fmt);
 	}
 
 	if (psde->pipe_hw->ops.setup_pre_downscale)
@@ -2892,6 +2953,7 @@ static int _sde_plane_atomic_check(struct drm_plane *plane,
 	int ret = 0;
 	struct sde_plane *psde;
 	struct sde_plane_state *pstate;
+	ktime_t start = ktime_get();
 
 	psde = to_sde_plane(plane);
 	pstate = to_sde_plane_state(state);
@@ -2905,6 +2967,8 @@ static int _sde_plane_atomic_check(struct drm_plane *plane,
 	ret = sde_plane_sspp_atomic_check(plane, state);
 
 exit:
+	trace_sde_plane_atomic_check(DRMID(plane), psde->pipe, ret,
+			ktime_to_ns(ktime_sub(ktime_get(), start)));
 	return ret;
 }
 
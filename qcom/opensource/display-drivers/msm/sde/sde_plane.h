@@ -26,6 +26,7 @@
 #include "sde_kms.h"
 #include "sde_hw_mdss.h"
 #include "sde_hw_sspp.h"
+#include "sde_formats.h"
 #include "sde_crtc.h"
 
 /* dirty bits for update function */
@@ -50,6 +51,33 @@
 		SDE_PLANE_DIRTY_FP16_UNMULT)
 #define SDE_PLANE_DIRTY_ALL	(0xFFFFFFFF & ~(SDE_PLANE_DIRTY_CP))
 
+/**
+ * struct sde_plane_scaler_cache - last default scaler config computed
+ * @valid:          true if the cached config may be reused
+ * @format:         source format the config was computed for
+ * @src_w:          source width
+ * @src_h:          source height
+ * @dst_w:          destination width
+ * @dst_h:          destination height
+ * @rotation:       plane rotation
+ * @horz_deci:      horizontal decimation
+ * @vert_deci:      vertical decimation
+ * @multirect_mode: multirect mode
+ * @scaler3_cfg:    cached QSEED3 default config
+ * @pixel_ext:      cached pixel extension config
+ */
+struct sde_plane_scaler_cache {
+	bool valid;
+	const struct sde_format *format;
+	u32 src_w, src_h;
+	u32 dst_w, dst_h;
+	u32 rotation;
+	u32 horz_deci, vert_deci;
+	u32 multirect_mode;
+	struct sde_hw_scaler3_cfg scaler3_cfg;
+	struct sde_hw_pixel_ext pixel_ext;
+};
+
 struct sde_plane {
 	struct drm_plane base;
 
@@ -78,6 +106,8 @@ struct sde_plane {
 	uint32_t cached_lut_flag;
 	struct sde_hw_scaler3_cfg scaler3_cfg;
 	struct sde_hw_pixel_ext pixel_ext;
+	struct sde_plane_scaler_cache scaler_cache;
+	struct sde_format_layout_cache layout_cache;
 
 	const struct sde_sspp_sub_blks *pipe_sblk;
 
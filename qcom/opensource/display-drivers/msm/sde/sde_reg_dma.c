@@ -4,6 +4,9 @@
  */
 
 #define pr_fmt(fmt)	"[drm:%s:%d] " fmt, __func__, __LINE__
+#include <linux/debugfs.h>
+#include <linux/mm.h>
+#include <linux/seq_file.h>
 #include "sde_reg_dma.h"
 #include "sde_hw_reg_dma_v1.h"
 #include "sde_dbg.h"
@@ -91,6 +94,21 @@ static void set_default_dma_ops(struct sde_hw_reg_dma *reg_dma)
 
 static struct sde_hw_reg_dma reg_dma;
 
+/**
+ * struct sde_reg_dma_lut_cache_stats - packed LUT reuse statistics
+ * @hits: setups that kicked off an already packed buffer
+ * @misses: setups that had to pack the blob
+ * @dma_bytes_reused: reg dma buffer bytes kicked off again without the
+ *                    CPU rewriting them
+ * @disable: debugfs knob to always re-pack
+ */
+static struct sde_reg_dma_lut_cache_stats {
+	atomic64_t hits;
+	atomic64_t misses;
+	atomic64_t dma_bytes_reused;
+	bool disable;
+} lut_cache_stats;
+
 int sde_reg_dma_init(void __iomem *addr, struct sde_mdss_cfg *m,
 		struct drm_device *dev)
 {
@@ -162,3 +180,105 @@ void sde_reg_dma_deinit(void)
 	memset(&reg_dma, 0, sizeof(reg_dma));
 	set_default_dma_ops(&reg_dma);
 }
+
+bool sde_reg_dma_lut_cache_hit(struct sde_reg_dma_buffer *buf, u64 tag,
+		const void *payload, u32 len)
+{
+	if (!buf || !payload || !len)
+		return false;
+
+	if (lut_cache_stats.disable) {
+		buf->lut_valid = false;
+		buf->lut_pending = false;
+		return false;
+	}
+
+	if (buf->lut_valid && buf->lut_tag == tag && buf->lut_len == len &&
+			!memcmp(buf->lut_blob, payload, len)) {
+		atomic64_inc(&lut_cache_stats.hits);
+		atomic64_add(buf->lut_dma_bytes,
+			&lut_cache_stats.dma_bytes_reused);
+		return true;
+	}
+
+	atomic64_inc(&lut_cache_stats.misses);
+	buf->lut_valid = false;
+	buf->lut_pending = false;
+
+	if (buf->lut_len != len) {
+		kvfree(buf->lut_blob);
+		buf->lut_blob = kvmalloc(len, GFP_KERNEL);
+		buf->lut_len = buf->lut_blob ? len : 0;
+		if (!buf->lut_blob)
+			return false;
+	}
+
+	/* copy before packing, some features mask the blob in place */
+	memcpy(buf->lut_blob, payload, len);
+	buf->lut_pending = true;
+
+	return false;
+}
+
+void sde_reg_dma_lut_cache_commit(struct sde_reg_dma_buffer *buf, u64 tag)
+{
+	if (!buf || !buf->lut_pending)
+		return;
+
+	buf->lut_pending = false;
+	buf->lut_tag = tag;
+	buf->lut_dma_bytes = buf->index;
+	buf->lut_valid = true;
+}
+
+void sde_reg_dma_lut_cache_free(struct sde_reg_dma_buffer *buf)
+{
+	if (!buf)
+		return;
+
+	kvfree(buf->lut_blob);
+	buf->lut_blob = NULL;
+	buf->lut_len = 0;
+	buf->lut_valid = false;
+	buf->lut_pending = false;
+}
+
+#if IS_ENABLED(CONFIG_DEBUG_FS)
+static int _sde_reg_dma_lut_cache_show(struct seq_file *s, void *data)
+{
+	seq_printf(s, "hits: %lld\n",
+		atomic64_read(&lut_cache_stats.hits));
+	seq_printf(s, "misses: %lld\n",
+		atomic64_read(&lut_cache_stats.misses));
+	seq_printf(s, "dma_bytes_reused: %lld\n",
+		atomic64_read(&lut_cache_stats.dma_bytes_reused));
+
+	return 0;
+}
+
+static int _sde_reg_dma_lut_cache_open(struct inode *inode,
+		struct file *file)
+{
+	return single_open(file, _sde_reg_dma_lut_cache_show,
+		inode->i_private);
+}
+
+void sde_reg_dma_debugfs_init(struct dentry *parent)
+{
+	static const struct file_operations debugfs_lut_cache_fops = {
+		.open =		_sde_reg_dma_lut_cache_open,
+		.read =		seq_read,
+		.llseek =	seq_lseek,
+		.release =	single_release,
+	};
+
+	debugfs_create_file("reg_dma_lut_cache", 0400, parent, NULL,
+		&debugfs_lut_cache_fops);
+	debugfs_create_bool("reg_dma_lut_cache_disable", 0600, parent,
+		&lut_cache_stats.disable);
+}
+#else
+void sde_reg_dma_debugfs_init(struct dentry *parent)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
@@ -243,6 +243,12 @@ enum sde_reg_dma_last_cmd_mode {
  * @next_op_allowed: operation allowed on the buffer
  * @ops_completed: operations completed on buffer
  * @abs_write_cnt: count of mdss absolute addr writes in the current buffer
+ * @lut_blob: copy of the blob the buffer was last packed from
+ * @lut_len: length of @lut_blob in bytes
+ * @lut_tag: non-blob packing inputs (block mask, op mode) for @lut_blob
+ * @lut_dma_bytes: size of the packed programming for @lut_blob
+ * @lut_valid: buffer still holds the packed programming for @lut_blob
+ * @lut_pending: @lut_blob describes the packing in progress
  */
 struct sde_reg_dma_buffer {
 	struct drm_gem_object *buf;
@@ -254,6 +260,12 @@ struct sde_reg_dma_buffer {
 	u32 next_op_allowed;
 	u32 ops_completed;
 	u32 abs_write_cnt;
+	void *lut_blob;
+	u32 lut_len;
+	u64 lut_tag;
+	u32 lut_dma_bytes;
+	bool lut_valid;
+	bool lut_pending;
 };
 
 /**
@@ -395,4 +407,38 @@ struct sde_hw_reg_dma_ops *sde_reg_dma_get_ops(void);
  * sde_reg_dma_deinit() - de-initialize the reg dma
  */
 void sde_reg_dma_deinit(void);
+
+/**
+ * sde_reg_dma_lut_cache_hit() - check whether a feature buffer already holds
+ *                               the packed programming for a blob. On a miss
+ *                               a copy of the blob is kept and must be
+ *                               committed once packing succeeds.
+ * @buf: feature reg dma buffer
+ * @tag: packing inputs other than the blob, e.g. block mask and op mode
+ * @payload: colour processing blob, compared by content
+ * @len: length of @payload in bytes
+ * Return: true if @buf can be kicked off again without re-packing
+ */
+bool sde_reg_dma_lut_cache_hit(struct sde_reg_dma_buffer *buf, u64 tag,
+		const void *payload, u32 len);
+
+/**
+ * sde_reg_dma_lut_cache_commit() - mark the packing recorded by the last
+ *                                  cache miss on @buf as complete
+ * @buf: feature reg dma buffer
+ * @tag: packing inputs other than the blob the buffer was packed with
+ */
+void sde_reg_dma_lut_cache_commit(struct sde_reg_dma_buffer *buf, u64 tag);
+
+/**
+ * sde_reg_dma_lut_cache_free() - release the blob copy held by @buf
+ * @buf: feature reg dma buffer
+ */
+void sde_reg_dma_lut_cache_free(struct sde_reg_dma_buffer *buf);
+
+/**
+ * sde_reg_dma_debugfs_init() - setup debugfs nodes for reg dma
+ * @parent: debugfs parent directory node
+ */
+void sde_reg_dma_debugfs_init(struct dentry *parent);
 #endif /* _SDE_REG_DMA_H */
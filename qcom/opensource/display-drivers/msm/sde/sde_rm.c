@@ -44,6 +44,10 @@
 				(t).comp_type == (r).comp_type)
 #define IS_COMPATIBLE_PP_DSC(p, d) (p % 2 == d % 2)
 
+/* topology control bits which influence mixer selection */
+#define RM_PLAN_TOP_CTRL_MASK (BIT(SDE_RM_TOPCTL_DSPP) | BIT(SDE_RM_TOPCTL_DS) |\
+		BIT(SDE_RM_TOPCTL_CWB) | BIT(SDE_RM_TOPCTL_DCWB))
+
 /* ~one vsync poll time for rsvp_nxt to cleared by modeset from commit thread */
 #define RM_NXT_CLEAR_POLL_TIMEOUT_US 33000
 
@@ -867,6 +871,8 @@ static int _sde_rm_status_show(struct seq_file *s, void *data)
 {
 	struct sde_rm *rm;
 	struct sde_rm_hw_blk *blk;
+	struct sde_rm_plan_stats *stats;
+	u64 avg_search_ns, avg_hit_ns, saved_ns;
 	u32 type, allocated, unallocated;
 
 	if (!s || !s->private)
@@ -886,6 +892,18 @@ static int _sde_rm_status_show(struct seq_file *s, void *data)
 			type, sde_hw_blk_str[type], allocated, unallocated);
 	}
 
+	stats = &rm->plan_stats;
+	avg_search_ns = stats->misses ?
+			div_u64(stats->search_ns, stats->misses) : 0;
+	avg_hit_ns = stats->hits ? div_u64(stats->hit_ns, stats->hits) : 0;
+	saved_ns = (avg_search_ns > avg_hit_ns) ?
+			(avg_search_ns - avg_hit_ns) * stats->hits : 0;
+
+	seq_printf(s, "plan_cache hits:%u misses:%u invalidations:%u\n",
+			stats->hits, stats->misses, stats->invalidations);
+	seq_printf(s, "plan_cache avg_search_ns:%llu avg_hit_ns:%llu saved_us:%llu\n",
+			avg_search_ns, avg_hit_ns, div_u64(saved_ns, NSEC_PER_USEC));
+
 	return 0;
 }
 
@@ -2073,6 +2091,180 @@ static int _sde_rm_make_vdc_rsvp(struct sde_rm *rm, struct sde_rm_rsvp *rsvp,
 	return ret;
 }
 
+static u32 _sde_rm_get_cur_ctl_mask(struct sde_rm *rm,
+		struct sde_rm_rsvp *rsvp)
+{
+	struct sde_rm_hw_blk *blk;
+	u32 mask = 0;
+
+	list_for_each_entry(blk, &rm->hw_blks[SDE_HW_BLK_CTL], list) {
+		if (RESERVED_BY_CURRENT(blk, rsvp))
+			mask |= BIT(blk->id);
+	}
+
+	return mask;
+}
+
+static bool _sde_rm_plan_match(struct sde_rm_plan *plan,
+		struct sde_rm_rsvp *rsvp, struct sde_rm_requirements *reqs,
+		u32 cur_ctl_mask)
+{
+	return plan->valid && plan->enc_id == rsvp->enc_id &&
+		plan->top_name == reqs->topology->top_name &&
+		plan->top_ctrl == (reqs->top_ctrl & RM_PLAN_TOP_CTRL_MASK) &&
+		plan->display_type == reqs->hw_res.display_type &&
+		plan->conn_lm_mask == (RM_RQ_DCWB(reqs) ? reqs->conn_lm_mask : 0) &&
+		plan->cur_ctl_mask == cur_ctl_mask;
+}
+
+/**
+ * _sde_rm_plan_apply - reserve the LM/CTL blocks of a memoised plan
+ * @rm: KMS handle
+ * @rsvp: reservation being created
+ * @reqs: proposed use case requirements
+ * @cur_ctl_mask: CTLs currently held by the requesting encoder
+ * @Return: true if a valid plan was found and its blocks reserved
+ */
+static bool _sde_rm_plan_apply(struct sde_rm *rm, struct sde_rm_rsvp *rsvp,
+		struct sde_rm_requirements *reqs, u32 cur_ctl_mask)
+{
+	struct sde_rm_plan *plan;
+	ktime_t start = ktime_get();
+	u32 i, j;
+
+	for (i = 0; i < SDE_RM_PLAN_CACHE_SIZE; i++) {
+		plan = &rm->plans[i];
+		if (!_sde_rm_plan_match(plan, rsvp, reqs, cur_ctl_mask))
+			continue;
+
+		/* blocks may have been taken by another display since */
+		for (j = 0; j < plan->num_blks; j++) {
+			if (RESERVED_BY_OTHER(plan->blks[j], rsvp)) {
+				plan->valid = false;
+				rm->plan_stats.invalidations++;
+				return false;
+			}
+		}
+
+		for (j = 0; j < plan->num_blks; j++) {
+			plan->blks[j]->rsvp_nxt = rsvp;
+			SDE_EVT32(plan->blks[j]->type, rsvp->enc_id,
+					plan->blks[j]->id, SDE_EVTLOG_FUNC_CASE1);
+		}
+
+		rm->plan_stats.hits++;
+		rm->plan_stats.hit_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		return true;
+	}
+
+	return false;
+}
+
+static void _sde_rm_plan_store(struct sde_rm *rm, struct sde_rm_rsvp *rsvp,
+		struct sde_rm_requirements *reqs, u32 cur_ctl_mask)
+{
+	static const enum sde_hw_blk_type types[] = {
+		SDE_HW_BLK_LM, SDE_HW_BLK_DSPP, SDE_HW_BLK_DS,
+		SDE_HW_BLK_PINGPONG, SDE_HW_BLK_CTL,
+	};
+	struct sde_rm_plan *plan = NULL;
+	struct sde_rm_hw_blk *blk;
+	u32 i;
+
+	for (i = 0; i < SDE_RM_PLAN_CACHE_SIZE; i++) {
+		if (!rm->plans[i].valid) {
+			plan = &rm->plans[i];
+			break;
+		}
+	}
+
+	if (!plan) {
+		plan = &rm->plans[rm->plan_next];
+		rm->plan_next = (rm->plan_next + 1) % SDE_RM_PLAN_CACHE_SIZE;
+	}
+
+	plan->valid = false;
+	plan->num_blks = 0;
+	for (i = 0; i < ARRAY_SIZE(types); i++) {
+		list_for_each_entry(blk, &rm->hw_blks[types[i]], list) {
+			if (blk->rsvp_nxt != rsvp)
+				continue;
+
+			if (plan->num_blks == SDE_RM_PLAN_MAX_BLKS)
+				return;
+
+			plan->blks[plan->num_blks++] = blk;
+		}
+	}
+
+	plan->enc_id = rsvp->enc_id;
+	plan->top_name = reqs->topology->top_name;
+	plan->top_ctrl = reqs->top_ctrl & RM_PLAN_TOP_CTRL_MASK;
+	plan->display_type = reqs->hw_res.display_type;
+	plan->conn_lm_mask = RM_RQ_DCWB(reqs) ? reqs->conn_lm_mask : 0;
+	plan->cur_ctl_mask = cur_ctl_mask;
+	plan->valid = true;
+}
+
+/**
+ * _sde_rm_plan_invalidate - drop plans of other displays
+ *	Freed blocks may allow a preferred block set for those displays, so
+ *	their plans are recomputed on the next reservation.
+ * @rm: KMS handle
+ * @enc_id: encoder whose reservation released blocks
+ */
+static void _sde_rm_plan_invalidate(struct sde_rm *rm, uint32_t enc_id)
+{
+	u32 i;
+
+	for (i = 0; i < SDE_RM_PLAN_CACHE_SIZE; i++) {
+		if (rm->plans[i].valid && rm->plans[i].enc_id != enc_id) {
+			rm->plans[i].valid = false;
+			rm->plan_stats.invalidations++;
+		}
+	}
+}
+
+static int _sde_rm_make_lm_ctl_rsvp(struct sde_rm *rm,
+		struct sde_rm_rsvp *rsvp, struct sde_rm_requirements *reqs,
+		struct sde_splash_display *splash_display)
+{
+	u32 cur_ctl_mask;
+	ktime_t start;
+	int ret;
+
+	/* splash provides its own block ids, don't memoise those */
+	cur_ctl_mask = _sde_rm_get_cur_ctl_mask(rm, rsvp);
+	if (!splash_display &&
+			_sde_rm_plan_apply(rm, rsvp, reqs, cur_ctl_mask))
+		return 0;
+
+	start = ktime_get();
+
+	ret = _sde_rm_make_lm_rsvp(rm, rsvp, reqs, splash_display);
+	if (ret) {
+		SDE_ERROR("unable to find appropriate mixers\n");
+		_sde_rm_print_rsvps_by_type(rm, SDE_HW_BLK_LM);
+		return ret;
+	}
+
+	ret = _sde_rm_make_ctl_rsvp(rm, rsvp, reqs, splash_display);
+	if (ret) {
+		SDE_ERROR("unable to find appropriate CTL\n");
+		return ret;
+	}
+
+	if (!splash_display) {
+		rm->plan_stats.misses++;
+		rm->plan_stats.search_ns +=
+				ktime_to_ns(ktime_sub(ktime_get(), start));
+		_sde_rm_plan_store(rm, rsvp, reqs, cur_ctl_mask);
+	}
+
+	return 0;
+}
+
 static int _sde_rm_make_next_rsvp(struct sde_rm *rm, struct drm_encoder *enc,
 		struct drm_crtc_state *crtc_state,
 		struct drm_connector_state *conn_state,
@@ -2108,18 +2300,9 @@ static int _sde_rm_make_next_rsvp(struct sde_rm *rm, struct drm_encoder *enc,
 	rsvp->pending = true;
 	list_add_tail(&rsvp->list, &rm->rsvps);
 
-	ret = _sde_rm_make_lm_rsvp(rm, rsvp, reqs, splash_display);
-	if (ret) {
-		SDE_ERROR("unable to find appropriate mixers\n");
-		_sde_rm_print_rsvps_by_type(rm, SDE_HW_BLK_LM);
-		return ret;
-	}
-
-	ret = _sde_rm_make_ctl_rsvp(rm, rsvp, reqs, splash_display);
-	if (ret) {
-		SDE_ERROR("unable to find appropriate CTL\n");
+	ret = _sde_rm_make_lm_ctl_rsvp(rm, rsvp, reqs, splash_display);
+	if (ret)
 		return ret;
-	}
 
 	/* Assign INTFs, WBs, and blks whose usage is tied to them: CTL & CDM */
 	ret = _sde_rm_reserve_intf_related_hw(rm, rsvp, reqs);
@@ -2610,6 +2793,7 @@ static void _sde_rm_release_rsvp(
 		}
 	}
 
+	_sde_rm_plan_invalidate(rm, rsvp->enc_id);
 	kfree(rsvp);
 }
 
@@ -163,6 +163,52 @@ struct sde_rm_topology_def {
 	enum msm_display_compression_type comp_type;
 };
 
+/* number of memoised LM/CTL reservation plans kept by the resource manager */
+#define SDE_RM_PLAN_CACHE_SIZE	8
+
+/* LM, DSPP, DS, PP and CTL blocks a single plan may hold */
+#define SDE_RM_PLAN_MAX_BLKS	(MAX_BLOCKS * 4)
+
+/**
+ * struct sde_rm_plan - memoised mixer and control path reservation
+ * @valid: plan may be reused
+ * @enc_id: encoder the plan was computed for
+ * @top_name: topology the plan was computed for
+ * @top_ctrl: topology control bits that affect mixer selection
+ * @display_type: connector display type of the request
+ * @conn_lm_mask: preferred LM mask of the request, for dcwb
+ * @cur_ctl_mask: CTLs held by the encoder when the plan was computed
+ * @num_blks: number of valid entries in @blks
+ * @blks: reserved LM, DSPP, DS, PP and CTL blocks
+ */
+struct sde_rm_plan {
+	bool valid;
+	uint32_t enc_id;
+	enum sde_rm_topology_name top_name;
+	uint64_t top_ctrl;
+	uint32_t display_type;
+	uint32_t conn_lm_mask;
+	uint32_t cur_ctl_mask;
+	uint32_t num_blks;
+	struct sde_rm_hw_blk *blks[SDE_RM_PLAN_MAX_BLKS];
+};
+
+/**
+ * struct sde_rm_plan_stats - reservation planner statistics
+ * @hits: plans reused without searching the hw block lists
+ * @misses: full searches performed
+ * @invalidations: plans dropped as blocks were freed or committed
+ * @hit_ns: total time spent applying reused plans
+ * @search_ns: total time spent in successful full searches
+ */
+struct sde_rm_plan_stats {
+	u32 hits;
+	u32 misses;
+	u32 invalidations;
+	u64 hit_ns;
+	u64 search_ns;
+};
+
 /**
  * struct sde_rm - SDE dynamic hardware resource manager
  * @dev: device handle for event logging purposes
@@ -174,6 +220,9 @@ struct sde_rm_topology_def {
  * @rsvp_next_seq: sequence number for next reservation for debugging purposes
  * @rm_lock: resource manager mutex
  * @avail_res: Pointer with curr available resources
+ * @plans: memoised LM/CTL reservations, keyed by encoder and request
+ * @plan_next: next plan slot to be replaced
+ * @plan_stats: reservation planner statistics
  */
 struct sde_rm {
 	struct drm_device *dev;
@@ -185,6 +234,9 @@ struct sde_rm {
 	struct mutex rm_lock;
 	const struct sde_rm_topology_def *topology_tbl;
 	struct msm_resource_caps_info avail_res;
+	struct sde_rm_plan plans[SDE_RM_PLAN_CACHE_SIZE];
+	u32 plan_next;
+	struct sde_rm_plan_stats plan_stats;
 };
 
 /**
@@ -62,6 +62,46 @@ TRACE_EVENT(sde_perf_set_ot,
 			__entry->vbif_idx)
 )
 
+TRACE_EVENT(sde_plane_atomic_check,
+	TP_PROTO(u32 plane_id, u32 pipe, int ret, u64 duration_ns),
+	TP_ARGS(plane_id, pipe, ret, duration_ns),
+	TP_STRUCT__entry(
+			__field(u32, plane_id)
+			__field(u32, pipe)
+			__field(int, ret)
+			__field(u64, duration_ns)
+	),
+	TP_fast_assign(
+			__entry->plane_id = plane_id;
+			__entry->pipe = pipe;
+			__entry->ret = ret;
+			__entry->duration_ns = duration_ns;
+	),
+	TP_printk("plane:%d pipe:%d ret:%d duration_ns:%llu",
+			__entry->plane_id, __entry->pipe, __entry->ret,
+			__entry->duration_ns)
+)
+
+TRACE_EVENT(dsi_panel_tx_cmd_set,
+	TP_PROTO(u32 type, u32 count, u32 kickoffs, u64 duration_ns),
+	TP_ARGS(type, count, kickoffs, duration_ns),
+	TP_STRUCT__entry(
+			__field(u32, type)
+			__field(u32, count)
+			__field(u32, kickoffs)
+			__field(u64, duration_ns)
+	),
+	TP_fast_assign(
+			__entry->type = type;
+			__entry->count = count;
+			__entry->kickoffs = kickoffs;
+			__entry->duration_ns = duration_ns;
+	),
+	TP_printk("type:%d count:%d kickoffs:%d duration_ns:%llu",
+			__entry->type, __entry->count, __entry->kickoffs,
+			__entry->duration_ns)
+)
+
 TRACE_EVENT(sde_perf_update_bus,
 	TP_PROTO(u32 bus_id, unsigned long long ab_quota,
 	unsigned long long ib_quota, u32 paths),
@@ -639,10 +639,18 @@ static int sde_md_notify_handler(struct notifier_block *this,
 	struct sde_kms *sde_kms = to_sde_kms(priv->kms);
 	struct sde_dbg_base *dbg_base = &sde_dbg_base;
 	u32 reg_dump_size = _sde_dbg_get_reg_dump_size();
+	char name[32];
+	int cpu;
 
 	sde_mini_dump_add_va_region("msm_drm_priv", sizeof(*priv), priv);
 	sde_mini_dump_add_va_region("sde_evtlog",
 			sizeof(*sde_dbg_base_evtlog), sde_dbg_base_evtlog);
+	for_each_possible_cpu(cpu) {
+		snprintf(name, sizeof(name), "sde_evtlog_cpu%d", cpu);
+		sde_mini_dump_add_va_region(name,
+				sizeof(*sde_dbg_base_evtlog->rings[cpu]),
+				sde_dbg_base_evtlog->rings[cpu]);
+	}
 	sde_mini_dump_add_va_region("sde_reglog",
 			sizeof(*sde_dbg_base_reglog), sde_dbg_base_reglog);
 
@@ -1587,9 +1595,7 @@ ssize_t oplus_sde_evtlog_dump_read(struct file *file, char __user *buff,
 
 	mutex_lock(&sde_dbg_base.mutex);
 	sde_dbg_base.cur_evt_index = 0;
-	sde_dbg_base.evtlog->first = (u32)atomic_add_return(0, &sde_dbg_base.evtlog->curr) + 1;
-	sde_dbg_base.evtlog->last =
-		sde_dbg_base.evtlog->first + SDE_EVTLOG_ENTRY;
+	sde_evtlog_rewind(sde_dbg_base.evtlog);
 
 	len = sde_evtlog_dump_to_buffer(sde_dbg_base.evtlog,
 			evtlog_buf, SDE_EVTLOG_BUF_MAX,
@@ -1627,9 +1633,7 @@ static int sde_dbg_debugfs_open(struct inode *inode, struct file *file)
 	file->private_data = inode->i_private;
 	mutex_lock(&sde_dbg_base.mutex);
 	sde_dbg_base.cur_evt_index = 0;
-	sde_dbg_base.evtlog->first = (u32)atomic_add_return(0, &sde_dbg_base.evtlog->curr) + 1;
-	sde_dbg_base.evtlog->last =
-		sde_dbg_base.evtlog->first + SDE_EVTLOG_ENTRY;
+	sde_evtlog_rewind(sde_dbg_base.evtlog);
 	mutex_unlock(&sde_dbg_base.mutex);
 	return 0;
 }
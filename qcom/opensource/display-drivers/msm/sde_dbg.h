@@ -10,6 +10,7 @@
 #include <stdarg.h>
 #include <linux/debugfs.h>
 #include <linux/list.h>
+#include <asm/local.h>
 #include <soc/qcom/minidump.h>
 #include <drm/drm_print.h>
 
@@ -136,6 +137,12 @@ enum sde_dbg_dump_context {
 #define SDE_EVTLOG_ENTRY	(SDE_EVTLOG_PRINT_ENTRY * 32)
 #endif /* IS_ENABLED(CONFIG_DRM_MSM_LOW_MEM_FOOTPRINT) */
 
+/*
+ * evtlog entries are written to per-CPU rings of this many entries, so that
+ * concurrent writers never share a cache line. Must be a power of two.
+ */
+#define SDE_EVTLOG_CPU_ENTRY	(SDE_EVTLOG_ENTRY / 4)
+
 #define SDE_EVTLOG_MAX_DATA 15
 #define SDE_EVTLOG_BUF_MAX 512
 #define SDE_EVTLOG_BUF_ALIGN 32
@@ -149,24 +156,37 @@ struct sde_dbg_power_ctrl {
 struct sde_dbg_evtlog_log {
 	s64 time;
 	const char *name;
-	int line;
 	u32 data[SDE_EVTLOG_MAX_DATA];
-	u32 data_cnt;
 	int pid;
+	u16 line;
+	u8 data_cnt;
 	u8 cpu;
 };
 
 /**
- * @last_dump: Index of last entry to be output during evtlog dumps
+ * struct sde_dbg_evtlog_ring - per-CPU event ring
+ * @logs: Ring entries, indexed by sequence number modulo ring size
+ * @head: Sequence number of the next entry to be written on this CPU
+ * @next: Sequence number of the next entry to be output during dumps
+ * @last_dump: Sequence number one past the last entry of the current dump
+ * @first: Scratch cursor used while trimming a dump to the newest entries
+ */
+struct sde_dbg_evtlog_ring {
+	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_CPU_ENTRY];
+	local_t head;
+	u32 next;
+	u32 last_dump;
+	u32 first;
+};
+
+/**
+ * @rings: Per-CPU event rings, merged by timestamp when dumped
+ * @prev_time: Timestamp of the previously dumped entry
  * @filter_list: Linked list of currently active filter strings
  */
 struct sde_dbg_evtlog {
-	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_ENTRY];
-	u32 first;
-	u32 last;
-	u32 last_dump;
-	atomic_t curr;
-	u32 next;
+	struct sde_dbg_evtlog_ring *rings[NR_CPUS];
+	s64 prev_time;
 	u32 enable;
 	u32 dump_mode;
 	char *dumped_evtlog;
@@ -363,6 +383,12 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 		char *evtlog_buf, ssize_t evtlog_buf_size,
 		bool update_last_entry, bool full_dump);
 
+/**
+ * sde_evtlog_rewind - restart dumping from the oldest entry still held
+ * @evtlog:	pointer to evtlog
+ */
+void sde_evtlog_rewind(struct sde_dbg_evtlog *evtlog);
+
 /**
  * sde_evtlog_count - count the current log size for print
  * @evtlog:	pointer to evtlog
@@ -14,6 +14,7 @@
 #include <linux/dma-buf.h>
 #include <linux/slab.h>
 #include <linux/sched/clock.h>
+#include <linux/jump_label.h>
 
 #include "sde_dbg.h"
 #include "sde_trace.h"
@@ -25,6 +26,9 @@ struct sde_evtlog_filter {
 	char filter[SDE_EVTLOG_FILTER_STRSIZE];
 };
 
+/* only walk the filter list on the logging path while one is installed */
+static DEFINE_STATIC_KEY_FALSE(sde_evtlog_filter_active);
+
 static bool _sde_evtlog_is_filtered_no_lock(
 		struct sde_dbg_evtlog *evtlog, const char *str)
 {
@@ -61,22 +65,33 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 {
 	int i, val = 0;
 	va_list args;
+	struct sde_dbg_evtlog_ring *ring;
 	struct sde_dbg_evtlog_log *log;
 	u32 index;
+	int cpu;
+
+	if (!evtlog || !name || !sde_evtlog_is_enabled(evtlog, flag))
+		return;
 
-	if (!evtlog || !sde_evtlog_is_enabled(evtlog, flag) ||
+	if (static_branch_unlikely(&sde_evtlog_filter_active) &&
 			_sde_evtlog_is_filtered_no_lock(evtlog, name))
 		return;
 
-	index = abs(atomic_inc_return(&evtlog->curr) % SDE_EVTLOG_ENTRY);
+	cpu = get_cpu();
+	ring = evtlog->rings[cpu];
+	if (unlikely(!ring))
+		goto exit;
 
-	log = &evtlog->logs[index];
+	/* IRQs nesting on this CPU claim their own slot through the local op */
+	index = (u32)(local_inc_return(&ring->head) - 1);
+
+	log = &ring->logs[index & (SDE_EVTLOG_CPU_ENTRY - 1)];
 	log->time = local_clock();
 	log->name = name;
 	log->line = line;
 	log->data_cnt = 0;
 	log->pid = current->pid;
-	log->cpu = raw_smp_processor_id();
+	log->cpu = cpu;
 
 	va_start(args, flag);
 	for (i = 0; i < SDE_EVTLOG_MAX_DATA; i++) {
@@ -90,13 +105,9 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	va_end(args);
 	log->data_cnt = i;
 
-#ifndef OPLUS_FEATURE_DISPLAY
-	evtlog->last++;
-#else
-	evtlog->last = atomic_read(&evtlog->curr);
-#endif /* OPLUS_FEATURE_DISPLAY */
-
 	trace_sde_evtlog(name, line, log->data_cnt, log->data);
+exit:
+	put_cpu();
 }
 
 void sde_reglog_log(u8 blk_id, u32 val, u32 addr)
@@ -119,36 +130,91 @@ void sde_reglog_log(u8 blk_id, u32 val, u32 addr)
 	reglog->last++;
 }
 
+static inline struct sde_dbg_evtlog_log *_sde_evtlog_ring_entry(
+		struct sde_dbg_evtlog_ring *ring, u32 seq)
+{
+	return &ring->logs[seq & (SDE_EVTLOG_CPU_ENTRY - 1)];
+}
+
+/*
+ * _sde_evtlog_trim_range - drop all but the newest @max_entries entries
+ *	across the per-CPU rings, walking them backwards in timestamp order
+ */
+static void _sde_evtlog_trim_range(struct sde_dbg_evtlog *evtlog,
+		u32 max_entries)
+{
+	struct sde_dbg_evtlog_ring *ring, *best;
+	s64 time, best_time;
+	u32 i;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		if (ring)
+			ring->first = ring->last_dump;
+	}
+
+	for (i = 0; i < max_entries; i++) {
+		best = NULL;
+		best_time = 0;
+		for_each_possible_cpu(cpu) {
+			ring = evtlog->rings[cpu];
+			if (!ring || ring->first == ring->next)
+				continue;
+
+			time = _sde_evtlog_ring_entry(ring, ring->first - 1)->time;
+			if (!best || time > best_time) {
+				best = ring;
+				best_time = time;
+			}
+		}
+
+		if (!best)
+			break;
+		best->first--;
+	}
+
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		if (ring)
+			ring->next = ring->first;
+	}
+}
+
 /* always dump the last entries which are not dumped yet */
 static bool _sde_evtlog_dump_calc_range(struct sde_dbg_evtlog *evtlog,
 		bool update_last_entry, bool full_dump)
 {
-	int max_entries = full_dump ? SDE_EVTLOG_ENTRY : SDE_EVTLOG_PRINT_ENTRY;
+	u32 max_entries = full_dump ? SDE_EVTLOG_ENTRY : SDE_EVTLOG_PRINT_ENTRY;
+	struct sde_dbg_evtlog_ring *ring;
+	u32 pending = 0;
+	int cpu;
 
 	if (!evtlog)
 		return false;
 
-	evtlog->first = evtlog->next;
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		if (!ring)
+			continue;
 
-	if (update_last_entry)
-		evtlog->last_dump = evtlog->last;
+		if (update_last_entry)
+			ring->last_dump = (u32)local_read(&ring->head);
 
-	if (evtlog->last_dump == evtlog->first)
-		return false;
+		/* older entries have already been overwritten */
+		if (ring->last_dump - ring->next > SDE_EVTLOG_CPU_ENTRY)
+			ring->next = ring->last_dump - SDE_EVTLOG_CPU_ENTRY;
 
-	if (evtlog->last_dump < evtlog->first) {
-		evtlog->first %= SDE_EVTLOG_ENTRY;
-		if (evtlog->last_dump < evtlog->first)
-			evtlog->last_dump += SDE_EVTLOG_ENTRY;
+		pending += ring->last_dump - ring->next;
 	}
 
-	if ((evtlog->last_dump - evtlog->first) > max_entries) {
-		pr_info("evtlog skipping %d entries, last=%d\n",
-			evtlog->last_dump - evtlog->first -
-			max_entries, evtlog->last_dump - 1);
-		evtlog->first = evtlog->last_dump - max_entries;
+	if (!pending)
+		return false;
+
+	if (pending > max_entries) {
+		pr_info("evtlog skipping %u entries\n", pending - max_entries);
+		_sde_evtlog_trim_range(evtlog, max_entries);
 	}
-	evtlog->next = evtlog->first + 1;
 
 	return true;
 }
@@ -157,10 +223,12 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 		char *evtlog_buf, ssize_t evtlog_buf_size,
 		bool update_last_entry, bool full_dump)
 {
-	int i;
+	int i, cpu;
 	ssize_t off = 0;
-	struct sde_dbg_evtlog_log *log, *prev_log;
+	struct sde_dbg_evtlog_ring *ring, *oldest = NULL;
+	struct sde_dbg_evtlog_log *log = NULL, *entry;
 	unsigned long flags;
+	u32 seq = 0;
 
 	if (!evtlog || !evtlog_buf)
 		return 0;
@@ -171,9 +239,25 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	if (!_sde_evtlog_dump_calc_range(evtlog, update_last_entry, full_dump))
 		goto exit;
 
-	log = &evtlog->logs[evtlog->first % SDE_EVTLOG_ENTRY];
+	/* merge the per-CPU rings by picking the oldest pending entry */
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		if (!ring || ring->next == ring->last_dump)
+			continue;
+
+		entry = _sde_evtlog_ring_entry(ring, ring->next);
+		if (!log || entry->time < log->time) {
+			oldest = ring;
+			log = entry;
+		}
+	}
+
+	if (!log)
+		goto exit;
 
-	prev_log = &evtlog->logs[(evtlog->first - 1) % SDE_EVTLOG_ENTRY];
+	seq = oldest->next++;
+	if (update_last_entry)
+		evtlog->prev_time = log->time;
 
 	off = snprintf((evtlog_buf + off), (evtlog_buf_size - off), "%s:%-4d",
 		log->name, log->line);
@@ -184,65 +268,89 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	}
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-		"=>[%-8d:%-11llu:%9llu][%-4d]:[%-4d]:", evtlog->first,
-		log->time, (log->time - prev_log->time), log->pid, log->cpu);
+		"=>[%-8u:%-11llu:%9llu][%-4d]:[%-4d]:", seq,
+		log->time, (log->time - evtlog->prev_time), log->pid, log->cpu);
 
 	for (i = 0; i < log->data_cnt; i++)
 		off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
 			"%x ", log->data[i]);
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off), "\n");
+	evtlog->prev_time = log->time;
 exit:
 	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
 
 	return off;
 }
 
-u32 sde_evtlog_count(struct sde_dbg_evtlog *evtlog)
+void sde_evtlog_rewind(struct sde_dbg_evtlog *evtlog)
 {
-	u32 first, next, last, last_dump;
+	struct sde_dbg_evtlog_ring *ring;
+	unsigned long flags;
+	long head;
+	int cpu;
 
 	if (!evtlog)
-		return 0;
+		return;
+
+	spin_lock_irqsave(&evtlog->spin_lock, flags);
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		if (!ring)
+			continue;
 
-	first = evtlog->first;
-	next = evtlog->next;
-	last = evtlog->last;
-	last_dump = evtlog->last_dump;
+		head = local_read(&ring->head);
+		ring->next = (u32)(head - min_t(long, head, SDE_EVTLOG_CPU_ENTRY));
+	}
+	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+}
 
-	first = next;
-	last_dump = last;
+u32 sde_evtlog_count(struct sde_dbg_evtlog *evtlog)
+{
+	struct sde_dbg_evtlog_ring *ring;
+	u32 count = 0;
+	int cpu;
 
-	if (last_dump == first)
+	if (!evtlog)
 		return 0;
 
-	if (last_dump < first) {
-		first %= SDE_EVTLOG_ENTRY;
-		if (last_dump < first)
-			last_dump += SDE_EVTLOG_ENTRY;
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		if (ring)
+			count += min_t(u32, (u32)local_read(&ring->head) - ring->next,
+					SDE_EVTLOG_CPU_ENTRY);
 	}
 
-	if ((last_dump - first) > SDE_EVTLOG_ENTRY)
-		return SDE_EVTLOG_ENTRY;
-
-	return last_dump - first;
+	return min_t(u32, count, SDE_EVTLOG_ENTRY);
 }
 
 struct sde_dbg_evtlog *sde_evtlog_init(void)
 {
 	struct sde_dbg_evtlog *evtlog;
+	struct sde_dbg_evtlog_ring *ring;
+	int cpu;
 
 	evtlog = vzalloc(sizeof(*evtlog));
 	if (!evtlog)
 		return ERR_PTR(-ENOMEM);
 
 	spin_lock_init(&evtlog->spin_lock);
-	atomic_set(&evtlog->curr, 0);
 	evtlog->enable = SDE_EVTLOG_DEFAULT_ENABLE;
 	evtlog->dump_mode = SDE_DBG_DEFAULT_DUMP_MODE;
 
 	INIT_LIST_HEAD(&evtlog->filter_list);
 
+	for_each_possible_cpu(cpu) {
+		ring = vzalloc(sizeof(*ring));
+		if (!ring) {
+			sde_evtlog_destroy(evtlog);
+			return ERR_PTR(-ENOMEM);
+		}
+
+		local_set(&ring->head, 0);
+		evtlog->rings[cpu] = ring;
+	}
+
 	return evtlog;
 }
 
@@ -343,6 +451,11 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 		spin_unlock_irqrestore(&evtlog->spin_lock, flags);
 	}
 
+	if (list_empty(&evtlog->filter_list))
+		static_branch_disable(&sde_evtlog_filter_active);
+	else
+		static_branch_enable(&sde_evtlog_filter_active);
+
 	/*
 	 * Free any unused filter_nodes back to the system.
 	 */
@@ -355,14 +468,19 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 void sde_evtlog_destroy(struct sde_dbg_evtlog *evtlog)
 {
 	struct sde_evtlog_filter *filter_node, *tmp;
+	int cpu;
 
 	if (!evtlog)
 		return;
 
+	static_branch_disable(&sde_evtlog_filter_active);
 	list_for_each_entry_safe(filter_node, tmp, &evtlog->filter_list, list) {
 		list_del(&filter_node->list);
 		kfree(filter_node);
 	}
+
+	for_each_possible_cpu(cpu)
+		vfree(evtlog->rings[cpu]);
 	vfree(evtlog);
 }
 
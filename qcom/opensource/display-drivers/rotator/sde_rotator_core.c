@@ -1491,6 +1491,54 @@ static void sde_rotator_release_entry(struct sde_rot_mgr *mgr,
 	sde_rotator_unassign_queue(mgr, entry);
 }
 
+/*
+ * sde_rotator_can_premap - check if entry buffers can be mapped before
+ *	the hw resource is acquired
+ * @entry: Pointer to rotation entry
+ *
+ * Mapping may switch the secure camera state, which has to wait until the
+ * entry owns a hw queue slot, so only entries which do not change the
+ * current secure state are mapped early.
+ */
+static bool sde_rotator_can_premap(struct sde_rot_entry *entry)
+{
+	struct sde_rot_data_type *mdata = sde_rot_get_mdata();
+	bool secure = (entry->item.flags & SDE_ROTATION_SECURE_CAMERA) ?
+			true : false;
+
+	if (!test_bit(SDE_CAPS_SEC_ATTACH_DETACH_SMMU, mdata->sde_caps_map))
+		return true;
+
+	return secure == !!mdata->sec_cam_en;
+}
+
+/*
+ * sde_rotator_map_entry - attach smmu and map/check entry buffers
+ * @entry: Pointer to rotation entry
+ *
+ * On success the smmu vote is held until the entry is done or cancelled.
+ */
+static int sde_rotator_map_entry(struct sde_rot_entry *entry)
+{
+	int ret;
+
+	ATRACE_INT("sde_smmu_ctrl", 0);
+	ret = sde_smmu_ctrl(1);
+	if (ret < 0) {
+		SDEROT_ERR("IOMMU attach failed\n");
+		return ret;
+	}
+	ATRACE_INT("sde_smmu_ctrl", 1);
+
+	ret = sde_rotator_map_and_check_data(entry);
+	if (ret) {
+		SDEROT_ERR("fail to prepare input/output data %d\n", ret);
+		sde_smmu_ctrl(0);
+	}
+
+	return ret;
+}
+
 /*
  * sde_rotator_commit_handler - Commit workqueue handler.
  * @file: Pointer to work struct.
@@ -1508,6 +1556,7 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 	struct sde_rot_mgr *mgr;
 	struct sched_param param = { .sched_priority = 5 };
 	struct sde_rot_trace_entry rot_trace;
+	bool mapped = false;
 	int ret;
 
 	entry = container_of(work, struct sde_rot_entry, commit_work);
@@ -1547,10 +1596,21 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 
 	sde_rot_mgr_lock(mgr);
 
+	/*
+	 * Prepare the buffers before waiting for a hw queue slot, so this
+	 * entry is ready to be programmed as soon as an earlier one retires.
+	 */
+	if (sde_rotator_can_premap(entry)) {
+		ret = sde_rotator_map_entry(entry);
+		if (ret)
+			goto get_hw_res_err;
+		mapped = true;
+	}
+
 	hw = sde_rotator_get_hw_resource(entry->commitq, entry);
 	if (!hw) {
 		SDEROT_ERR("no hw for the queue\n");
-		goto get_hw_res_err;
+		goto hw_res_err;
 	}
 
 	if (entry->item.ts)
@@ -1577,18 +1637,25 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 	trace_rot_entry_commit(
 		entry->item.session_id, entry->item.sequence_id, &rot_trace);
 
-	ATRACE_INT("sde_smmu_ctrl", 0);
-	ret = sde_smmu_ctrl(1);
-	if (ret < 0) {
-		SDEROT_ERR("IOMMU attach failed\n");
-		goto smmu_error;
-	}
-	ATRACE_INT("sde_smmu_ctrl", 1);
-
-	ret = sde_rotator_map_and_check_data(entry);
-	if (ret) {
-		SDEROT_ERR("fail to prepare input/output data %d\n", ret);
-		goto error;
+	if (!mapped) {
+		ret = sde_rotator_map_entry(entry);
+		if (ret)
+			goto error;
+		mapped = true;
+	} else if (!sde_rotator_can_premap(entry)) {
+		/*
+		 * The mgr lock is dropped while waiting for hw, so another
+		 * session may have switched the secure camera state after
+		 * this entry was premapped. Switch back to the state this
+		 * entry was mapped for.
+		 */
+		ret = sde_rotator_secure_session_ctrl(
+			(entry->item.flags & SDE_ROTATION_SECURE_CAMERA) ?
+			true : false);
+		if (ret) {
+			SDEROT_ERR("failed secure session switch %d\n", ret);
+			goto error;
+		}
 	}
 
 	ret = mgr->ops_config_hw(hw, entry);
@@ -1632,9 +1699,10 @@ kickoff_error:
 	sde_rotator_req_wait_for_idle(mgr, request);
 	mgr->ops_cancel_hw(hw, entry);
 error:
-	sde_smmu_ctrl(0);
-smmu_error:
 	sde_rotator_put_hw_resource(entry->commitq, entry, hw);
+hw_res_err:
+	if (mapped)
+		sde_smmu_ctrl(0);
 get_hw_res_err:
 	sde_rotator_signal_output(entry);
 	sde_rotator_release_entry(mgr, entry);
@@ -1693,8 +1761,19 @@ static void sde_rotator_done_handler(struct kthread_work *work)
 	}
 	SDEROT_EVTLOG(entry->item.session_id, 1);
 
-	if (entry->item.ts)
-		entry->item.ts[SDE_ROTATOR_TS_DONE] = ktime_get();
+	if (entry->item.ts) {
+		ktime_t *ts = entry->item.ts;
+
+		ts[SDE_ROTATOR_TS_DONE] = ktime_get();
+		trace_rot_entry_latency(entry->item.session_id,
+			entry->item.sequence_id, entry->item.wb_idx,
+			ktime_us_delta(ts[SDE_ROTATOR_TS_COMMIT],
+					ts[SDE_ROTATOR_TS_QUEUE]),
+			ktime_us_delta(ts[SDE_ROTATOR_TS_FLUSH],
+					ts[SDE_ROTATOR_TS_COMMIT]),
+			ktime_us_delta(ts[SDE_ROTATOR_TS_DONE],
+					ts[SDE_ROTATOR_TS_FLUSH]));
+	}
 
 	/* Set values to pass to trace */
 	rot_trace.wb_idx = entry->item.wb_idx;
@@ -85,6 +85,32 @@ DEFINE_EVENT(rot_entry_template, rot_entry_done,
 	TP_ARGS(ss_id, sq_id, rot)
 );
 
+TRACE_EVENT(rot_entry_latency,
+	TP_PROTO(u32 ss_id, u32 sq_id, u32 wb_idx, s64 queue_us,
+		s64 program_us, s64 execute_us),
+	TP_ARGS(ss_id, sq_id, wb_idx, queue_us, program_us, execute_us),
+	TP_STRUCT__entry(
+			__field(u32, ss_id)
+			__field(u32, sq_id)
+			__field(u32, wb_idx)
+			__field(s64, queue_us)
+			__field(s64, program_us)
+			__field(s64, execute_us)
+	),
+	TP_fast_assign(
+			__entry->ss_id = ss_id;
+			__entry->sq_id = sq_id;
+			__entry->wb_idx = wb_idx;
+			__entry->queue_us = queue_us;
+			__entry->program_us = program_us;
+			__entry->execute_us = execute_us;
+	),
+	TP_printk("%d.%d|%d|queue:%lld program:%lld execute:%lld",
+			__entry->ss_id, __entry->sq_id, __entry->wb_idx,
+			__entry->queue_us, __entry->program_us,
+			__entry->execute_us)
+);
+
 TRACE_EVENT(rot_perf_set_qos_luts,
 	TP_PROTO(u32 pnum, u32 fmt, u32 lut, bool linear),
 	TP_ARGS(pnum, fmt, lut, linear),
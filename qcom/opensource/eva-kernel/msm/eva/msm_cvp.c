@@ -262,7 +262,63 @@ exit:
 	return rc;
 }
 
-static bool cvp_fence_wait(struct cvp_fence_queue *q,
+/* True if fc waits on or signals a synx that prev signals */
+static bool cvp_fence_depends_on(struct cvp_fence_command *fc,
+			struct cvp_fence_command *prev)
+{
+	u32 i, j;
+
+	for (i = prev->output_index; i < prev->num_fences; i++) {
+		if (!prev->dep_synx[i])
+			continue;
+		for (j = 0; j < fc->num_fences; j++)
+			if (prev->dep_synx[i] == fc->dep_synx[j])
+				return true;
+	}
+
+	return false;
+}
+
+/*
+ * A fence command is ready when none of the commands in flight or
+ * queued ahead of it signal a synx it uses. Independent commands can
+ * then occupy idle fence threads instead of blocking in synx_wait
+ * behind their producer, while commands chained through a fence keep
+ * their submission order. Called with q->lock held.
+ */
+static bool cvp_fence_cmd_ready(struct cvp_fence_queue *q,
+			struct cvp_fence_command *fc)
+{
+	struct cvp_fence_command *f;
+
+	list_for_each_entry(f, &q->sched_list, list)
+		if (cvp_fence_depends_on(fc, f))
+			return false;
+
+	list_for_each_entry(f, &q->wait_list, list) {
+		if (f == fc)
+			break;
+		if (cvp_fence_depends_on(fc, f))
+			return false;
+	}
+
+	return true;
+}
+
+/* First ready command of the wait list, called with q->lock held */
+struct cvp_fence_command *cvp_fence_pick(struct cvp_fence_queue *q)
+{
+	struct cvp_fence_command *f;
+
+	list_for_each_entry(f, &q->wait_list, list)
+		if (cvp_fence_cmd_ready(q, f))
+			return f;
+
+	return NULL;
+}
+CVP_EXPORT_FOR_KUNIT(cvp_fence_pick);
+
+bool cvp_fence_wait(struct cvp_fence_queue *q,
 			struct cvp_fence_command **fence,
 			enum queue_state *state)
 {
@@ -281,7 +337,12 @@ static bool cvp_fence_wait(struct cvp_fence_queue *q,
 		return false;
 	}
 
-	f = list_first_entry(&q->wait_list, struct cvp_fence_command, list);
+	f = cvp_fence_pick(q);
+	if (!f) {
+		mutex_unlock(&q->lock);
+		return false;
+	}
+
 	list_del_init(&f->list);
 	list_add_tail(&f->list, &q->sched_list);
 
@@ -290,6 +351,7 @@ static bool cvp_fence_wait(struct cvp_fence_queue *q,
 
 	return true;
 }
+CVP_EXPORT_FOR_KUNIT(cvp_fence_wait);
 
 static int cvp_readjust_clock(struct msm_cvp_core *core,
 			u32 avg_cycles, enum hfi_hw_thread i)
@@ -547,8 +609,7 @@ static int cvp_fence_proc(struct msm_cvp_inst *inst,
 	}
 
 exit:
-	rc = inst->core->synx_ftbl->cvp_synx_ops(inst, CVP_OUTPUT_SYNX,
-			fc, &synx_state);
+	fc->synx_state = synx_state;
 	if (clock_check)
 		cvp_check_clock(inst,
 			(struct cvp_hfi_msg_session_hdr_ext *)&hdr);
@@ -583,6 +644,53 @@ static void cvp_free_fence_data(struct cvp_fence_command *f)
 	f = NULL;
 }
 
+/*
+ * Signal and release the output synx of every processed command in the
+ * sched list in one pass. A fence thread marks its command done before
+ * it takes q->lock, so the first thread to get the lock also completes
+ * the commands other threads finished meanwhile, and the waiters are
+ * woken once per batch. fc may be freed by any thread once it is done.
+ */
+int cvp_fence_complete(struct msm_cvp_inst *inst,
+			struct cvp_fence_command *fc,
+			enum queue_state *state)
+{
+	struct cvp_fence_queue *q = &inst->fence_cmd_queue;
+	struct cvp_fence_command *f, *d;
+	LIST_HEAD(done);
+	int rc = 0, rc2;
+
+	smp_store_release(&fc->done, true);
+
+	mutex_lock(&q->lock);
+	list_for_each_entry_safe(f, d, &q->sched_list, list) {
+		if (!smp_load_acquire(&f->done))
+			continue;
+		rc2 = inst->core->synx_ftbl->cvp_synx_ops(inst,
+				CVP_OUTPUT_SYNX, f, &f->synx_state);
+		if (rc2)
+			rc = rc2;
+		inst->core->synx_ftbl->cvp_release_synx(inst, f);
+		list_move_tail(&f->list, &done);
+	}
+	*state = q->state;
+	mutex_unlock(&q->lock);
+
+	if (list_empty(&done))
+		return rc;
+
+	/* Commands chained behind these may be ready now */
+	wake_up_all(&q->wq);
+
+	list_for_each_entry_safe(f, d, &done, list) {
+		list_del_init(&f->list);
+		cvp_free_fence_data(f);
+	}
+
+	return rc;
+}
+CVP_EXPORT_FOR_KUNIT(cvp_fence_complete);
+
 static int cvp_fence_thread(void *data)
 {
 	int rc = 0;
@@ -625,16 +733,10 @@ wait:
 
 	rc = cvp_fence_proc(inst, f, pkt);
 
-	mutex_lock(&q->lock);
-	inst->core->synx_ftbl->cvp_release_synx(inst, f);
-	list_del_init(&f->list);
-	state = q->state;
-	mutex_unlock(&q->lock);
-
 	dprintk(CVP_SYNX, "%s done with %d ktid %llu frameID %llu rc %d\n",
 		current->comm, pkt->packet_type, ktid, f->frame_id, rc);
 
-	cvp_free_fence_data(f);
+	rc = cvp_fence_complete(inst, f, &state);
 
 	if (rc && state != QUEUE_START)
 		goto exit;
@@ -661,9 +763,11 @@ static int msm_cvp_session_process_hfi_fence(struct msm_cvp_inst *inst,
 	struct msm_cvp_inst *s;
 	struct cvp_fence_command *f;
 	struct cvp_fence_queue *q;
+	struct cvp_fence_type *fs;
 	u32 *fence;
 	enum op_mode mode;
 	bool is_config_pkt;
+	u32 i;
 
 	if (!inst || !inst->core || !arg || !inst->core->device) {
 		dprintk(CVP_ERR, "%s: invalid params\n", __func__);
@@ -758,6 +862,10 @@ static int msm_cvp_session_process_hfi_fence(struct msm_cvp_inst *inst,
 
 	f->pkt->client_data.kdata |= FENCE_BIT;
 
+	fs = (struct cvp_fence_type *)fence;
+	for (i = 0; i < f->num_fences; i++)
+		f->dep_synx[i] = fs[i].h_synx;
+
 	rc = inst->core->synx_ftbl->cvp_import_synx(inst, f, fence);
 	if (rc) {
 		kfree(f);
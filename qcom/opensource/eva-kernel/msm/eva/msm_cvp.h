@@ -38,4 +38,11 @@ int msm_cvp_session_delete(struct msm_cvp_inst *inst);
 int msm_cvp_get_session_info(struct msm_cvp_inst *inst, u32 *session);
 int msm_cvp_update_power(struct msm_cvp_inst *inst);
 int cvp_clean_session_queues(struct msm_cvp_inst *inst);
+struct cvp_fence_command *cvp_fence_pick(struct cvp_fence_queue *q);
+bool cvp_fence_wait(struct cvp_fence_queue *q,
+			struct cvp_fence_command **fence,
+			enum queue_state *state);
+int cvp_fence_complete(struct msm_cvp_inst *inst,
+			struct cvp_fence_command *fc,
+			enum queue_state *state);
 #endif
@@ -1122,69 +1122,87 @@ void msm_cvp_cache_operations(struct msm_cvp_smem *smem, u32 type,
 	msm_cvp_smem_cache_operations(smem->dma_buf, cache_op, offset, size);
 }
 
+/* caller holds dma_cache.lock */
+void msm_cvp_smem_hash_add(struct cvp_dmamap_cache *cache,
+				struct msm_cvp_smem *smem)
+{
+	if (hlist_unhashed(&smem->hnode))
+		hash_add(cache->smem_hash, &smem->hnode,
+			(unsigned long)smem->dma_buf);
+}
+CVP_EXPORT_FOR_KUNIT(msm_cvp_smem_hash_add);
+
+/* caller holds dma_cache.lock */
+void msm_cvp_smem_hash_del(struct msm_cvp_smem *smem)
+{
+	hash_del(&smem->hnode);
+}
+CVP_EXPORT_FOR_KUNIT(msm_cvp_smem_hash_del);
+
+/*
+ * Single lookup over cache entries, persist and frame buffers.
+ * A dma_buf may have more than one smem, e.g. a user persist
+ * mapping and a cache entry; the cache entry is preferred as the
+ * cache used to be searched first.
+ * caller holds dma_cache.lock
+ */
+struct msm_cvp_smem *msm_cvp_smem_hash_find(struct cvp_dmamap_cache *cache,
+				struct dma_buf *dma_buf)
+{
+	struct msm_cvp_smem *smem = NULL, *s;
+
+	hash_for_each_possible(cache->smem_hash, s, hnode,
+			(unsigned long)dma_buf) {
+		if (s->dma_buf != dma_buf)
+			continue;
+		if (s->bitmap_index < MAX_DMABUF_NUMS)
+			return s;
+		if (!smem)
+			smem = s;
+	}
+
+	return smem;
+}
+CVP_EXPORT_FOR_KUNIT(msm_cvp_smem_hash_find);
+
 static struct msm_cvp_smem *msm_cvp_session_find_smem(struct msm_cvp_inst *inst,
 				struct dma_buf *dma_buf,
 				u32 pkt_type)
 {
 	struct msm_cvp_smem *smem;
-	struct msm_cvp_frame *frame;
-	struct cvp_internal_buf *buf;
 	int i;
 
 	if (inst->dma_cache.nr > MAX_DMABUF_NUMS)
 		return NULL;
 
 	mutex_lock(&inst->dma_cache.lock);
-	for (i = 0; i < inst->dma_cache.nr; i++)
-		if (inst->dma_cache.entries[i]->dma_buf == dma_buf) {
-			SET_USE_BITMAP(i, inst);
-			smem = inst->dma_cache.entries[i];
-			smem->bitmap_index = i;
-			smem->pkt_type = pkt_type;
-			atomic_inc(&smem->refcount);
-			/*
-			 * If we find it, it means we already increased
-			 * refcount before, so we put it to avoid double
-			 * incremental.
-			 */
-			msm_cvp_smem_put_dma_buf(smem->dma_buf);
-			mutex_unlock(&inst->dma_cache.lock);
-			print_smem(CVP_MEM, "found in cache", inst, smem);
-			return smem;
-		}
-
-	mutex_unlock(&inst->dma_cache.lock);
-
-	/* earch persist list */
-	mutex_lock(&inst->persistbufs.lock);
-	list_for_each_entry(buf, &inst->persistbufs.list, list) {
-		smem = buf->smem;
-		if (smem && smem->dma_buf == dma_buf) {
-			atomic_inc(&smem->refcount);
-			mutex_unlock(&inst->persistbufs.lock);
-			print_smem(CVP_MEM, "found in persist", inst, smem);
-			return smem;
-		}
+	smem = msm_cvp_smem_hash_find(&inst->dma_cache, dma_buf);
+	if (!smem) {
+		mutex_unlock(&inst->dma_cache.lock);
+		return NULL;
 	}
-	mutex_unlock(&inst->persistbufs.lock);
 
-	/* Search frame list */
-	mutex_lock(&inst->frames.lock);
-	list_for_each_entry(frame, &inst->frames.list, list) {
-		for (i = 0; i < frame->nr; i++) {
-			smem = frame->bufs[i].smem;
-			if (smem && smem->dma_buf == dma_buf) {
-				atomic_inc(&smem->refcount);
-				mutex_unlock(&inst->frames.lock);
-				print_smem(CVP_MEM, "found in frame",
-					inst, smem);
-				return smem;
-			}
-		}
+	if (smem->bitmap_index < MAX_DMABUF_NUMS) {
+		i = smem->bitmap_index;
+		SET_USE_BITMAP(i, inst);
+		smem->pkt_type = pkt_type;
+		atomic_inc(&smem->refcount);
+		/*
+		 * If we find it, it means we already increased
+		 * refcount before, so we put it to avoid double
+		 * incremental.
+		 */
+		msm_cvp_smem_put_dma_buf(smem->dma_buf);
+		mutex_unlock(&inst->dma_cache.lock);
+		print_smem(CVP_MEM, "found in cache", inst, smem);
+		return smem;
 	}
-	mutex_unlock(&inst->frames.lock);
 
-	return NULL;
+	atomic_inc(&smem->refcount);
+	mutex_unlock(&inst->dma_cache.lock);
+	print_smem(CVP_MEM, "found in persist or frame", inst, smem);
+
+	return smem;
 }
 
 static int msm_cvp_session_add_smem(struct msm_cvp_inst *inst,
@@ -1205,6 +1223,7 @@ static int msm_cvp_session_add_smem(struct msm_cvp_inst *inst,
 				MAX_DMABUF_NUMS);
 		if (i < MAX_DMABUF_NUMS) {
 			smem2 = inst->dma_cache.entries[i];
+			msm_cvp_smem_hash_del(smem2);
 			msm_cvp_unmap_smem(inst, smem2, "unmap cpu");
 			msm_cvp_smem_put_dma_buf(smem2->dma_buf);
 			cvp_kmem_cache_free(&cvp_driver->smem_cache, smem2);
@@ -1217,12 +1236,14 @@ static int msm_cvp_session_add_smem(struct msm_cvp_inst *inst,
 			"%s: reached limit, fallback to buf mapping list\n"
 			, __func__);
 			atomic_inc(&smem->refcount);
+			msm_cvp_smem_hash_add(&inst->dma_cache, smem);
 			mutex_unlock(&inst->dma_cache.lock);
 			return -ENOMEM;
 		}
 	}
 
 	atomic_inc(&smem->refcount);
+	msm_cvp_smem_hash_add(&inst->dma_cache, smem);
 	mutex_unlock(&inst->dma_cache.lock);
 	dprintk(CVP_MEM, "Add entry %d into cache\n", i);
 
@@ -1390,6 +1411,10 @@ static u32 msm_cvp_map_user_persist_buf(struct msm_cvp_inst *inst,
 	list_add_tail(&pbuf->list, &inst->persistbufs.list);
 	mutex_unlock(&inst->persistbufs.lock);
 
+	mutex_lock(&inst->dma_cache.lock);
+	msm_cvp_smem_hash_add(&inst->dma_cache, smem);
+	mutex_unlock(&inst->dma_cache.lock);
+
 	print_internal_buffer(CVP_MEM, "map persist", inst, pbuf);
 
 	iova = smem->device_addr + buf->offset;
@@ -1461,8 +1486,20 @@ static void msm_cvp_unmap_frame_buf(struct msm_cvp_inst *inst,
 		msm_cvp_cache_operations(smem, type, buf->offset, buf->size);
 
 		if (smem->bitmap_index >= MAX_DMABUF_NUMS) {
-			/* smem not in dmamap cache */
-			if (atomic_dec_and_test(&smem->refcount)) {
+			bool release;
+
+			/*
+			 * smem not in dmamap cache, drop the last reference
+			 * under the cache lock so that a concurrent lookup
+			 * cannot take a new one on a buffer being freed
+			 */
+			mutex_lock(&inst->dma_cache.lock);
+			release = atomic_dec_and_test(&smem->refcount);
+			if (release)
+				msm_cvp_smem_hash_del(smem);
+			mutex_unlock(&inst->dma_cache.lock);
+
+			if (release) {
 				msm_cvp_unmap_smem(inst, smem, "unmap cpu");
 				dma_heap_buffer_free(smem->dma_buf);
 				smem->buf_idx |= 0xdead0000;
@@ -1661,6 +1698,9 @@ int msm_cvp_session_deinit_buffers(struct msm_cvp_inst *inst)
 				 * don't care refcount, has to remove mapping
 				 * this is user persistent buffer
 				 */
+				mutex_lock(&inst->dma_cache.lock);
+				msm_cvp_smem_hash_del(smem);
+				mutex_unlock(&inst->dma_cache.lock);
 				if (smem->device_addr) {
 					msm_cvp_unmap_smem(inst, smem,
 						"unmap persist");
@@ -1691,6 +1731,7 @@ int msm_cvp_session_deinit_buffers(struct msm_cvp_inst *inst)
 		} else if (!(smem->flags & SMEM_PERSIST)) {
 			print_smem(CVP_WARN, "in use", inst, smem);
 		}
+		msm_cvp_smem_hash_del(smem);
 		msm_cvp_unmap_smem(inst, smem, "unmap cpu");
 		msm_cvp_smem_put_dma_buf(smem->dma_buf);
 		cvp_kmem_cache_free(&cvp_driver->smem_cache, smem);
@@ -11,10 +11,12 @@
 #include <linux/dma-buf.h>
 #include <linux/dma-heap.h>
 #include <linux/refcount.h>
+#include <linux/hashtable.h>
 #include <media/msm_eva_private.h>
 
 #define MAX_FRAME_BUFFER_NUMS 30
 #define MAX_DMABUF_NUMS 64
+#define CVP_SMEM_HASH_BITS 7
 #define IS_CVP_BUF_VALID(buf, smem) \
 	((buf->size <= smem->size) && \
 	(buf->size <= smem->size - buf->offset))
@@ -67,6 +69,7 @@ struct cvp_dma_mapping_info {
 
 struct msm_cvp_smem {
 	struct list_head list;
+	struct hlist_node hnode; /* in cvp_dmamap_cache smem_hash */
 	atomic_t refcount;
 	struct dma_buf *dma_buf;
 	void *kvaddr;
@@ -92,6 +95,11 @@ struct cvp_dmamap_cache {
 	struct mutex lock;
 	struct msm_cvp_smem *entries[MAX_DMABUF_NUMS];
 	unsigned int nr;
+	/*
+	 * user smem of the session keyed by dma_buf: cache entries as
+	 * well as persist and frame buffers mapped outside the cache
+	 */
+	DECLARE_HASHTABLE(smem_hash, CVP_SMEM_HASH_BITS);
 };
 
 static inline void INIT_DMAMAP_CACHE(struct cvp_dmamap_cache *cache)
@@ -99,6 +107,7 @@ static inline void INIT_DMAMAP_CACHE(struct cvp_dmamap_cache *cache)
 	mutex_init(&cache->lock);
 	cache->usage_bitmap = 0;
 	cache->nr = 0;
+	hash_init(cache->smem_hash);
 }
 
 static inline void DEINIT_DMAMAP_CACHE(struct cvp_dmamap_cache *cache)
@@ -221,6 +230,11 @@ int msm_cvp_register_buffer(struct msm_cvp_inst *inst,
 int msm_cvp_unregister_buffer(struct msm_cvp_inst *inst,
 		struct eva_kmd_buffer *buf);
 int msm_cvp_session_deinit_buffers(struct msm_cvp_inst *inst);
+void msm_cvp_smem_hash_add(struct cvp_dmamap_cache *cache,
+		struct msm_cvp_smem *smem);
+void msm_cvp_smem_hash_del(struct msm_cvp_smem *smem);
+struct msm_cvp_smem *msm_cvp_smem_hash_find(struct cvp_dmamap_cache *cache,
+		struct dma_buf *dma_buf);
 void msm_cvp_print_inst_bufs(struct msm_cvp_inst *inst, bool log);
 int cvp_allocate_dsp_bufs(struct msm_cvp_inst *inst,
 			struct cvp_internal_buf *buf,
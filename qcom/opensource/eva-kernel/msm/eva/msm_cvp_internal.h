@@ -26,6 +26,13 @@
 #include "cvp_hfi_helper.h"
 #include <synx_api.h>
 
+/* makes a symbol available to the KUnit modules in msm/eva/test */
+#if defined(CONFIG_EVA_KUNIT_TEST)
+#define CVP_EXPORT_FOR_KUNIT(sym) EXPORT_SYMBOL(sym)
+#else
+#define CVP_EXPORT_FOR_KUNIT(sym)
+#endif
+
 #define MAX_SUPPORTED_INSTANCES 16
 #define MAX_DEBUGFS_NAME 50
 #define MAX_DSP_INIT_ATTEMPTS 16
@@ -35,6 +35,11 @@ struct cvp_fence_command {
 	u32 output_index;
 	u32 type;
 	u32 synx[MAX_HFI_FENCE_SIZE/2];
+	/* client synx handles, used to order commands sharing fences */
+	s32 dep_synx[MAX_HFI_FENCE_SIZE/2];
+	/* set once processed, outputs are signalled with the next batch */
+	bool done;
+	u32 synx_state;
 	struct cvp_hfi_cmd_session_hdr *pkt;
 };
 
@@ -0,0 +1,362 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/completion.h>
+#include <linux/delay.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+
+#include "msm_cvp.h"
+#include "msm_cvp_synx.h"
+
+#define CVP_TEST_STREAMS 4
+#define CVP_TEST_FRAMES 16
+#define CVP_TEST_CMDS (CVP_TEST_STREAMS * CVP_TEST_FRAMES)
+#define CVP_TEST_MAX_WORKERS 4
+#define CVP_TEST_HW_US 500
+#define CVP_TEST_SYNX_BASE 100
+#define CVP_TEST_MAX_SYNX (CVP_TEST_SYNX_BASE + CVP_TEST_CMDS)
+#define CVP_TEST_WAIT_MS 5000
+
+/* fences 0..output_index-1 are waited on, the rest are signalled */
+static struct cvp_fence_command *cvp_test_fence_cmd(struct kunit *test,
+		struct cvp_fence_queue *q, s32 in, s32 out)
+{
+	struct cvp_fence_command *fc;
+
+	fc = kunit_kzalloc(test, sizeof(*fc), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, fc);
+	fc->num_fences = 2;
+	fc->output_index = 1;
+	fc->dep_synx[0] = in;
+	fc->dep_synx[1] = out;
+	list_add_tail(&fc->list, &q->wait_list);
+
+	return fc;
+}
+
+/* what cvp_fence_wait does on behalf of a fence thread */
+static struct cvp_fence_command *cvp_test_fence_sched(
+		struct cvp_fence_queue *q)
+{
+	struct cvp_fence_command *f;
+
+	mutex_lock(&q->lock);
+	f = cvp_fence_pick(q);
+	if (f)
+		list_move_tail(&f->list, &q->sched_list);
+	mutex_unlock(&q->lock);
+
+	return f;
+}
+
+static void cvp_test_fence_done(struct cvp_fence_queue *q,
+		struct cvp_fence_command *f)
+{
+	mutex_lock(&q->lock);
+	list_del_init(&f->list);
+	mutex_unlock(&q->lock);
+}
+
+static void cvp_test_fence_queue_init(struct cvp_fence_queue *q)
+{
+	mutex_init(&q->lock);
+	q->state = QUEUE_START;
+	INIT_LIST_HEAD(&q->wait_list);
+	INIT_LIST_HEAD(&q->sched_list);
+	init_waitqueue_head(&q->wq);
+}
+
+static void msm_cvp_test_fence_order(struct kunit *test)
+{
+	struct cvp_fence_queue *q;
+	struct cvp_fence_command *a, *b, *c, *d;
+
+	q = kunit_kzalloc(test, sizeof(*q), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, q);
+	cvp_test_fence_queue_init(q);
+
+	/* b consumes a's output, d consumes b's output, c is independent */
+	a = cvp_test_fence_cmd(test, q, 5, 10);
+	b = cvp_test_fence_cmd(test, q, 10, 20);
+	c = cvp_test_fence_cmd(test, q, 30, 40);
+	d = cvp_test_fence_cmd(test, q, 20, 50);
+
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q), a);
+	/* c overtakes b, which waits for a */
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q), c);
+	/* b blocked by a in flight, d by b queued ahead of it */
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q),
+		(struct cvp_fence_command *)NULL);
+
+	cvp_test_fence_done(q, c);
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q),
+		(struct cvp_fence_command *)NULL);
+
+	cvp_test_fence_done(q, a);
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q), b);
+	/* d must not run while b is in flight */
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q),
+		(struct cvp_fence_command *)NULL);
+
+	cvp_test_fence_done(q, b);
+	KUNIT_EXPECT_PTR_EQ(test, cvp_test_fence_sched(q), d);
+	cvp_test_fence_done(q, d);
+
+	KUNIT_EXPECT_TRUE(test, list_empty(&q->wait_list));
+	KUNIT_EXPECT_TRUE(test, list_empty(&q->sched_list));
+	mutex_destroy(&q->lock);
+}
+
+/*
+ * Fenced command pipeline with synx and HFI stubbed out: synx handles
+ * are flags in cvp_test_pipe, and the hardware takes CVP_TEST_HW_US
+ * per command. Workers run the fence thread loop on top of the real
+ * cvp_fence_wait() and cvp_fence_complete().
+ */
+struct cvp_test_pipe {
+	struct msm_cvp_inst *inst;
+	wait_queue_head_t synx_wq;
+	bool signaled[CVP_TEST_MAX_SYNX];
+	u64 submit_ns[CVP_TEST_CMDS];
+	u64 start_ns[CVP_TEST_CMDS];
+	u64 done_ns[CVP_TEST_CMDS];
+	s32 producer[CVP_TEST_CMDS];
+	atomic_t num_done;
+	atomic_t errors;
+	struct completion all_done;
+	struct completion worker_exit[CVP_TEST_MAX_WORKERS];
+};
+
+static struct cvp_test_pipe *cvp_test_pipe;
+
+static int cvp_test_release_synx(struct msm_cvp_inst *inst,
+		struct cvp_fence_command *fc)
+{
+	return 0;
+}
+
+static int cvp_test_synx_ops(struct msm_cvp_inst *inst,
+		enum cvp_synx_type type, struct cvp_fence_command *fc,
+		u32 *synx_state)
+{
+	struct cvp_test_pipe *p = cvp_test_pipe;
+	u32 i;
+
+	if (type == CVP_INPUT_SYNX) {
+		for (i = 0; i < fc->output_index; i++) {
+			if (!wait_event_timeout(p->synx_wq,
+				READ_ONCE(p->signaled[fc->synx[i]]),
+				msecs_to_jiffies(CVP_TEST_WAIT_MS))) {
+				*synx_state = SYNX_STATE_SIGNALED_ERROR;
+				return -ETIMEDOUT;
+			}
+		}
+		return 0;
+	}
+
+	/* called with q->lock held, once per command of a batch */
+	if (fc->synx_state != SYNX_STATE_SIGNALED_SUCCESS)
+		atomic_inc(&p->errors);
+	p->done_ns[fc->frame_id] = ktime_get_ns();
+	for (i = fc->output_index; i < fc->num_fences; i++)
+		WRITE_ONCE(p->signaled[fc->synx[i]], true);
+	wake_up_all(&p->synx_wq);
+	if (atomic_inc_return(&p->num_done) == CVP_TEST_CMDS)
+		complete(&p->all_done);
+
+	return 0;
+}
+
+static struct msm_cvp_synx_ops cvp_test_synx_ftbl = {
+	.cvp_release_synx = cvp_test_release_synx,
+	.cvp_synx_ops = cvp_test_synx_ops,
+};
+
+struct cvp_test_worker {
+	struct cvp_test_pipe *pipe;
+	int id;
+};
+
+/* cvp_fence_thread with cvp_fence_proc replaced by the stubs */
+static int cvp_test_fence_worker(void *data)
+{
+	struct cvp_test_worker *w = data;
+	struct cvp_test_pipe *p = w->pipe;
+	struct msm_cvp_inst *inst = p->inst;
+	struct cvp_fence_queue *q = &inst->fence_cmd_queue;
+	struct cvp_fence_command *f;
+	enum queue_state state;
+	u32 synx_state;
+
+	for (;;) {
+		f = NULL;
+		wait_event_interruptible(q->wq, cvp_fence_wait(q, &f, &state));
+		if (state != QUEUE_START)
+			break;
+		if (!f)
+			continue;
+
+		synx_state = SYNX_STATE_SIGNALED_SUCCESS;
+		inst->core->synx_ftbl->cvp_synx_ops(inst, CVP_INPUT_SYNX, f,
+			&synx_state);
+		p->start_ns[f->frame_id] = ktime_get_ns();
+		usleep_range(CVP_TEST_HW_US, CVP_TEST_HW_US + 50);
+		f->synx_state = synx_state;
+
+		cvp_fence_complete(inst, f, &state);
+	}
+
+	complete(&p->worker_exit[w->id]);
+	return 0;
+}
+
+/*
+ * Queue CVP_TEST_CMDS commands in one burst. Chained streams consume
+ * the output of the previous frame of the same stream, otherwise every
+ * command waits on a fence that is already signalled.
+ */
+static void cvp_test_fence_submit(struct kunit *test, struct cvp_test_pipe *p,
+		bool chained)
+{
+	struct cvp_fence_queue *q = &p->inst->fence_cmd_queue;
+	struct cvp_fence_command *fc;
+	LIST_HEAD(cmds);
+	int i, s, n;
+	s32 in;
+
+	for (n = 0; n < CVP_TEST_CMDS; n++) {
+		s = n % CVP_TEST_STREAMS;
+		i = n / CVP_TEST_STREAMS;
+
+		fc = kzalloc(sizeof(*fc), GFP_KERNEL);
+		KUNIT_ASSERT_NOT_ERR_OR_NULL(test, fc);
+		fc->pkt = kzalloc(sizeof(*fc->pkt), GFP_KERNEL);
+		KUNIT_ASSERT_NOT_ERR_OR_NULL(test, fc->pkt);
+
+		in = chained && i ? CVP_TEST_SYNX_BASE + n - CVP_TEST_STREAMS :
+			1 + s;
+		p->producer[n] = in >= CVP_TEST_SYNX_BASE ?
+			in - CVP_TEST_SYNX_BASE : -1;
+
+		fc->frame_id = n;
+		fc->num_fences = 2;
+		fc->output_index = 1;
+		fc->synx[0] = in;
+		fc->synx[1] = CVP_TEST_SYNX_BASE + n;
+		fc->dep_synx[0] = in;
+		fc->dep_synx[1] = CVP_TEST_SYNX_BASE + n;
+		list_add_tail(&fc->list, &cmds);
+	}
+
+	mutex_lock(&q->lock);
+	for (n = 0; n < CVP_TEST_CMDS; n++)
+		p->submit_ns[n] = ktime_get_ns();
+	list_splice_tail_init(&cmds, &q->wait_list);
+	mutex_unlock(&q->lock);
+
+	wake_up_all(&q->wq);
+}
+
+static void cvp_test_fence_pipeline(struct kunit *test, bool chained,
+		int num_workers)
+{
+	struct cvp_test_pipe *p;
+	struct cvp_test_worker *w;
+	struct msm_cvp_inst *inst;
+	struct cvp_fence_queue *q;
+	struct task_struct *task;
+	u64 start_ns, total_ns, lat_ns, sum_ns = 0, max_ns = 0;
+	int i, s;
+
+	p = kunit_kzalloc(test, sizeof(*p), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, p);
+	w = kunit_kcalloc(test, num_workers, sizeof(*w), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, w);
+	inst = kunit_kzalloc(test, sizeof(*inst), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, inst);
+	inst->core = kunit_kzalloc(test, sizeof(*inst->core), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, inst->core);
+	inst->core->synx_ftbl = &cvp_test_synx_ftbl;
+
+	p->inst = inst;
+	init_waitqueue_head(&p->synx_wq);
+	init_completion(&p->all_done);
+	for (s = 0; s < CVP_TEST_STREAMS; s++)
+		p->signaled[1 + s] = true;
+	cvp_test_pipe = p;
+
+	q = &inst->fence_cmd_queue;
+	cvp_test_fence_queue_init(q);
+
+	for (i = 0; i < num_workers; i++) {
+		w[i].pipe = p;
+		w[i].id = i;
+		init_completion(&p->worker_exit[i]);
+		task = kthread_run(cvp_test_fence_worker, &w[i],
+			"cvp_test_fence_%d", i);
+		KUNIT_ASSERT_FALSE(test, IS_ERR(task));
+	}
+
+	start_ns = ktime_get_ns();
+	cvp_test_fence_submit(test, p, chained);
+	KUNIT_EXPECT_NE(test, wait_for_completion_timeout(&p->all_done,
+		msecs_to_jiffies(CVP_TEST_WAIT_MS)), 0UL);
+	total_ns = ktime_get_ns() - start_ns;
+
+	mutex_lock(&q->lock);
+	q->state = QUEUE_STOP;
+	mutex_unlock(&q->lock);
+	wake_up_all(&q->wq);
+	for (i = 0; i < num_workers; i++)
+		wait_for_completion(&p->worker_exit[i]);
+
+	KUNIT_EXPECT_EQ(test, atomic_read(&p->num_done), CVP_TEST_CMDS);
+	KUNIT_EXPECT_EQ(test, atomic_read(&p->errors), 0);
+	KUNIT_EXPECT_TRUE(test, list_empty(&q->wait_list));
+	KUNIT_EXPECT_TRUE(test, list_empty(&q->sched_list));
+
+	for (i = 0; i < CVP_TEST_CMDS; i++) {
+		/* a consumer never starts before its producer signalled */
+		if (p->producer[i] >= 0)
+			KUNIT_EXPECT_GE(test, p->start_ns[i],
+				p->done_ns[p->producer[i]]);
+		lat_ns = p->done_ns[i] - p->submit_ns[i];
+		sum_ns += lat_ns;
+		max_ns = max(max_ns, lat_ns);
+	}
+
+	kunit_info(test, "%s, %d workers: %llu cmds/s, latency avg %llu us max %llu us\n",
+		chained ? "chained streams" : "independent", num_workers,
+		div64_u64((u64)CVP_TEST_CMDS * NSEC_PER_SEC, total_ns),
+		div_u64(sum_ns, CVP_TEST_CMDS * NSEC_PER_USEC),
+		div_u64(max_ns, NSEC_PER_USEC));
+
+	cvp_test_pipe = NULL;
+	mutex_destroy(&q->lock);
+}
+
+static void msm_cvp_test_fence_throughput(struct kunit *test)
+{
+	cvp_test_fence_pipeline(test, false, 1);
+	cvp_test_fence_pipeline(test, false, CVP_TEST_MAX_WORKERS);
+	cvp_test_fence_pipeline(test, true, 1);
+	cvp_test_fence_pipeline(test, true, CVP_TEST_MAX_WORKERS);
+}
+
+static struct kunit_case msm_cvp_fence_cases[] = {
+	KUNIT_CASE(msm_cvp_test_fence_order),
+	KUNIT_CASE(msm_cvp_test_fence_throughput),
+	{}
+};
+
+static struct kunit_suite msm_cvp_fence_suite = {
+	.name = "msm_cvp_fence",
+	.test_cases = msm_cvp_fence_cases,
+};
+
+kunit_test_suite(msm_cvp_fence_suite);
+
+MODULE_DESCRIPTION("EVA fenced command scheduling KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+
+#include "msm_cvp_buf.h"
+
+#define CVP_TEST_PERSIST_BUFS 8
+#define CVP_TEST_FRAME_BUFS 8
+#define CVP_TEST_MAX_FRAMES 64
+#define CVP_TEST_ROUNDS 16
+#define CVP_TEST_NUM_SMEM (MAX_DMABUF_NUMS + CVP_TEST_PERSIST_BUFS + \
+	CVP_TEST_MAX_FRAMES * CVP_TEST_FRAME_BUFS)
+
+static struct msm_cvp_smem *cvp_test_smem(struct kunit *test,
+		struct dma_buf *dma_buf, u32 bitmap_index, u32 flags)
+{
+	struct msm_cvp_smem *smem;
+
+	smem = kunit_kzalloc(test, sizeof(*smem), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, smem);
+	smem->dma_buf = dma_buf;
+	smem->bitmap_index = bitmap_index;
+	smem->flags = flags;
+
+	return smem;
+}
+
+static struct dma_buf *cvp_test_dma_buf(struct kunit *test)
+{
+	struct dma_buf *dma_buf;
+
+	/* only used as lookup key */
+	dma_buf = kunit_kzalloc(test, sizeof(*dma_buf), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dma_buf);
+
+	return dma_buf;
+}
+
+static void msm_cvp_test_smem_find(struct kunit *test)
+{
+	struct cvp_dmamap_cache *cache;
+	struct dma_buf *shared, *frame_buf, *unknown;
+	struct msm_cvp_smem *persist, *cached, *frame;
+
+	cache = kunit_kzalloc(test, sizeof(*cache), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, cache);
+	INIT_DMAMAP_CACHE(cache);
+
+	shared = cvp_test_dma_buf(test);
+	frame_buf = cvp_test_dma_buf(test);
+	unknown = cvp_test_dma_buf(test);
+
+	/* persist mapping added first, cache entry of the same dma_buf later */
+	persist = cvp_test_smem(test, shared, MAX_DMABUF_NUMS, SMEM_PERSIST);
+	cached = cvp_test_smem(test, shared, 3, 0);
+	/* frame buffer which did not fit into the full cache */
+	frame = cvp_test_smem(test, frame_buf, MAX_DMABUF_NUMS, 0);
+
+	mutex_lock(&cache->lock);
+	msm_cvp_smem_hash_add(cache, persist);
+	msm_cvp_smem_hash_add(cache, frame);
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, shared),
+		persist);
+
+	msm_cvp_smem_hash_add(cache, cached);
+	/* adding twice must not link the node twice */
+	msm_cvp_smem_hash_add(cache, cached);
+
+	/* cache entry wins over the persist mapping */
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, shared),
+		cached);
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, frame_buf),
+		frame);
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, unknown),
+		(struct msm_cvp_smem *)NULL);
+
+	/* cache entry evicted: persist mapping is found again */
+	msm_cvp_smem_hash_del(cached);
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, shared),
+		persist);
+
+	/* frame buffer released, deleting twice is harmless */
+	msm_cvp_smem_hash_del(frame);
+	msm_cvp_smem_hash_del(frame);
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, frame_buf),
+		(struct msm_cvp_smem *)NULL);
+
+	msm_cvp_smem_hash_del(persist);
+	KUNIT_EXPECT_PTR_EQ(test, msm_cvp_smem_hash_find(cache, shared),
+		(struct msm_cvp_smem *)NULL);
+	mutex_unlock(&cache->lock);
+
+	DEINIT_DMAMAP_CACHE(cache);
+}
+
+/*
+ * Reference for the search the hash replaced: cache entries first,
+ * then persist buffers, then the buffers of every in-flight frame.
+ */
+static struct msm_cvp_smem *cvp_test_linear_find(struct msm_cvp_smem **smems,
+		u32 nr, struct dma_buf *dma_buf)
+{
+	u32 i;
+
+	for (i = 0; i < nr; i++) {
+		if (smems[i]->dma_buf == dma_buf)
+			return smems[i];
+	}
+
+	return NULL;
+}
+
+static void msm_cvp_test_smem_frame_cost(struct kunit *test)
+{
+	static const u32 frames[] = {1, 2, 4, 8, 16, 32, CVP_TEST_MAX_FRAMES};
+	struct cvp_dmamap_cache *cache;
+	struct msm_cvp_smem **smems, *smem;
+	u64 start_ns, hash_ns, linear_ns;
+	u32 i, f, r, b, nr = 0, nr_frames = 0, misses = 0, base;
+
+	cache = kunit_kzalloc(test, sizeof(*cache), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, cache);
+	INIT_DMAMAP_CACHE(cache);
+
+	smems = kunit_kcalloc(test, CVP_TEST_NUM_SMEM, sizeof(*smems),
+		GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, smems);
+
+	/* a full cache and a few persist buffers, frames spill over */
+	for (i = 0; i < MAX_DMABUF_NUMS; i++)
+		smems[nr++] = cvp_test_smem(test, cvp_test_dma_buf(test), i, 0);
+	for (i = 0; i < CVP_TEST_PERSIST_BUFS; i++)
+		smems[nr++] = cvp_test_smem(test, cvp_test_dma_buf(test),
+			MAX_DMABUF_NUMS, SMEM_PERSIST);
+	base = nr;
+
+	mutex_lock(&cache->lock);
+	for (i = 0; i < nr; i++)
+		msm_cvp_smem_hash_add(cache, smems[i]);
+	mutex_unlock(&cache->lock);
+
+	for (f = 0; f < ARRAY_SIZE(frames); f++) {
+		/* bring the number of in-flight frames up to frames[f] */
+		for (; nr_frames < frames[f]; nr_frames++) {
+			for (b = 0; b < CVP_TEST_FRAME_BUFS; b++) {
+				smem = cvp_test_smem(test, cvp_test_dma_buf(test),
+					MAX_DMABUF_NUMS, 0);
+				smems[nr++] = smem;
+				mutex_lock(&cache->lock);
+				msm_cvp_smem_hash_add(cache, smem);
+				mutex_unlock(&cache->lock);
+			}
+		}
+
+		/* map every buffer of every in-flight frame, as map_frame does */
+		start_ns = ktime_get_ns();
+		for (r = 0; r < CVP_TEST_ROUNDS; r++) {
+			for (i = base; i < nr; i++) {
+				mutex_lock(&cache->lock);
+				smem = msm_cvp_smem_hash_find(cache,
+					smems[i]->dma_buf);
+				mutex_unlock(&cache->lock);
+				if (smem != smems[i])
+					misses++;
+			}
+		}
+		hash_ns = ktime_get_ns() - start_ns;
+
+		start_ns = ktime_get_ns();
+		for (r = 0; r < CVP_TEST_ROUNDS; r++) {
+			for (i = base; i < nr; i++) {
+				mutex_lock(&cache->lock);
+				smem = cvp_test_linear_find(smems, nr,
+					smems[i]->dma_buf);
+				mutex_unlock(&cache->lock);
+				if (smem != smems[i])
+					misses++;
+			}
+		}
+		linear_ns = ktime_get_ns() - start_ns;
+
+		kunit_info(test, "frames %u: hash %llu ns/frame, linear %llu ns/frame\n",
+			nr_frames, hash_ns / (CVP_TEST_ROUNDS * nr_frames),
+			linear_ns / (CVP_TEST_ROUNDS * nr_frames));
+	}
+
+	KUNIT_EXPECT_EQ(test, misses, 0U);
+
+	mutex_lock(&cache->lock);
+	for (i = 0; i < nr; i++)
+		msm_cvp_smem_hash_del(smems[i]);
+	for (i = 0; i < nr; i++)
+		KUNIT_EXPECT_PTR_EQ(test,
+			msm_cvp_smem_hash_find(cache, smems[i]->dma_buf),
+			(struct msm_cvp_smem *)NULL);
+	mutex_unlock(&cache->lock);
+
+	DEINIT_DMAMAP_CACHE(cache);
+}
+
+static struct kunit_case msm_cvp_smem_cases[] = {
+	KUNIT_CASE(msm_cvp_test_smem_find),
+	KUNIT_CASE(msm_cvp_test_smem_frame_cost),
+	{}
+};
+
+static struct kunit_suite msm_cvp_smem_suite = {
+	.name = "msm_cvp_smem",
+	.test_cases = msm_cvp_smem_cases,
+};
+
+kunit_test_suite(msm_cvp_smem_suite);
+
+MODULE_DESCRIPTION("EVA session smem lookup KUnit tests");
+MODULE_LICENSE("GPL v2");
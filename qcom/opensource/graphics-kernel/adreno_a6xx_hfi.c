@@ -11,6 +11,7 @@
 #include "adreno_a6xx.h"
 #include "adreno_a6xx_hfi.h"
 #include "kgsl_device.h"
+#include "kgsl_eventlog.h"
 #include "kgsl_trace.h"
 
 /* Below section is for all structures related to HFI queues */
@@ -89,6 +90,9 @@ int a6xx_hfi_queue_read(struct a6xx_gmu_device *gmu, uint32_t queue_idx,
 		trace_kgsl_hfi_receive(MSG_HDR_GET_ID(msg_hdr),
 			MSG_HDR_GET_SIZE(msg_hdr), MSG_HDR_GET_SEQNUM(msg_hdr));
 
+	log_kgsl_hfi_event(MSG_HDR_GET_ID(msg_hdr), MSG_HDR_GET_SIZE(msg_hdr),
+		MSG_HDR_GET_SEQNUM(msg_hdr), true);
+
 	hfi_update_read_idx(hdr, read);
 
 done:
@@ -114,6 +118,7 @@ int a6xx_hfi_queue_write(struct adreno_device *adreno_dev, uint32_t queue_idx,
 	queue = HOST_QUEUE_START_ADDR(gmu->hfi.hfi_mem, queue_idx);
 
 	trace_kgsl_hfi_send(id, size, MSG_HDR_GET_SEQNUM(*msg));
+	log_kgsl_hfi_event(id, size, MSG_HDR_GET_SEQNUM(*msg), false);
 
 	write_idx = hdr->write_index;
 	read_idx = hdr->read_index;
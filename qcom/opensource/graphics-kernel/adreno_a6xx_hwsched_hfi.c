@@ -1673,6 +1673,7 @@ static int a6xx_hfi_dispatch_queue_write(struct adreno_device *adreno_dev, uint3
 	adreno_profile_submit_time(time);
 
 	trace_kgsl_hfi_send(id, size, MSG_HDR_GET_SEQNUM(*msg));
+	log_kgsl_hfi_event(id, size, MSG_HDR_GET_SEQNUM(*msg), false);
 
 	hfi_update_write_idx(&hdr->write_index, write);
 
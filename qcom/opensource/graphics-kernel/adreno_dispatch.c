@@ -2271,6 +2271,7 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 
 	trace_adreno_cmdbatch_done(drawobj->context->id,
 		drawobj->context->priority, drawobj->timestamp);
+	kgsl_drawobj_cmd_mark_used(cmdobj);
 	kgsl_drawobj_destroy(drawobj);
 }
 
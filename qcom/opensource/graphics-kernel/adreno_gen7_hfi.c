@@ -11,6 +11,7 @@
 #include "adreno_gen7.h"
 #include "adreno_gen7_hfi.h"
 #include "kgsl_device.h"
+#include "kgsl_eventlog.h"
 #include "kgsl_trace.h"
 
 /* Below section is for all structures related to HFI queues */
@@ -93,6 +94,9 @@ int gen7_hfi_queue_read(struct gen7_gmu_device *gmu, u32 queue_idx,
 		trace_kgsl_hfi_receive(MSG_HDR_GET_ID(msg_hdr),
 			MSG_HDR_GET_SIZE(msg_hdr), MSG_HDR_GET_SEQNUM(msg_hdr));
 
+	log_kgsl_hfi_event(MSG_HDR_GET_ID(msg_hdr), MSG_HDR_GET_SIZE(msg_hdr),
+		MSG_HDR_GET_SEQNUM(msg_hdr), true);
+
 done:
 	return result;
 }
@@ -116,6 +120,7 @@ int gen7_hfi_queue_write(struct adreno_device *adreno_dev, u32 queue_idx,
 	queue = HOST_QUEUE_START_ADDR(gmu->hfi.hfi_mem, queue_idx);
 
 	trace_kgsl_hfi_send(id, size, MSG_HDR_GET_SEQNUM(*msg));
+	log_kgsl_hfi_event(id, size, MSG_HDR_GET_SEQNUM(*msg), false);
 
 	write_idx = hdr->write_index;
 	read_idx = hdr->read_index;
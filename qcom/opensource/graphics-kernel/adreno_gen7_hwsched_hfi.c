@@ -1944,6 +1944,7 @@ int gen7_gmu_context_queue_write(struct adreno_device *adreno_dev,
 	adreno_profile_submit_time(time);
 
 	trace_kgsl_hfi_send(id, size, MSG_HDR_GET_SEQNUM(*msg));
+	log_kgsl_hfi_event(id, size, MSG_HDR_GET_SEQNUM(*msg), false);
 
 	hfi_update_write_idx(&hdr->write_index, write_idx);
 
@@ -2173,6 +2174,7 @@ static int gen7_hfi_dispatch_queue_write(struct adreno_device *adreno_dev, u32 q
 	adreno_profile_submit_time(time);
 
 	trace_kgsl_hfi_send(id, size, MSG_HDR_GET_SEQNUM(*msg));
+	log_kgsl_hfi_event(id, size, MSG_HDR_GET_SEQNUM(*msg), false);
 
 	hfi_update_write_idx(&hdr->write_index, write);
 
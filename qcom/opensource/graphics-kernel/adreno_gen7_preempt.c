@@ -8,6 +8,7 @@
 #include "adreno_gen7.h"
 #include "adreno_pm4types.h"
 #include "adreno_trace.h"
+#include "kgsl_eventlog.h"
 
 #define PREEMPT_RECORD(_field) \
 		offsetof(struct gen7_cp_preemption_record, _field)
@@ -112,6 +113,8 @@ static void _gen7_preemption_done(struct adreno_device *adreno_dev)
 
 	trace_adreno_preempt_done(adreno_dev->cur_rb, adreno_dev->next_rb,
 		status);
+	log_kgsl_preempt_event(adreno_dev->cur_rb->id, adreno_dev->next_rb->id,
+		status);
 
 	/* Clean up all the bits */
 	adreno_dev->prev_rb = adreno_dev->cur_rb;
@@ -425,6 +428,8 @@ void gen7_preemption_callback(struct adreno_device *adreno_dev, int bit)
 
 	trace_adreno_preempt_done(adreno_dev->cur_rb, adreno_dev->next_rb,
 		status);
+	log_kgsl_preempt_event(adreno_dev->cur_rb->id, adreno_dev->next_rb->id,
+		status);
 
 	adreno_dev->prev_rb = adreno_dev->cur_rb;
 	adreno_dev->cur_rb = adreno_dev->next_rb;
@@ -1114,6 +1114,10 @@ void adreno_hwsched_retire_cmdobj(struct adreno_hwsched *hwsched,
 		atomic_inc(&drawobj->context->proc_priv->period->frames);
 	}
 
+	/* Commands of invalidated contexts are dropped here without running */
+	if (!kgsl_context_is_bad(context))
+		kgsl_drawobj_cmd_mark_used(cmdobj);
+
 	entry = cmdobj->profiling_buf_entry;
 	if (entry) {
 		profile_buffer = kgsl_gpuaddr_to_vaddr(&entry->memdesc,
@@ -2120,4 +2120,75 @@ struct kgsl_recurring_command {
 #define IOCTL_KGSL_RECURRING_COMMAND \
 	_IOWR(KGSL_IOC_TYPE, 0x5F, struct kgsl_recurring_command)
 
+/*
+ * Binary GPU event ring. The kgsl sysfs node gpu_event_ring can be mapped
+ * read-only, and only by its owner since it holds submission and timing data
+ * of all processes. It starts with a struct kgsl_event_ring_header followed by
+ * nr_cpus rings of ring_size bytes each. Every ring starts with a struct
+ * kgsl_event_ring_cpu followed by nr_records struct kgsl_event_record.
+ */
+#define KGSL_EVENT_RING_MAGIC 0x52564547
+#define KGSL_EVENT_RING_VERSION 1
+
+#define KGSL_EVENT_RING_SUBMIT 1
+#define KGSL_EVENT_RING_RETIRE 2
+#define KGSL_EVENT_RING_PREEMPT 3
+#define KGSL_EVENT_RING_HFI 4
+#define KGSL_EVENT_RING_PWRLEVEL 5
+
+/**
+ * struct kgsl_event_ring_header - Layout of the GPU event ring
+ * @magic: KGSL_EVENT_RING_MAGIC
+ * @version: KGSL_EVENT_RING_VERSION
+ * @nr_cpus: Number of per-CPU rings
+ * @ring_offset: Offset in bytes of the first per-CPU ring
+ * @ring_size: Size in bytes of each per-CPU ring including its header
+ * @nr_records: Number of records in each ring, always a power of two
+ * @record_size: Size in bytes of struct kgsl_event_record
+ */
+struct kgsl_event_ring_header {
+	__u32 magic;
+	__u32 version;
+	__u32 nr_cpus;
+	__u32 ring_offset;
+	__u32 ring_size;
+	__u32 nr_records;
+	__u32 record_size;
+	/* private: padding for 64 bit compatibility */
+	__u32 padding;
+};
+
+/**
+ * struct kgsl_event_ring_cpu - Per-CPU ring header
+ * @head: Number of records ever written on this CPU. Record n lives at
+ * index n % nr_records.
+ */
+struct kgsl_event_ring_cpu {
+	__u64 head;
+	/* private: keep each head in its own cache line */
+	__u64 padding[7];
+};
+
+/**
+ * struct kgsl_event_record - One binary GPU event
+ * @time: local_clock() time of the event in nanoseconds
+ * @seq: Zero while the record is being written, (n + 1) once record n is
+ * complete. Readers copy the record and discard it if @seq changed or does
+ * not match the slot they expected.
+ * @type: KGSL_EVENT_RING_* identifier
+ * @flags: Event specific flags
+ * @data: Event specific data:
+ *   SUBMIT/RETIRE: context id, timestamp, priority, drawobj flags
+ *   PREEMPT: current rb id, next rb id, status, 0
+ *   HFI: message id, size in dwords, sequence number, 1 if received
+ *   PWRLEVEL: new level, new frequency (kHz), old level, old frequency (kHz)
+ */
+struct kgsl_event_record {
+	__u64 time;
+	__u32 seq;
+	__u16 type;
+	__u16 flags;
+	__u32 data[4];
+};
+
 #endif /* _UAPI_MSM_KGSL_H */
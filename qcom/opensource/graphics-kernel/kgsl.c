@@ -260,6 +260,7 @@ static struct kgsl_mem_entry *kgsl_mem_entry_create(void)
 		kref_get(&entry->refcount);
 		atomic_set(&entry->map_count, 0);
 		atomic_set(&entry->vbo_count, 0);
+		entry->last_use = jiffies;
 	}
 
 	return entry;
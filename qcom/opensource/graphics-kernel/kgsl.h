@@ -350,6 +350,11 @@ struct kgsl_mem_entry {
 	atomic_t map_count;
 	/** @vbo_count: Count how many VBO ranges this entry is mapped in */
 	atomic_t vbo_count;
+	/**
+	 * @last_use: Jiffies when the entry was created, restored or last
+	 * referenced by a retired command
+	 */
+	unsigned long last_use;
 };
 
 struct kgsl_device_private;
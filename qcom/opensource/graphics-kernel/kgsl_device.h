@@ -83,6 +83,42 @@ struct kgsl_context;
 struct kgsl_power_stats;
 struct kgsl_event;
 struct kgsl_snapshot;
+struct crypto_comp;
+
+#define KGSL_SNAPSHOT_MAX_TIMED_SECTIONS 32
+
+/**
+ * struct kgsl_snapshot_section_time - Time spent on one snapshot section type
+ * @id: Section identifier (KGSL_SNAPSHOT_SECTION_*)
+ * @count: Number of sections of this type that were added
+ * @bytes: Total bytes written for sections of this type
+ * @usecs: Total time spent filling sections of this type
+ */
+struct kgsl_snapshot_section_time {
+	u16 id;
+	u32 count;
+	u64 bytes;
+	u64 usecs;
+};
+
+/**
+ * struct kgsl_snapshot_timing - Timing breakdown of the last snapshot
+ * @capture_usecs: Time spent in the target specific snapshot callback
+ * @objs_usecs: Time spent saving the frozen GPU objects
+ * @objs_bytes: Bytes of GPU object data frozen in the snapshot
+ * @objs_stored: Bytes actually stored for the GPU objects
+ * @nr_sections: Number of valid entries in @sections
+ * @sections: Per section type timing
+ */
+struct kgsl_snapshot_timing {
+	u64 capture_usecs;
+	u64 objs_usecs;
+	u64 objs_bytes;
+	u64 objs_stored;
+	u32 nr_sections;
+	struct kgsl_snapshot_section_time
+		sections[KGSL_SNAPSHOT_MAX_TIMED_SECTIONS];
+};
 struct kgsl_sync_fence;
 
 struct kgsl_functable {
@@ -274,6 +310,23 @@ struct kgsl_device {
 	bool snapshot_legacy;
 	/* Use to dump the context record in bytes */
 	u64 snapshot_ctxt_record_size;
+	/* Compress frozen GPU objects with LZ4 before they are stored */
+	bool snapshot_compress;
+	/** @snapshot_comp: LZ4 transform used for compressed snapshots */
+	struct crypto_comp *snapshot_comp;
+	/**
+	 * @snapshot_comp_lock: Serialises use of @snapshot_comp. The save
+	 * worker of a snapshot that is still being read can overlap with
+	 * the worker of the snapshot that replaced it.
+	 */
+	struct mutex snapshot_comp_lock;
+	/** @snapshot_timing: Per section timing of the last snapshot */
+	struct kgsl_snapshot_timing snapshot_timing;
+	/**
+	 * @snapshot_timing_lock: Protects @snapshot_timing against the
+	 * object save worker, which runs without the device mutex
+	 */
+	spinlock_t snapshot_timing_lock;
 
 	struct kobject snapshot_kobj;
 
@@ -514,6 +567,14 @@ struct kgsl_process_private {
 	 * @reclaim_lock: Mutex lock to protect KGSL_PROC_PINNED_STATE
 	 */
 	struct mutex reclaim_lock;
+	/** @reclaimed_bytes: Total bytes ever reclaimed from the process */
+	atomic64_t reclaimed_bytes;
+	/** @restored_bytes: Total bytes pinned back, protected by reclaim_lock */
+	u64 restored_bytes;
+	/** @restore_usecs: Duration of the last restore to pinned state */
+	u64 restore_usecs;
+	/** @restore_usecs_max: Longest restore to pinned state */
+	u64 restore_usecs_max;
 	/** @period: Stats for GPU utilization */
 	struct gpu_work_period *period;
 	/**
@@ -555,6 +616,8 @@ struct kgsl_device_private {
  * @timestamp: Timestamp of the snapshot instance (in seconds since boot)
  * @mempool: Pointer to the memory pool for storing memory objects
  * @mempool_size: Size of the memory pool
+ * @chunks: List of individually allocated (compressed) object sections
+ * @timing: Section timing to update, NULL for atomic snapshots
  * @obj_list: List of frozen GPU buffers that are waiting to be dumped.
  * @cp_list: List of IB's to be dumped.
  * @work: worker to dump the frozen memory
@@ -584,6 +647,8 @@ struct kgsl_snapshot {
 	unsigned long timestamp;
 	u8 *mempool;
 	size_t mempool_size;
+	struct list_head chunks;
+	struct kgsl_snapshot_timing *timing;
 	struct list_head obj_list;
 	struct list_head cp_list;
 	struct work_struct work;
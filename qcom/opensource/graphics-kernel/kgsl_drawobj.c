@@ -27,6 +27,7 @@
 #include "kgsl_device.h"
 #include "kgsl_drawobj.h"
 #include "kgsl_eventlog.h"
+#include "kgsl_reclaim.h"
 #include "kgsl_sync.h"
 #include "kgsl_timeline.h"
 #include "kgsl_trace.h"
@@ -443,6 +444,23 @@ static void cmdobj_destroy(struct kgsl_drawobj *drawobj)
 	}
 }
 
+/**
+ * kgsl_drawobj_cmd_mark_used() - Let reclaim know the buffers of a command
+ * were just used by the GPU
+ * @cmdobj: Command object that retired
+ *
+ * Only call this on retire, commands that were cancelled or failed never
+ * touched their buffers.
+ */
+void kgsl_drawobj_cmd_mark_used(struct kgsl_drawobj_cmd *cmdobj)
+{
+	struct kgsl_process_private *process =
+		DRAWOBJ(cmdobj)->context->proc_priv;
+
+	kgsl_reclaim_mark_used(process, &cmdobj->cmdlist);
+	kgsl_reclaim_mark_used(process, &cmdobj->memlist);
+}
+
 /**
  * kgsl_drawobj_destroy() - Destroy a kgsl object structure
  * @obj: Pointer to the kgsl object to destroy
@@ -269,6 +269,8 @@ void kgsl_dump_syncpoints(struct kgsl_device *device,
 
 void kgsl_drawobj_destroy(struct kgsl_drawobj *drawobj);
 
+void kgsl_drawobj_cmd_mark_used(struct kgsl_drawobj_cmd *cmdobj);
+
 void kgsl_drawobj_destroy_object(struct kref *kref);
 
 static inline bool kgsl_drawobj_events_pending(
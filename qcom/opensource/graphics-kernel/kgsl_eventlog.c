@@ -3,10 +3,13 @@
  * Copyright (c) 2021, The Linux Foundation. All rights reserved.
  */
 
+#include <asm/local.h>
+#include <linux/mm.h>
 #include <linux/sched.h>
 #include <linux/sched/clock.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
+#include <linux/vmalloc.h>
 
 #include "kgsl_device.h"
 #include "kgsl_eventlog.h"
@@ -34,6 +37,208 @@ static spinlock_t lock;
 static void *kgsl_eventlog;
 static int eventlog_wptr;
 
+/*
+ * The binary event ring is a set of per-CPU rings of fixed size records.
+ * Writers only touch the ring of the CPU they run on and claim a slot with a
+ * local (interrupt safe) increment, so no lock is shared between CPUs. The
+ * area is built from individually refcounted pages. The kernel writes through
+ * a vmap() of them and userspace maps them read-only through a fault handler,
+ * so every user mapping holds its own page references for continuous
+ * telemetry.
+ */
+#define EVENT_RING_RECORDS 1024
+
+/* Kernel view of struct kgsl_event_ring_cpu */
+struct event_ring_cpu {
+	local_t head;
+	u8 padding[sizeof(struct kgsl_event_ring_cpu) - sizeof(local_t)];
+	struct kgsl_event_record records[EVENT_RING_RECORDS];
+};
+
+static void *event_ring;
+static size_t event_ring_size;
+static struct page **event_ring_pages;
+static unsigned int event_ring_nr_pages;
+
+static inline struct event_ring_cpu *event_ring_get_cpu(void *base, int cpu)
+{
+	struct kgsl_event_ring_header *header = base;
+
+	return base + header->ring_offset + (cpu * header->ring_size);
+}
+
+static void event_ring_write(u16 type, u32 d0, u32 d1, u32 d2, u32 d3)
+{
+	struct kgsl_event_record *rec;
+	struct event_ring_cpu *ring;
+	unsigned long n;
+	void *base;
+
+	/* Disabling preemption also keeps the ring alive, see event_ring_exit */
+	preempt_disable();
+
+	base = READ_ONCE(event_ring);
+	if (!base) {
+		preempt_enable();
+		return;
+	}
+
+	ring = event_ring_get_cpu(base, smp_processor_id());
+
+	n = local_inc_return(&ring->head) - 1;
+	rec = &ring->records[n & (EVENT_RING_RECORDS - 1)];
+
+	/* Invalidate the slot before overwriting it */
+	WRITE_ONCE(rec->seq, 0);
+	smp_wmb();
+
+	rec->time = local_clock();
+	rec->type = type;
+	rec->flags = 0;
+	rec->data[0] = d0;
+	rec->data[1] = d1;
+	rec->data[2] = d2;
+	rec->data[3] = d3;
+
+	/* Publish the record only once all of its fields are written */
+	smp_wmb();
+	WRITE_ONCE(rec->seq, (u32)n + 1);
+
+	preempt_enable();
+}
+
+static ssize_t event_ring_read(struct file *filp, struct kobject *kobj,
+		struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+	if (!event_ring || off >= event_ring_size)
+		return 0;
+
+	count = min_t(size_t, count, event_ring_size - off);
+	memcpy(buf, event_ring + off, count);
+
+	return count;
+}
+
+static vm_fault_t event_ring_fault(struct vm_fault *vmf)
+{
+	struct page *page;
+
+	if (vmf->pgoff >= event_ring_nr_pages)
+		return VM_FAULT_SIGBUS;
+
+	/* The mapping keeps this reference until the pte is zapped */
+	page = event_ring_pages[vmf->pgoff];
+	get_page(page);
+	vmf->page = page;
+
+	return 0;
+}
+
+static const struct vm_operations_struct event_ring_vm_ops = {
+	.fault = event_ring_fault,
+};
+
+static int event_ring_mmap(struct file *filp, struct kobject *kobj,
+		struct bin_attribute *attr, struct vm_area_struct *vma)
+{
+	if (!event_ring)
+		return -ENODEV;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	if (vma->vm_pgoff + vma_pages(vma) > event_ring_nr_pages)
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_ops = &event_ring_vm_ops;
+
+	return 0;
+}
+
+static struct bin_attribute event_ring_attr = {
+	.attr.name = "gpu_event_ring",
+	.attr.mode = 0400,
+	.read = event_ring_read,
+	.mmap = event_ring_mmap,
+};
+
+static void event_ring_init(void)
+{
+	struct kgsl_event_ring_header *header;
+	size_t ring_size = ALIGN(sizeof(struct event_ring_cpu), SMP_CACHE_BYTES);
+	size_t offset = ALIGN(sizeof(*header), SMP_CACHE_BYTES);
+	size_t size = PAGE_ALIGN(offset + (ring_size * nr_cpu_ids));
+	unsigned int i, nr_pages = size >> PAGE_SHIFT;
+	struct page **pages;
+
+	pages = kcalloc(nr_pages, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		return;
+
+	for (i = 0; i < nr_pages; i++) {
+		pages[i] = alloc_page(GFP_KERNEL | __GFP_ZERO);
+		if (!pages[i])
+			goto err;
+	}
+
+	header = vmap(pages, nr_pages, VM_MAP, PAGE_KERNEL);
+	if (!header)
+		goto err;
+
+	header->magic = KGSL_EVENT_RING_MAGIC;
+	header->version = KGSL_EVENT_RING_VERSION;
+	header->nr_cpus = nr_cpu_ids;
+	header->ring_offset = offset;
+	header->ring_size = ring_size;
+	header->nr_records = EVENT_RING_RECORDS;
+	header->record_size = sizeof(struct kgsl_event_record);
+
+	event_ring_attr.size = size;
+	event_ring_size = size;
+	event_ring_pages = pages;
+	event_ring_nr_pages = nr_pages;
+	event_ring = header;
+
+	if (sysfs_create_bin_file(&kgsl_driver.virtdev.kobj, &event_ring_attr))
+		pr_err("kgsl: Unable to create the gpu_event_ring node\n");
+
+	return;
+err:
+	while (i--)
+		__free_page(pages[i]);
+	kfree(pages);
+}
+
+static void event_ring_exit(void)
+{
+	void *ring = event_ring;
+	unsigned int i;
+
+	if (!ring)
+		return;
+
+	/*
+	 * Removing the node zaps the user mappings and fails any later fault
+	 * on them, so the fault handler is done with the page array after this.
+	 */
+	sysfs_remove_bin_file(&kgsl_driver.virtdev.kobj, &event_ring_attr);
+
+	WRITE_ONCE(event_ring, NULL);
+	/* Wait for writers that still see the ring with preemption disabled */
+	synchronize_rcu();
+	vunmap(ring);
+
+	/* Pages still referenced by a user of the mapping are freed with it */
+	for (i = 0; i < event_ring_nr_pages; i++)
+		put_page(event_ring_pages[i]);
+
+	kfree(event_ring_pages);
+	event_ring_pages = NULL;
+	event_ring_nr_pages = 0;
+}
+
 struct kgsl_log_header {
 	u32 magic;
 	int pid;
@@ -95,10 +300,14 @@ void kgsl_eventlog_init(void)
 
 	kgsl_add_to_minidump("KGSL_EVENTLOG", (u64) kgsl_eventlog,
 				__pa(kgsl_eventlog), EVENTLOG_SIZE);
+
+	event_ring_init();
 }
 
 void kgsl_eventlog_exit(void)
 {
+	event_ring_exit();
+
 	kgsl_remove_from_minidump("KGSL_EVENTLOG", (u64) kgsl_eventlog,
 				__pa(kgsl_eventlog), EVENTLOG_SIZE);
 
@@ -135,6 +344,8 @@ void log_kgsl_cmdbatch_submitted_event(u32 id, u32 ts, u32 prio, u64 flags)
 		u64 flags;
 	} *entry;
 
+	event_ring_write(KGSL_EVENT_RING_SUBMIT, id, ts, prio, flags);
+
 	entry = kgsl_eventlog_alloc(LOG_CMDBATCH_SUBMITTED_EVENT, sizeof(*entry));
 	if (!entry)
 		return;
@@ -157,6 +368,8 @@ void log_kgsl_cmdbatch_retired_event(u32 id, u32 ts, u32 prio, u64 flags,
 		u64 retire;
 	} *entry;
 
+	event_ring_write(KGSL_EVENT_RING_RETIRE, id, ts, prio, flags);
+
 	entry = kgsl_eventlog_alloc(LOG_CMDBATCH_RETIRED_EVENT, sizeof(*entry));
 	if (!entry)
 		return;
@@ -230,3 +443,20 @@ void log_kgsl_timeline_fence_release_event(u32 id, u64 seqno)
 	entry->id = id;
 	entry->seqno = seqno;
 }
+
+void log_kgsl_preempt_event(u32 cur_rb, u32 next_rb, u32 status)
+{
+	event_ring_write(KGSL_EVENT_RING_PREEMPT, cur_rb, next_rb, status, 0);
+}
+
+void log_kgsl_hfi_event(u32 id, u32 size, u32 seqnum, bool receive)
+{
+	event_ring_write(KGSL_EVENT_RING_HFI, id, size, seqnum, receive);
+}
+
+void log_kgsl_pwrlevel_event(u32 new_level, u32 new_freq, u32 old_level,
+		u32 old_freq)
+{
+	event_ring_write(KGSL_EVENT_RING_PWRLEVEL, new_level, new_freq / 1000,
+		old_level, old_freq / 1000);
+}
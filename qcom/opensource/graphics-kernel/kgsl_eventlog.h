@@ -17,4 +17,8 @@ void log_kgsl_syncpoint_fence_event(u32 id, char *fence_name);
 void log_kgsl_syncpoint_fence_expire_event(u32 id, char *fence_name);
 void log_kgsl_timeline_fence_alloc_event(u32 id, u64 seqno);
 void log_kgsl_timeline_fence_release_event(u32 id, u64 seqno);
+void log_kgsl_preempt_event(u32 cur_rb, u32 next_rb, u32 status);
+void log_kgsl_hfi_event(u32 id, u32 size, u32 seqnum, bool receive);
+void log_kgsl_pwrlevel_event(u32 new_level, u32 new_freq, u32 old_level,
+		u32 old_freq);
 #endif
@@ -269,17 +269,13 @@ static void kgsl_iommu_flush_tlb(struct kgsl_mmu *mmu)
 		iommu_flush_iotlb_all(to_iommu_domain(&iommu->lpac_context));
 }
 
-static int _iopgtbl_unmap(struct kgsl_iommu_pt *pt, u64 gpuaddr, size_t size)
+static int _iopgtbl_unmap_noflush(struct kgsl_iommu_pt *pt, u64 gpuaddr,
+	size_t size)
 {
 	struct io_pgtable_ops *ops = pt->pgtbl_ops;
-	int ret = 0;
 
-	if (ops->unmap_pages) {
-		ret = _iopgtbl_unmap_pages(pt, gpuaddr, size);
-		if (ret)
-			return ret;
-		goto flush;
-	}
+	if (ops->unmap_pages)
+		return _iopgtbl_unmap_pages(pt, gpuaddr, size);
 
 	while (size) {
 		if ((ops->unmap(ops, gpuaddr, PAGE_SIZE, NULL)) != PAGE_SIZE)
@@ -289,26 +285,40 @@ static int _iopgtbl_unmap(struct kgsl_iommu_pt *pt, u64 gpuaddr, size_t size)
 		size -= PAGE_SIZE;
 	}
 
-flush:
+	return 0;
+}
+
+static void kgsl_iommu_flush_unmapped(struct kgsl_mmu *mmu)
+{
 	/*
 	 * Skip below logic for 5.15 kernel version and above as
 	 * qcom_skip_tlb_management() API takes care of avoiding
 	 * TLB operations during slumber.
 	 */
 	if (KERNEL_VERSION(5, 15, 0) > LINUX_VERSION_CODE) {
-		struct kgsl_device *device = KGSL_MMU_DEVICE(pt->base.mmu);
+		struct kgsl_device *device = KGSL_MMU_DEVICE(mmu);
 
 		/* Skip TLB Operations if GPU is in slumber */
 		if (mutex_trylock(&device->mutex)) {
 			if (device->state == KGSL_STATE_SLUMBER) {
 				mutex_unlock(&device->mutex);
-				return 0;
+				return;
 			}
 			mutex_unlock(&device->mutex);
 		}
 	}
 
-	kgsl_iommu_flush_tlb(pt->base.mmu);
+	kgsl_iommu_flush_tlb(mmu);
+}
+
+static int _iopgtbl_unmap(struct kgsl_iommu_pt *pt, u64 gpuaddr, size_t size)
+{
+	int ret = _iopgtbl_unmap_noflush(pt, gpuaddr, size);
+
+	if (ret)
+		return ret;
+
+	kgsl_iommu_flush_unmapped(pt->base.mmu);
 	return 0;
 }
 
@@ -521,6 +531,13 @@ static int kgsl_iopgtbl_unmap(struct kgsl_pagetable *pagetable,
 		kgsl_memdesc_footprint(memdesc));
 }
 
+static int kgsl_iopgtbl_unmap_noflush(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc)
+{
+	return _iopgtbl_unmap_noflush(to_iommu_pt(pagetable), memdesc->gpuaddr,
+		kgsl_memdesc_footprint(memdesc));
+}
+
 static int _iommu_unmap(struct iommu_domain *domain, u64 addr, size_t size)
 {
 	size_t unmapped = 0;
@@ -2690,6 +2707,7 @@ static const struct kgsl_mmu_ops kgsl_iommu_ops = {
 	.mmu_getpagetable = kgsl_iommu_getpagetable,
 	.mmu_map_global = kgsl_iommu_map_global,
 	.mmu_send_tlb_hint = kgsl_iommu_send_tlb_hint,
+	.mmu_flush_tlb = kgsl_iommu_flush_unmapped,
 };
 
 static const struct kgsl_mmu_pt_ops iopgtbl_pt_ops = {
@@ -2697,6 +2715,7 @@ static const struct kgsl_mmu_pt_ops iopgtbl_pt_ops = {
 	.mmu_map_child = kgsl_iopgtbl_map_child,
 	.mmu_map_zero_page_to_range = kgsl_iopgtbl_map_zero_page_to_range,
 	.mmu_unmap = kgsl_iopgtbl_unmap,
+	.mmu_unmap_noflush = kgsl_iopgtbl_unmap_noflush,
 	.mmu_unmap_range = kgsl_iopgtbl_unmap_range,
 	.mmu_destroy_pagetable = kgsl_iommu_destroy_pagetable,
 	.get_ttbr0 = kgsl_iommu_get_ttbr0,
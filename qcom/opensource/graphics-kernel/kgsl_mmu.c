@@ -434,9 +434,9 @@ int kgsl_mmu_svm_range(struct kgsl_pagetable *pagetable,
 	return -ENODEV;
 }
 
-int
-kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
-		struct kgsl_memdesc *memdesc)
+static int
+_kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, bool flush)
 {
 	int ret = 0;
 	struct kgsl_device *device = KGSL_MMU_DEVICE(pagetable->mmu);
@@ -456,7 +456,11 @@ kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
 
 		size = kgsl_memdesc_footprint(memdesc);
 
-		ret = pagetable->pt_ops->mmu_unmap(pagetable, memdesc);
+		if (!flush && PT_OP_VALID(pagetable, mmu_unmap_noflush))
+			ret = pagetable->pt_ops->mmu_unmap_noflush(pagetable,
+				memdesc);
+		else
+			ret = pagetable->pt_ops->mmu_unmap(pagetable, memdesc);
 		if (ret)
 			return ret;
 
@@ -474,6 +478,29 @@ kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
 	return ret;
 }
 
+int
+kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc)
+{
+	return _kgsl_mmu_unmap(pagetable, memdesc, true);
+}
+
+/**
+ * kgsl_mmu_unmap_noflush - Unmap a buffer without invalidating the TLB
+ * @pagetable: Pagetable the buffer is mapped in
+ * @memdesc: Memory descriptor to unmap
+ *
+ * Pagetables that can't defer the invalidation still flush as part of the
+ * unmap.
+ * Callers must call kgsl_mmu_flush_tlb() before releasing the pages.
+ */
+int
+kgsl_mmu_unmap_noflush(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc)
+{
+	return _kgsl_mmu_unmap(pagetable, memdesc, false);
+}
+
 int
 kgsl_mmu_unmap_range(struct kgsl_pagetable *pagetable,
 		struct kgsl_memdesc *memdesc, u64 offset, u64 length)
@@ -112,6 +112,7 @@ struct kgsl_mmu_ops {
 	void (*mmu_map_global)(struct kgsl_mmu *mmu,
 		struct kgsl_memdesc *memdesc, u32 padding);
 	void (*mmu_send_tlb_hint)(struct kgsl_mmu *mmu, bool hint);
+	void (*mmu_flush_tlb)(struct kgsl_mmu *mmu);
 };
 
 struct kgsl_mmu_pt_ops {
@@ -125,6 +126,8 @@ struct kgsl_mmu_pt_ops {
 		struct kgsl_memdesc *memdesc, u64 start, u64 length);
 	int (*mmu_unmap)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc);
+	int (*mmu_unmap_noflush)(struct kgsl_pagetable *pt,
+			struct kgsl_memdesc *memdesc);
 	int (*mmu_unmap_range)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc, u64 offset, u64 length);
 	void (*mmu_destroy_pagetable)(struct kgsl_pagetable *pt);
@@ -221,6 +224,8 @@ int kgsl_mmu_map_zero_page_to_range(struct kgsl_pagetable *pt,
 		struct kgsl_memdesc *memdesc, u64 start, u64 length);
 int kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
 		    struct kgsl_memdesc *memdesc);
+int kgsl_mmu_unmap_noflush(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc);
 int kgsl_mmu_unmap_range(struct kgsl_pagetable *pt,
 		struct kgsl_memdesc *memdesc, u64 offset, u64 length);
 unsigned int kgsl_mmu_log_fault_addr(struct kgsl_mmu *mmu,
@@ -371,6 +376,19 @@ static inline void kgsl_mmu_send_tlb_hint(struct kgsl_mmu *mmu, bool hint)
 		return mmu->mmu_ops->mmu_send_tlb_hint(mmu, hint);
 }
 
+/**
+ * kgsl_mmu_flush_tlb - Flush the TLB after a batch of unmaps
+ * @mmu: Pointer to the KGSL MMU
+ *
+ * Must be called after kgsl_mmu_unmap_noflush() and before the pages backing
+ * the unmapped buffers are released.
+ */
+static inline void kgsl_mmu_flush_tlb(struct kgsl_mmu *mmu)
+{
+	if (MMU_OP_VALID(mmu, mmu_flush_tlb))
+		mmu->mmu_ops->mmu_flush_tlb(mmu);
+}
+
 /**
  * kgsl_mmu_map_global - Map a memdesc as a global buffer
  * @device: A KGSL GPU device handle
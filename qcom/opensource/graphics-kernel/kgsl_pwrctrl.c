@@ -15,6 +15,7 @@
 
 #include "kgsl_device.h"
 #include "kgsl_bus.h"
+#include "kgsl_eventlog.h"
 #include "kgsl_pwrscale.h"
 #include "kgsl_sysfs.h"
 #include "kgsl_trace.h"
@@ -250,6 +251,9 @@ void kgsl_pwrctrl_pwrlevel_change(struct kgsl_device *device,
 
 	trace_gpu_frequency(pwrlevel->gpu_freq/1000, 0);
 
+	log_kgsl_pwrlevel_event(pwr->active_pwrlevel, pwrlevel->gpu_freq,
+		pwr->previous_pwrlevel, pwr->pwrlevels[old_level].gpu_freq);
+
 	/*
 	 * Some targets do not support the bandwidth requirement of
 	 * GPU at TURBO, for such targets we need to set GPU-BIMC
@@ -7,6 +7,7 @@
 #include <linux/kthread.h>
 #include <linux/notifier.h>
 #include <linux/shmem_fs.h>
+#include <linux/sort.h>
 
 #include "kgsl_reclaim.h"
 #include "kgsl_sharedmem.h"
@@ -24,7 +25,25 @@ static u32 kgsl_reclaim_max_page_limit = 7680;
 /* Setting this to 0 means we reclaim pages as specified in shrinker call */
 static u32 kgsl_nr_to_scan;
 
-struct work_struct reclaim_work;
+/*
+ * Number of pages background processes may keep pinned before reclaim is
+ * started without waiting for the shrinker. Setting this to 0 disables
+ * proactive reclaim.
+ */
+static u32 kgsl_reclaim_watermark;
+
+/*
+ * Upper bound on the number of entries ranked in one reclaim pass. Entries
+ * that don't fit are considered again in the next pass.
+ */
+#define KGSL_RECLAIM_MAX_CANDIDATES 1024
+
+struct kgsl_reclaim_candidate {
+	struct kgsl_mem_entry *entry;
+	unsigned long last_use;
+};
+
+static struct work_struct reclaim_work;
 
 static atomic_t kgsl_nr_to_reclaim;
 
@@ -63,6 +82,7 @@ static int kgsl_memdesc_get_reclaimed_pages(struct kgsl_mem_entry *entry)
 	if (ret)
 		return ret;
 
+	entry->last_use = jiffies;
 	trace_kgsl_reclaim_memdesc(entry, false);
 
 	memdesc->priv &= ~KGSL_MEMDESC_RECLAIMED;
@@ -75,13 +95,15 @@ int kgsl_reclaim_to_pinned_state(
 		struct kgsl_process_private *process)
 {
 	struct kgsl_mem_entry *entry, *valid_entry;
-	int next = 0, ret = 0, count;
+	int next = 0, ret = 0, count, restored;
+	ktime_t start;
 
 	mutex_lock(&process->reclaim_lock);
 
 	if (test_bit(KGSL_PROC_PINNED_STATE, &process->state))
-		goto done;
+		goto unlock;
 
+	start = ktime_get();
 	count = atomic_read(&process->unpinned_page_count);
 
 	for ( ; ; ) {
@@ -110,10 +132,84 @@ int kgsl_reclaim_to_pinned_state(
 	trace_kgsl_reclaim_process(process, count, false);
 	set_bit(KGSL_PROC_PINNED_STATE, &process->state);
 done:
+	restored = count - atomic_read(&process->unpinned_page_count);
+	if (restored > 0)
+		process->restored_bytes += (u64)restored << PAGE_SHIFT;
+
+	process->restore_usecs = ktime_us_delta(ktime_get(), start);
+	process->restore_usecs_max = max(process->restore_usecs_max,
+		process->restore_usecs);
+unlock:
 	mutex_unlock(&process->reclaim_lock);
 	return ret;
 }
 
+/**
+ * kgsl_reclaim_mark_used - Update the last use of the entries in a command
+ * @process: Process that submitted the command
+ * @head: cmdlist or memlist of the command
+ *
+ * Called as the command is retired so that reclaim can pick the buffers that
+ * have not been used by the GPU for the longest time first.
+ */
+void kgsl_reclaim_mark_used(struct kgsl_process_private *process,
+		struct list_head *head)
+{
+	struct kgsl_memobj_node *mem;
+	unsigned long now = jiffies;
+
+	if (list_empty(head))
+		return;
+
+	spin_lock(&process->mem_lock);
+	list_for_each_entry(mem, head, node) {
+		struct kgsl_mem_entry *entry;
+
+		if (!mem->id)
+			continue;
+
+		entry = idr_find(&process->mem_idr, mem->id);
+		if (entry)
+			WRITE_ONCE(entry->last_use, now);
+	}
+	spin_unlock(&process->mem_lock);
+}
+
+/*
+ * Start reclaim if the pages held by background processes cross the
+ * configured watermark instead of waiting for kswapd to ask for them.
+ */
+static void kgsl_reclaim_proactive(void)
+{
+	struct kgsl_process_private *process;
+	u64 resident = 0;
+
+	if (!kgsl_reclaim_watermark)
+		return;
+
+	read_lock(&kgsl_driver.proclist_lock);
+	list_for_each_entry(process, &kgsl_driver.process_list, list) {
+		u64 pages, unpinned;
+
+		if (test_bit(KGSL_PROC_STATE, &process->state))
+			continue;
+
+		pages = atomic64_read(&process->stats[KGSL_MEM_ENTRY_KERNEL].cur)
+			>> PAGE_SHIFT;
+		unpinned = atomic_read(&process->unpinned_page_count);
+		if (pages > unpinned)
+			resident += pages - unpinned;
+	}
+	read_unlock(&kgsl_driver.proclist_lock);
+
+	if (resident <= kgsl_reclaim_watermark)
+		return;
+
+	atomic_set(&kgsl_nr_to_reclaim,
+		min_t(u64, resident - kgsl_reclaim_watermark, INT_MAX));
+	kgsl_schedule_work(&reclaim_work);
+}
+
 static void kgsl_reclaim_foreground_work(struct work_struct *work)
 {
 	struct kgsl_process_private *process =
@@ -147,7 +243,8 @@ static ssize_t kgsl_proc_state_store(struct kobject *kobj,
 			kgsl_process_private_get(process))
 			kgsl_schedule_work(&process->fg_work);
 	} else if (sysfs_streq(buf, "background")) {
-		clear_bit(KGSL_PROC_STATE, &process->state);
+		if (test_and_clear_bit(KGSL_PROC_STATE, &process->state))
+			kgsl_reclaim_proactive();
 	} else
 		return -EINVAL;
 
@@ -164,12 +261,49 @@ static ssize_t gpumem_reclaimed_show(struct kobject *kobj,
 		atomic_read(&process->unpinned_page_count) << PAGE_SHIFT);
 }
 
+static ssize_t gpumem_reclaimed_total_show(struct kobject *kobj,
+		struct kgsl_process_attribute *attr, char *buf)
+{
+	struct kgsl_process_private *process =
+		container_of(kobj, struct kgsl_process_private, kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%lld\n",
+		atomic64_read(&process->reclaimed_bytes));
+}
+
+static ssize_t gpumem_restored_show(struct kobject *kobj,
+		struct kgsl_process_attribute *attr, char *buf)
+{
+	struct kgsl_process_private *process =
+		container_of(kobj, struct kgsl_process_private, kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%llu\n",
+		READ_ONCE(process->restored_bytes));
+}
+
+static ssize_t gpumem_restore_latency_show(struct kobject *kobj,
+		struct kgsl_process_attribute *attr, char *buf)
+{
+	struct kgsl_process_private *process =
+		container_of(kobj, struct kgsl_process_private, kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "last: %lluus max: %lluus\n",
+		READ_ONCE(process->restore_usecs),
+		READ_ONCE(process->restore_usecs_max));
+}
+
 PROCESS_ATTR(state, 0644, kgsl_proc_state_show, kgsl_proc_state_store);
 PROCESS_ATTR(gpumem_reclaimed, 0444, gpumem_reclaimed_show, NULL);
+PROCESS_ATTR(gpumem_reclaimed_total, 0444, gpumem_reclaimed_total_show, NULL);
+PROCESS_ATTR(gpumem_restored, 0444, gpumem_restored_show, NULL);
+PROCESS_ATTR(gpumem_restore_latency, 0444, gpumem_restore_latency_show, NULL);
 
 static const struct attribute *proc_reclaim_attrs[] = {
 	&attr_state.attr,
 	&attr_gpumem_reclaimed.attr,
+	&attr_gpumem_reclaimed_total.attr,
+	&attr_gpumem_restored.attr,
+	&attr_gpumem_restore_latency.attr,
 	NULL,
 };
 
@@ -208,111 +342,184 @@ ssize_t kgsl_nr_to_scan_show(struct device *dev,
 	return scnprintf(buf, PAGE_SIZE, "%d\n", kgsl_nr_to_scan);
 }
 
-static u32 kgsl_reclaim_process(struct kgsl_process_private *process,
-		u32 pages_to_reclaim)
+ssize_t kgsl_reclaim_watermark_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
 {
-	struct kgsl_memdesc *memdesc;
-	struct kgsl_mem_entry *entry, *valid_entry;
-	u32 next = 0, remaining = pages_to_reclaim;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &kgsl_reclaim_watermark);
+	if (ret)
+		return ret;
 
+	kgsl_reclaim_proactive();
+	return count;
+}
+
+ssize_t kgsl_reclaim_watermark_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", kgsl_reclaim_watermark);
+}
+
+static bool kgsl_reclaim_entry_valid(struct kgsl_mem_entry *entry)
+{
+	struct kgsl_memdesc *memdesc = &entry->memdesc;
+
+	/* Do not reclaim pages mapped into a VBO */
+	return !entry->pending_free &&
+		(memdesc->priv & KGSL_MEMDESC_CAN_RECLAIM) &&
+		!(memdesc->priv & KGSL_MEMDESC_RECLAIMED) &&
+		!(memdesc->priv & KGSL_MEMDESC_SKIP_RECLAIM) &&
+		!atomic_read(&entry->vbo_count) &&
+		memdesc->page_count <= kgsl_reclaim_max_page_limit;
+}
+
+static bool kgsl_reclaim_abort(struct kgsl_process_private *process)
+{
 	/*
-	 * If we do not get the lock here, it means that the buffers are
-	 * being pinned back. So do not keep waiting here as we would anyway
-	 * return empty handed once the lock is acquired.
+	 * Abort reclaim if process submitted work or if the process foreground
+	 * hint is received.
 	 */
-	if (!mutex_trylock(&process->reclaim_lock))
-		return 0;
+	return atomic_read(&process->cmd_count) ||
+		test_bit(KGSL_PROC_STATE, &process->state);
+}
 
-	while (remaining) {
+static int kgsl_reclaim_add_candidates(struct kgsl_process_private *process,
+		struct kgsl_reclaim_candidate *cands, int count, int max)
+{
+	struct kgsl_mem_entry *entry;
+	int id;
 
-		if (atomic_read(&process->unpinned_page_count) >=
-				kgsl_reclaim_max_page_limit)
+	spin_lock(&process->mem_lock);
+	idr_for_each_entry(&process->mem_idr, entry, id) {
+		if (count == max)
 			break;
 
-		/* Abort reclaim if process submitted work. */
-		if (atomic_read(&process->cmd_count))
-			break;
+		if (!kgsl_reclaim_entry_valid(entry) ||
+				!kgsl_mem_entry_get(entry))
+			continue;
 
-		/* Abort reclaim if process foreground hint is received. */
-		if (test_bit(KGSL_PROC_STATE, &process->state))
-			break;
+		cands[count].entry = entry;
+		cands[count].last_use = READ_ONCE(entry->last_use);
+		count++;
+	}
+	spin_unlock(&process->mem_lock);
 
-		valid_entry = NULL;
-		spin_lock(&process->mem_lock);
-		entry = idr_get_next(&process->mem_idr, &next);
-		if (entry == NULL) {
-			spin_unlock(&process->mem_lock);
-			break;
-		}
+	return count;
+}
 
-		memdesc = &entry->memdesc;
-		if (!entry->pending_free &&
-				(memdesc->priv & KGSL_MEMDESC_CAN_RECLAIM) &&
-				!(memdesc->priv & KGSL_MEMDESC_RECLAIMED) &&
-				!(memdesc->priv & KGSL_MEMDESC_SKIP_RECLAIM))
-			valid_entry = kgsl_mem_entry_get(entry);
-		spin_unlock(&process->mem_lock);
+/* Oldest entries first, bigger entries first among equally old ones */
+static int kgsl_reclaim_cmp(const void *a, const void *b)
+{
+	const struct kgsl_reclaim_candidate *l = a, *r = b;
 
-		if (!valid_entry) {
-			next++;
-			continue;
-		}
+	if (l->last_use != r->last_use)
+		return time_before(l->last_use, r->last_use) ? -1 : 1;
 
-		/* Do not reclaim pages mapped into a VBO */
-		if (atomic_read(&valid_entry->vbo_count)) {
-			kgsl_mem_entry_put(entry);
-			next++;
-			continue;
-		}
+	if (l->entry->memdesc.page_count != r->entry->memdesc.page_count)
+		return l->entry->memdesc.page_count >
+			r->entry->memdesc.page_count ? -1 : 1;
+
+	return 0;
+}
+
+static void kgsl_reclaim_release_pages(struct kgsl_mem_entry *entry)
+{
+	struct kgsl_memdesc *memdesc = &entry->memdesc;
+	int i;
+
+	for (i = 0; i < memdesc->page_count; i++) {
+		set_page_dirty_lock(memdesc->pages[i]);
+		spin_lock(&memdesc->lock);
+		put_page(memdesc->pages[i]);
+		memdesc->pages[i] = NULL;
+		spin_unlock(&memdesc->lock);
+	}
+
+	reclaim_shmem_address_space(memdesc->shmem_filp->f_mapping);
+	memdesc->priv |= KGSL_MEMDESC_RECLAIMED;
+	atomic64_add(memdesc->size, &entry->priv->reclaimed_bytes);
+	trace_kgsl_reclaim_memdesc(entry, true);
+}
+
+/*
+ * Rank the reclaimable entries of all locked background processes by their
+ * last GPU use and unmap the oldest ones until @nr_pages are reclaimed. All
+ * the entries are unmapped first so that a single TLB invalidate covers the
+ * whole batch before any of the pages are released.
+ */
+static void kgsl_reclaim_batch(struct list_head *procs, u32 nr_procs,
+		u32 nr_pages)
+{
+	struct kgsl_reclaim_candidate *cands;
+	struct kgsl_process_private *process;
+	struct kgsl_mmu *mmu = NULL;
+	int i, count = 0, nr_unmapped = 0, per_proc;
+
+	cands = kvcalloc(KGSL_RECLAIM_MAX_CANDIDATES, sizeof(*cands),
+			GFP_KERNEL);
+	if (!cands)
+		return;
+
+	/* Share the candidate slots so one big process can't starve others */
+	per_proc = max_t(int, KGSL_RECLAIM_MAX_CANDIDATES / nr_procs, 1);
+
+	list_for_each_entry(process, procs, reclaim_list)
+		count = kgsl_reclaim_add_candidates(process, cands, count,
+			min(count + per_proc, KGSL_RECLAIM_MAX_CANDIDATES));
+
+	sort(cands, count, sizeof(*cands), kgsl_reclaim_cmp, NULL);
 
-		if ((atomic_read(&process->unpinned_page_count) +
-			memdesc->page_count) > kgsl_reclaim_max_page_limit) {
+	for (i = 0; i < count; i++) {
+		struct kgsl_mem_entry *entry = cands[i].entry;
+		struct kgsl_memdesc *memdesc = &entry->memdesc;
+
+		process = entry->priv;
+
+		if (!nr_pages || memdesc->page_count > nr_pages ||
+			kgsl_reclaim_abort(process) ||
+			(atomic_read(&process->unpinned_page_count) +
+			memdesc->page_count) > kgsl_reclaim_max_page_limit ||
+			kgsl_mmu_unmap_noflush(memdesc->pagetable, memdesc)) {
 			kgsl_mem_entry_put(entry);
-			next++;
 			continue;
 		}
 
-		if (memdesc->page_count > remaining) {
+		atomic_add(memdesc->page_count, &process->unpinned_page_count);
+		nr_pages -= memdesc->page_count;
+		mmu = memdesc->pagetable->mmu;
+		cands[nr_unmapped++] = cands[i];
+	}
+
+	if (nr_unmapped)
+		kgsl_mmu_flush_tlb(mmu);
+
+	list_for_each_entry(process, procs, reclaim_list) {
+		u32 swapped = 0;
+
+		for (i = 0; i < nr_unmapped; i++) {
+			struct kgsl_mem_entry *entry = cands[i].entry;
+
+			if (entry->priv != process)
+				continue;
+
+			swapped += entry->memdesc.page_count;
+			kgsl_reclaim_release_pages(entry);
 			kgsl_mem_entry_put(entry);
-			next++;
-			continue;
 		}
 
-		if (!kgsl_mmu_unmap(memdesc->pagetable, memdesc)) {
-			int i;
-
-			for (i = 0; i < memdesc->page_count; i++) {
-				set_page_dirty_lock(memdesc->pages[i]);
-				spin_lock(&memdesc->lock);
-				put_page(memdesc->pages[i]);
-				memdesc->pages[i] = NULL;
-				atomic_inc(&process->unpinned_page_count);
-				spin_unlock(&memdesc->lock);
-				remaining--;
-			}
-
-			reclaim_shmem_address_space(memdesc->shmem_filp->f_mapping);
-			memdesc->priv |= KGSL_MEMDESC_RECLAIMED;
-			trace_kgsl_reclaim_memdesc(entry, true);
-		}
+		if (swapped)
+			clear_bit(KGSL_PROC_PINNED_STATE, &process->state);
 
-		kgsl_mem_entry_put(entry);
-		next++;
+		trace_kgsl_reclaim_process(process, swapped, true);
 	}
 
-	if (next)
-		clear_bit(KGSL_PROC_PINNED_STATE, &process->state);
-
-	trace_kgsl_reclaim_process(process, pages_to_reclaim - remaining, true);
-	mutex_unlock(&process->reclaim_lock);
-
-	return (pages_to_reclaim - remaining);
+	kvfree(cands);
 }
 
 static void kgsl_reclaim_background_work(struct work_struct *work)
 {
 	u32 bg_proc = 0, nr_pages = atomic_read(&kgsl_nr_to_reclaim);
-	u64 pp_nr_pages;
 	struct list_head kgsl_reclaim_process_list;
 	struct kgsl_process_private *process, *next;
 
@@ -323,23 +530,34 @@ static void kgsl_reclaim_background_work(struct work_struct *work)
 				!kgsl_process_private_get(process))
 			continue;
 
-		bg_proc++;
 		list_add(&process->reclaim_list, &kgsl_reclaim_process_list);
 	}
 	read_unlock(&kgsl_driver.proclist_lock);
 
-	list_for_each_entry(process, &kgsl_reclaim_process_list, reclaim_list) {
-		if (!nr_pages)
-			break;
+	/*
+	 * If we do not get the lock here, it means that the buffers are
+	 * being pinned back. So do not keep waiting here as we would anyway
+	 * return empty handed once the lock is acquired.
+	 */
+	list_for_each_entry_safe(process, next,
+			&kgsl_reclaim_process_list, reclaim_list) {
+		if (mutex_trylock(&process->reclaim_lock)) {
+			bg_proc++;
+			continue;
+		}
 
-		pp_nr_pages = nr_pages;
-		do_div(pp_nr_pages, bg_proc--);
-		nr_pages -= kgsl_reclaim_process(process, pp_nr_pages);
+		list_del(&process->reclaim_list);
+		kgsl_process_private_put(process);
 	}
 
+	if (bg_proc && nr_pages)
+		kgsl_reclaim_batch(&kgsl_reclaim_process_list, bg_proc,
+			nr_pages);
+
 	list_for_each_entry_safe(process, next,
 			&kgsl_reclaim_process_list, reclaim_list) {
 		list_del(&process->reclaim_list);
+		mutex_unlock(&process->reclaim_lock);
 		kgsl_process_private_put(process);
 	}
 }
@@ -395,18 +613,19 @@ void kgsl_reclaim_proc_private_init(struct kgsl_process_private *process)
 	set_bit(KGSL_PROC_PINNED_STATE, &process->state);
 	set_bit(KGSL_PROC_STATE, &process->state);
 	atomic_set(&process->unpinned_page_count, 0);
+	atomic64_set(&process->reclaimed_bytes, 0);
 }
 
 int kgsl_reclaim_init(void)
 {
 	int ret;
 
+	INIT_WORK(&reclaim_work, kgsl_reclaim_background_work);
+
 	/* Initialize shrinker */
 	ret = register_shrinker(&kgsl_reclaim_shrinker);
 	if (ret)
 		pr_err("kgsl: reclaim: Failed to register shrinker\n");
-	else
-		INIT_WORK(&reclaim_work, kgsl_reclaim_background_work);
 
 	return ret;
 }
@@ -28,6 +28,12 @@ ssize_t kgsl_nr_to_scan_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t count);
 ssize_t kgsl_nr_to_scan_show(struct device *dev,
 		struct device_attribute *attr, char *buf);
+ssize_t kgsl_reclaim_watermark_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count);
+ssize_t kgsl_reclaim_watermark_show(struct device *dev,
+		struct device_attribute *attr, char *buf);
+void kgsl_reclaim_mark_used(struct kgsl_process_private *process,
+		struct list_head *head);
 #else
 static inline int kgsl_reclaim_init(void)
 {
@@ -48,5 +54,8 @@ static inline void kgsl_reclaim_proc_sysfs_init
 static inline void kgsl_reclaim_proc_private_init
 		(struct kgsl_process_private *process) { }
 
+static inline void kgsl_reclaim_mark_used(struct kgsl_process_private *process,
+		struct list_head *head) { }
+
 #endif
 #endif /* __KGSL_RECLAIM_H */
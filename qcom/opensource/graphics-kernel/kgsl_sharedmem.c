@@ -396,6 +396,12 @@ static struct device_attribute dev_attr_page_reclaim_per_call = {
 	.show = kgsl_nr_to_scan_show,
 	.store = kgsl_nr_to_scan_store,
 };
+
+static struct device_attribute dev_attr_reclaim_watermark = {
+	.attr = { .name = "reclaim_watermark", .mode = 0644 },
+	.show = kgsl_reclaim_watermark_show,
+	.store = kgsl_reclaim_watermark_store,
+};
 #endif
 
 /**
@@ -505,6 +511,7 @@ static const struct attribute *drv_attr_list[] = {
 #ifdef CONFIG_QCOM_KGSL_PROCESS_RECLAIM
 	&dev_attr_max_reclaim_limit.attr,
 	&dev_attr_page_reclaim_per_call.attr,
+	&dev_attr_reclaim_watermark.attr,
 #endif
 	NULL,
 };
@@ -4,6 +4,7 @@
  * Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
  */
 
+#include <linux/crypto.h>
 #include <linux/of.h>
 #include <linux/panic_notifier.h>
 #include <linux/slab.h>
@@ -24,6 +25,16 @@ struct kgsl_snapshot_cp_obj {
 	struct list_head node;
 };
 
+/* An individually allocated snapshot section stored after the mempool */
+struct kgsl_snapshot_chunk {
+	struct list_head node;
+	size_t size;
+	u8 data[];
+};
+
+/* Worst case size of an LZ4 block for @_size bytes of input */
+#define SNAPSHOT_LZ4_BOUND(_size) ((_size) + ((_size) / 255) + 16)
+
 struct snapshot_obj_itr {
 	u8 *buf;      /* Buffer pointer to write to */
 	int pos;        /* Current position in the sequence */
@@ -385,6 +396,36 @@ void kgsl_snapshot_indexed_registers(struct kgsl_device *device,
 		snapshot, kgsl_snapshot_dump_indexed_regs, &iregs);
 }
 
+static void kgsl_snapshot_time_section(struct kgsl_snapshot *snapshot,
+	u16 id, size_t size, ktime_t start)
+{
+	struct kgsl_snapshot_timing *timing = snapshot->timing;
+	struct kgsl_snapshot_section_time *sec = NULL;
+	int i;
+
+	if (!timing)
+		return;
+
+	for (i = 0; i < timing->nr_sections; i++) {
+		if (timing->sections[i].id == id) {
+			sec = &timing->sections[i];
+			break;
+		}
+	}
+
+	if (!sec) {
+		if (timing->nr_sections == ARRAY_SIZE(timing->sections))
+			return;
+
+		sec = &timing->sections[timing->nr_sections++];
+		sec->id = id;
+	}
+
+	sec->count++;
+	sec->bytes += size;
+	sec->usecs += ktime_us_delta(ktime_get(), start);
+}
+
 /**
  * kgsl_snapshot_add_section() - Add a new section to the GPU snapshot
  * @device: the KGSL device being snapshotted
@@ -404,6 +445,7 @@ void kgsl_snapshot_add_section(struct kgsl_device *device, u16 id,
 	struct kgsl_snapshot_section_header *header =
 		(struct kgsl_snapshot_section_header *)snapshot->ptr;
 	u8 *data = snapshot->ptr + sizeof(*header);
+	ktime_t start = ktime_get();
 	size_t ret = 0;
 
 	/*
@@ -437,11 +479,14 @@ void kgsl_snapshot_add_section(struct kgsl_device *device, u16 id,
 	snapshot->ptr += header->size;
 	snapshot->remain -= header->size;
 	snapshot->size += header->size;
+
+	kgsl_snapshot_time_section(snapshot, id, header->size, start);
 }
 
 static void kgsl_free_snapshot(struct kgsl_snapshot *snapshot)
 {
 	struct kgsl_snapshot_object *obj, *tmp;
+	struct kgsl_snapshot_chunk *chunk, *chunk_tmp;
 	struct kgsl_device *device = snapshot->device;
 
 	wait_for_completion(&snapshot->dump_gate);
@@ -450,6 +495,11 @@ static void kgsl_free_snapshot(struct kgsl_snapshot *snapshot)
 				&snapshot->obj_list, node)
 		kgsl_snapshot_put_object(obj);
 
+	list_for_each_entry_safe(chunk, chunk_tmp, &snapshot->chunks, node) {
+		list_del(&chunk->node);
+		kvfree(chunk);
+	}
+
 	if (snapshot->mempool)
 		vfree(snapshot->mempool);
 
@@ -531,6 +581,7 @@ static void kgsl_device_snapshot_atomic(struct kgsl_device *device)
 	device->snapshot_atomic = true;
 	INIT_LIST_HEAD(&snapshot->obj_list);
 	INIT_LIST_HEAD(&snapshot->cp_list);
+	INIT_LIST_HEAD(&snapshot->chunks);
 
 	snapshot->start = device->snapshot_memory_atomic.ptr;
 	snapshot->ptr = device->snapshot_memory_atomic.ptr;
@@ -574,6 +625,7 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 {
 	struct kgsl_snapshot *snapshot;
 	struct timespec64 boot;
+	ktime_t start;
 
 	if (device->ftbl->set_isdb_breakpoint_registers)
 		device->ftbl->set_isdb_breakpoint_registers(device);
@@ -625,6 +677,7 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	init_completion(&snapshot->dump_gate);
 	INIT_LIST_HEAD(&snapshot->obj_list);
 	INIT_LIST_HEAD(&snapshot->cp_list);
+	INIT_LIST_HEAD(&snapshot->chunks);
 	INIT_WORK(&snapshot->work, kgsl_snapshot_save_frozen_objs);
 
 	snapshot->start = device->snapshot_memory.ptr;
@@ -634,7 +687,14 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	snapshot->first_read = true;
 	snapshot->sysfs_read = 0;
 
+	spin_lock(&device->snapshot_timing_lock);
+	memset(&device->snapshot_timing, 0, sizeof(device->snapshot_timing));
+	spin_unlock(&device->snapshot_timing_lock);
+	snapshot->timing = &device->snapshot_timing;
+
+	start = ktime_get();
 	device->ftbl->snapshot(device, snapshot, context, context_lpac);
+	device->snapshot_timing.capture_usecs = ktime_us_delta(ktime_get(), start);
 
 	/*
 	 * The timestamp is the seconds since boot so it is easier to match to
@@ -649,9 +709,9 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	snapshot->device = device;
 
 	/* log buffer info to aid in ramdump fault tolerance */
-	dev_err(device->dev, "%s snapshot created at pa %llx++0x%zx\n",
+	dev_err(device->dev, "%s snapshot created at pa %llx++0x%zx in %lluus\n",
 			gmu_fault ? "GMU" : "GPU", snapshot_phy_addr(device),
-			snapshot->size);
+			snapshot->size, device->snapshot_timing.capture_usecs);
 
 	kgsl_add_to_minidump("GPU_SNAPSHOT", (u64) device->snapshot_memory.ptr,
 			snapshot_phy_addr(device), device->snapshot_memory.size);
@@ -745,6 +805,7 @@ static ssize_t snapshot_show(struct file *filep, struct kobject *kobj,
 	struct kgsl_device *device = kobj_to_device(kobj);
 	struct kgsl_snapshot *snapshot;
 	struct kgsl_snapshot_section_header head;
+	struct kgsl_snapshot_chunk *chunk;
 	struct snapshot_obj_itr itr;
 	int ret = 0;
 
@@ -798,6 +859,13 @@ static ssize_t snapshot_show(struct file *filep, struct kobject *kobj,
 			goto done;
 	}
 
+	/* Dump the individually stored object sections */
+	list_for_each_entry(chunk, &snapshot->chunks, node) {
+		ret = obj_itr_out(&itr, chunk->data, chunk->size);
+		if (ret == 0)
+			goto done;
+	}
+
 	{
 		head.magic = SNAPSHOT_SECTION_MAGIC;
 		head.id = KGSL_SNAPSHOT_SECTION_END;
@@ -926,6 +994,48 @@ static ssize_t timestamp_show(struct kgsl_device *device, char *buf)
 	return scnprintf(buf, PAGE_SIZE, "%lu\n", timestamp);
 }
 
+static ssize_t snapshot_compress_show(struct kgsl_device *device, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%d\n", device->snapshot_compress);
+}
+
+static ssize_t snapshot_compress_store(struct kgsl_device *device,
+	const char *buf, size_t count)
+{
+	int ret;
+
+	ret = kstrtobool(buf, &device->snapshot_compress);
+	return ret ? ret : count;
+}
+
+/* Show how long each part of the last snapshot took to collect */
+static ssize_t section_timing_show(struct kgsl_device *device, char *buf)
+{
+	struct kgsl_snapshot_timing *timing = &device->snapshot_timing;
+	int i, count;
+
+	mutex_lock(&device->mutex);
+	spin_lock(&device->snapshot_timing_lock);
+
+	count = scnprintf(buf, PAGE_SIZE,
+		"capture: %lluus\nobjects: %lluus %llu bytes stored as %llu\n",
+		timing->capture_usecs, timing->objs_usecs,
+		timing->objs_bytes, timing->objs_stored);
+
+	for (i = 0; i < timing->nr_sections; i++) {
+		struct kgsl_snapshot_section_time *sec = &timing->sections[i];
+
+		count += scnprintf(buf + count, PAGE_SIZE - count,
+			"section 0x%04x: %u sections %llu bytes %lluus\n",
+			sec->id, sec->count, sec->bytes, sec->usecs);
+	}
+
+	spin_unlock(&device->snapshot_timing_lock);
+	mutex_unlock(&device->mutex);
+
+	return count;
+}
+
 static ssize_t snapshot_legacy_show(struct kgsl_device *device, char *buf)
 {
 	return scnprintf(buf, PAGE_SIZE, "%d\n", device->snapshot_legacy);
@@ -965,6 +1075,9 @@ static SNAPSHOT_ATTR(snapshot_legacy, 0644, snapshot_legacy_show,
 	snapshot_legacy_store);
 static SNAPSHOT_ATTR(skip_ib_capture, 0644, skip_ib_capture_show,
 		skip_ib_capture_store);
+static SNAPSHOT_ATTR(snapshot_compress, 0644, snapshot_compress_show,
+		snapshot_compress_store);
+static SNAPSHOT_ATTR(section_timing, 0444, section_timing_show, NULL);
 
 static ssize_t snapshot_sysfs_show(struct kobject *kobj,
 	struct attribute *attr, char *buf)
@@ -1011,6 +1124,8 @@ static const struct attribute *snapshot_attrs[] = {
 	&attr_snapshot_crashdumper.attr,
 	&attr_snapshot_legacy.attr,
 	&attr_skip_ib_capture.attr,
+	&attr_snapshot_compress.attr,
+	&attr_section_timing.attr,
 	NULL,
 };
 
@@ -1029,6 +1144,7 @@ static int kgsl_panic_notifier_callback(struct notifier_block *nb,
 
 void kgsl_device_snapshot_probe(struct kgsl_device *device, u32 size)
 {
+	spin_lock_init(&device->snapshot_timing_lock);
 	device->snapshot_memory.size = size;
 
 	device->snapshot_memory.ptr = dma_alloc_coherent(&device->pdev->dev,
@@ -1068,6 +1184,18 @@ void kgsl_device_snapshot_probe(struct kgsl_device *device, u32 size)
 	 */
 	device->prioritize_unrecoverable = false;
 
+	/*
+	 * Set up the LZ4 transform once here so that the save workers never
+	 * race to allocate it. Compression stays off if LZ4 is unavailable.
+	 */
+	mutex_init(&device->snapshot_comp_lock);
+	device->snapshot_comp = crypto_alloc_comp("lz4", 0, 0);
+	if (IS_ERR(device->snapshot_comp)) {
+		dev_err(device->dev,
+			"snapshot: LZ4 unavailable, storing objects uncompressed\n");
+		device->snapshot_comp = NULL;
+	}
+
 	if (kobject_init_and_add(&device->snapshot_kobj, &ktype_snapshot,
 		&device->dev->kobj, "snapshot"))
 		return;
@@ -1098,6 +1226,10 @@ void kgsl_device_snapshot_close(struct kgsl_device *device)
 
 	kobject_put(&device->snapshot_kobj);
 
+	if (device->snapshot_comp)
+		crypto_free_comp(device->snapshot_comp);
+	device->snapshot_comp = NULL;
+
 	if (device->snapshot_memory.dma_handle)
 		dma_free_coherent(&device->pdev->dev, device->snapshot_memory.size,
 			device->snapshot_memory.ptr, device->snapshot_memory.dma_handle);
@@ -1127,6 +1259,18 @@ int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	return 0;
 }
 
+static void _mempool_mark_ib_dumped(struct kgsl_snapshot *snapshot,
+		struct kgsl_snapshot_object *obj)
+{
+	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
+				snapshot->ib1base, snapshot->ib1size))
+		snapshot->ib1dumped = true;
+
+	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
+				snapshot->ib2base, snapshot->ib2size))
+		snapshot->ib2dumped = true;
+}
+
 static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 		struct kgsl_snapshot_object *obj)
 {
@@ -1155,13 +1299,7 @@ static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 		kgsl_mmu_pagetable_get_ttbr0(obj->entry->priv->pagetable);
 	header->type = obj->type;
 
-	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
-				snapshot->ib1base, snapshot->ib1size))
-		snapshot->ib1dumped = true;
-
-	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
-				snapshot->ib2base, snapshot->ib2size))
-		snapshot->ib2dumped = true;
+	_mempool_mark_ib_dumped(snapshot, obj);
 
 	memcpy(dest, obj->entry->memdesc.hostptr + obj->offset, size);
 	kgsl_memdesc_unmap(&obj->entry->memdesc);
@@ -1169,6 +1307,119 @@ static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 	return section->size;
 }
 
+/*
+ * Compress a frozen object into its own LZ4 section in @scratch and keep a
+ * right-sized copy of it on the snapshot chunk list. Objects that do not
+ * shrink are stored as a plain GPU_OBJECT_V2 section instead. Returns the
+ * number of bytes stored for the object.
+ */
+static size_t _chunk_add_object(struct kgsl_snapshot *snapshot,
+		struct crypto_comp *tfm, u8 *scratch, size_t scratch_size,
+		struct kgsl_snapshot_object *obj)
+{
+	struct kgsl_snapshot_section_header *section =
+		(struct kgsl_snapshot_section_header *)scratch;
+	struct kgsl_snapshot_gpu_object_lz4 *header =
+		(struct kgsl_snapshot_gpu_object_lz4 *)(scratch + sizeof(*section));
+	size_t hdr_size = sizeof(*section) + sizeof(*header);
+	struct kgsl_snapshot_chunk *chunk;
+	unsigned int dlen = scratch_size - hdr_size;
+	size_t size;
+	int ret;
+
+	if (!kgsl_memdesc_map(&obj->entry->memdesc)) {
+		dev_err(snapshot->device->dev,
+			"snapshot: failed to map GPU object\n");
+		return 0;
+	}
+
+	ret = crypto_comp_compress(tfm,
+		obj->entry->memdesc.hostptr + obj->offset, obj->size,
+		scratch + hdr_size, &dlen);
+	kgsl_memdesc_unmap(&obj->entry->memdesc);
+
+	/* Fall back to an uncompressed section if LZ4 didn't help */
+	if (ret || dlen + sizeof(*header) >= obj->size +
+			sizeof(struct kgsl_snapshot_gpu_object_v2)) {
+		size = obj->size + sizeof(*section) +
+			sizeof(struct kgsl_snapshot_gpu_object_v2);
+
+		chunk = kvmalloc(struct_size(chunk, data, size), GFP_KERNEL);
+		if (!chunk)
+			return 0;
+
+		chunk->size = _mempool_add_object(snapshot, chunk->data, obj);
+		if (!chunk->size) {
+			kvfree(chunk);
+			return 0;
+		}
+
+		list_add_tail(&chunk->node, &snapshot->chunks);
+		return chunk->size;
+	}
+
+	section->magic = SNAPSHOT_SECTION_MAGIC;
+	section->id = KGSL_SNAPSHOT_SECTION_GPU_OBJECT_LZ4;
+	section->size = hdr_size + dlen;
+
+	header->size = obj->size >> 2;
+	header->compressed_size = dlen;
+	header->gpuaddr = obj->gpuaddr;
+	header->ptbase =
+		kgsl_mmu_pagetable_get_ttbr0(obj->entry->priv->pagetable);
+	header->type = obj->type;
+
+	chunk = kvmalloc(struct_size(chunk, data, section->size), GFP_KERNEL);
+	if (!chunk)
+		return 0;
+
+	_mempool_mark_ib_dumped(snapshot, obj);
+
+	chunk->size = section->size;
+	memcpy(chunk->data, scratch, chunk->size);
+	list_add_tail(&chunk->node, &snapshot->chunks);
+
+	return chunk->size;
+}
+
+/*
+ * Store each frozen object as its own compressed section so only the
+ * compressed data stays resident until the snapshot is read. Returns false
+ * if the objects should be stored in the mempool instead.
+ */
+static bool kgsl_snapshot_save_compressed(struct kgsl_snapshot *snapshot,
+		size_t max_size, u64 *stored)
+{
+	struct kgsl_device *device = snapshot->device;
+	struct kgsl_snapshot_object *obj, *tmp;
+	size_t scratch_size;
+	u8 *scratch;
+
+	if (!device->snapshot_compress || !device->snapshot_comp)
+		return false;
+
+	scratch_size = SNAPSHOT_LZ4_BOUND(max_size) +
+		sizeof(struct kgsl_snapshot_section_header) +
+		sizeof(struct kgsl_snapshot_gpu_object_lz4);
+
+	scratch = vmalloc(scratch_size);
+	if (!scratch)
+		return false;
+
+	mutex_lock(&device->snapshot_comp_lock);
+	list_for_each_entry_safe(obj, tmp, &snapshot->obj_list, node) {
+		size_t ret = _chunk_add_object(snapshot, device->snapshot_comp,
+				scratch, scratch_size, obj);
+
+		*stored += ret;
+		kgsl_snapshot_put_object(obj);
+	}
+	mutex_unlock(&device->snapshot_comp_lock);
+
+	vfree(scratch);
+	return true;
+}
+
 /**
  * kgsl_snapshot_save_frozen_objs() - Save the objects frozen in snapshot into
  * memory so that the data reported in these objects is correct when snapshot
@@ -1179,8 +1430,11 @@ static void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 {
 	struct kgsl_snapshot *snapshot = container_of(work,
 				struct kgsl_snapshot, work);
+	struct kgsl_snapshot_timing *timing = snapshot->timing;
 	struct kgsl_snapshot_object *obj, *tmp;
-	size_t size = 0;
+	size_t size = 0, max_size = 0;
+	u64 objs_bytes = 0, objs_stored = 0;
+	ktime_t start = ktime_get();
 	void *ptr;
 
 	if (snapshot->device->gmu_fault)
@@ -1194,11 +1448,16 @@ static void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 		size += ((size_t) obj->size +
 			sizeof(struct kgsl_snapshot_gpu_object_v2) +
 			sizeof(struct kgsl_snapshot_section_header));
+		max_size = max_t(size_t, max_size, obj->size);
+		objs_bytes += obj->size;
 	}
 
 	if (size == 0)
 		goto done;
 
+	if (kgsl_snapshot_save_compressed(snapshot, max_size, &objs_stored))
+		goto done;
+
 	snapshot->mempool = vmalloc(size);
 
 	ptr = snapshot->mempool;
@@ -1215,7 +1474,18 @@ static void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 
 		kgsl_snapshot_put_object(obj);
 	}
+
+	objs_stored = snapshot->mempool_size;
 done:
+	/* This runs without the device mutex, publish under the timing lock */
+	if (timing) {
+		spin_lock(&snapshot->device->snapshot_timing_lock);
+		timing->objs_bytes = objs_bytes;
+		timing->objs_stored = objs_stored;
+		timing->objs_usecs = ktime_us_delta(ktime_get(), start);
+		spin_unlock(&snapshot->device->snapshot_timing_lock);
+	}
+
 	/*
 	 * Get rid of the process struct here, so that it doesn't sit
 	 * around until someone bothers to read the snapshot file.
@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Decode the kgsl gpu_event_ring sysfs node.
+ *
+ * kgsl_event_ring_decode [-f] [path]
+ *
+ * Without -f the rings are read once, merged by time and printed. With -f the
+ * node is mapped and new records are printed as they are written. path may
+ * also be a copy of the node saved from a device.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <linux/msm_kgsl.h>
+
+#define DEFAULT_PATH "/sys/class/kgsl/kgsl/gpu_event_ring"
+
+struct decoded {
+	struct kgsl_event_record rec;
+	unsigned int cpu;
+};
+
+static const struct kgsl_event_ring_cpu *ring_cpu(const void *base,
+		const struct kgsl_event_ring_header *hdr, unsigned int cpu)
+{
+	return (const void *)((const char *)base + hdr->ring_offset +
+		(size_t)cpu * hdr->ring_size);
+}
+
+static const struct kgsl_event_record *ring_records(
+		const struct kgsl_event_ring_cpu *ring)
+{
+	return (const void *)(ring + 1);
+}
+
+static int check_header(const struct kgsl_event_ring_header *hdr, size_t size)
+{
+	if (size < sizeof(*hdr) || hdr->magic != KGSL_EVENT_RING_MAGIC) {
+		fprintf(stderr, "not a kgsl event ring\n");
+		return -1;
+	}
+
+	if (hdr->version != KGSL_EVENT_RING_VERSION ||
+			hdr->record_size != sizeof(struct kgsl_event_record)) {
+		fprintf(stderr, "unsupported event ring version %u\n",
+			hdr->version);
+		return -1;
+	}
+
+	if (!hdr->nr_records || (hdr->nr_records & (hdr->nr_records - 1)) ||
+			(size_t)hdr->ring_offset +
+			(size_t)hdr->nr_cpus * hdr->ring_size > size ||
+			sizeof(struct kgsl_event_ring_cpu) + (size_t)hdr->nr_records *
+			hdr->record_size > hdr->ring_size) {
+		fprintf(stderr, "corrupt event ring header\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Copy record n of a ring, returns 0 if it was complete and not overwritten */
+static int read_record(const struct kgsl_event_ring_cpu *ring,
+		const struct kgsl_event_ring_header *hdr, uint64_t n,
+		struct kgsl_event_record *out)
+{
+	const volatile struct kgsl_event_record *rec =
+		&ring_records(ring)[n & (hdr->nr_records - 1)];
+	uint32_t seq = rec->seq;
+
+	if (seq != (uint32_t)(n + 1))
+		return -1;
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	memcpy(out, (const void *)rec, sizeof(*out));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return rec->seq == seq ? 0 : -1;
+}
+
+static void print_record(const struct kgsl_event_record *rec, unsigned int cpu)
+{
+	const uint32_t *d = rec->data;
+
+	printf("%llu.%09llu cpu%u ", (unsigned long long)(rec->time / 1000000000),
+		(unsigned long long)(rec->time % 1000000000), cpu);
+
+	switch (rec->type) {
+	case KGSL_EVENT_RING_SUBMIT:
+	case KGSL_EVENT_RING_RETIRE:
+		printf("%s ctx=%u ts=%u prio=%u flags=0x%x\n",
+			rec->type == KGSL_EVENT_RING_SUBMIT ? "submit" : "retire",
+			d[0], d[1], d[2], d[3]);
+		break;
+	case KGSL_EVENT_RING_PREEMPT:
+		printf("preempt rb=%u next_rb=%u status=%u\n", d[0], d[1], d[2]);
+		break;
+	case KGSL_EVENT_RING_HFI:
+		printf("hfi %s id=%u dwords=%u seq=%u\n", d[3] ? "recv" : "send",
+			d[0], d[1], d[2]);
+		break;
+	case KGSL_EVENT_RING_PWRLEVEL:
+		printf("pwrlevel %u (%u kHz) -> %u (%u kHz)\n", d[2], d[3],
+			d[0], d[1]);
+		break;
+	default:
+		printf("type=%u data=%u %u %u %u\n", rec->type, d[0], d[1],
+			d[2], d[3]);
+		break;
+	}
+}
+
+static int cmp_time(const void *a, const void *b)
+{
+	const struct decoded *x = a, *y = b;
+
+	if (x->rec.time == y->rec.time)
+		return 0;
+	return x->rec.time < y->rec.time ? -1 : 1;
+}
+
+static int dump(const void *base, const struct kgsl_event_ring_header *hdr)
+{
+	struct decoded *out;
+	size_t count = 0, i;
+	unsigned int cpu;
+
+	out = calloc((size_t)hdr->nr_cpus * hdr->nr_records, sizeof(*out));
+	if (!out)
+		return -ENOMEM;
+
+	for (cpu = 0; cpu < hdr->nr_cpus; cpu++) {
+		const struct kgsl_event_ring_cpu *ring = ring_cpu(base, hdr, cpu);
+		uint64_t head = ring->head, n;
+
+		n = head > hdr->nr_records ? head - hdr->nr_records : 0;
+		for (; n < head; n++) {
+			if (read_record(ring, hdr, n, &out[count].rec))
+				continue;
+			out[count++].cpu = cpu;
+		}
+	}
+
+	qsort(out, count, sizeof(*out), cmp_time);
+	for (i = 0; i < count; i++)
+		print_record(&out[i].rec, out[i].cpu);
+
+	free(out);
+	return 0;
+}
+
+static void follow(const void *base, const struct kgsl_event_ring_header *hdr)
+{
+	uint64_t *seen;
+	unsigned int cpu;
+
+	seen = calloc(hdr->nr_cpus, sizeof(*seen));
+	if (!seen)
+		return;
+
+	for (cpu = 0; cpu < hdr->nr_cpus; cpu++)
+		seen[cpu] = ring_cpu(base, hdr, cpu)->head;
+
+	for (;;) {
+		for (cpu = 0; cpu < hdr->nr_cpus; cpu++) {
+			const struct kgsl_event_ring_cpu *ring =
+				ring_cpu(base, hdr, cpu);
+			uint64_t head = __atomic_load_n(&ring->head,
+				__ATOMIC_ACQUIRE);
+			struct kgsl_event_record rec;
+
+			if (head - seen[cpu] > hdr->nr_records) {
+				printf("cpu%u: lost %llu records\n", cpu,
+					(unsigned long long)(head - seen[cpu] -
+					hdr->nr_records));
+				seen[cpu] = head - hdr->nr_records;
+			}
+
+			for (; seen[cpu] < head; seen[cpu]++)
+				if (!read_record(ring, hdr, seen[cpu], &rec))
+					print_record(&rec, cpu);
+		}
+
+		fflush(stdout);
+		usleep(100000);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = DEFAULT_PATH;
+	const struct kgsl_event_ring_header *hdr;
+	int opt, fd, follow_mode = 0, ret;
+	struct stat st;
+	size_t size;
+	void *base;
+
+	while ((opt = getopt(argc, argv, "f")) != -1) {
+		if (opt != 'f') {
+			fprintf(stderr, "usage: %s [-f] [path]\n", argv[0]);
+			return 1;
+		}
+		follow_mode = 1;
+	}
+
+	if (optind < argc)
+		path = argv[optind];
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		return 1;
+	}
+
+	size = st.st_size;
+	base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		perror("mmap");
+		close(fd);
+		return 1;
+	}
+
+	hdr = base;
+	ret = check_header(hdr, size);
+	if (!ret) {
+		if (follow_mode)
+			follow(base, hdr);
+		else
+			ret = dump(base, hdr);
+	}
+
+	munmap(base, size);
+	close(fd);
+
+	return ret ? 1 : 0;
+}
@@ -7,6 +7,9 @@
 #define _MMRM_CLK_RESOURCE_MGR_H_
 
 #include <dt-bindings/regulator/qcom,rpmh-regulator-levels.h>
+#include <linux/rwsem.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #include <linux/soc/qcom/msm_mmrm.h>
 
 #include "mmrm_internal.h"
@@ -66,6 +69,9 @@ struct mmrm_sw_clk_client_tbl_entry {
 	bool reserve;
 	u32 ref_count;
 	u32 num_hw_blocks;
+
+	/* serializes same level updates, taken with clk mgr lock held for read */
+	spinlock_t lock;
 };
 
 struct mmrm_sw_throttled_clients_data {
@@ -73,6 +79,16 @@ struct mmrm_sw_throttled_clients_data {
 	u32 table_id;
 	u32 delta_cu_ma;
 	u32 prev_vdd_level;
+	enum mmrm_client_priority pri;
+};
+
+/* client notification deferred to the notify worker */
+struct mmrm_sw_notify_data {
+	struct list_head list;
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry;
+	u32 clk_src_id;
+	notifier_callback_fn_t notifier_cb_fn;
+	struct mmrm_client_notifier_data notifier_data;
 };
 
 struct mmrm_sw_peak_current_data {
@@ -102,13 +118,33 @@ struct mmrm_sw_clk_mgr_info {
 	/* peak current data */
 	struct mmrm_sw_peak_current_data peak_cur_data;
 
-	/* HEAD of list of clients throttled */
+	/*
+	 * running sum of current of all enabled clients for each
+	 * aggregate mmcx level, in ma
+	 */
+	u32 level_cur_ma[MMRM_VDD_LEVEL_MAX];
+
+	/* number of enabled clients at each vdd level */
+	u32 level_clients[MMRM_VDD_LEVEL_MAX];
+
+	/*
+	 * HEAD of list of clients throttled, kept in reinstatement order:
+	 * high priority clients first, then smallest current delta first
+	 */
 	struct list_head throttled_clients;
 
+	/* notifications sent outside the clk mgr lock */
+	struct list_head pending_notify;
+	spinlock_t notify_lock;
+	struct work_struct notify_work;
 };
 
 struct mmrm_clk_mgr {
-	struct mutex lock;
+	/*
+	 * held for write when the peak current data or the client table
+	 * changes, for read by setval calls that stay within their level
+	 */
+	struct rw_semaphore lock;
 	enum mmrm_clk_mgr_scheme scheme;
 	union {
 		struct mmrm_sw_clk_mgr_info sw_info;
@@ -174,6 +174,92 @@ static int mmrm_sw_update_curr(struct mmrm_sw_clk_mgr_info *sinfo,
 	return 0;
 }
 
+static inline bool mmrm_sw_is_client_enabled(
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry)
+{
+	return !IS_ERR_OR_NULL(tbl_entry->clk) && tbl_entry->clk_rate;
+}
+
+/*
+ * Add or remove the current drawn by an enabled client to the per
+ * level running sums, and the client to the per level client counts.
+ * Callers remove the contribution before changing clk_rate, vdd_level
+ * or num_hw_blocks of an entry and add it back afterwards, with the
+ * clk mgr lock held for write.
+ */
+static void mmrm_sw_update_level_cur(struct mmrm_sw_clk_mgr_info *sinfo,
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry, bool add)
+{
+	u32 level, cur;
+
+	if (!mmrm_sw_is_client_enabled(tbl_entry))
+		return;
+
+	if (add)
+		sinfo->level_clients[tbl_entry->vdd_level]++;
+	else
+		sinfo->level_clients[tbl_entry->vdd_level]--;
+
+	for (level = 0; level < MMRM_VDD_LEVEL_MAX; level++) {
+		cur = tbl_entry->current_ma[tbl_entry->vdd_level][level] *
+			tbl_entry->num_hw_blocks;
+		if (add)
+			sinfo->level_cur_ma[level] += cur;
+		else
+			sinfo->level_cur_ma[level] -= cur;
+	}
+}
+
+static void mmrm_sw_notify_work_handler(struct work_struct *work)
+{
+	struct mmrm_sw_clk_mgr_info *sinfo = container_of(work,
+		struct mmrm_sw_clk_mgr_info, notify_work);
+	struct mmrm_sw_notify_data *nd;
+	u64 start_ts = 0, end_ts = 0;
+	int rc;
+
+	spin_lock(&sinfo->notify_lock);
+	while (!list_empty(&sinfo->pending_notify)) {
+		nd = list_first_entry(&sinfo->pending_notify,
+			struct mmrm_sw_notify_data, list);
+		list_del(&nd->list);
+		spin_unlock(&sinfo->notify_lock);
+
+		start_ts = ktime_get_ns();
+		rc = nd->notifier_cb_fn(&nd->notifier_data);
+		end_ts = ktime_get_ns();
+		d_mpr_h("%s: Client notifier cbk processing time(%llu)ns\n",
+			__func__, end_ts - start_ts);
+
+		if (rc)
+			d_mpr_e("%s: Client notifier callback failed(%d)\n",
+				__func__, nd->clk_src_id);
+		if ((end_ts - start_ts) > NOTIFY_TIMEOUT)
+			d_mpr_e("%s: Client notifier took %llu ns\n",
+				__func__, (end_ts - start_ts));
+
+		kfree(nd);
+		spin_lock(&sinfo->notify_lock);
+	}
+	spin_unlock(&sinfo->notify_lock);
+}
+
+/* drop notifications still pending for a client that goes away */
+static void mmrm_sw_cancel_notify(struct mmrm_sw_clk_mgr_info *sinfo,
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry)
+{
+	struct mmrm_sw_notify_data *nd, *safe_nd;
+
+	spin_lock(&sinfo->notify_lock);
+	list_for_each_entry_safe(nd, safe_nd, &sinfo->pending_notify, list) {
+		if (!tbl_entry || nd->tbl_entry == tbl_entry) {
+			list_del(&nd->list);
+			kfree(nd);
+		}
+	}
+	spin_unlock(&sinfo->notify_lock);
+}
+
 static struct mmrm_client *mmrm_sw_clk_client_register(
 	struct mmrm_clk_mgr *sw_clk_mgr,
 	struct mmrm_clk_client_desc clk_desc,
@@ -189,7 +275,7 @@ static struct mmrm_client *mmrm_sw_clk_client_register(
 	u32 c = 0;
 	u32 clk_client_src_id = 0;
 
-	mutex_lock(&sw_clk_mgr->lock);
+	down_write(&sw_clk_mgr->lock);
 
 	/* check if entry is free in table */
 	if (sinfo->tot_clk_clients == sinfo->enabled_clk_clients) {
@@ -282,7 +368,7 @@ static struct mmrm_client *mmrm_sw_clk_client_register(
 	}
 
 exit_found:
-	mutex_unlock(&sw_clk_mgr->lock);
+	up_write(&sw_clk_mgr->lock);
 	return clk_client;
 
 err_fail_update_entry:
@@ -296,7 +382,7 @@ err_fail_alloc_clk_client:
 	tbl_entry->notifier_cb_fn = NULL;
 err_nofree_entry:
 err_already_registered:
-	mutex_unlock(&sw_clk_mgr->lock);
+	up_write(&sw_clk_mgr->lock);
 
 	d_mpr_e("%s: error = %d\n", __func__, rc);
 	return NULL;
@@ -323,7 +409,7 @@ static int mmrm_sw_clk_client_deregister(struct mmrm_clk_mgr *sw_clk_mgr,
 		goto err_invalid_client;
 	}
 
-	mutex_lock(&sw_clk_mgr->lock);
+	down_write(&sw_clk_mgr->lock);
 
 	tbl_entry = &sinfo->clk_client_tbl[client->client_uid];
 	if (tbl_entry->ref_count > 0) {
@@ -332,6 +418,8 @@ static int mmrm_sw_clk_client_deregister(struct mmrm_clk_mgr *sw_clk_mgr,
 
 	if (tbl_entry->ref_count == 0) {
 
+		mmrm_sw_update_level_cur(sinfo, tbl_entry, false);
+		mmrm_sw_cancel_notify(sinfo, tbl_entry);
 		kfree(tbl_entry->client);
 		tbl_entry->vdd_level = 0;
 		tbl_entry->clk_rate = 0;
@@ -342,7 +430,14 @@ static int mmrm_sw_clk_client_deregister(struct mmrm_clk_mgr *sw_clk_mgr,
 		tbl_entry->notifier_cb_fn = NULL;
 	}
 
-	mutex_unlock(&sw_clk_mgr->lock);
+	up_write(&sw_clk_mgr->lock);
+
+	/*
+	 * A notification already taken off the queue by the worker may
+	 * still be calling into the client; wait for it so no callback
+	 * runs with the client's pvt_data after deregister returns.
+	 */
+	flush_work(&sinfo->notify_work);
 
 	return rc;
 
@@ -409,13 +504,12 @@ err_invalid_corner:
 
 static int mmrm_sw_check_req_level(
 	struct mmrm_sw_clk_mgr_info *sinfo,
-	u32 clk_src_id, u32 req_level, u32 *adj_level)
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry, u32 req_level,
+	u32 *adj_level)
 {
 	int rc = 0;
 	struct mmrm_sw_peak_current_data *peak_data = &sinfo->peak_cur_data;
-	struct mmrm_sw_clk_client_tbl_entry *tbl_entry = NULL;
-	struct mmrm_sw_clk_client_tbl_entry *next_max_entry = NULL;
-	u32 c, level = req_level;
+	u32 level = req_level, num_clients, i;
 
 	if (req_level >= MMRM_VDD_LEVEL_MAX) {
 		d_mpr_e("%s: invalid level %lu\n", __func__, req_level);
@@ -423,30 +517,20 @@ static int mmrm_sw_check_req_level(
 		goto err_invalid_level;
 	}
 	d_mpr_h("%s: csid(0x%x) level(%d) peak_data->aggreg_level(%d)\n",
-		__func__, clk_src_id, level, peak_data->aggreg_level);
-
-	/* req_level is rejected when another client has a higher level */
-	if (req_level < peak_data->aggreg_level) {
-		for (c = 0; c < sinfo->tot_clk_clients; c++) {
-			tbl_entry = &sinfo->clk_client_tbl[c];
-			if (IS_ERR_OR_NULL(tbl_entry->clk) || !tbl_entry->clk_rate ||
-				(tbl_entry->clk_src_id == clk_src_id)) {
-				continue;
-			}
-			if (tbl_entry->vdd_level == peak_data->aggreg_level) {
-				break;
-			}
-			if  ((tbl_entry->vdd_level < peak_data->aggreg_level)
-					&& (tbl_entry->vdd_level > req_level ))
-				next_max_entry = tbl_entry;
+		__func__, tbl_entry->clk_src_id, level, peak_data->aggreg_level);
 
-		}
-		/* reject req level */
-		if (c < sinfo->tot_clk_clients) {
-			level = peak_data->aggreg_level;
-		} else if (!IS_ERR_OR_NULL(next_max_entry)
-			&& next_max_entry->vdd_level > req_level) {
-			level = next_max_entry->vdd_level;
+	/*
+	 * raise req_level to the highest level of the other enabled
+	 * clients, found from the per level client counts
+	 */
+	for (i = peak_data->aggreg_level; i > req_level; i--) {
+		num_clients = sinfo->level_clients[i];
+		if (mmrm_sw_is_client_enabled(tbl_entry) &&
+			tbl_entry->vdd_level == i)
+			num_clients--;
+		if (num_clients) {
+			level = i;
+			break;
 		}
 	}
 
@@ -463,8 +547,7 @@ static int mmrm_sw_calculate_total_current(
 	u32 req_level, u32 *total_cur, struct mmrm_sw_clk_client_tbl_entry *tbl_entry_new)
 {
 	int rc = 0;
-	struct mmrm_sw_clk_client_tbl_entry *tbl_entry;
-	u32 c, sum_cur = 0;
+	u32 sum_cur = 0;
 
 	if (req_level >= MMRM_VDD_LEVEL_MAX) {
 		d_mpr_e("%s: invalid level %lu\n", __func__, req_level);
@@ -472,16 +555,11 @@ static int mmrm_sw_calculate_total_current(
 		goto err_invalid_level;
 	}
 
-	/* calculate sum of values (scaled by volt) */
-	for (c = 0; c < sinfo->tot_clk_clients; c++) {
-		tbl_entry = &sinfo->clk_client_tbl[c];
-		if (IS_ERR_OR_NULL(tbl_entry->clk) || !tbl_entry->clk_rate
-			|| (tbl_entry == tbl_entry_new)) {
-			continue;
-		}
-		sum_cur += (tbl_entry->current_ma[tbl_entry->vdd_level][req_level]
-			* tbl_entry->num_hw_blocks);
-	}
+	/* sum of values (scaled by volt) of all clients except the new one */
+	sum_cur = sinfo->level_cur_ma[req_level];
+	if (mmrm_sw_is_client_enabled(tbl_entry_new))
+		sum_cur -= tbl_entry_new->current_ma[tbl_entry_new->vdd_level][req_level] *
+			tbl_entry_new->num_hw_blocks;
 
 	*total_cur = sum_cur;
 	d_mpr_h("%s: total_cur(%lu)\n", __func__, *total_cur);
@@ -491,55 +569,87 @@ err_invalid_level:
 	return rc;
 }
 
+/*
+ * Order in which throttle candidates are picked: low priority clients
+ * first, then the one that saves the most current. There are at most
+ * MMRM_MAX_THROTTLE_CLIENTS candidates, so they are ranked with a single
+ * pass rather than kept in a separate heap.
+ */
+static bool mmrm_sw_throttle_prefer(
+	struct mmrm_sw_clk_client_tbl_entry *a, u32 a_savings,
+	struct mmrm_sw_clk_client_tbl_entry *b, u32 b_savings)
+{
+	if (a->pri != b->pri)
+		return a->pri == MMRM_CLIENT_PRIOR_LOW;
+
+	return a_savings > b_savings;
+}
+
+/* reinstate high priority clients first, then the cheapest to restore */
+static bool mmrm_sw_reinstate_prefer(struct mmrm_sw_throttled_clients_data *a,
+	struct mmrm_sw_throttled_clients_data *b)
+{
+	if (a->pri != b->pri)
+		return a->pri == MMRM_CLIENT_PRIOR_HIGH;
+
+	return a->delta_cu_ma < b->delta_cu_ma;
+}
+
 static int mmrm_sw_throttle_low_priority_client(
 	struct mmrm_sw_clk_mgr_info *sinfo, int *delta_cur)
 {
-	int rc = 0, i;
+	int rc = 0, i, throttle_idx = 0;
 	u64 start_ts = 0, end_ts = 0;
 	bool found_client_throttle = false;
-	struct mmrm_sw_clk_client_tbl_entry *tbl_entry_throttle_client;
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry_throttle_client = NULL;
+	struct mmrm_sw_clk_client_tbl_entry *candidate;
 	struct mmrm_client_notifier_data notifier_data;
-	struct completion timeout;
 	struct mmrm_sw_peak_current_data *peak_data = &sinfo->peak_cur_data;
-	struct mmrm_sw_throttled_clients_data *tc_data;
+	struct mmrm_sw_throttled_clients_data *tc_data, *iter;
 
-	u32 now_cur_ma, min_cur_ma;
+	u32 now_cur_ma = 0, min_cur_ma = 0, cand_now_ma, cand_min_ma;
 	long clk_min_level = MMRM_VDD_LEVEL_LOW_SVS;
 
-	init_completion(&timeout);
-
 	for (i = 0; i < sinfo->throttle_clients_data_length ; i++) {
-		tbl_entry_throttle_client =
+		candidate =
 			&sinfo->clk_client_tbl[sinfo->throttle_clients_info[i].tbl_entry_id];
-		if (!IS_ERR_OR_NULL(tbl_entry_throttle_client)) {
-			now_cur_ma = tbl_entry_throttle_client->current_ma
-				[tbl_entry_throttle_client->vdd_level]
-				[peak_data->aggreg_level];
-			min_cur_ma = tbl_entry_throttle_client->current_ma[clk_min_level]
-				[peak_data->aggreg_level];
-
-			d_mpr_h("%s:csid(0x%x) name(%s)\n",
-				__func__, tbl_entry_throttle_client->clk_src_id,
-				tbl_entry_throttle_client->name);
-			d_mpr_h("%s:now_cur_ma(%llu) min_cur_ma(%llu) delta_cur(%d)\n",
-				__func__, now_cur_ma, min_cur_ma, *delta_cur);
-
-			if ((now_cur_ma > min_cur_ma)
-				&& (now_cur_ma - min_cur_ma > *delta_cur)) {
-				found_client_throttle = true;
-				d_mpr_h("%s: Throttle client csid(0x%x) name(%s)\n",
-					__func__, tbl_entry_throttle_client->clk_src_id,
-					tbl_entry_throttle_client->name);
-				d_mpr_h("%s:now_cur_ma %llu-min_cur_ma %llu>delta_cur %d\n",
-					__func__, now_cur_ma, min_cur_ma, *delta_cur);
-				/* found client to throttle, break from here. */
-				break;
-			}
-		}
+		if (IS_ERR_OR_NULL(candidate))
+			continue;
+
+		cand_now_ma = candidate->current_ma[candidate->vdd_level]
+			[peak_data->aggreg_level];
+		cand_min_ma = candidate->current_ma[clk_min_level]
+			[peak_data->aggreg_level];
+
+		d_mpr_h("%s:csid(0x%x) name(%s)\n",
+			__func__, candidate->clk_src_id, candidate->name);
+		d_mpr_h("%s:now_cur_ma(%llu) min_cur_ma(%llu) delta_cur(%d)\n",
+			__func__, cand_now_ma, cand_min_ma, *delta_cur);
+
+		if ((cand_now_ma <= cand_min_ma)
+			|| (cand_now_ma - cand_min_ma <= *delta_cur))
+			continue;
+
+		if (found_client_throttle &&
+			!mmrm_sw_throttle_prefer(candidate, cand_now_ma - cand_min_ma,
+				tbl_entry_throttle_client, now_cur_ma - min_cur_ma))
+			continue;
+
+		found_client_throttle = true;
+		tbl_entry_throttle_client = candidate;
+		throttle_idx = i;
+		now_cur_ma = cand_now_ma;
+		min_cur_ma = cand_min_ma;
 	}
 
 	/*Client to throttle is found, Throttle this client now to minimum clock rate*/
 	if (found_client_throttle) {
+		d_mpr_h("%s: Throttle client csid(0x%x) name(%s)\n",
+			__func__, tbl_entry_throttle_client->clk_src_id,
+			tbl_entry_throttle_client->name);
+		d_mpr_h("%s:now_cur_ma %llu-min_cur_ma %llu>delta_cur %d\n",
+			__func__, now_cur_ma, min_cur_ma, *delta_cur);
+
 		/* Setup notifier */
 
 		notifier_data.cb_type = MMRM_CLIENT_RESOURCE_VALUE_CHANGE;
@@ -548,6 +658,9 @@ static int mmrm_sw_throttle_low_priority_client(
 		notifier_data.cb_data.val_chng.new_val =
 			tbl_entry_throttle_client->freq[clk_min_level];
 		notifier_data.pvt_data = tbl_entry_throttle_client->pvt_data;
+		/* a reinstate queued earlier must not land after this throttle */
+		mmrm_sw_cancel_notify(sinfo, tbl_entry_throttle_client);
+
 		start_ts = ktime_get_ns();
 
 		if (tbl_entry_throttle_client->notifier_cb_fn)
@@ -590,11 +703,18 @@ static int mmrm_sw_throttle_low_priority_client(
 			d_mpr_e("%s: Failed to allocate memory\n", __func__);
 			return -ENOMEM;
 		}
-		tc_data->table_id = i;
+		tc_data->table_id = throttle_idx;
 		tc_data->delta_cu_ma = now_cur_ma - min_cur_ma;
 		tc_data->prev_vdd_level = tbl_entry_throttle_client->vdd_level;
-		// Add throttled client to list to access it later
-		list_add_tail(&tc_data->list, &sinfo->throttled_clients);
+		tc_data->pri = tbl_entry_throttle_client->pri;
+		// Add throttled client to list in reinstatement order
+		list_for_each_entry(iter, &sinfo->throttled_clients, list) {
+			if (mmrm_sw_reinstate_prefer(tc_data, iter))
+				break;
+		}
+		list_add_tail(&tc_data->list, &iter->list);
+
+		mmrm_sw_update_level_cur(sinfo, tbl_entry_throttle_client, false);
 
 		/* Store the throttled clock rate of client */
 		tbl_entry_throttle_client->clk_rate =
@@ -603,6 +723,8 @@ static int mmrm_sw_throttle_low_priority_client(
 		/* Store the corner level of throttled client */
 		tbl_entry_throttle_client->vdd_level = clk_min_level;
 
+		mmrm_sw_update_level_cur(sinfo, tbl_entry_throttle_client, true);
+
 		/* Clearing the reserve flag */
 		tbl_entry_throttle_client->reserve = false;
 	}
@@ -638,10 +760,9 @@ static void mmrm_sw_dump_enabled_client_info(struct mmrm_sw_clk_mgr_info *sinfo)
 static int mmrm_reinstate_throttled_client(struct mmrm_sw_clk_mgr_info *sinfo) {
 	struct mmrm_sw_peak_current_data *peak_data = &sinfo->peak_cur_data;
 	struct mmrm_sw_throttled_clients_data *iter, *safe_iter = NULL;
-	struct mmrm_client_notifier_data notifier_data;
 	struct mmrm_sw_clk_client_tbl_entry *re_entry_throttle_client;
-	int rc =  0;
-	u64 start_ts = 0, end_ts = 0;
+	struct mmrm_sw_notify_data *nd;
+	bool queued = false;
 
 	list_for_each_entry_safe(iter, safe_iter, &sinfo->throttled_clients, list) {
 		if (!IS_ERR_OR_NULL(iter) && peak_data->aggreg_val +
@@ -657,37 +778,46 @@ static int mmrm_reinstate_throttled_client(struct mmrm_sw_clk_mgr_info *sinfo) {
 				d_mpr_h("%s:found throttled client name(%s) clsid (0x%x)\n",
 					__func__, re_entry_throttle_client->name,
 					re_entry_throttle_client->clk_src_id);
-				notifier_data.cb_type = MMRM_CLIENT_RESOURCE_VALUE_CHANGE;
-				notifier_data.cb_data.val_chng.old_val =
-					re_entry_throttle_client->freq[MMRM_VDD_LEVEL_LOW_SVS];
-
-				notifier_data.cb_data.val_chng.new_val =
-					re_entry_throttle_client->freq[iter->prev_vdd_level];
-
-				notifier_data.pvt_data = re_entry_throttle_client->pvt_data;
-				start_ts = ktime_get_ns();
 
+				/*
+				 * The client is only informed that it may go back
+				 * to its previous rate, so notify it from the worker
+				 * rather than with the clk mgr lock held.
+				 */
 				if (re_entry_throttle_client->notifier_cb_fn) {
-					rc = re_entry_throttle_client->notifier_cb_fn
-								(&notifier_data);
-					end_ts = ktime_get_ns();
-					d_mpr_h("%s: Client notifier cbk processing time(%llu)ns\n",
-						__func__, end_ts - start_ts);
-
-					if (rc) {
-						d_mpr_e("%s: Client notifier callback failed(%d)\n",
-							__func__,
-							re_entry_throttle_client->clk_src_id);
+					nd = kzalloc(sizeof(*nd), GFP_KERNEL);
+					if (!nd) {
+						d_mpr_e("%s: Failed to allocate memory\n",
+							__func__);
+						continue;
 					}
-					if ((end_ts - start_ts) > NOTIFY_TIMEOUT)
-						d_mpr_e("%s: Client notifier took %llu ns\n",
-							__func__, (end_ts - start_ts));
+					nd->tbl_entry = re_entry_throttle_client;
+					nd->clk_src_id = re_entry_throttle_client->clk_src_id;
+					nd->notifier_cb_fn =
+						re_entry_throttle_client->notifier_cb_fn;
+					nd->notifier_data.cb_type =
+						MMRM_CLIENT_RESOURCE_VALUE_CHANGE;
+					nd->notifier_data.cb_data.val_chng.old_val =
+						re_entry_throttle_client->freq[MMRM_VDD_LEVEL_LOW_SVS];
+					nd->notifier_data.cb_data.val_chng.new_val =
+						re_entry_throttle_client->freq[iter->prev_vdd_level];
+					nd->notifier_data.pvt_data =
+						re_entry_throttle_client->pvt_data;
+
+					spin_lock(&sinfo->notify_lock);
+					list_add_tail(&nd->list, &sinfo->pending_notify);
+					spin_unlock(&sinfo->notify_lock);
+					queued = true;
 				}
 				list_del(&iter->list);
 				kfree(iter);
 			}
 		}
 	}
+
+	if (queued)
+		schedule_work(&sinfo->notify_work);
+
 	return 0;
 }
 
@@ -704,7 +834,7 @@ static int mmrm_sw_check_peak_current(struct mmrm_sw_clk_mgr_info *sinfo,
 	int delta_cur = 0;
 
 	/* check the req level and adjust according to tbl entries */
-	rc = mmrm_sw_check_req_level(sinfo, tbl_entry->clk_src_id, req_level, &adj_level);
+	rc = mmrm_sw_check_req_level(sinfo, tbl_entry, req_level, &adj_level);
 	if (rc) {
 		goto err_invalid_level;
 	}
@@ -788,6 +918,47 @@ err_peak_overshoot:
 	return rc;
 }
 
+/*
+ * Update an enabled client whose new rate stays within its current level
+ * and number of hw blocks. Its current, and so the aggregated current,
+ * do not change as long as the aggregate level is not adjusted either,
+ * so only the clk mgr lock for read is taken and such calls from
+ * different clients do not serialize against each other.
+ * Returns false if the full peak current check is required.
+ */
+static bool mmrm_sw_clk_client_setval_same_level(struct mmrm_clk_mgr *sw_clk_mgr,
+	struct mmrm_sw_clk_client_tbl_entry *tbl_entry, u32 req_level,
+	unsigned long clk_val, u32 num_hw_blocks, bool req_reserve)
+{
+	struct mmrm_sw_clk_mgr_info *sinfo = &(sw_clk_mgr->data.sw_info);
+	struct mmrm_sw_peak_current_data *peak_data = &sinfo->peak_cur_data;
+	bool updated = false;
+	u32 adj_level;
+
+	down_read(&sw_clk_mgr->lock);
+	spin_lock(&tbl_entry->lock);
+
+	if (!tbl_entry->clk_rate || tbl_entry->vdd_level != req_level ||
+		tbl_entry->num_hw_blocks != num_hw_blocks ||
+		peak_data->aggreg_val >= peak_data->threshold)
+		goto unlock;
+
+	if (mmrm_sw_check_req_level(sinfo, tbl_entry,
+			req_level, &adj_level) ||
+		adj_level != peak_data->aggreg_level)
+		goto unlock;
+
+	tbl_entry->clk_rate = clk_val;
+	tbl_entry->reserve = req_reserve;
+	updated = true;
+
+unlock:
+	spin_unlock(&tbl_entry->lock);
+	up_read(&sw_clk_mgr->lock);
+
+	return updated;
+}
+
 static int mmrm_sw_clk_client_setval(struct mmrm_clk_mgr *sw_clk_mgr,
 	struct mmrm_client *client,
 	struct mmrm_client_data *client_data,
@@ -850,9 +1021,11 @@ static int mmrm_sw_clk_client_setval(struct mmrm_clk_mgr *sw_clk_mgr,
 			goto exit_no_err;
 
 		/* c & d */
-		mutex_lock(&sw_clk_mgr->lock);
+		down_read(&sw_clk_mgr->lock);
+		spin_lock(&tbl_entry->lock);
 		tbl_entry->reserve = req_reserve;
-		mutex_unlock(&sw_clk_mgr->lock);
+		spin_unlock(&tbl_entry->lock);
+		up_read(&sw_clk_mgr->lock);
 
 		/* skip or set clk rate */
 		if (req_reserve)
@@ -881,7 +1054,16 @@ static int mmrm_sw_clk_client_setval(struct mmrm_clk_mgr *sw_clk_mgr,
 		req_level = 0;
 	}
 
-	mutex_lock(&sw_clk_mgr->lock);
+	/* same level: current and peak data do not change, skip the peak check */
+	if (clk_val && mmrm_sw_clk_client_setval_same_level(sw_clk_mgr,
+			tbl_entry, req_level, clk_val, client_data->num_hw_blocks,
+			req_reserve)) {
+		d_mpr_h("%s: csid(0x%x) level(%d) unchanged\n",
+			__func__, tbl_entry->clk_src_id, req_level);
+		goto check_reserve;
+	}
+
+	down_write(&sw_clk_mgr->lock);
 
 	/* check and update for peak current */
 	rc = mmrm_sw_check_peak_current(sinfo, tbl_entry,
@@ -890,18 +1072,21 @@ static int mmrm_sw_clk_client_setval(struct mmrm_clk_mgr *sw_clk_mgr,
 		d_mpr_e("%s: csid (0x%x) peak overshoot peak_cur(%lu)\n",
 			__func__, tbl_entry->clk_src_id,
 			sinfo->peak_cur_data.aggreg_val);
-		mutex_unlock(&sw_clk_mgr->lock);
+		up_write(&sw_clk_mgr->lock);
 		goto err_peak_overshoot;
 	}
 
 	/* update table entry */
+	mmrm_sw_update_level_cur(sinfo, tbl_entry, false);
 	tbl_entry->clk_rate = clk_val;
 	tbl_entry->vdd_level = req_level;
 	tbl_entry->reserve = req_reserve;
 	tbl_entry->num_hw_blocks = client_data->num_hw_blocks;
+	mmrm_sw_update_level_cur(sinfo, tbl_entry, true);
 
-	mutex_unlock(&sw_clk_mgr->lock);
+	up_write(&sw_clk_mgr->lock);
 
+check_reserve:
 	/* check reserve only flag (skip set clock rate) */
 	if (req_reserve) {
 		d_mpr_h("%s: csid(0x%x) skip setting clk rate\n",
@@ -1055,6 +1240,7 @@ static int mmrm_sw_prepare_table(struct mmrm_clk_platform_resources *cres,
 		tbl_entry->leak_pwr[MMRM_VDD_LEVEL_NOM] =
 			nom_tbl_entry->nom_leak_pwr;
 		tbl_entry->max_num_hw_blocks = nom_tbl_entry->num_hw_block;
+		spin_lock_init(&tbl_entry->lock);
 
 		d_mpr_h("%s: updating csid(0x%x) dyn_pwr(%d) leak_pwr(%d) num(%d)\n",
 			__func__,
@@ -1103,6 +1289,9 @@ int mmrm_init_sw_clk_mgr(void *driver_data)
 	sinfo->tot_clk_clients = cres->nom_clk_set.count;
 	sinfo->enabled_clk_clients = 0;
 	INIT_LIST_HEAD(&sinfo->throttled_clients);
+	INIT_LIST_HEAD(&sinfo->pending_notify);
+	spin_lock_init(&sinfo->notify_lock);
+	INIT_WORK(&sinfo->notify_work, mmrm_sw_notify_work_handler);
 
 	/* prepare table entries */
 	rc = mmrm_sw_prepare_table(cres, sinfo);
@@ -1129,8 +1318,8 @@ int mmrm_init_sw_clk_mgr(void *driver_data)
 		}
 	}
 
-	/* initialize mutex for sw clk mgr */
-	mutex_init(&sw_clk_mgr->lock);
+	/* initialize lock for sw clk mgr */
+	init_rwsem(&sw_clk_mgr->lock);
 	sw_clk_mgr->scheme = drv_data->clk_res.scheme;
 
 	/* clk client operations */
@@ -1155,6 +1344,9 @@ int mmrm_destroy_sw_clk_mgr(struct mmrm_clk_mgr *sw_clk_mgr)
 	struct mmrm_sw_clk_mgr_info *sinfo = &(sw_clk_mgr->data.sw_info);
 	struct mmrm_sw_throttled_clients_data *iter, *safe_iter = NULL;
 
+	cancel_work_sync(&sinfo->notify_work);
+	mmrm_sw_cancel_notify(sinfo, NULL);
+
 	list_for_each_entry_safe(iter, safe_iter, &sinfo->throttled_clients, list) {
 		list_del(&iter->list);
 		kfree(iter);
@@ -1166,7 +1358,6 @@ int mmrm_destroy_sw_clk_mgr(struct mmrm_clk_mgr *sw_clk_mgr)
 	}
 
 	kfree(sw_clk_mgr->data.sw_info.clk_client_tbl);
-	mutex_destroy(&sw_clk_mgr->lock);
 	kfree(sw_clk_mgr);
 
 	return rc;
@@ -212,11 +212,17 @@ static int mmrm_test_probe(struct platform_device *pdev)
 		test_mmrm_client(pdev, MMRM_TEST_WAIPIO, MMRM_TEST_WAIPIO_NUM_CLK_CLIENTS);
 		test_mmrm_concurrent_client_cases(pdev, waipio_testcases, waipio_testcases_count);
 		test_mmrm_switch_volt_corner_client_testcases(pdev, waipio_cornercase_testcases, waipio_cornercase_testcases_count);
+		test_mmrm_setval_stress(pdev, MMRM_TEST_WAIPIO_NUM_CLK_CLIENTS);
+		test_mmrm_notify_cancel(pdev, MMRM_TEST_WAIPIO_NUM_CLK_CLIENTS);
+		test_mmrm_scenario_replay(pdev, MMRM_TEST_WAIPIO_NUM_CLK_CLIENTS);
 		break;
 	case SOC_ID_KAILUA: /* KAILUA */
 		test_mmrm_client(pdev, MMRM_TEST_KAILUA, MMRM_TEST_KAILUA_NUM_CLK_CLIENTS);
 		test_mmrm_concurrent_client_cases(pdev, waipio_testcases, waipio_testcases_count);
 		test_mmrm_switch_volt_corner_client_testcases(pdev, waipio_cornercase_testcases, waipio_cornercase_testcases_count);
+		test_mmrm_setval_stress(pdev, MMRM_TEST_KAILUA_NUM_CLK_CLIENTS);
+		test_mmrm_notify_cancel(pdev, MMRM_TEST_KAILUA_NUM_CLK_CLIENTS);
+		test_mmrm_scenario_replay(pdev, MMRM_TEST_KAILUA_NUM_CLK_CLIENTS);
 		break;
 	default:
 		pr_info("%s: Not supported for soc_id %d [Target %s]\n",
@@ -15,11 +15,21 @@
 
 #include <linux/slab.h>
 #include <linux/clk.h>
+#include <linux/completion.h>
+#include <linux/delay.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 
 #include "mmrm_test_internal.h"
 
 #define MMRM_TEST_MAX_CLK_CLIENTS 30
 #define MMRM_TEST_NUM_CASES 3
+#define MMRM_TEST_STRESS_ITERATIONS 1000
+#define MMRM_TEST_NOTIFY_CB_MS 50
+#define MMRM_TEST_NOTIFY_WAIT_MS 1000
+#define MMRM_TEST_SCENARIO_INTERVALS 8
+#define MMRM_TEST_SCENARIO_DOMAINS 4
+#define MMRM_TEST_LEVEL_OFF -1
 
 enum mmrm_test_result {
 	TEST_MMRM_SUCCESS = 0,
@@ -34,6 +44,137 @@ struct mmrm_test_clk_client {
 	struct mmrm_client *client;
 };
 
+struct mmrm_test_stress_client {
+	struct clk *clk;
+	struct mmrm_client *client;
+	struct clock_rate *clk_rate;
+	struct completion done;
+	bool same_level;
+	u32 errors;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+struct mmrm_test_notify_client {
+	struct clk *clk;
+	struct mmrm_client *client;
+	struct clock_rate *clk_rate;
+	bool low_pri;
+	atomic_t num_cb;
+	atomic_t throttled;
+	atomic_t in_cb;
+	atomic_t cb_done;
+};
+
+struct mmrm_test_scenario_stats {
+	atomic_t num_throttled;
+	atomic_t num_reinstated;
+};
+
+struct mmrm_test_scenario_client {
+	struct clk *clk;
+	struct mmrm_client *client;
+	struct clock_rate *clk_rate;
+	int domain_idx;
+};
+
+struct mmrm_test_scenario {
+	const char *name;
+	u32 num_intervals;
+	/* level of each scenario domain per interval, or off */
+	int levels[MMRM_TEST_SCENARIO_INTERVALS][MMRM_TEST_SCENARIO_DOMAINS];
+};
+
+/* clients the driver may throttle, as listed in its platform data */
+static const struct mmrm_test_throttle_client {
+	u32 domain;
+	u32 id;
+} test_mmrm_throttle_clients[] = {
+	{MMRM_CLIENT_DOMAIN_DISPLAY, 0x3d},
+	{MMRM_CLIENT_DOMAIN_VIDEO, 0x03},
+	{MMRM_CLIENT_DOMAIN_CAMERA, 0x46},
+	{MMRM_CLIENT_DOMAIN_CVP, 0x08},
+	{MMRM_CLIENT_DOMAIN_CAMERA, 0x02},
+};
+
+static const u32 test_mmrm_scenario_domains[MMRM_TEST_SCENARIO_DOMAINS] = {
+	MMRM_CLIENT_DOMAIN_CAMERA,
+	MMRM_CLIENT_DOMAIN_VIDEO,
+	MMRM_CLIENT_DOMAIN_DISPLAY,
+	MMRM_CLIENT_DOMAIN_CVP,
+};
+
+#define OFF MMRM_TEST_LEVEL_OFF
+#define LSVS MMRM_TEST_VDD_LEVEL_LOW_SVS
+#define SVS MMRM_TEST_VDD_LEVEL_SVS
+#define SVSL1 MMRM_TEST_VDD_LEVEL_SVS_L1
+#define NOM MMRM_TEST_VDD_LEVEL_NOM
+#define TURBO MMRM_TEST_VDD_LEVEL_TURBO
+
+/* levels are in camera, video, display, cvp order */
+static const struct mmrm_test_scenario test_mmrm_scenarios[] = {
+	{
+		"camera preview to 4k hdr record", 6,
+		{
+			{SVS,   OFF,   SVS,   OFF},
+			{NOM,   OFF,   SVS,   OFF},
+			{NOM,   NOM,   SVS,   OFF},
+			{TURBO, NOM,   NOM,   SVSL1},
+			{TURBO, TURBO, NOM,   SVSL1},
+			{SVS,   OFF,   SVS,   OFF},
+		},
+	},
+	{
+		"8k playback with cv post processing", 5,
+		{
+			{OFF,   TURBO, NOM,   OFF},
+			{OFF,   TURBO, NOM,   SVS},
+			{OFF,   TURBO, TURBO, NOM},
+			{OFF,   TURBO, TURBO, TURBO},
+			{OFF,   NOM,   SVS,   OFF},
+		},
+	},
+	{
+		"video call with background blur", 6,
+		{
+			{SVSL1, SVSL1, SVS,   OFF},
+			{SVSL1, SVSL1, SVS,   SVSL1},
+			{TURBO, SVSL1, SVS,   NOM},
+			{TURBO, NOM,   NOM,   TURBO},
+			{SVSL1, SVSL1, SVS,   SVSL1},
+			{LSVS,  LSVS,  LSVS,  OFF},
+		},
+	},
+	{
+		"all domains at turbo", 3,
+		{
+			{NOM,   NOM,   NOM,   NOM},
+			{TURBO, TURBO, TURBO, TURBO},
+			{LSVS,  LSVS,  LSVS,  LSVS},
+		},
+	},
+};
+
+#undef OFF
+#undef LSVS
+#undef SVS
+#undef SVSL1
+#undef NOM
+#undef TURBO
+
+static bool test_mmrm_is_throttle_client(struct clock_rate *clk_rate)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(test_mmrm_throttle_clients); i++) {
+		if (test_mmrm_throttle_clients[i].domain == clk_rate->domain &&
+			test_mmrm_throttle_clients[i].id == clk_rate->id)
+			return true;
+	}
+
+	return false;
+}
+
 static int test_mmrm_client_callback(struct mmrm_client_notifier_data *notifier_data)
 {
 	// TODO: Test callback here
@@ -1004,3 +1145,488 @@ err_fail_alloc_result_ptr:
 
 }
 
+static int test_mmrm_stress_thread(void *data)
+{
+	struct mmrm_test_stress_client *sc = data;
+	struct mmrm_client_data client_data =
+		(struct mmrm_client_data){1, MMRM_CLIENT_DATA_FLAG_RESERVE_ONLY};
+	u64 start_ns, delta_ns;
+	unsigned long val;
+	int i;
+
+	for (i = 0; i < MMRM_TEST_STRESS_ITERATIONS; i++) {
+		if (sc->same_level) {
+			/* rates within svs, served under the read lock */
+			val = sc->clk_rate->clk_rates[MMRM_TEST_VDD_LEVEL_SVS];
+			if (i % 2 && val > 1)
+				val--;
+		} else {
+			/* cross a level on every call, served under the write lock */
+			val = sc->clk_rate->clk_rates[i % 2 ?
+				MMRM_TEST_VDD_LEVEL_SVS : MMRM_TEST_VDD_LEVEL_LOW_SVS];
+		}
+
+		start_ns = ktime_get_ns();
+		if (mmrm_client_set_value(sc->client, &client_data, val))
+			sc->errors++;
+		delta_ns = ktime_get_ns() - start_ns;
+
+		sc->total_ns += delta_ns;
+		if (delta_ns > sc->max_ns)
+			sc->max_ns = delta_ns;
+	}
+
+	complete(&sc->done);
+	return 0;
+}
+
+static u32 test_mmrm_stress_run(struct mmrm_test_stress_client *sc_tbl,
+	int num_clients, bool same_level, u64 *avg_ns, u64 *max_ns)
+{
+	struct mmrm_test_stress_client *sc;
+	struct task_struct *task;
+	u64 total_ns = 0;
+	u32 errors = 0, num_calls = 0;
+	int i;
+
+	*max_ns = 0;
+	for (i = 0; i < num_clients; i++) {
+		sc = &sc_tbl[i];
+		sc->same_level = same_level;
+		sc->errors = 0;
+		sc->total_ns = 0;
+		sc->max_ns = 0;
+		reinit_completion(&sc->done);
+	}
+
+	for (i = 0; i < num_clients; i++) {
+		sc = &sc_tbl[i];
+		task = kthread_run(test_mmrm_stress_thread, sc,
+			"mmrm_stress_%d", i);
+		if (IS_ERR(task)) {
+			pr_info("%s: Failed to start thread for %s\n",
+				__func__, sc->clk_rate->name);
+			sc->errors = MMRM_TEST_STRESS_ITERATIONS;
+			complete(&sc->done);
+		}
+	}
+
+	for (i = 0; i < num_clients; i++) {
+		sc = &sc_tbl[i];
+		wait_for_completion(&sc->done);
+
+		pr_info("%s: %s %s avg %llu ns max %llu ns errors %u\n",
+			__func__, same_level ? "same level" : "cross level",
+			sc->clk_rate->name,
+			sc->total_ns / MMRM_TEST_STRESS_ITERATIONS,
+			sc->max_ns, sc->errors);
+
+		total_ns += sc->total_ns;
+		*max_ns = max(*max_ns, sc->max_ns);
+		errors += sc->errors;
+		num_calls += MMRM_TEST_STRESS_ITERATIONS;
+	}
+
+	*avg_ns = num_calls ? total_ns / num_calls : 0;
+	return errors;
+}
+
+void test_mmrm_setval_stress(struct platform_device *pdev, int count)
+{
+	struct mmrm_test_stress_client *sc_tbl, *sc;
+	struct mmrm_client_data client_data =
+		(struct mmrm_client_data){1, MMRM_CLIENT_DATA_FLAG_RESERVE_ONLY};
+	struct mmrm_client_desc desc = {
+		MMRM_CLIENT_CLOCK,          // client type
+		{},                         // clock client descriptor
+		MMRM_CLIENT_PRIOR_HIGH,     // client priority
+		NULL,                       // pvt_data
+		test_mmrm_client_callback   // callback fn
+	};
+	u64 same_avg_ns, same_max_ns, cross_avg_ns, cross_max_ns;
+	u32 errors;
+	int i, num_clients = 0;
+
+	pr_info("%s: Started\n", __func__);
+
+	sc_tbl = kcalloc(count, sizeof(*sc_tbl), GFP_KERNEL);
+	if (!sc_tbl) {
+		pr_info("%s: failed to allocate memory for stress test\n",
+			__func__);
+		return;
+	}
+
+	/* register every available clock source as a concurrent client */
+	for (i = 0; i < count; i++) {
+		sc = &sc_tbl[num_clients];
+		sc->clk_rate = get_nth_clock(i);
+		if (sc->clk_rate == NULL)
+			break;
+
+		desc.client_info.desc.client_domain = sc->clk_rate->domain;
+		desc.client_info.desc.client_id = sc->clk_rate->id;
+		strlcpy((char *)desc.client_info.desc.name, sc->clk_rate->name,
+			MMRM_CLK_CLIENT_NAME_SIZE);
+
+		sc->clk = clk_get(&pdev->dev, sc->clk_rate->name);
+		if (IS_ERR_OR_NULL(sc->clk)) {
+			pr_info("%s: Failed clk_get for %s\n",
+				__func__, sc->clk_rate->name);
+			continue;
+		}
+		desc.client_info.desc.clk = sc->clk;
+
+		sc->client = mmrm_client_register(&desc);
+		if (sc->client == NULL) {
+			pr_info("%s: Failed to register %s\n",
+				__func__, sc->clk_rate->name);
+			clk_put(sc->clk);
+			continue;
+		}
+		init_completion(&sc->done);
+		num_clients++;
+	}
+
+	errors = test_mmrm_stress_run(sc_tbl, num_clients, false,
+		&cross_avg_ns, &cross_max_ns);
+	errors += test_mmrm_stress_run(sc_tbl, num_clients, true,
+		&same_avg_ns, &same_max_ns);
+
+	for (i = 0; i < num_clients; i++) {
+		sc = &sc_tbl[i];
+		mmrm_client_set_value(sc->client, &client_data, 0);
+		mmrm_client_deregister(sc->client);
+		clk_put(sc->clk);
+	}
+
+	pr_info("%s: clients %d calls %u: same level avg %llu ns max %llu ns, cross level avg %llu ns max %llu ns, errors %u\n",
+		__func__, num_clients, 2 * num_clients * MMRM_TEST_STRESS_ITERATIONS,
+		same_avg_ns, same_max_ns, cross_avg_ns, cross_max_ns, errors);
+
+	/* same level calls must not be slower than the write lock path */
+	if (!num_clients || errors || same_avg_ns > cross_avg_ns)
+		pr_info("%s: Finish setval stress: FAIL\n", __func__);
+	else
+		pr_info("%s: Finish setval stress: PASS\n", __func__);
+
+	kfree(sc_tbl);
+}
+
+static int test_mmrm_notify_callback(
+	struct mmrm_client_notifier_data *notifier_data)
+{
+	struct mmrm_test_notify_client *nc = notifier_data->pvt_data;
+
+	atomic_inc(&nc->num_cb);
+
+	/* throttle is notified with the clk mgr lock held, return quickly */
+	if (notifier_data->cb_data.val_chng.new_val <
+		notifier_data->cb_data.val_chng.old_val) {
+		atomic_set(&nc->throttled, 1);
+		return 0;
+	}
+
+	/* reinstate runs from the notify worker, stay busy for a while */
+	atomic_set(&nc->in_cb, 1);
+	msleep(MMRM_TEST_NOTIFY_CB_MS);
+	atomic_set(&nc->cb_done, 1);
+
+	return 0;
+}
+
+void test_mmrm_notify_cancel(struct platform_device *pdev, int count)
+{
+	struct mmrm_test_notify_client *nc_tbl, *nc, *req = NULL, *victim = NULL;
+	struct mmrm_client_data client_data =
+		(struct mmrm_client_data){1, MMRM_CLIENT_DATA_FLAG_RESERVE_ONLY};
+	struct mmrm_client_desc desc = {
+		MMRM_CLIENT_CLOCK,          // client type
+		{},                         // clock client descriptor
+		MMRM_CLIENT_PRIOR_LOW,      // client priority
+		NULL,                       // pvt_data
+		test_mmrm_notify_callback   // callback fn
+	};
+	int i, num_cb, waited_ms, num_clients = 0, num_low = 0;
+	const char *result = "fail";
+
+	pr_info("%s: Started\n", __func__);
+
+	nc_tbl = kcalloc(count, sizeof(*nc_tbl), GFP_KERNEL);
+	if (!nc_tbl) {
+		pr_info("%s: failed to allocate memory for notify test\n",
+			__func__);
+		return;
+	}
+
+	/* clients on the throttle list are low priority, the rest high */
+	for (i = 0; i < count; i++) {
+		nc = &nc_tbl[num_clients];
+		nc->clk_rate = get_nth_clock(i);
+		if (nc->clk_rate == NULL)
+			break;
+
+		desc.client_info.desc.client_domain = nc->clk_rate->domain;
+		desc.client_info.desc.client_id = nc->clk_rate->id;
+		strlcpy((char *)desc.client_info.desc.name, nc->clk_rate->name,
+			MMRM_CLK_CLIENT_NAME_SIZE);
+		nc->low_pri = test_mmrm_is_throttle_client(nc->clk_rate);
+		desc.priority = nc->low_pri ?
+			MMRM_CLIENT_PRIOR_LOW : MMRM_CLIENT_PRIOR_HIGH;
+		desc.pvt_data = nc;
+
+		nc->clk = clk_get(&pdev->dev, nc->clk_rate->name);
+		if (IS_ERR_OR_NULL(nc->clk)) {
+			pr_info("%s: Failed clk_get for %s\n",
+				__func__, nc->clk_rate->name);
+			continue;
+		}
+		desc.client_info.desc.clk = nc->clk;
+
+		nc->client = mmrm_client_register(&desc);
+		if (nc->client == NULL) {
+			pr_info("%s: Failed to register %s\n",
+				__func__, nc->clk_rate->name);
+			clk_put(nc->clk);
+			continue;
+		}
+		if (nc->low_pri)
+			num_low++;
+		else if (!req)
+			req = nc;
+		num_clients++;
+	}
+
+	if (!req || !num_low) {
+		pr_info("%s: no high priority requester or throttle client (clients %d low %d)\n",
+			__func__, num_clients, num_low);
+		result = "skipped";
+		goto err_cleanup;
+	}
+
+	/* load the low priority clients, then let the requester overshoot */
+	for (i = 0; i < num_clients; i++) {
+		nc = &nc_tbl[i];
+		if (nc->low_pri)
+			mmrm_client_set_value(nc->client, &client_data,
+				nc->clk_rate->clk_rates[MMRM_TEST_VDD_LEVEL_NOM]);
+	}
+
+	mmrm_client_set_value(req->client, &client_data,
+		req->clk_rate->clk_rates[MMRM_TEST_VDD_LEVEL_TURBO]);
+
+	for (i = 0; i < num_clients; i++) {
+		if (nc_tbl[i].low_pri && atomic_read(&nc_tbl[i].throttled)) {
+			victim = &nc_tbl[i];
+			break;
+		}
+	}
+	if (!victim) {
+		pr_info("%s: no client throttled\n", __func__);
+		result = "skipped";
+		goto err_cleanup;
+	}
+
+	/* dropping the requester queues the reinstate notification */
+	mmrm_client_set_value(req->client, &client_data, 0);
+
+	for (waited_ms = 0; waited_ms < MMRM_TEST_NOTIFY_WAIT_MS &&
+		!atomic_read(&victim->in_cb); waited_ms++)
+		usleep_range(1000, 1100);
+	if (!atomic_read(&victim->in_cb)) {
+		pr_info("%s: reinstate of %s not delivered\n",
+			__func__, victim->clk_rate->name);
+		goto err_cleanup;
+	}
+
+	/* deregister must wait for the running callback to finish */
+	mmrm_client_set_value(victim->client, &client_data, 0);
+	mmrm_client_deregister(victim->client);
+	victim->client = NULL;
+	if (!atomic_read(&victim->cb_done)) {
+		pr_info("%s: deregister of %s returned inside its callback\n",
+			__func__, victim->clk_rate->name);
+		goto err_cleanup;
+	}
+
+	/* and no callback may run for it afterwards */
+	num_cb = atomic_read(&victim->num_cb);
+	msleep(2 * MMRM_TEST_NOTIFY_CB_MS);
+	if (atomic_read(&victim->num_cb) != num_cb) {
+		pr_info("%s: %s notified after deregister\n",
+			__func__, victim->clk_rate->name);
+		goto err_cleanup;
+	}
+	result = "pass";
+
+err_cleanup:
+	for (i = 0; i < num_clients; i++) {
+		nc = &nc_tbl[i];
+		if (nc->client) {
+			mmrm_client_set_value(nc->client, &client_data, 0);
+			mmrm_client_deregister(nc->client);
+		}
+		clk_put(nc->clk);
+	}
+
+	pr_info("%s: Finish notify cancel test (clients %d): %s\n",
+		__func__, num_clients, result);
+
+	kfree(nc_tbl);
+}
+
+static int test_mmrm_scenario_callback(
+	struct mmrm_client_notifier_data *notifier_data)
+{
+	struct mmrm_test_scenario_stats *stats = notifier_data->pvt_data;
+
+	if (notifier_data->cb_data.val_chng.new_val <
+		notifier_data->cb_data.val_chng.old_val)
+		atomic_inc(&stats->num_throttled);
+	else
+		atomic_inc(&stats->num_reinstated);
+
+	return 0;
+}
+
+static void test_mmrm_scenario_run(struct mmrm_test_scenario_client *sc_tbl,
+	int num_clients, const struct mmrm_test_scenario *scn,
+	struct mmrm_test_scenario_stats *stats)
+{
+	struct mmrm_test_scenario_client *sc;
+	struct mmrm_client_data client_data =
+		(struct mmrm_client_data){1, MMRM_CLIENT_DATA_FLAG_RESERVE_ONLY};
+	u64 start_ns, delta_ns, total_ns = 0, max_ns = 0;
+	u64 thr_total_ns = 0, thr_max_ns = 0;
+	u32 num_calls = 0, num_decisions = 0, num_rejected = 0;
+	u32 num_over = 0;
+	int i, c, level, num_thr;
+	bool over;
+	unsigned long val;
+
+	atomic_set(&stats->num_throttled, 0);
+	atomic_set(&stats->num_reinstated, 0);
+
+	for (i = 0; i < scn->num_intervals; i++) {
+		over = false;
+		for (c = 0; c < num_clients; c++) {
+			sc = &sc_tbl[c];
+			level = scn->levels[i][sc->domain_idx];
+			val = level == MMRM_TEST_LEVEL_OFF ?
+				0 : sc->clk_rate->clk_rates[level];
+
+			/* throttle callbacks run inside the set value call */
+			num_thr = atomic_read(&stats->num_throttled);
+			start_ns = ktime_get_ns();
+			if (mmrm_client_set_value(sc->client, &client_data, val)) {
+				num_rejected++;
+				over = true;
+			}
+			delta_ns = ktime_get_ns() - start_ns;
+
+			total_ns += delta_ns;
+			max_ns = max(max_ns, delta_ns);
+			num_calls++;
+
+			if (atomic_read(&stats->num_throttled) != num_thr) {
+				thr_total_ns += delta_ns;
+				thr_max_ns = max(thr_max_ns, delta_ns);
+				num_decisions++;
+				over = true;
+			}
+		}
+		if (over)
+			num_over++;
+	}
+
+	for (c = 0; c < num_clients; c++)
+		mmrm_client_set_value(sc_tbl[c].client, &client_data, 0);
+
+	pr_info("%s: %s: intervals %u over threshold %u rejected %u\n",
+		__func__, scn->name, scn->num_intervals, num_over, num_rejected);
+	pr_info("%s: %s: set value calls %u avg %llu ns max %llu ns\n",
+		__func__, scn->name, num_calls,
+		num_calls ? total_ns / num_calls : 0, max_ns);
+	pr_info("%s: %s: throttle decisions %u avg %llu ns max %llu ns reinstated %d\n",
+		__func__, scn->name, num_decisions,
+		num_decisions ? thr_total_ns / num_decisions : 0, thr_max_ns,
+		atomic_read(&stats->num_reinstated));
+}
+
+void test_mmrm_scenario_replay(struct platform_device *pdev, int count)
+{
+	struct mmrm_test_scenario_client *sc_tbl, *sc;
+	struct mmrm_test_scenario_stats stats;
+	struct mmrm_client_desc desc = {
+		MMRM_CLIENT_CLOCK,          // client type
+		{},                         // clock client descriptor
+		MMRM_CLIENT_PRIOR_LOW,      // client priority
+		&stats,                     // pvt_data
+		test_mmrm_scenario_callback // callback fn
+	};
+	int i, d, num_clients = 0;
+
+	pr_info("%s: Started\n", __func__);
+
+	sc_tbl = kcalloc(count, sizeof(*sc_tbl), GFP_KERNEL);
+	if (!sc_tbl) {
+		pr_info("%s: failed to allocate memory for scenario test\n",
+			__func__);
+		return;
+	}
+
+	/* register the clients of the scenario domains */
+	for (i = 0; i < count; i++) {
+		sc = &sc_tbl[num_clients];
+		sc->clk_rate = get_nth_clock(i);
+		if (sc->clk_rate == NULL)
+			break;
+
+		for (d = 0; d < MMRM_TEST_SCENARIO_DOMAINS; d++) {
+			if (test_mmrm_scenario_domains[d] == sc->clk_rate->domain)
+				break;
+		}
+		if (d == MMRM_TEST_SCENARIO_DOMAINS)
+			continue;
+		sc->domain_idx = d;
+
+		desc.client_info.desc.client_domain = sc->clk_rate->domain;
+		desc.client_info.desc.client_id = sc->clk_rate->id;
+		strlcpy((char *)desc.client_info.desc.name, sc->clk_rate->name,
+			MMRM_CLK_CLIENT_NAME_SIZE);
+		desc.priority = test_mmrm_is_throttle_client(sc->clk_rate) ?
+			MMRM_CLIENT_PRIOR_LOW : MMRM_CLIENT_PRIOR_HIGH;
+
+		sc->clk = clk_get(&pdev->dev, sc->clk_rate->name);
+		if (IS_ERR_OR_NULL(sc->clk)) {
+			pr_info("%s: Failed clk_get for %s\n",
+				__func__, sc->clk_rate->name);
+			continue;
+		}
+		desc.client_info.desc.clk = sc->clk;
+
+		sc->client = mmrm_client_register(&desc);
+		if (sc->client == NULL) {
+			pr_info("%s: Failed to register %s\n",
+				__func__, sc->clk_rate->name);
+			clk_put(sc->clk);
+			continue;
+		}
+		num_clients++;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(test_mmrm_scenarios); i++)
+		test_mmrm_scenario_run(sc_tbl, num_clients,
+			&test_mmrm_scenarios[i], &stats);
+
+	/* reinstate notifications are delivered from the mmrm worker */
+	for (i = 0; i < num_clients; i++) {
+		sc = &sc_tbl[i];
+		mmrm_client_deregister(sc->client);
+		clk_put(sc->clk);
+	}
+
+	pr_info("%s: Finish scenario replay (clients %d scenarios %zu)\n",
+		__func__, num_clients, ARRAY_SIZE(test_mmrm_scenarios));
+
+	kfree(sc_tbl);
+}
@@ -78,5 +78,8 @@ struct clock_rate *find_clk_by_name(const char *name);
 struct clock_rate *get_nth_clock(int nth);
 void test_mmrm_switch_volt_corner_client_testcases(struct platform_device *pdev,
 		test_case_info_t **testcases, int count);
+void test_mmrm_setval_stress(struct platform_device *pdev, int count);
+void test_mmrm_notify_cancel(struct platform_device *pdev, int count);
+void test_mmrm_scenario_replay(struct platform_device *pdev, int count);
 
 #endif  // TEST_MMRM_TEST_INTERNAL_H_
@@ -6,3 +6,4 @@
 
 #define CONFIG_MSM_VIDC_CROW   1
 #define CONFIG_MSM_VIDC_IRIS2    1
+#define CONFIG_MSM_VIDC_KUNIT_TEST 1
@@ -6,3 +6,4 @@
 
 #define CONFIG_MSM_VIDC_KALAMA   1
 #define CONFIG_MSM_VIDC_IRIS3    1
+#define CONFIG_MSM_VIDC_KUNIT_TEST 1
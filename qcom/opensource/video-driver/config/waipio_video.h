@@ -5,3 +5,4 @@
 
 #define CONFIG_MSM_VIDC_WAIPIO   1
 #define CONFIG_MSM_VIDC_IRIS2    1
+#define CONFIG_MSM_VIDC_KUNIT_TEST 1
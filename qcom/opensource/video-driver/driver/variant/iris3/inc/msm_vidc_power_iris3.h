@@ -11,7 +11,9 @@
 #include "msm_vidc_inst.h"
 
 u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst* inst, u32 data_size);
+u64 msm_vidc_calc_freq_params_iris3(const struct msm_vidc_freq_params *p);
 int msm_vidc_calc_bw_iris3(struct msm_vidc_inst* inst,
 		struct vidc_bus_vote_data* vote_data);
+u64 msm_vidc_calc_bw_params_iris3(struct vidc_bus_vote_data *d);
 
 #endif
@@ -605,11 +605,79 @@ struct msm_vidc_buf_type_handle {
 	u32 (*handle)(struct msm_vidc_inst *inst);
 };
 
+static bool msm_vidc_decoder_size_cacheable(enum msm_vidc_buffer_type type)
+{
+	switch (type) {
+	case MSM_VIDC_BUF_BIN:
+	case MSM_VIDC_BUF_COMV:
+	case MSM_VIDC_BUF_NON_COMV:
+	case MSM_VIDC_BUF_LINE:
+	case MSM_VIDC_BUF_PERSIST:
+	case MSM_VIDC_BUF_DPB:
+	case MSM_VIDC_BUF_PARTIAL_DATA:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void msm_vidc_decoder_size_key(struct msm_vidc_inst *inst,
+	struct msm_vidc_buffer_size_key *key)
+{
+	struct msm_vidc_inst_capability *capability = inst->capabilities;
+
+	memset(key, 0, sizeof(*key));
+	key->codec = inst->codec;
+	key->in_width = inst->fmts[INPUT_PORT].fmt.pix_mp.width;
+	key->in_height = inst->fmts[INPUT_PORT].fmt.pix_mp.height;
+	key->out_width = inst->fmts[OUTPUT_PORT].fmt.pix_mp.width;
+	key->out_height = inst->fmts[OUTPUT_PORT].fmt.pix_mp.height;
+	key->out_pixelformat = inst->fmts[OUTPUT_PORT].fmt.pix_mp.pixelformat;
+	key->pix_fmt = capability->cap[PIX_FMTS].value;
+	key->out_min_count = inst->buffers.output.min_count;
+	key->vpp_delay = inst->decode_vpp_delay.enable ?
+		inst->decode_vpp_delay.size : DEFAULT_BSE_VPP_DELAY;
+	key->num_vpp_pipes = inst->core->capabilities[NUM_VPP_PIPE].value;
+	key->coded_frames = capability->cap[CODED_FRAMES].value;
+	key->drap = capability->cap[DRAP].value;
+	key->film_grain = capability->cap[FILM_GRAIN].value;
+	key->dolby_rpu = capability->cap[META_DOLBY_RPU].value;
+	key->thumbnail = capability->cap[THUMBNAIL_MODE].value;
+	key->slice_mode = capability->cap[SLICE_MODE].value;
+	key->slice_max_mb = capability->cap[SLICE_MAX_MB].value;
+	key->delivery_mode = capability->cap[DELIVERY_MODE].value;
+}
+
+/*
+ * Expanding the HFI size macros is costly and the same decoder sizes and
+ * counts are requested several times per stream (get_buf_req,
+ * create/queue internal buffers, port reconfig), so they are cached per
+ * session against the key above.
+ */
+static bool msm_vidc_decoder_cacheable(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type, bool count)
+{
+	if (!is_decode_session(inst) || !inst->core ||
+		!inst->core->capabilities || !inst->capabilities)
+		return false;
+
+	/* port buffer counts only depend on the key, their sizes do not */
+	if (count && (type == MSM_VIDC_BUF_INPUT ||
+		type == MSM_VIDC_BUF_OUTPUT ||
+		type == MSM_VIDC_BUF_INPUT_META ||
+		type == MSM_VIDC_BUF_OUTPUT_META))
+		return true;
+
+	return msm_vidc_decoder_size_cacheable(type);
+}
+
 int msm_buffer_size_iris3(struct msm_vidc_inst *inst,
 		enum msm_vidc_buffer_type buffer_type)
 {
 	int i;
 	u32 size = 0, buf_type_handle_size = 0;
+	bool cacheable;
+	struct msm_vidc_buffer_size_key key;
 	const struct msm_vidc_buf_type_handle *buf_type_handle_arr = NULL;
 	static const struct msm_vidc_buf_type_handle dec_buf_type_handle[] = {
 		{MSM_VIDC_BUF_INPUT,           msm_vidc_decoder_input_size              },
@@ -652,6 +720,21 @@ int msm_buffer_size_iris3(struct msm_vidc_inst *inst,
 		return size;
 	}
 
+	cacheable = msm_vidc_decoder_cacheable(inst, buffer_type, false);
+	if (cacheable) {
+		msm_vidc_decoder_size_key(inst, &key);
+		if (msm_vidc_buffer_size_cache_get(&inst->buf_size_cache, &key,
+			buffer_type, &size)) {
+			/* COMV size helper also sets NUM_COMV, read by set_num_comv */
+			if (buffer_type == MSM_VIDC_BUF_COMV)
+				msm_vidc_update_cap_value(inst, NUM_COMV,
+					inst->buf_size_cache.num_comv, __func__);
+			i_vpr_l(inst, "buffer_size: type: %11s,  size: %9u (cached)\n",
+				buf_name(buffer_type), size);
+			return size;
+		}
+	}
+
 	/* fetch buffer size */
 	for (i = 0; i < buf_type_handle_size; i++) {
 		if (buf_type_handle_arr[i].type == buffer_type) {
@@ -666,11 +749,20 @@ int msm_buffer_size_iris3(struct msm_vidc_inst *inst,
 		goto exit;
 	}
 
+	if (cacheable) {
+		msm_vidc_buffer_size_cache_put(&inst->buf_size_cache,
+			buffer_type, size);
+		if (buffer_type == MSM_VIDC_BUF_COMV)
+			inst->buf_size_cache.num_comv =
+				inst->capabilities->cap[NUM_COMV].value;
+	}
+
 	i_vpr_l(inst, "buffer_size: type: %11s,  size: %9u\n", buf_name(buffer_type), size);
 
 exit:
 	return size;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_buffer_size_iris3);
 
 static int msm_vidc_input_min_count_iris3(struct msm_vidc_inst* inst)
 {
@@ -775,12 +867,26 @@ int msm_buffer_min_count_iris3(struct msm_vidc_inst *inst,
 		enum msm_vidc_buffer_type buffer_type)
 {
 	int count = 0;
+	u32 cached_count = 0;
+	bool cacheable;
+	struct msm_vidc_buffer_size_key key;
 
 	if (!inst) {
 		d_vpr_e("%s: invalid params\n", __func__);
 		return 0;
 	}
 
+	cacheable = msm_vidc_decoder_cacheable(inst, buffer_type, true);
+	if (cacheable) {
+		msm_vidc_decoder_size_key(inst, &key);
+		if (msm_vidc_buffer_count_cache_get(&inst->buf_size_cache, &key,
+			buffer_type, &cached_count)) {
+			i_vpr_l(inst, "  min_count: type: %11s, count: %9u (cached)\n",
+				buf_name(buffer_type), cached_count);
+			return cached_count;
+		}
+	}
+
 	switch (buffer_type) {
 	case MSM_VIDC_BUF_INPUT:
 	case MSM_VIDC_BUF_INPUT_META:
@@ -808,6 +914,10 @@ int msm_buffer_min_count_iris3(struct msm_vidc_inst *inst,
 		break;
 	}
 
+	if (cacheable)
+		msm_vidc_buffer_count_cache_put(&inst->buf_size_cache,
+			buffer_type, count);
+
 	i_vpr_l(inst, "  min_count: type: %11s, count: %9u\n", buf_name(buffer_type), count);
 	return count;
 }
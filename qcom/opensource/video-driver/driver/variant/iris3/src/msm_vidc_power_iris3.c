@@ -11,58 +11,49 @@
 #include "msm_vidc_debug.h"
 #include "msm_vidc_dt.h"
 
-u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
+/*
+ * Clock frequency model: reads nothing but the params, so it can run on
+ * params filled outside of a session.
+ */
+u64 msm_vidc_calc_freq_params_iris3(const struct msm_vidc_freq_params *p)
 {
 	u64 freq = 0;
-	struct msm_vidc_core* core;
 	u64 vsp_cycles = 0, vpp_cycles = 0, fw_cycles = 0;
 	u64 fw_vpp_cycles = 0, bitrate = 0;
-	u32 vpp_cycles_per_mb;
 	u32 mbs_per_second;
-	u32 operating_rate, vsp_factor_num = 1, vsp_factor_den = 1;
+	u32 vsp_factor_num = 1, vsp_factor_den = 1;
 	u32 base_cycles = 0;
-	u32 fps, mbpf;
-
-	if (!inst || !inst->core || !inst->capabilities) {
-		d_vpr_e("%s: invalid params\n", __func__);
-		return freq;
-	}
+	u32 fps, data_size;
 
-	core = inst->core;
-	if (!core->dt || !core->dt->allowed_clks_tbl) {
+	if (!p || !p->pipe) {
 		d_vpr_e("%s: invalid params\n", __func__);
 		return freq;
 	}
 
-	mbpf = msm_vidc_get_mbs_per_frame(inst);
-	fps = inst->max_rate;
-	mbs_per_second = mbpf * fps;
+	fps = p->fps;
+	data_size = p->data_size;
+	mbs_per_second = p->mbpf * fps;
 
 	/*
 	 * Calculate vpp, vsp, fw cycles separately for encoder and decoder.
 	 * Even though, most part is common now, in future it may change
 	 * between them.
 	 */
-	fw_cycles = fps * inst->capabilities->cap[MB_CYCLES_FW].value;
-	fw_vpp_cycles = fps * inst->capabilities->cap[MB_CYCLES_FW_VPP].value;
-
-	if (inst->domain == MSM_VIDC_ENCODER) {
-		vpp_cycles_per_mb = is_low_power_session(inst) ?
-			inst->capabilities->cap[MB_CYCLES_LP].value :
-			inst->capabilities->cap[MB_CYCLES_VPP].value;
+	fw_cycles = fps * p->mb_cycles_fw;
+	fw_vpp_cycles = fps * p->mb_cycles_fw_vpp;
 
-		vpp_cycles = mbs_per_second * vpp_cycles_per_mb /
-			inst->capabilities->cap[PIPE].value;
+	if (p->domain == MSM_VIDC_ENCODER) {
+		vpp_cycles = mbs_per_second * p->mb_cycles_vpp / p->pipe;
 
 		/* Factor 1.25 for IbP and 1.375 for I1B2b1P GOP structure */
-		if (inst->capabilities->cap[B_FRAME].value > 1)
+		if (p->b_frame > 1)
 			vpp_cycles += (vpp_cycles / 4) + (vpp_cycles / 8);
-		else if (inst->capabilities->cap[B_FRAME].value)
+		else if (p->b_frame)
 			vpp_cycles += vpp_cycles / 4;
 		/* 21 / 20 is minimum overhead factor */
 		vpp_cycles += max(div_u64(vpp_cycles, 20), fw_vpp_cycles);
 		/* 1.01 is multi-pipe overhead */
-		if (inst->capabilities->cap[PIPE].value > 1)
+		if (p->pipe > 1)
 			vpp_cycles += div_u64(vpp_cycles, 100);
 		/*
 		 * 1080p@480fps usecase needs exactly 338MHz
@@ -80,25 +71,22 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 			vpp_cycles += div_u64(vpp_cycles * 5, 100);
 
 		/* increase vpp_cycles by 50% for preprocessing */
-		if (inst->capabilities->cap[REQUEST_PREPROCESS].value)
+		if (p->preprocess)
 			vpp_cycles = vpp_cycles + vpp_cycles / 2;
 
 		/* VSP */
 		/* bitrate is based on fps, scale it using operating rate */
-		operating_rate = inst->capabilities->cap[OPERATING_RATE].value >> 16;
-		if (operating_rate >
-			(inst->capabilities->cap[FRAME_RATE].value >> 16) &&
-			(inst->capabilities->cap[FRAME_RATE].value >> 16)) {
-			vsp_factor_num = operating_rate;
-			vsp_factor_den = inst->capabilities->cap[FRAME_RATE].value >> 16;
+		if (p->operating_rate > p->frame_rate && p->frame_rate) {
+			vsp_factor_num = p->operating_rate;
+			vsp_factor_den = p->frame_rate;
 		}
-		vsp_cycles = div_u64(((u64)inst->capabilities->cap[BIT_RATE].value *
-					vsp_factor_num), vsp_factor_den);
+		vsp_cycles = div_u64(((u64)p->bit_rate * vsp_factor_num),
+					vsp_factor_den);
 
-		base_cycles = inst->capabilities->cap[MB_CYCLES_VSP].value;
-		if (inst->codec == MSM_VIDC_VP9) {
+		base_cycles = p->mb_cycles_vsp;
+		if (p->codec == MSM_VIDC_VP9) {
 			vsp_cycles = div_u64(vsp_cycles * 170, 100);
-		} else if (inst->capabilities->cap[ENTROPY_MODE].value ==
+		} else if (p->entropy_mode ==
 			V4L2_MPEG_VIDEO_H264_ENTROPY_MODE_CABAC) {
 			vsp_cycles = div_u64(vsp_cycles * 135, 100);
 		} else {
@@ -108,19 +96,18 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 		/* VSP FW Overhead 1.05 */
 		vsp_cycles = div_u64(vsp_cycles * 21, 20);
 
-		if (inst->capabilities->cap[STAGE].value == MSM_VIDC_STAGE_1)
+		if (p->stage == MSM_VIDC_STAGE_1)
 			vsp_cycles = vsp_cycles * 3;
 
 		vsp_cycles += mbs_per_second * base_cycles;
 
-	} else if (inst->domain == MSM_VIDC_DECODER) {
+	} else if (p->domain == MSM_VIDC_DECODER) {
 		/* VPP */
-		vpp_cycles = mbs_per_second * inst->capabilities->cap[MB_CYCLES_VPP].value /
-			inst->capabilities->cap[PIPE].value;
+		vpp_cycles = mbs_per_second * p->mb_cycles_vpp / p->pipe;
 		/* 21 / 20 is minimum overhead factor */
 		vpp_cycles += max(vpp_cycles / 20, fw_vpp_cycles);
-		if (inst->capabilities->cap[PIPE].value > 1) {
-			if (inst->codec == MSM_VIDC_AV1) {
+		if (p->pipe > 1) {
+			if (p->codec == MSM_VIDC_AV1) {
 				/*
 				 * Additional vpp_cycles are required for bitstreams with
 				 * 128x128 superblock and non-recommended tile settings.
@@ -128,7 +115,7 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 				 * non-recommended tiles: 1080P_V4XH2_V4X1, UHD_V8X4_V8X1,
 				 * 8KUHD_V8X8_V8X1
 				 */
-				if (inst->capabilities->cap[SUPER_BLOCK].value)
+				if (p->super_block)
 					vpp_cycles += div_u64(vpp_cycles * 1464, 1000);
 				else
 					vpp_cycles += div_u64(vpp_cycles * 410, 1000);
@@ -139,7 +126,7 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 		}
 
 		/* VSP */
-		if (inst->codec == MSM_VIDC_AV1) {
+		if (p->codec == MSM_VIDC_AV1) {
 			/*
 			 * For AV1: Use VSP calculations from Kalama perf model.
 			 * For legacy codecs, use vsp_cycles based on legacy MB_CYCLES_VSP.
@@ -150,28 +137,23 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 			u32 input_bitrate_mbps = 0;
 			u32 bitrate_2stage[2] = {130, 120};
 			u32 bitrate_1stage = 100;
-			u32 width, height;
-			u32 bitrate_entry, freq_entry, frequency_table_value;
-			struct allowed_clock_rates_table *allowed_clks_tbl;
-			struct v4l2_format *out_f = &inst->fmts[OUTPUT_PORT];
-
-			width = out_f->fmt.pix_mp.width;
-			height = out_f->fmt.pix_mp.height;
+			u32 bitrate_entry, frequency_table_value;
+			u64 table_freq;
 
 			bitrate_entry = 1;
 			/* 8KUHD60, UHD240, 1080p960 */
-			if (width * height * fps >= 3840 * 2160 * 240)
+			if (p->width * p->height * fps >= 3840 * 2160 * 240)
 				bitrate_entry = 0;
 
-			freq_entry = bitrate_entry;
-
-			allowed_clks_tbl = core->dt->allowed_clks_tbl;
-			frequency_table_value = allowed_clks_tbl[freq_entry].clock_rate / 1000000;
+			/* index 0 of the clock table is TURBO, index 1 is NOM */
+			table_freq = bitrate_entry && p->nom_freq ?
+				p->nom_freq : p->max_freq;
+			frequency_table_value = div_u64(table_freq, 1000000);
 
 			input_bitrate_mbps = fps * data_size * 8 / (1024 * 1024);
 			vsp_hw_min_frequency = frequency_table_value * 1000 * input_bitrate_mbps;
 
-			if (inst->capabilities->cap[STAGE].value == MSM_VIDC_STAGE_2) {
+			if (p->stage == MSM_VIDC_STAGE_2) {
 				vsp_hw_min_frequency +=
 					(bitrate_2stage[bitrate_entry] * fw_sw_vsp_offset - 1);
 				vsp_hw_min_frequency = div_u64(vsp_hw_min_frequency,
@@ -187,14 +169,13 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 
 			vsp_cycles = vsp_hw_min_frequency * 1000000;
 		} else {
-			base_cycles = inst->has_bframe ?
-					80 : inst->capabilities->cap[MB_CYCLES_VSP].value;
+			base_cycles = p->has_bframe ? 80 : p->mb_cycles_vsp;
 			bitrate = fps * data_size * 8;
 			vsp_cycles = bitrate;
 
-			if (inst->codec == MSM_VIDC_VP9) {
+			if (p->codec == MSM_VIDC_VP9) {
 				vsp_cycles = div_u64(vsp_cycles * 170, 100);
-			} else if (inst->capabilities->cap[ENTROPY_MODE].value ==
+			} else if (p->entropy_mode ==
 				V4L2_MPEG_VIDEO_H264_ENTROPY_MODE_CABAC) {
 				vsp_cycles = div_u64(vsp_cycles * 135, 100);
 			} else {
@@ -204,7 +185,7 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 			/* VSP FW overhead 1.05 */
 			vsp_cycles = div_u64(vsp_cycles * 21, 20);
 
-			if (inst->capabilities->cap[STAGE].value == MSM_VIDC_STAGE_1)
+			if (p->stage == MSM_VIDC_STAGE_1)
 				vsp_cycles = vsp_cycles * 3;
 
 			vsp_cycles += mbs_per_second * base_cycles;
@@ -214,27 +195,26 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 				vsp_cycles += div_u64(vpp_cycles * 25, 100);
 
 			/* Add 25 percent extra for HEVC 10bit all intra use case */
-			if (inst->iframe && is_hevc_10bit_decode_session(inst)) {
+			if (p->iframe && p->hevc_10bit) {
 				vsp_cycles += div_u64(vsp_cycles * 25, 100);
 			}
 
-			if (inst->codec == MSM_VIDC_VP9 &&
-					inst->capabilities->cap[STAGE].value ==
-						MSM_VIDC_STAGE_2 &&
-					inst->capabilities->cap[PIPE].value == 4 &&
+			if (p->codec == MSM_VIDC_VP9 &&
+					p->stage == MSM_VIDC_STAGE_2 &&
+					p->pipe == 4 &&
 					bitrate > 90000000)
-				vsp_cycles = msm_vidc_max_freq(inst);
+				vsp_cycles = p->max_freq;
 		}
 	} else {
-		i_vpr_e(inst, "%s: Unknown session type\n", __func__);
-		return msm_vidc_max_freq(inst);
+		d_vpr_e("%s: Unknown session type\n", __func__);
+		return p->max_freq;
 	}
 
 	freq = max(vpp_cycles, vsp_cycles);
 	freq = max(freq, fw_cycles);
 
-	if (inst->codec == MSM_VIDC_AV1 || (inst->iframe && is_hevc_10bit_decode_session(inst)) ||
-			(!is_realtime_session(inst))) {
+	if (p->codec == MSM_VIDC_AV1 || (p->iframe && p->hevc_10bit) ||
+			!p->realtime) {
 		/*
 		 * TURBO is only allowed for:
 		 *     1. AV1 decoding session.
@@ -244,13 +224,93 @@ u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
 		 */
 	} else {
 		/* limit to NOM, index 0 is TURBO, index 1 is NOM clock rate */
-		if (core->dt->allowed_clks_tbl_size >= 2 &&
-		    freq > core->dt->allowed_clks_tbl[1].clock_rate)
-			freq = core->dt->allowed_clks_tbl[1].clock_rate;
+		if (p->nom_freq && freq > p->nom_freq)
+			freq = p->nom_freq;
+	}
+
+	return freq;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_calc_freq_params_iris3);
+
+static void msm_vidc_fill_freq_params_iris3(struct msm_vidc_inst *inst,
+	u32 data_size, struct msm_vidc_freq_params *p)
+{
+	struct msm_vidc_inst_capability *capability = inst->capabilities;
+	struct allowed_clock_rates_table *allowed_clks_tbl;
+	struct v4l2_format *out_f = &inst->fmts[OUTPUT_PORT];
+	struct msm_vidc_core *core = inst->core;
+
+	/* zero the whole struct, the memo compares it with memcmp */
+	memset(p, 0, sizeof(*p));
+
+	allowed_clks_tbl = core->dt->allowed_clks_tbl;
+	p->max_freq = allowed_clks_tbl[0].clock_rate;
+	if (core->dt->allowed_clks_tbl_size >= 2)
+		p->nom_freq = allowed_clks_tbl[1].clock_rate;
+
+	p->domain = inst->domain;
+	p->codec = inst->codec;
+	p->width = out_f->fmt.pix_mp.width;
+	p->height = out_f->fmt.pix_mp.height;
+	p->mbpf = msm_vidc_get_mbs_per_frame(inst);
+	p->fps = inst->max_rate;
+	p->data_size = data_size;
+	p->mb_cycles_fw = capability->cap[MB_CYCLES_FW].value;
+	p->mb_cycles_fw_vpp = capability->cap[MB_CYCLES_FW_VPP].value;
+	p->mb_cycles_vpp = inst->domain == MSM_VIDC_ENCODER &&
+		is_low_power_session(inst) ?
+		capability->cap[MB_CYCLES_LP].value :
+		capability->cap[MB_CYCLES_VPP].value;
+	p->mb_cycles_vsp = capability->cap[MB_CYCLES_VSP].value;
+	p->pipe = capability->cap[PIPE].value;
+	p->stage = capability->cap[STAGE].value;
+	p->b_frame = capability->cap[B_FRAME].value;
+	p->bit_rate = capability->cap[BIT_RATE].value;
+	p->frame_rate = capability->cap[FRAME_RATE].value >> 16;
+	p->operating_rate = capability->cap[OPERATING_RATE].value >> 16;
+	p->entropy_mode = capability->cap[ENTROPY_MODE].value;
+	p->super_block = capability->cap[SUPER_BLOCK].value;
+	p->preprocess = capability->cap[REQUEST_PREPROCESS].value;
+	p->has_bframe = inst->has_bframe;
+	p->iframe = inst->iframe;
+	p->hevc_10bit = is_hevc_10bit_decode_session(inst);
+	p->realtime = is_realtime_session(inst);
+}
+
+u64 msm_vidc_calc_freq_iris3(struct msm_vidc_inst *inst, u32 data_size)
+{
+	u64 freq = 0;
+	struct msm_vidc_core* core;
+	struct msm_vidc_power *power;
+	struct msm_vidc_freq_params params;
+
+	if (!inst || !inst->core || !inst->capabilities) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return freq;
+	}
+
+	core = inst->core;
+	if (!core->dt || !core->dt->allowed_clks_tbl) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return freq;
+	}
+	power = &inst->power;
+
+	msm_vidc_fill_freq_params_iris3(inst, data_size, &params);
+
+	/* reuse the previous result if none of the model inputs changed */
+	if (power->freq_memo_valid &&
+		!memcmp(&params, &power->freq_memo, sizeof(params))) {
+		freq = power->freq_memo_result;
+	} else {
+		freq = msm_vidc_calc_freq_params_iris3(&params);
+		memcpy(&power->freq_memo, &params, sizeof(params));
+		power->freq_memo_result = freq;
+		power->freq_memo_valid = true;
 	}
 
 	i_vpr_p(inst, "%s: filled len %d, required freq %llu, fps %u, mbpf %u\n",
-		__func__, data_size, freq, fps, mbpf);
+		__func__, data_size, freq, params.fps, params.mbpf);
 
 	return freq;
 }
@@ -782,10 +842,19 @@ static u64 __calculate_encoder(struct vidc_bus_vote_data *d)
 	return ret;
 }
 
-static u64 __calculate(struct msm_vidc_inst* inst, struct vidc_bus_vote_data *d)
+/*
+ * Bandwidth model: fills calc_bw_ddr and calc_bw_llcc from the vote data
+ * alone, so it can run on vote data built outside of a session.
+ */
+u64 msm_vidc_calc_bw_params_iris3(struct vidc_bus_vote_data *d)
 {
 	u64 value = 0;
 
+	if (!d) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return value;
+	}
+
 	switch (d->domain) {
 	case MSM_VIDC_ENCODER:
 		value = __calculate_encoder(d);
@@ -794,11 +863,12 @@ static u64 __calculate(struct msm_vidc_inst* inst, struct vidc_bus_vote_data *d)
 		value = __calculate_decoder(d);
 		break;
 	default:
-		i_vpr_e(inst, "%s: Unknown Domain %#x", __func__, d->domain);
+		d_vpr_e("%s: Unknown Domain %#x", __func__, d->domain);
 	}
 
 	return value;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_calc_bw_params_iris3);
 
 int msm_vidc_calc_bw_iris3(struct msm_vidc_inst *inst,
 		struct vidc_bus_vote_data *vidc_data)
@@ -808,7 +878,7 @@ int msm_vidc_calc_bw_iris3(struct msm_vidc_inst *inst,
 	if (!vidc_data)
 		return value;
 
-	value = __calculate(inst, vidc_data);
+	value = msm_vidc_calc_bw_params_iris3(vidc_data);
 
 	return value;
 }
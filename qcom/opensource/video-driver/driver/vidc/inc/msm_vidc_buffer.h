@@ -33,5 +33,15 @@ u32 msm_vidc_encoder_input_meta_size(struct msm_vidc_inst *inst);
 u32 msm_vidc_encoder_output_meta_size(struct msm_vidc_inst *inst);
 u32 msm_vidc_enc_delivery_mode_based_output_buf_size(struct msm_vidc_inst *inst,
 	u32 frame_size);
+bool msm_vidc_buffer_size_cache_get(struct msm_vidc_buffer_size_cache *cache,
+	const struct msm_vidc_buffer_size_key *key,
+	enum msm_vidc_buffer_type type, u32 *size);
+void msm_vidc_buffer_size_cache_put(struct msm_vidc_buffer_size_cache *cache,
+	enum msm_vidc_buffer_type type, u32 size);
+bool msm_vidc_buffer_count_cache_get(struct msm_vidc_buffer_size_cache *cache,
+	const struct msm_vidc_buffer_size_key *key,
+	enum msm_vidc_buffer_type type, u32 *count);
+void msm_vidc_buffer_count_cache_put(struct msm_vidc_buffer_size_cache *cache,
+	enum msm_vidc_buffer_type type, u32 count);
 
 #endif // __H_MSM_VIDC_BUFFER_H__
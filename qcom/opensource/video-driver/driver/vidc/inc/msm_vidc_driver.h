@@ -509,6 +509,12 @@ int msm_vidc_get_delayed_unmap(struct msm_vidc_inst *inst,
 	struct msm_vidc_map *map);
 int msm_vidc_put_delayed_unmap(struct msm_vidc_inst *inst,
 	struct msm_vidc_map *map);
+int msm_vidc_unmap_stale_mappings(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type);
+int msm_vidc_memory_unmap_completely(struct msm_vidc_inst *inst,
+	struct msm_vidc_map *map);
+struct msm_vidc_map *msm_vidc_find_map(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type, struct dma_buf *dmabuf);
 void msm_vidc_update_stats(struct msm_vidc_inst *inst,
 	struct msm_vidc_buffer *buf, enum msm_vidc_debugfs_event etype);
 void msm_vidc_stats_handler(struct work_struct *work);
@@ -150,6 +150,8 @@ struct msm_vidc_inst {
 	struct msm_vidc_subscription_params       subcr_params[MAX_PORT];
 	struct msm_vidc_hfi_frame_info     hfi_frame_info;
 	struct msm_vidc_decode_batch       decode_batch;
+	struct msm_vidc_hfi_batch          hfi_batch;
+	struct msm_vidc_buffer_size_cache  buf_size_cache;
 	struct msm_vidc_decode_vpp_delay   decode_vpp_delay;
 	struct msm_vidc_session_idle       session_idle;
 	struct delayed_work                stats_work;
@@ -157,7 +159,8 @@ struct msm_vidc_inst {
 	struct msm_vidc_stability          stability;
 	struct workqueue_struct           *workq;
 	struct list_head                   enc_input_crs;
-	struct list_head                   dmabuf_tracker; /* list of struct msm_memory_dmabuf */
+	DECLARE_HASHTABLE(dmabuf_tracker, MSM_VIDC_DMABUF_HASH_BITS); /* struct msm_memory_dmabuf */
+	DECLARE_HASHTABLE(map_tracker, MSM_VIDC_DMABUF_HASH_BITS); /* external struct msm_vidc_map */
 	struct list_head                   input_timer_list; /* list of struct msm_vidc_input_timer */
 	struct list_head                   caps_list;
 	struct list_head                   children_list; /* struct msm_vidc_inst_cap_entry */
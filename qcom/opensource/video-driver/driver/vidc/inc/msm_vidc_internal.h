@@ -8,6 +8,7 @@
 
 #include <linux/version.h>
 #include <linux/bits.h>
+#include <linux/export.h>
 #include <linux/workqueue.h>
 #include <linux/spinlock.h>
 #include <linux/sync_file.h>
@@ -21,6 +22,13 @@
 #include <media/videobuf2-core.h>
 #include <media/videobuf2-v4l2.h>
 
+/* makes a symbol available to the KUnit modules in driver/vidc/test */
+#if defined(CONFIG_MSM_VIDC_KUNIT_TEST)
+#define MSM_VIDC_EXPORT_FOR_KUNIT(sym) EXPORT_SYMBOL(sym)
+#else
+#define MSM_VIDC_EXPORT_FOR_KUNIT(sym)
+#endif
+
 #define MAX_NAME_LENGTH   128
 #define VENUS_VERSION_LENGTH 128
 #define MAX_MATRIX_COEFFS 9
@@ -70,6 +78,8 @@
 #define INVALID_CLIENT_ID                    -1
 
 #define DCVS_WINDOW 16
+#define DCVS_HISTORY_MIN_SAMPLES 4
+#define DCVS_HISTORY_IDLE_RESET 8
 #define ENC_FPS_WINDOW 3
 #define DEC_FPS_WINDOW 10
 #define INPUT_TIMER_LIST_SIZE 30
@@ -134,6 +144,8 @@
 #define FW_UNLOAD_DELAY_VALUE         (SW_PC_DELAY_VALUE + 1500)
 
 #define MAX_MAP_OUTPUT_COUNT 64
+#define MAX_MAP_CACHE_COUNT 32
+#define MAX_MAP_CACHE_SIZE (256 * 1024 * 1024)
 #define MAX_FENCE_COUNT 10
 #define MAX_DPB_COUNT 32
  /*
@@ -636,6 +648,11 @@ enum msm_vidc_dcvs_flags {
 	MSM_VIDC_DCVS_DECR               = BIT(1),
 };
 
+enum msm_vidc_dcvs_governor {
+	MSM_VIDC_DCVS_GOV_REACTIVE       = 0,
+	MSM_VIDC_DCVS_GOV_PREDICTIVE     = 1,
+};
+
 enum msm_vidc_clock_properties {
 	CLOCK_PROP_HAS_SCALING           = BIT(0),
 	CLOCK_PROP_HAS_MEM_RETENTION     = BIT(1),
@@ -799,6 +816,49 @@ struct msm_vidc_decode_batch {
 	struct delayed_work    work;
 };
 
+struct msm_vidc_hfi_batch {
+	bool                   active;
+	u32                    pending; /* packets written since last doorbell */
+	u32                    packets;
+	u32                    doorbells;
+};
+
+/*
+ * Inputs that decide the decoder buffer sizes and counts. Kept as plain
+ * u32 fields so that two keys can be compared with memcmp().
+ */
+struct msm_vidc_buffer_size_key {
+	u32                    codec;
+	u32                    in_width;
+	u32                    in_height;
+	u32                    out_width;
+	u32                    out_height;
+	u32                    out_pixelformat;
+	u32                    pix_fmt;
+	u32                    out_min_count;
+	u32                    vpp_delay;
+	u32                    num_vpp_pipes;
+	u32                    coded_frames;
+	u32                    drap;
+	u32                    film_grain;
+	u32                    dolby_rpu;
+	u32                    thumbnail;
+	u32                    slice_mode;
+	u32                    slice_max_mb;
+	u32                    delivery_mode;
+};
+
+struct msm_vidc_buffer_size_cache {
+	struct msm_vidc_buffer_size_key key;
+	u32                    valid; /* bitmask of cached buffer sizes */
+	u32                    count_valid; /* bitmask of cached min counts */
+	u32                    size[MSM_VIDC_BUF_PARTIAL_DATA + 1];
+	u32                    min_count[MSM_VIDC_BUF_PARTIAL_DATA + 1];
+	u32                    num_comv; /* NUM_COMV set along with COMV size */
+	u32                    hits;
+	u32                    misses;
+};
+
 enum msm_vidc_power_mode {
 	VIDC_POWER_NORMAL = 0,
 	VIDC_POWER_LOW,
@@ -828,6 +888,55 @@ struct vidc_bus_vote_data {
 	bool vpss_preprocessing_enabled;
 };
 
+/*
+ * Inputs of the clock frequency model, filled from the session by the
+ * variant so that the model itself does not touch the session. Kept as
+ * plain words so that two parameter sets compare with memcmp.
+ */
+struct msm_vidc_freq_params {
+	u64                    max_freq;
+	u64                    nom_freq;
+	u32                    domain;
+	u32                    codec;
+	u32                    width;
+	u32                    height;
+	u32                    mbpf;
+	u32                    fps;
+	u32                    data_size;
+	u32                    mb_cycles_fw;
+	u32                    mb_cycles_fw_vpp;
+	u32                    mb_cycles_vpp;
+	u32                    mb_cycles_vsp;
+	u32                    pipe;
+	u32                    stage;
+	u32                    b_frame;
+	u32                    bit_rate;
+	u32                    frame_rate;
+	u32                    operating_rate;
+	u32                    entropy_mode;
+	u32                    super_block;
+	u32                    preprocess;
+	u32                    has_bframe;
+	u32                    iframe;
+	u32                    hevc_10bit;
+	u32                    realtime;
+};
+
+/*
+ * Per session load history used by the predictive dcvs governor.
+ * Averages and trends are kept in Q4 fixed point.
+ */
+struct msm_vidc_dcvs_history {
+	u64                    last_fbd_ns;
+	u32                    samples;
+	u32                    idle;
+	u32                    proc_ewma_us;
+	s32                    proc_trend_us;
+	u32                    occ_samples;
+	u32                    occ_ewma;
+	s32                    occ_trend;
+};
+
 struct msm_vidc_power {
 	enum msm_vidc_power_mode power_mode;
 	u32                    buffer_counter;
@@ -843,6 +952,12 @@ struct msm_vidc_power {
 	u32                    dcvs_flags;
 	u32                    fw_cr;
 	u32                    fw_cf;
+	bool                   bw_memo_valid;
+	struct vidc_bus_vote_data bw_memo; /* vote data of last bw calculation */
+	bool                   freq_memo_valid;
+	u64                    freq_memo_result;
+	struct msm_vidc_freq_params freq_memo; /* inputs of last freq calculation */
+	struct msm_vidc_dcvs_history dcvs_hist;
 };
 
 struct msm_vidc_fence_context {
@@ -880,6 +995,7 @@ struct msm_vidc_allocations {
 
 struct msm_vidc_map {
 	struct list_head            list;
+	struct hlist_node           node; /* entry in inst->map_tracker */
 	enum msm_vidc_buffer_type   type;
 	enum msm_vidc_buffer_region region;
 	struct dma_buf             *dmabuf;
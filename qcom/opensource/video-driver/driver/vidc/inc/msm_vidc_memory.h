@@ -6,15 +6,17 @@
 #ifndef _MSM_VIDC_MEMORY_H_
 #define _MSM_VIDC_MEMORY_H_
 
+#include <linux/hashtable.h>
 #include "msm_vidc_internal.h"
 
 struct msm_vidc_core;
 struct msm_vidc_inst;
 
 #define MSM_MEM_POOL_PACKET_SIZE 1024
+#define MSM_VIDC_DMABUF_HASH_BITS 6
 
 struct msm_memory_dmabuf {
-	struct list_head       list;
+	struct hlist_node      node;
 	struct dma_buf        *dmabuf;
 	u32                    refcount;
 };
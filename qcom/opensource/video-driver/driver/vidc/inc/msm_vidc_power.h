@@ -254,4 +254,14 @@ int msm_vidc_get_inst_load(struct msm_vidc_inst *inst);
 int msm_vidc_get_mbps(struct msm_vidc_inst *inst);
 int msm_vidc_scale_power(struct msm_vidc_inst *inst, bool scale_buses);
 void msm_vidc_power_data_reset(struct msm_vidc_inst *inst);
+void msm_vidc_dcvs_record_frame(struct msm_vidc_inst *inst);
+u32 msm_vidc_dcvs_forecast(u32 ewma, s32 trend);
+void msm_vidc_dcvs_history_add(struct msm_vidc_dcvs_history *hist,
+	u64 now_ns, bool backlog);
+u64 msm_vidc_dcvs_predict_freq(u64 calc_freq, u64 clk_share, u32 proc_us,
+	u32 deadline_us, u64 max_freq);
+void msm_vidc_dcvs_reactive(struct msm_vidc_power *power, bool decode,
+	int bufs_with_fw);
+void msm_vidc_dcvs_predictive(struct msm_vidc_power *power, bool decode,
+	int bufs_with_fw, u32 max_rate, u64 clk_share, u64 max_freq);
 #endif
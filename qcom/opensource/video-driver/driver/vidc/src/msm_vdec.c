@@ -2092,6 +2092,7 @@ static int msm_vidc_unmap_excessive_mappings(struct msm_vidc_inst *inst)
 			if (rc)
 				return rc;
 			if (!map->refcount) {
+				hash_del(&map->node);
 				list_del_init(&map->list);
 				msm_vidc_memory_put_dmabuf(inst, map->dmabuf);
 				msm_memory_pool_free(inst, map);
@@ -2135,6 +2136,11 @@ int msm_vdec_qbuf(struct msm_vidc_inst *inst, struct vb2_buffer *vb2)
 		rc = msm_vidc_unmap_excessive_mappings(inst);
 		if (rc)
 			return rc;
+	} else {
+		rc = msm_vidc_unmap_stale_mappings(inst,
+			v4l2_type_to_driver(vb2->type, __func__));
+		if (rc)
+			return rc;
 	}
 
 	return rc;
@@ -903,6 +903,11 @@ int msm_venc_qbuf(struct msm_vidc_inst *inst, struct vb2_buffer *vb2)
 	if (rc)
 		return rc;
 
+	rc = msm_vidc_unmap_stale_mappings(inst,
+		v4l2_type_to_driver(vb2->type, __func__));
+	if (rc)
+		return rc;
+
 	return rc;
 }
 
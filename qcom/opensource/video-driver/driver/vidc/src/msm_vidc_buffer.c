@@ -480,3 +480,80 @@ u32 msm_vidc_encoder_output_meta_size(struct msm_vidc_inst *inst)
 {
 	return MSM_VIDC_METADATA_SIZE;
 }
+
+/*
+ * Per session cache of buffer sizes and min counts. The variant fills
+ * the key with every input its size and count helpers read; any change
+ * of the key drops everything cached for the previous one.
+ */
+static void msm_vidc_buffer_size_cache_check_key(
+	struct msm_vidc_buffer_size_cache *cache,
+	const struct msm_vidc_buffer_size_key *key)
+{
+	if (!memcmp(&cache->key, key, sizeof(*key)))
+		return;
+
+	cache->key = *key;
+	cache->valid = 0;
+	cache->count_valid = 0;
+}
+
+bool msm_vidc_buffer_size_cache_get(struct msm_vidc_buffer_size_cache *cache,
+	const struct msm_vidc_buffer_size_key *key,
+	enum msm_vidc_buffer_type type, u32 *size)
+{
+	if (!cache || !key || !size || type > MSM_VIDC_BUF_PARTIAL_DATA)
+		return false;
+
+	msm_vidc_buffer_size_cache_check_key(cache, key);
+	if (!(cache->valid & BIT(type))) {
+		cache->misses++;
+		return false;
+	}
+
+	cache->hits++;
+	*size = cache->size[type];
+	return true;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_buffer_size_cache_get);
+
+void msm_vidc_buffer_size_cache_put(struct msm_vidc_buffer_size_cache *cache,
+	enum msm_vidc_buffer_type type, u32 size)
+{
+	if (!cache || type > MSM_VIDC_BUF_PARTIAL_DATA)
+		return;
+
+	cache->size[type] = size;
+	cache->valid |= BIT(type);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_buffer_size_cache_put);
+
+bool msm_vidc_buffer_count_cache_get(struct msm_vidc_buffer_size_cache *cache,
+	const struct msm_vidc_buffer_size_key *key,
+	enum msm_vidc_buffer_type type, u32 *count)
+{
+	if (!cache || !key || !count || type > MSM_VIDC_BUF_PARTIAL_DATA)
+		return false;
+
+	msm_vidc_buffer_size_cache_check_key(cache, key);
+	if (!(cache->count_valid & BIT(type))) {
+		cache->misses++;
+		return false;
+	}
+
+	cache->hits++;
+	*count = cache->min_count[type];
+	return true;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_buffer_count_cache_get);
+
+void msm_vidc_buffer_count_cache_put(struct msm_vidc_buffer_size_cache *cache,
+	enum msm_vidc_buffer_type type, u32 count)
+{
+	if (!cache || type > MSM_VIDC_BUF_PARTIAL_DATA)
+		return;
+
+	cache->min_count[type] = count;
+	cache->count_valid |= BIT(type);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_buffer_count_cache_put);
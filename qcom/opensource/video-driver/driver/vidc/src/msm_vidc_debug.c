@@ -132,6 +132,7 @@ bool msm_vidc_syscache_disable = !true;
 EXPORT_SYMBOL(msm_vidc_syscache_disable);
 
 int msm_vidc_clock_voting = !1;
+int msm_vidc_dcvs_governor = MSM_VIDC_DCVS_GOV_REACTIVE;
 int msm_vidc_ddr_bw = !1;
 int msm_vidc_llc_bw = !1;
 
@@ -396,6 +397,8 @@ struct dentry* msm_vidc_debugfs_init_drv(void)
 
 	debugfs_create_u32("core_clock_voting", 0644, dir,
 			&msm_vidc_clock_voting);
+	debugfs_create_u32("dcvs_governor", 0644, dir,
+			&msm_vidc_dcvs_governor);
 	debugfs_create_u32("ddr_bw_kbps", 0644, dir,
 			&msm_vidc_ddr_bw);
 	debugfs_create_u32("llc_bw_kbps", 0644, dir,
@@ -547,6 +550,8 @@ static ssize_t inst_info_read(struct file *file, char __user *buf,
 		inst->debug_count.ftb);
 	cur += write_str(cur, end - cur, "FBD Count: %d\n",
 		inst->debug_count.fbd);
+	cur += write_str(cur, end - cur, "Buffer size cache hits: %u misses: %u\n",
+		inst->buf_size_cache.hits, inst->buf_size_cache.misses);
 
 	publish_unreleased_reference(inst, &cur, end);
 	len = simple_read_from_buffer(buf, count, ppos,
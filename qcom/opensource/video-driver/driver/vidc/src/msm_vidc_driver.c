@@ -2685,6 +2685,7 @@ int msm_vidc_memory_unmap_completely(struct msm_vidc_inst *inst,
 			break;
 		if (!map->refcount) {
 			msm_vidc_memory_put_dmabuf(inst, map->dmabuf);
+			hash_del(&map->node);
 			list_del(&map->list);
 			msm_memory_pool_free(inst, map);
 			break;
@@ -2692,6 +2693,7 @@ int msm_vidc_memory_unmap_completely(struct msm_vidc_inst *inst,
 	}
 	return rc;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_memory_unmap_completely);
 
 int msm_vidc_set_auto_framerate(struct msm_vidc_inst *inst, u64 timestamp)
 {
@@ -3187,31 +3189,121 @@ int msm_vidc_unmap_buffers(struct msm_vidc_inst *inst,
 	return rc;
 }
 
-int msm_vidc_unmap_driver_buf(struct msm_vidc_inst *inst,
-	struct msm_vidc_buffer *buf)
+struct msm_vidc_map *msm_vidc_find_map(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type, struct dma_buf *dmabuf)
+{
+	struct msm_vidc_map *map;
+
+	hash_for_each_possible(inst->map_tracker, map, node,
+			(unsigned long)dmabuf) {
+		if (map->dmabuf == dmabuf && map->type == type)
+			return map;
+	}
+
+	return NULL;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_find_map);
+
+/*
+ * Client buffers whose iommu mapping is kept across qbuf/dqbuf through an
+ * extra (delayed unmap) reference, so that requeueing the same dma_buf
+ * does not map it again. Decoder output mappings are evicted by
+ * msm_vidc_unmap_excessive_mappings(), the others by
+ * msm_vidc_unmap_stale_mappings(), and all of them on streamoff and
+ * session close.
+ */
+static bool msm_vidc_is_map_cached(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type)
+{
+	if (is_decode_session(inst))
+		return is_output_buffer(type) || is_input_buffer(type) ||
+			is_input_meta_buffer(type);
+
+	if (is_encode_session(inst))
+		return is_input_buffer(type) || is_output_buffer(type) ||
+			is_input_meta_buffer(type) || is_output_meta_buffer(type);
+
+	return false;
+}
+
+/*
+ * A cached mapping also holds a dma_buf reference, so a buffer the client
+ * has already freed stays allocated until it is evicted here. Mappings
+ * held only by the cache are released in the order they were created
+ * while there are more than MAX_MAP_CACHE_COUNT of them or they pin more
+ * than MAX_MAP_CACHE_SIZE bytes, i.e. about 20 4K NV12 encoder inputs.
+ */
+int msm_vidc_unmap_stale_mappings(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type)
 {
 	int rc = 0;
 	struct msm_vidc_mappings *mappings;
-	struct msm_vidc_map *map = NULL;
-	bool found = false;
+	struct msm_vidc_map *map, *temp;
+	u32 stale_count = 0;
+	u64 stale_size = 0;
 
-	if (!inst || !buf) {
+	if (!inst) {
 		d_vpr_e("%s: invalid params\n", __func__);
 		return -EINVAL;
 	}
 
-	mappings = msm_vidc_get_mappings(inst, buf->type, __func__);
+	if (!msm_vidc_is_map_cached(inst, type))
+		return 0;
+
+	mappings = msm_vidc_get_mappings(inst, type, __func__);
 	if (!mappings)
 		return -EINVAL;
 
-	/* sanity check to see if it was not removed */
+	/* only the cache reference left: buffer is not with driver/fw */
 	list_for_each_entry(map, &mappings->list, list) {
-		if (map->dmabuf == buf->dmabuf) {
-			found = true;
+		if (map->skip_delayed_unmap && map->refcount == 1) {
+			stale_count++;
+			stale_size += map->dmabuf->size;
+		}
+	}
+
+	list_for_each_entry_safe(map, temp, &mappings->list, list) {
+		if (stale_count <= MAX_MAP_CACHE_COUNT &&
+			stale_size <= MAX_MAP_CACHE_SIZE)
 			break;
+		if (!map->skip_delayed_unmap || map->refcount != 1)
+			continue;
+
+		i_vpr_l(inst,
+			"%s: type %11s, device_addr %#x, refcount %d, region %d\n",
+			__func__, buf_name(map->type), map->device_addr,
+			map->refcount, map->region);
+		stale_count--;
+		stale_size -= map->dmabuf->size;
+		rc = msm_vidc_put_delayed_unmap(inst, map);
+		if (rc)
+			return rc;
+		if (!map->refcount) {
+			hash_del(&map->node);
+			list_del_init(&map->list);
+			msm_vidc_memory_put_dmabuf(inst, map->dmabuf);
+			msm_memory_pool_free(inst, map);
 		}
 	}
-	if (!found) {
+
+	return rc;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_unmap_stale_mappings);
+
+int msm_vidc_unmap_driver_buf(struct msm_vidc_inst *inst,
+	struct msm_vidc_buffer *buf)
+{
+	int rc = 0;
+	struct msm_vidc_map *map = NULL;
+
+	if (!inst || !buf) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return -EINVAL;
+	}
+
+	/* sanity check to see if it was not removed */
+	map = msm_vidc_find_map(inst, buf->type, buf->dmabuf);
+	if (!map) {
 		print_vidc_buffer(VIDC_ERR, "err ", "no buf in mappings", inst, buf);
 		return -EINVAL;
 	}
@@ -3225,12 +3317,14 @@ int msm_vidc_unmap_driver_buf(struct msm_vidc_inst *inst,
 	/* finally delete if refcount is zero */
 	if (!map->refcount) {
 		msm_vidc_memory_put_dmabuf(inst, map->dmabuf);
+		hash_del(&map->node);
 		list_del(&map->list);
 		msm_memory_pool_free(inst, map);
 	}
 
 	return rc;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_unmap_driver_buf);
 
 int msm_vidc_map_driver_buf(struct msm_vidc_inst *inst,
 	struct msm_vidc_buffer *buf)
@@ -3253,13 +3347,10 @@ int msm_vidc_map_driver_buf(struct msm_vidc_inst *inst,
 	 * new buffer: map twice for delayed unmap feature sake
 	 * existing buffer: map once
 	 */
-	list_for_each_entry(map, &mappings->list, list) {
-		if (map->dmabuf == buf->dmabuf) {
-			found = true;
-			break;
-		}
-	}
-	if (!found) {
+	map = msm_vidc_find_map(inst, buf->type, buf->dmabuf);
+	if (map) {
+		found = true;
+	} else {
 		/* new buffer case */
 		map = msm_memory_pool_alloc(inst, MSM_MEM_POOL_MAP);
 		if (!map) {
@@ -3274,9 +3365,11 @@ int msm_vidc_map_driver_buf(struct msm_vidc_inst *inst,
 			rc = -EINVAL;
 			goto error;
 		}
+		hash_add(inst->map_tracker, &map->node,
+			(unsigned long)map->dmabuf);
 		map->region = msm_vidc_get_buffer_region(inst, buf->type, __func__);
-		/* delayed unmap feature needed for decoder output buffers */
-		if (is_decode_session(inst) && is_output_buffer(buf->type)) {
+		/* keep the mapping across qbuf/dqbuf for cached buffer types */
+		if (msm_vidc_is_map_cached(inst, buf->type)) {
 			rc = msm_vidc_get_delayed_unmap(inst, map);
 			if (rc)
 				goto error;
@@ -3291,14 +3384,16 @@ int msm_vidc_map_driver_buf(struct msm_vidc_inst *inst,
 	return 0;
 error:
 	if (!found) {
-		if (is_decode_session(inst) && is_output_buffer(buf->type))
+		if (map->skip_delayed_unmap)
 			msm_vidc_put_delayed_unmap(inst, map);
 		msm_vidc_memory_put_dmabuf(inst, map->dmabuf);
+		hash_del(&map->node);
 		list_del_init(&map->list);
 		msm_memory_pool_free(inst, map);
 	}
 	return rc;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_map_driver_buf);
 
 int msm_vidc_put_driver_buf(struct msm_vidc_inst *inst,
 	struct msm_vidc_buffer *buf)
@@ -3922,15 +4017,17 @@ int msm_vidc_queue_deferred_buffers(struct msm_vidc_inst *inst, enum msm_vidc_bu
 
 	msm_vidc_scale_power(inst, true);
 
+	venus_hfi_queue_buffer_batch_begin(inst);
 	list_for_each_entry(buf, &buffers->list, list) {
 		if (!(buf->attr & MSM_VIDC_ATTR_DEFERRED))
 			continue;
 		rc = msm_vidc_queue_buffer(inst, buf);
 		if (rc)
-			return rc;
+			break;
 	}
+	venus_hfi_queue_buffer_batch_end(inst);
 
-	return 0;
+	return rc;
 }
 
 int msm_vidc_queue_buffer_single(struct msm_vidc_inst *inst, struct vb2_buffer *vb2)
@@ -4239,6 +4336,7 @@ int msm_vidc_queue_internal_buffers(struct msm_vidc_inst *inst,
 		return 0;
 	}
 
+	venus_hfi_queue_buffer_batch_begin(inst);
 	list_for_each_entry_safe(buffer, dummy, &buffers->list, list) {
 		/* do not queue pending release buffers */
 		if (buffer->flags & MSM_VIDC_ATTR_PENDING_RELEASE)
@@ -4248,15 +4346,16 @@ int msm_vidc_queue_internal_buffers(struct msm_vidc_inst *inst,
 			continue;
 		rc = venus_hfi_queue_buffer(inst, buffer, NULL);
 		if (rc)
-			return rc;
+			break;
 		/* mark queued */
 		buffer->attr |= MSM_VIDC_ATTR_QUEUED;
 
 		i_vpr_h(inst, "%s: queue: type: %8s, size: %9u, device_addr %#x\n", __func__,
 			buf_name(buffer->type), buffer->buffer_size, buffer->device_addr);
 	}
+	venus_hfi_queue_buffer_batch_end(inst);
 
-	return 0;
+	return rc;
 }
 
 int msm_vidc_alloc_and_queue_session_internal_buffers(struct msm_vidc_inst *inst,
@@ -5896,7 +5995,8 @@ void msm_vidc_destroy_buffers(struct msm_vidc_inst *inst)
 	struct msm_vidc_buffers *buffers;
 	struct msm_vidc_buffer *buf, *dummy;
 	struct msm_vidc_timestamp *ts, *dummy_ts;
-	struct msm_memory_dmabuf *dbuf, *dummy_dbuf;
+	struct msm_memory_dmabuf *dbuf;
+	struct hlist_node *dummy_node;
 	struct msm_vidc_input_timer *timer, *dummy_timer;
 	struct msm_vidc_buffer_stats *stats, *dummy_stats;
 	struct msm_vidc_inst_cap_entry *entry, *dummy_entry;
@@ -5995,7 +6095,7 @@ void msm_vidc_destroy_buffers(struct msm_vidc_inst *inst)
 		msm_memory_pool_free(inst, stats);
 	}
 
-	list_for_each_entry_safe(dbuf, dummy_dbuf, &inst->dmabuf_tracker, list) {
+	hash_for_each_safe(inst->dmabuf_tracker, i, dummy_node, dbuf, node) {
 		i_vpr_e(inst, "%s: removing dma_buf %#x, refcount %u\n",
 			__func__, dbuf->dmabuf, dbuf->refcount);
 		msm_vidc_memory_put_dmabuf_completely(inst, dbuf);
@@ -83,7 +83,8 @@ struct dma_buf *msm_vidc_memory_get_dmabuf(struct msm_vidc_inst *inst, int fd)
 	}
 
 	/* track dmabuf - inc refcount if already present */
-	list_for_each_entry(buf, &inst->dmabuf_tracker, list) {
+	hash_for_each_possible(inst->dmabuf_tracker, buf, node,
+			(unsigned long)dmabuf) {
 		if (buf->dmabuf == dmabuf) {
 			buf->refcount++;
 			found = true;
@@ -106,13 +107,13 @@ struct dma_buf *msm_vidc_memory_get_dmabuf(struct msm_vidc_inst *inst, int fd)
 	/* hold dmabuf strong ref in tracker */
 	buf->dmabuf = dmabuf;
 	buf->refcount = 1;
-	INIT_LIST_HEAD(&buf->list);
 
 	/* add new dmabuf entry to tracker */
-	list_add_tail(&buf->list, &inst->dmabuf_tracker);
+	hash_add(inst->dmabuf_tracker, &buf->node, (unsigned long)dmabuf);
 
 	return dmabuf;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_memory_get_dmabuf);
 
 void msm_vidc_memory_put_dmabuf(struct msm_vidc_inst *inst, struct dma_buf *dmabuf)
 {
@@ -125,7 +126,8 @@ void msm_vidc_memory_put_dmabuf(struct msm_vidc_inst *inst, struct dma_buf *dmab
 	}
 
 	/* track dmabuf - dec refcount if already present */
-	list_for_each_entry(buf, &inst->dmabuf_tracker, list) {
+	hash_for_each_possible(inst->dmabuf_tracker, buf, node,
+			(unsigned long)dmabuf) {
 		if (buf->dmabuf == dmabuf) {
 			buf->refcount--;
 			found = true;
@@ -142,7 +144,7 @@ void msm_vidc_memory_put_dmabuf(struct msm_vidc_inst *inst, struct dma_buf *dmab
 		return;
 
 	/* remove dmabuf entry from tracker */
-	list_del(&buf->list);
+	hash_del(&buf->node);
 
 	/* release dmabuf strong ref from tracker */
 	dma_buf_put(buf->dmabuf);
@@ -150,6 +152,7 @@ void msm_vidc_memory_put_dmabuf(struct msm_vidc_inst *inst, struct dma_buf *dmab
 	/* put tracker instance back to pool */
 	msm_memory_pool_free(inst, buf);
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_memory_put_dmabuf);
 
 void msm_vidc_memory_put_dmabuf_completely(struct msm_vidc_inst *inst,
 	struct msm_memory_dmabuf *buf)
@@ -163,7 +166,7 @@ void msm_vidc_memory_put_dmabuf_completely(struct msm_vidc_inst *inst,
 		buf->refcount--;
 		if (!buf->refcount) {
 			/* remove dmabuf entry from tracker */
-			list_del(&buf->list);
+			hash_del(&buf->node);
 
 			/* release dmabuf strong ref from tracker */
 			dma_buf_put(buf->dmabuf);
@@ -174,6 +177,7 @@ void msm_vidc_memory_put_dmabuf_completely(struct msm_vidc_inst *inst,
 		}
 	}
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_memory_put_dmabuf_completely);
 
 static bool is_non_secure_buffer(struct dma_buf *dmabuf)
 {
@@ -602,6 +606,7 @@ void *msm_memory_pool_alloc(struct msm_vidc_inst *inst, enum msm_memory_pool_typ
 
 	return hdr->buf;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_memory_pool_alloc);
 
 void msm_memory_pool_free(struct msm_vidc_inst *inst, void *vidc_buf)
 {
@@ -691,6 +696,7 @@ void msm_memory_pools_deinit(struct msm_vidc_inst *inst)
 	for (i = 0; i < MSM_MEM_POOL_MAX; i++)
 		msm_vidc_destroy_pool_buffers(inst, i);
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_memory_pools_deinit);
 
 struct msm_vidc_type_size_name {
 	enum msm_memory_pool_type type;
@@ -739,6 +745,7 @@ int msm_memory_pools_init(struct msm_vidc_inst *inst)
 
 	return 0;
 }
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_memory_pools_init);
 
 /*
 int msm_memory_cache_operations(struct msm_vidc_inst *inst,
@@ -303,7 +303,16 @@ int msm_vidc_scale_buses(struct msm_vidc_inst *inst)
 	vote_data->num_vpp_pipes = core->capabilities[NUM_VPP_PIPE].value;
 	fill_dynamic_stats(inst, vote_data);
 
-	call_session_op(core, calc_bw, inst, vote_data);
+	/*
+	 * bw calculation depends on the vote data only, reuse the previous
+	 * result if none of the inputs changed since then
+	 */
+	if (!power->bw_memo_valid ||
+		memcmp(vote_data, &power->bw_memo, sizeof(*vote_data))) {
+		call_session_op(core, calc_bw, inst, vote_data);
+		memcpy(&power->bw_memo, vote_data, sizeof(*vote_data));
+		power->bw_memo_valid = true;
+	}
 
 	inst->power.ddr_bw = vote_data->calc_bw_ddr;
 	inst->power.sys_cache_bw = vote_data->calc_bw_llcc;
@@ -400,66 +409,151 @@ int msm_vidc_set_clocks(struct msm_vidc_inst* inst)
 	return 0;
 }
 
-static int msm_vidc_apply_dcvs(struct msm_vidc_inst *inst)
+static int msm_vidc_dcvs_bufs_with_fw(struct msm_vidc_inst *inst)
 {
-	int rc = 0;
-	int bufs_with_fw = 0;
-	struct msm_vidc_power *power;
+	if (is_decode_session(inst))
+		return msm_vidc_num_buffers(inst,
+			MSM_VIDC_BUF_OUTPUT, MSM_VIDC_ATTR_QUEUED);
 
-	if (!inst) {
-		d_vpr_e("%s: invalid params %pK\n", __func__, inst);
-		return -EINVAL;
+	return msm_vidc_num_buffers(inst,
+		MSM_VIDC_BUF_INPUT, MSM_VIDC_ATTR_QUEUED);
+}
+
+/*
+ * Update a Q4 exponentially weighted average (alpha 1/4) and a smoothed
+ * per-sample trend (alpha 1/2) with a new sample.
+ */
+static void msm_vidc_dcvs_ewma(u32 *ewma, s32 *trend, u32 sample, bool first)
+{
+	s64 prev = *ewma;
+	s64 curr;
+
+	if (first) {
+		*ewma = sample << 4;
+		*trend = 0;
+		return;
 	}
 
-	/* skip dcvs */
-	if (!inst->power.dcvs_mode)
+	curr = prev + (((s64)sample << 4) - prev) / 4;
+	*trend += (s32)((curr - prev - *trend) / 2);
+	*ewma = (u32)curr;
+}
+
+/* one window ahead forecast: average plus trend, rounded to integer */
+u32 msm_vidc_dcvs_forecast(u32 ewma, s32 trend)
+{
+	s64 val = (s64)ewma + trend;
+
+	if (val < 0)
 		return 0;
 
-	power = &inst->power;
+	return (u32)((val + 8) >> 4);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_dcvs_forecast);
 
-	if (is_decode_session(inst)) {
-		bufs_with_fw = msm_vidc_num_buffers(inst,
-			MSM_VIDC_BUF_OUTPUT, MSM_VIDC_ATTR_QUEUED);
-	} else {
-		bufs_with_fw = msm_vidc_num_buffers(inst,
-			MSM_VIDC_BUF_INPUT, MSM_VIDC_ATTR_QUEUED);
+/*
+ * Add the frame completion at @now_ns to the processing time history.
+ * The spacing to the previous completion is a sample only if firmware
+ * had a @backlog to work on, otherwise it just follows the client
+ * queuing rate. A run of completions without backlog means firmware
+ * keeps up at the current clock, so the history is dropped and rebuilt
+ * the next time it falls behind.
+ */
+void msm_vidc_dcvs_history_add(struct msm_vidc_dcvs_history *hist,
+	u64 now_ns, bool backlog)
+{
+	u64 sample_us;
+
+	if (!backlog) {
+		if (hist->samples && ++hist->idle >= DCVS_HISTORY_IDLE_RESET) {
+			hist->samples = 0;
+			hist->idle = 0;
+		}
+	} else if (hist->last_fbd_ns && now_ns > hist->last_fbd_ns) {
+		sample_us = min_t(u64, div_u64(now_ns - hist->last_fbd_ns,
+			NSEC_PER_USEC), USEC_PER_SEC);
+		msm_vidc_dcvs_ewma(&hist->proc_ewma_us, &hist->proc_trend_us,
+			(u32)sample_us, !hist->samples);
+		hist->samples++;
+		hist->idle = 0;
+	}
+	hist->last_fbd_ns = now_ns;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_dcvs_history_add);
+
+void msm_vidc_dcvs_record_frame(struct msm_vidc_inst *inst)
+{
+	if (!inst) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return;
 	}
 
-	/* +1 as one buffer is going to be queued after the function */
-	bufs_with_fw += 1;
+	if (msm_vidc_dcvs_governor != MSM_VIDC_DCVS_GOV_PREDICTIVE ||
+		!inst->power.dcvs_mode)
+		return;
 
-	/*
-	 * DCVS decides clock level based on below algorithm
-	 *
-	 * Limits :
-	 * min_threshold : Buffers required for reference by FW.
-	 * nom_threshold : Midpoint of Min and Max thresholds
-	 * max_threshold : Min Threshold + DCVS extra buffers, allocated
-	 *				   for smooth flow.
-	 * 1) When buffers outside FW are reaching client's extra buffers,
-	 *    FW is slow and will impact pipeline, Increase clock.
-	 * 2) When pending buffers with FW are less than FW requested,
-	 *    pipeline has cushion to absorb FW slowness, Decrease clocks.
-	 * 3) When DCVS has engaged(Inc or Dec):
-	 *    For decode:
-	 *        - Pending buffers with FW transitions past the nom_threshold,
-	 *        switch to calculated load, this smoothens the clock transitions.
-	 *    For encode:
-	 *        - Always switch to calculated load.
-	 * 4) Otherwise maintain previous Load config.
-	 */
+	msm_vidc_dcvs_history_add(&inst->power.dcvs_hist, ktime_get_ns(),
+		msm_vidc_dcvs_bufs_with_fw(inst) >= inst->power.min_threshold);
+}
+
+/*
+ * Scale the session's share of the core clock, the clock its processing
+ * time was measured at, by the forecast processing time against the frame
+ * deadline, with 1/8 headroom. Sessions add up their min_freq in
+ * msm_vidc_set_clocks(), so the estimate must not be based on the whole
+ * core clock. Never go below the reactive (calc_freq) value.
+ */
+u64 msm_vidc_dcvs_predict_freq(u64 calc_freq, u64 clk_share, u32 proc_us,
+	u32 deadline_us, u64 max_freq)
+{
+	u64 freq;
+
+	if (!clk_share || !proc_us || !deadline_us)
+		return calc_freq;
+
+	freq = div_u64(clk_share * proc_us, deadline_us);
+	freq += freq >> 3;
+	freq = max(freq, calc_freq);
+
+	return min(freq, max_freq);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_dcvs_predict_freq);
+
+/*
+ * DCVS decides clock level based on below algorithm
+ *
+ * Limits :
+ * min_threshold : Buffers required for reference by FW.
+ * nom_threshold : Midpoint of Min and Max thresholds
+ * max_threshold : Min Threshold + DCVS extra buffers, allocated
+ *				   for smooth flow.
+ * 1) When buffers outside FW are reaching client's extra buffers,
+ *    FW is slow and will impact pipeline, Increase clock.
+ * 2) When pending buffers with FW are less than FW requested,
+ *    pipeline has cushion to absorb FW slowness, Decrease clocks.
+ * 3) When DCVS has engaged(Inc or Dec):
+ *    For decode:
+ *        - Pending buffers with FW transitions past the nom_threshold,
+ *        switch to calculated load, this smoothens the clock transitions.
+ *    For encode:
+ *        - Always switch to calculated load.
+ * 4) Otherwise maintain previous Load config.
+ */
+void msm_vidc_dcvs_reactive(struct msm_vidc_power *power, bool decode,
+	int bufs_with_fw)
+{
 	if (bufs_with_fw >= power->max_threshold) {
 		power->dcvs_flags = MSM_VIDC_DCVS_INCR;
-		goto exit;
+		return;
 	} else if (bufs_with_fw < power->min_threshold) {
 		power->dcvs_flags = MSM_VIDC_DCVS_DECR;
-		goto exit;
+		return;
 	}
 
 	/* encoder: dcvs window handling */
-	if (is_encode_session(inst)) {
+	if (!decode) {
 		power->dcvs_flags = 0;
-		goto exit;
+		return;
 	}
 
 	/* decoder: dcvs window handling */
@@ -467,8 +561,115 @@ static int msm_vidc_apply_dcvs(struct msm_vidc_inst *inst)
 		(power->dcvs_flags & MSM_VIDC_DCVS_INCR && bufs_with_fw <= power->nom_threshold)) {
 		power->dcvs_flags = 0;
 	}
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_dcvs_reactive);
+
+/*
+ * Same thresholds and decoder hysteresis as the reactive governor, but
+ * applied to the forecast occupancy so that a growing backlog bumps the
+ * clock before the client runs out of buffers and a short dip does not
+ * drop it. Once the forecast settles inside the window, the session's
+ * calculated clock in power->min_freq is raised to what the forecast
+ * processing time needs at @clk_share to meet the frame deadline.
+ */
+void msm_vidc_dcvs_predictive(struct msm_vidc_power *power, bool decode,
+	int bufs_with_fw, u32 max_rate, u64 clk_share, u64 max_freq)
+{
+	struct msm_vidc_dcvs_history *hist = &power->dcvs_hist;
+	u32 occupancy, proc_us;
+
+	msm_vidc_dcvs_ewma(&hist->occ_ewma, &hist->occ_trend,
+		bufs_with_fw, !hist->occ_samples);
+	hist->occ_samples++;
+	occupancy = msm_vidc_dcvs_forecast(hist->occ_ewma, hist->occ_trend);
+
+	if (occupancy >= power->max_threshold) {
+		power->dcvs_flags = MSM_VIDC_DCVS_INCR;
+		return;
+	} else if (occupancy < power->min_threshold) {
+		power->dcvs_flags = MSM_VIDC_DCVS_DECR;
+		return;
+	}
+
+	/* decoder: keep the step until the forecast crosses nom_threshold */
+	if (decode &&
+		((power->dcvs_flags & MSM_VIDC_DCVS_DECR && occupancy < power->nom_threshold) ||
+		(power->dcvs_flags & MSM_VIDC_DCVS_INCR && occupancy > power->nom_threshold)))
+		return;
+	power->dcvs_flags = 0;
+
+	if (hist->samples < DCVS_HISTORY_MIN_SAMPLES || !max_rate)
+		return;
+
+	proc_us = msm_vidc_dcvs_forecast(hist->proc_ewma_us,
+		hist->proc_trend_us);
+	power->min_freq = msm_vidc_dcvs_predict_freq(power->min_freq,
+		clk_share, proc_us, USEC_PER_SEC / max_rate, max_freq);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(msm_vidc_dcvs_predictive);
+
+/* part of the current core clock this session voted for last time */
+static u64 msm_vidc_dcvs_clk_share(struct msm_vidc_inst *inst)
+{
+	struct msm_vidc_core *core = inst->core;
+	struct msm_vidc_inst *temp;
+	u64 total = 0, share = 0;
+
+	mutex_lock(&core->lock);
+	list_for_each_entry(temp, &core->instances, list) {
+		if (temp->active)
+			total += temp->power.curr_freq;
+	}
+	if (total)
+		share = div64_u64((u64)core->power.clk_freq *
+			inst->power.curr_freq, total);
+	mutex_unlock(&core->lock);
+
+	return share;
+}
+
+static int msm_vidc_apply_dcvs(struct msm_vidc_inst *inst)
+{
+	int rc = 0;
+	int bufs_with_fw = 0;
+	struct msm_vidc_power *power;
+	struct msm_vidc_dcvs_history *hist;
+
+	if (!inst || !inst->core) {
+		d_vpr_e("%s: invalid params %pK\n", __func__, inst);
+		return -EINVAL;
+	}
+
+	/* skip dcvs */
+	if (!inst->power.dcvs_mode)
+		return 0;
+
+	power = &inst->power;
+
+	bufs_with_fw = msm_vidc_dcvs_bufs_with_fw(inst);
+
+	/* +1 as one buffer is going to be queued after the function */
+	bufs_with_fw += 1;
+
+	if (msm_vidc_dcvs_governor == MSM_VIDC_DCVS_GOV_PREDICTIVE) {
+		msm_vidc_dcvs_predictive(power, is_decode_session(inst),
+			bufs_with_fw, inst->max_rate,
+			msm_vidc_dcvs_clk_share(inst), msm_vidc_max_freq(inst));
+		hist = &power->dcvs_hist;
+		i_vpr_p(inst,
+			"dcvs: predictive bufs_with_fw %d forecast %u proc %u us th[%d %d %d] freq %llu flags %#x\n",
+			bufs_with_fw,
+			msm_vidc_dcvs_forecast(hist->occ_ewma, hist->occ_trend),
+			msm_vidc_dcvs_forecast(hist->proc_ewma_us,
+				hist->proc_trend_us),
+			power->min_threshold, power->nom_threshold,
+			power->max_threshold, power->min_freq,
+			power->dcvs_flags);
+		return rc;
+	}
+
+	msm_vidc_dcvs_reactive(power, is_decode_session(inst), bufs_with_fw);
 
-exit:
 	i_vpr_p(inst, "dcvs: bufs_with_fw %d th[%d %d %d] flags %#x\n",
 		bufs_with_fw, power->min_threshold,
 		power->nom_threshold, power->max_threshold,
@@ -644,6 +845,7 @@ void msm_vidc_dcvs_data_reset(struct msm_vidc_inst *inst)
 	dcvs->dcvs_window = min_count < max_count ? max_count - min_count : 0;
 	dcvs->nom_threshold = dcvs->min_threshold + (dcvs->dcvs_window / 2);
 	dcvs->dcvs_flags = 0;
+	memset(&dcvs->dcvs_hist, 0, sizeof(dcvs->dcvs_hist));
 
 	i_vpr_p(inst, "%s: dcvs: thresholds [%d %d %d] flags %#x\n",
 		__func__, dcvs->min_threshold,
@@ -991,12 +991,11 @@ static int __iface_cmdq_write_relaxed(struct msm_vidc_core *core,
 		goto err_q_write;
 	}
 
-	if (!__write_queue(q_info, (u8 *)pkt, requires_interrupt)) {
+	rc = __write_queue(q_info, (u8 *)pkt, requires_interrupt);
+	if (!rc)
 		__schedule_power_collapse_work(core);
-		rc = 0;
-	} else {
+	else
 		d_vpr_e("__iface_cmdq_write: queue full\n");
-	}
 
 err_q_write:
 err_q_null:
@@ -1027,6 +1026,69 @@ static int __iface_cmdq_write_intr(struct msm_vidc_core *core,
 	return rc;
 }
 
+/* command queue is considered nearly full once 3/4 of it is in use */
+static bool __iface_cmdq_nearly_full(struct msm_vidc_core *core)
+{
+	struct msm_vidc_iface_q_info *qinfo;
+	struct hfi_queue_header *queue;
+	u32 read_idx, write_idx, q_words, used;
+
+	qinfo = &core->iface_queues[VIDC_IFACEQ_CMDQ_IDX];
+	queue = (struct hfi_queue_header *)qinfo->q_hdr;
+	if (!queue)
+		return true;
+
+	q_words = qinfo->q_array.mem_size >> 2;
+	read_idx = queue->qhdr_read_idx;
+	write_idx = queue->qhdr_write_idx;
+	used = (write_idx >= read_idx) ? (write_idx - read_idx) :
+		(q_words - (read_idx - write_idx));
+
+	return used >= q_words - (q_words >> 2);
+}
+
+static void __iface_cmdq_batch_doorbell(struct msm_vidc_inst *inst)
+{
+	struct msm_vidc_core *core = inst->core;
+
+	if (!inst->hfi_batch.pending)
+		return;
+
+	if (core->power_enabled)
+		call_venus_op(core, raise_interrupt, core);
+	inst->hfi_batch.pending = 0;
+	inst->hfi_batch.doorbells++;
+}
+
+/*
+ * While a buffer batch is open on the session, write the packet without
+ * raising the doorbell; firmware is interrupted once at the end of the
+ * batch, or right away if the command queue is getting full or the
+ * write failed.
+ */
+int __iface_cmdq_write_batched(struct msm_vidc_inst *inst, void *pkt)
+{
+	struct msm_vidc_core *core = inst->core;
+	bool needs_interrupt = false;
+	int rc;
+
+	if (!inst->hfi_batch.active)
+		return __iface_cmdq_write(core, pkt);
+
+	rc = __iface_cmdq_write_relaxed(core, pkt, &needs_interrupt);
+	if (!rc) {
+		inst->hfi_batch.packets++;
+		if (needs_interrupt)
+			inst->hfi_batch.pending++;
+	}
+
+	if (rc || __iface_cmdq_nearly_full(core))
+		__iface_cmdq_batch_doorbell(inst);
+
+	return rc;
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(__iface_cmdq_write_batched);
+
 int __iface_msgq_read(struct msm_vidc_core *core, void *pkt)
 {
 	u32 tx_req_is_set = 0;
@@ -3810,7 +3872,7 @@ int venus_hfi_queue_buffer(struct msm_vidc_inst *inst,
 	if (rc)
 		goto unlock;
 
-	rc = __iface_cmdq_write(inst->core, inst->packet);
+	rc = __iface_cmdq_write_batched(inst, inst->packet);
 	if (rc)
 		goto unlock;
 
@@ -3819,6 +3881,46 @@ unlock:
 	return rc;
 }
 
+void venus_hfi_queue_buffer_batch_begin(struct msm_vidc_inst *inst)
+{
+	struct msm_vidc_core *core;
+
+	if (!inst || !inst->core) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return;
+	}
+	core = inst->core;
+
+	core_lock(core, __func__);
+	inst->hfi_batch.active = true;
+	inst->hfi_batch.pending = 0;
+	inst->hfi_batch.packets = 0;
+	inst->hfi_batch.doorbells = 0;
+	core_unlock(core, __func__);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(venus_hfi_queue_buffer_batch_begin);
+
+void venus_hfi_queue_buffer_batch_end(struct msm_vidc_inst *inst)
+{
+	struct msm_vidc_core *core;
+
+	if (!inst || !inst->core) {
+		d_vpr_e("%s: invalid params\n", __func__);
+		return;
+	}
+	core = inst->core;
+
+	core_lock(core, __func__);
+	__iface_cmdq_batch_doorbell(inst);
+	inst->hfi_batch.active = false;
+	if (inst->hfi_batch.packets)
+		i_vpr_l(inst, "%s: queued %u packets with %u doorbells\n",
+			__func__, inst->hfi_batch.packets,
+			inst->hfi_batch.doorbells);
+	core_unlock(core, __func__);
+}
+MSM_VIDC_EXPORT_FOR_KUNIT(venus_hfi_queue_buffer_batch_end);
+
 int venus_hfi_release_buffer(struct msm_vidc_inst *inst,
 	struct msm_vidc_buffer *buffer)
 {
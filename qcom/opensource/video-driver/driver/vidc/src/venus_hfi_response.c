@@ -15,6 +15,7 @@
 #include "msm_vidc_control.h"
 #include "msm_vidc_memory.h"
 #include "msm_vidc_fence.h"
+#include "msm_vidc_power.h"
 
 #define in_range(range, val) (((range.begin) < (val)) && ((range.end) > (val)))
 
@@ -1043,6 +1044,7 @@ static int handle_output_buffer(struct msm_vidc_inst *inst,
 
 	print_vidc_buffer(VIDC_HIGH, "high", "dqbuf", inst, buf);
 	msm_vidc_update_stats(inst, buf, MSM_VIDC_DEBUGFS_EVENT_FBD);
+	msm_vidc_dcvs_record_frame(inst);
 
 	/* fbd: print stats and remove entry */
 	if (!msm_vidc_is_super_buffer(inst))
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+
+#include "hfi_property.h"
+#include "hfi_buffer_iris3.h"
+#include "msm_media_info.h"
+#include "msm_vidc_buffer.h"
+#include "msm_vidc_buffer_iris3.h"
+#include "msm_vidc_core.h"
+#include "msm_vidc_inst.h"
+#include "msm_vidc_internal.h"
+
+#define MSM_VIDC_TEST_PIPES      4
+#define MSM_VIDC_TEST_MIN_COUNT  4
+/* deliberately off the 16/32/64 alignments the macros round to */
+#define MSM_VIDC_TEST_DIM_MIN    96
+#define MSM_VIDC_TEST_DIM_MAX    4096
+#define MSM_VIDC_TEST_DIM_STEP   100
+
+static const enum msm_vidc_codec_type msm_vidc_test_codecs[] = {
+	MSM_VIDC_H264, MSM_VIDC_HEVC, MSM_VIDC_VP9,
+};
+
+static const enum msm_vidc_buffer_type msm_vidc_test_types[] = {
+	MSM_VIDC_BUF_BIN, MSM_VIDC_BUF_COMV, MSM_VIDC_BUF_NON_COMV,
+	MSM_VIDC_BUF_LINE, MSM_VIDC_BUF_PERSIST,
+};
+
+static void msm_vidc_test_size_cache_hit_miss(struct kunit *test)
+{
+	struct msm_vidc_buffer_size_cache *cache;
+	struct msm_vidc_buffer_size_key key = {
+		.codec = MSM_VIDC_HEVC,
+		.in_width = 1920,
+		.in_height = 1080,
+		.out_width = 1920,
+		.out_height = 1080,
+		.out_min_count = 4,
+	};
+	u32 size = 0, count = 0;
+
+	cache = kunit_kzalloc(test, sizeof(*cache), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, cache);
+
+	/* first request misses */
+	KUNIT_EXPECT_FALSE(test, msm_vidc_buffer_size_cache_get(cache, &key,
+		MSM_VIDC_BUF_COMV, &size));
+	KUNIT_EXPECT_EQ(test, cache->misses, 1U);
+	msm_vidc_buffer_size_cache_put(cache, MSM_VIDC_BUF_COMV, 0x1000);
+
+	/* same key hits */
+	KUNIT_EXPECT_TRUE(test, msm_vidc_buffer_size_cache_get(cache, &key,
+		MSM_VIDC_BUF_COMV, &size));
+	KUNIT_EXPECT_EQ(test, size, 0x1000U);
+	KUNIT_EXPECT_EQ(test, cache->hits, 1U);
+
+	/* sizes and counts are cached separately */
+	KUNIT_EXPECT_FALSE(test, msm_vidc_buffer_count_cache_get(cache, &key,
+		MSM_VIDC_BUF_COMV, &count));
+	msm_vidc_buffer_count_cache_put(cache, MSM_VIDC_BUF_COMV, 1);
+	KUNIT_EXPECT_TRUE(test, msm_vidc_buffer_count_cache_get(cache, &key,
+		MSM_VIDC_BUF_COMV, &count));
+	KUNIT_EXPECT_EQ(test, count, 1U);
+
+	/* resolution change drops both */
+	key.in_width = 3840;
+	key.in_height = 2160;
+	KUNIT_EXPECT_FALSE(test, msm_vidc_buffer_size_cache_get(cache, &key,
+		MSM_VIDC_BUF_COMV, &size));
+	KUNIT_EXPECT_FALSE(test, msm_vidc_buffer_count_cache_get(cache, &key,
+		MSM_VIDC_BUF_COMV, &count));
+	KUNIT_EXPECT_EQ(test, cache->hits, 2U);
+	KUNIT_EXPECT_EQ(test, cache->misses, 4U);
+
+	/* buffer types outside the cache are never hits */
+	KUNIT_EXPECT_FALSE(test, msm_vidc_buffer_size_cache_get(cache, &key,
+		MSM_VIDC_BUF_PARTIAL_DATA + 1, &size));
+}
+
+/* Same derivations as the iris3 size helpers, straight from the macros */
+static u32 msm_vidc_test_raw_size(enum msm_vidc_codec_type codec,
+	enum msm_vidc_buffer_type type, u32 width, u32 height)
+{
+	u32 vpp_delay = DEFAULT_BSE_VPP_DELAY;
+	u32 num_comv = max_t(u32, vpp_delay + 1, MSM_VIDC_TEST_MIN_COUNT);
+	u32 size = 0;
+
+	switch (type) {
+	case MSM_VIDC_BUF_BIN:
+		if (codec == MSM_VIDC_H264)
+			HFI_BUFFER_BIN_H264D(size, width, height, false,
+				vpp_delay, MSM_VIDC_TEST_PIPES);
+		else if (codec == MSM_VIDC_HEVC)
+			HFI_BUFFER_BIN_H265D(size, width, height, 0,
+				vpp_delay, MSM_VIDC_TEST_PIPES);
+		else if (codec == MSM_VIDC_VP9)
+			HFI_BUFFER_BIN_VP9D(size, width, height, 0,
+				MSM_VIDC_TEST_PIPES);
+		break;
+	case MSM_VIDC_BUF_COMV:
+		if (codec == MSM_VIDC_H264)
+			HFI_BUFFER_COMV_H264D(size, width, height, num_comv);
+		else if (codec == MSM_VIDC_HEVC)
+			HFI_BUFFER_COMV_H265D(size, width, height, num_comv);
+		break;
+	case MSM_VIDC_BUF_NON_COMV:
+		if (codec == MSM_VIDC_H264)
+			HFI_BUFFER_NON_COMV_H264D(size, width, height,
+				MSM_VIDC_TEST_PIPES);
+		else if (codec == MSM_VIDC_HEVC)
+			HFI_BUFFER_NON_COMV_H265D(size, width, height,
+				MSM_VIDC_TEST_PIPES);
+		break;
+	case MSM_VIDC_BUF_LINE:
+		if (codec == MSM_VIDC_H264)
+			HFI_BUFFER_LINE_H264D(size, width, height, true,
+				MSM_VIDC_TEST_PIPES);
+		else if (codec == MSM_VIDC_HEVC)
+			HFI_BUFFER_LINE_H265D(size, width, height, true,
+				MSM_VIDC_TEST_PIPES);
+		else if (codec == MSM_VIDC_VP9)
+			HFI_BUFFER_LINE_VP9D(size, width, height, num_comv,
+				true, MSM_VIDC_TEST_PIPES);
+		break;
+	case MSM_VIDC_BUF_PERSIST:
+		if (codec == MSM_VIDC_H264)
+			HFI_BUFFER_PERSIST_H264D(size, 0);
+		else if (codec == MSM_VIDC_HEVC)
+			HFI_BUFFER_PERSIST_H265D(size, 0);
+		else if (codec == MSM_VIDC_VP9)
+			HFI_BUFFER_PERSIST_VP9D(size);
+		break;
+	default:
+		break;
+	}
+
+	return size;
+}
+
+static void msm_vidc_test_set_res(struct msm_vidc_inst *inst, u32 width,
+	u32 height)
+{
+	inst->fmts[INPUT_PORT].fmt.pix_mp.width = width;
+	inst->fmts[INPUT_PORT].fmt.pix_mp.height = height;
+	inst->fmts[OUTPUT_PORT].fmt.pix_mp.width = width;
+	inst->fmts[OUTPUT_PORT].fmt.pix_mp.height = height;
+}
+
+/* A progressive UBWC decode session on a four pipe core */
+static int msm_vidc_buffer_test_init(struct kunit *test)
+{
+	struct msm_vidc_inst *inst;
+
+	inst = kunit_kzalloc(test, sizeof(*inst), GFP_KERNEL);
+	if (!inst)
+		return -ENOMEM;
+	inst->core = kunit_kzalloc(test, sizeof(*inst->core), GFP_KERNEL);
+	if (!inst->core)
+		return -ENOMEM;
+	inst->core->capabilities = kunit_kcalloc(test, CORE_CAP_MAX,
+		sizeof(*inst->core->capabilities), GFP_KERNEL);
+	if (!inst->core->capabilities)
+		return -ENOMEM;
+	inst->capabilities = kunit_kzalloc(test, sizeof(*inst->capabilities),
+		GFP_KERNEL);
+	if (!inst->capabilities)
+		return -ENOMEM;
+
+	strscpy(inst->debug_str, "vidc_test: ", sizeof(inst->debug_str));
+	inst->domain = MSM_VIDC_DECODER;
+	inst->core->capabilities[NUM_VPP_PIPE].value = MSM_VIDC_TEST_PIPES;
+	inst->capabilities->cap[CODED_FRAMES].value = CODED_FRAMES_PROGRESSIVE;
+	inst->capabilities->cap[PIX_FMTS].value = MSM_VIDC_FMT_NV12C;
+	inst->fmts[OUTPUT_PORT].fmt.pix_mp.pixelformat = V4L2_PIX_FMT_VIDC_NV12C;
+	inst->buffers.output.min_count = MSM_VIDC_TEST_MIN_COUNT;
+	test->priv = inst;
+
+	return 0;
+}
+
+/* A cache hit on COMV puts back the NUM_COMV the size helper had set */
+static void msm_vidc_test_size_cache_num_comv(struct kunit *test)
+{
+	struct msm_vidc_inst *inst = test->priv;
+	u32 size;
+
+	inst->codec = MSM_VIDC_HEVC;
+	msm_vidc_test_set_res(inst, 1920, 1080);
+
+	size = msm_buffer_size_iris3(inst, MSM_VIDC_BUF_COMV);
+	KUNIT_EXPECT_EQ(test, (s32)MSM_VIDC_TEST_MIN_COUNT,
+		inst->capabilities->cap[NUM_COMV].value);
+
+	inst->capabilities->cap[NUM_COMV].value = 0;
+	KUNIT_EXPECT_EQ(test, size,
+		(u32)msm_buffer_size_iris3(inst, MSM_VIDC_BUF_COMV));
+	KUNIT_EXPECT_EQ(test, 1U, inst->buf_size_cache.hits);
+	KUNIT_EXPECT_EQ(test, (s32)MSM_VIDC_TEST_MIN_COUNT,
+		inst->capabilities->cap[NUM_COMV].value);
+}
+
+/*
+ * Every size the driver returns, on the first call that fills the cache
+ * and on the second that hits it, matches the raw HFI macros over a
+ * dense resolution grid. The time per lookup of each path is logged.
+ */
+static void msm_vidc_test_size_cache_grid(struct kunit *test)
+{
+	struct msm_vidc_inst *inst = test->priv;
+	enum msm_vidc_buffer_type type;
+	u64 start, raw_ns, miss_ns, hit_ns;
+	u32 c, t, w, h, raw, lookups, mismatches;
+
+	for (c = 0; c < ARRAY_SIZE(msm_vidc_test_codecs); c++) {
+		inst->codec = msm_vidc_test_codecs[c];
+		raw_ns = miss_ns = hit_ns = 0;
+		lookups = mismatches = 0;
+
+		for (w = MSM_VIDC_TEST_DIM_MIN; w <= MSM_VIDC_TEST_DIM_MAX;
+				w += MSM_VIDC_TEST_DIM_STEP)
+		for (h = MSM_VIDC_TEST_DIM_MIN; h <= MSM_VIDC_TEST_DIM_MAX;
+				h += MSM_VIDC_TEST_DIM_STEP) {
+			/* the new resolution changes the key, so the cache empties */
+			msm_vidc_test_set_res(inst, w, h);
+
+			for (t = 0; t < ARRAY_SIZE(msm_vidc_test_types); t++) {
+				type = msm_vidc_test_types[t];
+
+				start = ktime_get_ns();
+				raw = msm_vidc_test_raw_size(inst->codec, type,
+					w, h);
+				raw_ns += ktime_get_ns() - start;
+
+				start = ktime_get_ns();
+				if (raw != (u32)msm_buffer_size_iris3(inst, type))
+					mismatches++;
+				miss_ns += ktime_get_ns() - start;
+
+				start = ktime_get_ns();
+				if (raw != (u32)msm_buffer_size_iris3(inst, type))
+					mismatches++;
+				hit_ns += ktime_get_ns() - start;
+
+				lookups++;
+			}
+		}
+
+		KUNIT_EXPECT_EQ(test, 0U, mismatches);
+		kunit_info(test, "codec %#x: %u sizes, raw macros %llu ns, uncached %llu ns, cached %llu ns per lookup, %llux\n",
+			inst->codec, lookups, div_u64(raw_ns, lookups),
+			div_u64(miss_ns, lookups), div_u64(hit_ns, lookups),
+			div64_u64(miss_ns, max_t(u64, hit_ns, 1)));
+	}
+
+	/* every first lookup per resolution missed, every second one hit */
+	KUNIT_EXPECT_EQ(test, inst->buf_size_cache.hits,
+		inst->buf_size_cache.misses);
+}
+
+static struct kunit_case msm_vidc_buffer_test_cases[] = {
+	KUNIT_CASE(msm_vidc_test_size_cache_hit_miss),
+	KUNIT_CASE(msm_vidc_test_size_cache_num_comv),
+	KUNIT_CASE(msm_vidc_test_size_cache_grid),
+	{}
+};
+
+static struct kunit_suite msm_vidc_buffer_test_suite = {
+	.name = "msm_vidc_buffer_iris3",
+	.init = msm_vidc_buffer_test_init,
+	.test_cases = msm_vidc_buffer_test_cases,
+};
+
+kunit_test_suite(msm_vidc_buffer_test_suite);
+
+MODULE_DESCRIPTION("Video driver iris3 buffer size cache KUnit tests");
+MODULE_LICENSE("GPL v2");
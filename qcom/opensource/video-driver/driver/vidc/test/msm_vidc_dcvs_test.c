@@ -0,0 +1,373 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+#include "msm_vidc_buffer.h"
+#include "msm_vidc_internal.h"
+#include "msm_vidc_power.h"
+
+/* kalama clock plan, highest rate first like allowed_clks_tbl */
+static const u64 msm_vidc_test_clks[] = {
+	533333333, 444000000, 366000000, 338000000, 240000000,
+};
+
+#define MSM_VIDC_TEST_MAX_FREQ   533333333ULL
+#define MSM_VIDC_TEST_MIN_COUNT  4
+#define MSM_VIDC_TEST_FRAMES     600
+
+static void msm_vidc_test_dcvs_init(struct msm_vidc_power *power)
+{
+	memset(power, 0, sizeof(*power));
+	power->min_threshold = MSM_VIDC_TEST_MIN_COUNT;
+	power->max_threshold = MSM_VIDC_TEST_MIN_COUNT +
+		DCVS_DEC_EXTRA_OUTPUT_BUFFERS;
+	power->dcvs_window = DCVS_DEC_EXTRA_OUTPUT_BUFFERS;
+	power->nom_threshold = power->min_threshold + power->dcvs_window / 2;
+}
+
+/* a constant processing time is forecast as is, with no trend */
+static void msm_vidc_test_dcvs_forecast_steady(struct kunit *test)
+{
+	struct msm_vidc_dcvs_history hist = {0};
+	u64 now_ns = NSEC_PER_SEC;
+	int i;
+
+	for (i = 0; i < 32; i++) {
+		now_ns += 20 * NSEC_PER_MSEC;
+		msm_vidc_dcvs_history_add(&hist, now_ns, true);
+	}
+
+	/* the first completion only sets the reference point */
+	KUNIT_EXPECT_EQ(test, hist.samples, 31U);
+	KUNIT_EXPECT_EQ(test, hist.proc_trend_us, 0);
+	KUNIT_EXPECT_EQ(test, msm_vidc_dcvs_forecast(hist.proc_ewma_us,
+		hist.proc_trend_us), 20000U);
+}
+
+/* on a growing load the trend puts the forecast ahead of the average */
+static void msm_vidc_test_dcvs_forecast_ramp(struct kunit *test)
+{
+	struct msm_vidc_dcvs_history hist = {0};
+	u64 now_ns = NSEC_PER_SEC;
+	u32 sample_us = 10000, average, forecast;
+	int i;
+
+	msm_vidc_dcvs_history_add(&hist, now_ns, true);
+	for (i = 0; i < 16; i++) {
+		now_ns += (u64)sample_us * NSEC_PER_USEC;
+		msm_vidc_dcvs_history_add(&hist, now_ns, true);
+		sample_us += 1000;
+	}
+	sample_us -= 1000;
+
+	average = msm_vidc_dcvs_forecast(hist.proc_ewma_us, 0);
+	forecast = msm_vidc_dcvs_forecast(hist.proc_ewma_us,
+		hist.proc_trend_us);
+	kunit_info(test, "last %u us average %u us forecast %u us\n",
+		sample_us, average, forecast);
+
+	KUNIT_EXPECT_GT(test, hist.proc_trend_us, 0);
+	KUNIT_EXPECT_GT(test, forecast, average);
+	KUNIT_EXPECT_LE(test, forecast, sample_us + 1000);
+
+	/* and behind it once the load falls again */
+	for (i = 0; i < 8; i++) {
+		now_ns += 10 * NSEC_PER_MSEC;
+		msm_vidc_dcvs_history_add(&hist, now_ns, true);
+	}
+	KUNIT_EXPECT_LT(test, hist.proc_trend_us, 0);
+	KUNIT_EXPECT_LT(test, msm_vidc_dcvs_forecast(hist.proc_ewma_us,
+		hist.proc_trend_us), msm_vidc_dcvs_forecast(hist.proc_ewma_us, 0));
+}
+
+/* completions without a backlog follow the client, they are not samples */
+static void msm_vidc_test_dcvs_history_backlog(struct kunit *test)
+{
+	struct msm_vidc_dcvs_history hist = {0};
+	u64 i;
+
+	msm_vidc_dcvs_history_add(&hist, NSEC_PER_SEC, true);
+	msm_vidc_dcvs_history_add(&hist, 2 * NSEC_PER_SEC, false);
+	KUNIT_EXPECT_EQ(test, hist.samples, 0U);
+	KUNIT_EXPECT_EQ(test, hist.last_fbd_ns, (u64)(2 * NSEC_PER_SEC));
+
+	/* a stall is clamped to one second */
+	msm_vidc_dcvs_history_add(&hist, 5 * NSEC_PER_SEC, true);
+	KUNIT_EXPECT_EQ(test, hist.samples, 1U);
+	KUNIT_EXPECT_EQ(test, msm_vidc_dcvs_forecast(hist.proc_ewma_us,
+		hist.proc_trend_us), (u32)USEC_PER_SEC);
+
+	/* firmware keeping up for a while drops the history */
+	for (i = 1; i < DCVS_HISTORY_IDLE_RESET; i++)
+		msm_vidc_dcvs_history_add(&hist, (5 + i) * NSEC_PER_SEC, false);
+	KUNIT_EXPECT_EQ(test, hist.samples, 1U);
+	msm_vidc_dcvs_history_add(&hist, (5 + i) * NSEC_PER_SEC, false);
+	KUNIT_EXPECT_EQ(test, hist.samples, 0U);
+}
+
+/* a decoder bump is held until the forecast falls to nom_threshold */
+static void msm_vidc_test_dcvs_predictive_hysteresis(struct kunit *test)
+{
+	struct msm_vidc_power power;
+	int i;
+
+	msm_vidc_test_dcvs_init(&power);
+	for (i = 0; i < 4; i++)
+		msm_vidc_dcvs_predictive(&power, true,
+			power.max_threshold + 1, 30, 0, MSM_VIDC_TEST_MAX_FREQ);
+	KUNIT_EXPECT_EQ(test, power.dcvs_flags, (u32)MSM_VIDC_DCVS_INCR);
+
+	/* back inside the window but above nom: keep the bump */
+	for (i = 0; i < 2; i++)
+		msm_vidc_dcvs_predictive(&power, true, power.nom_threshold + 1,
+			30, 0, MSM_VIDC_TEST_MAX_FREQ);
+	KUNIT_EXPECT_EQ(test, power.dcvs_flags, (u32)MSM_VIDC_DCVS_INCR);
+
+	for (i = 0; i < 16; i++)
+		msm_vidc_dcvs_predictive(&power, true, power.nom_threshold,
+			30, 0, MSM_VIDC_TEST_MAX_FREQ);
+	KUNIT_EXPECT_EQ(test, power.dcvs_flags, 0U);
+
+	/* an encoder drops the bump as soon as it is inside the window */
+	msm_vidc_test_dcvs_init(&power);
+	msm_vidc_dcvs_predictive(&power, false, power.max_threshold, 30, 0,
+		MSM_VIDC_TEST_MAX_FREQ);
+	KUNIT_EXPECT_EQ(test, power.dcvs_flags, (u32)MSM_VIDC_DCVS_INCR);
+	msm_vidc_test_dcvs_init(&power);
+	msm_vidc_dcvs_predictive(&power, false, power.nom_threshold + 1, 30, 0,
+		MSM_VIDC_TEST_MAX_FREQ);
+	KUNIT_EXPECT_EQ(test, power.dcvs_flags, 0U);
+}
+
+/*
+ * Two 30fps sessions on a 444MHz core that they split 2:1 in the last
+ * vote. msm_vidc_set_clocks() sums their estimates.
+ */
+static void msm_vidc_test_dcvs_predict_two_sessions(struct kunit *test)
+{
+	u64 max_freq = 533000000, share_a, share_b, freq_a, freq_b;
+	u32 deadline_us = USEC_PER_SEC / 30;
+
+	share_a = div64_u64(444000000ULL * 300000000, 450000000);
+	share_b = div64_u64(444000000ULL * 150000000, 450000000);
+
+	/* busy session: 90% of the deadline at its share, 1/8 headroom */
+	freq_a = msm_vidc_dcvs_predict_freq(240000000, share_a, 30000,
+		deadline_us, max_freq);
+	KUNIT_EXPECT_EQ(test, freq_a, 299702997ULL);
+
+	/* light session: never below its own calculated clock */
+	freq_b = msm_vidc_dcvs_predict_freq(150000000, share_b, 10000,
+		deadline_us, max_freq);
+	KUNIT_EXPECT_EQ(test, freq_b, 150000000ULL);
+
+	/* scaling the whole core clock would have voted it about twice */
+	KUNIT_EXPECT_LE(test, freq_a + freq_b, max_freq);
+	KUNIT_EXPECT_GT(test, msm_vidc_dcvs_predict_freq(240000000,
+		444000000, 30000, deadline_us, max_freq) +
+		msm_vidc_dcvs_predict_freq(150000000, 444000000, 10000,
+		deadline_us, max_freq), max_freq);
+}
+
+static void msm_vidc_test_dcvs_predict_limits(struct kunit *test)
+{
+	u64 max_freq = 533000000;
+	u32 deadline_us = USEC_PER_SEC / 30;
+
+	/* no forecast or no vote yet: keep the reactive value */
+	KUNIT_EXPECT_EQ(test, msm_vidc_dcvs_predict_freq(240000000, 338000000,
+		0, deadline_us, max_freq), 240000000ULL);
+	KUNIT_EXPECT_EQ(test, msm_vidc_dcvs_predict_freq(240000000, 338000000,
+		30000, 0, max_freq), 240000000ULL);
+	KUNIT_EXPECT_EQ(test, msm_vidc_dcvs_predict_freq(240000000, 0,
+		30000, deadline_us, max_freq), 240000000ULL);
+
+	/* overloaded session is capped at the max clock */
+	KUNIT_EXPECT_EQ(test, msm_vidc_dcvs_predict_freq(500000000, 500000000,
+		40000, deadline_us, max_freq), max_freq);
+}
+
+/*
+ * Synthetic per-frame decode cost in kcycles of a 30fps stream. calc_freq
+ * only knows the average, the traces differ in how the cost moves
+ * around it.
+ */
+struct msm_vidc_test_trace {
+	const char *name;
+	u32 (*kcycles)(u32 frame);
+};
+
+/* 1080p at a constant cost */
+static u32 msm_vidc_test_trace_steady(u32 frame)
+{
+	return 9000;
+}
+
+/* an I frame of three times the cost opens every 30 frame GOP */
+static u32 msm_vidc_test_trace_gop(u32 frame)
+{
+	return frame % 30 ? 8000 : 24000;
+}
+
+/* scene complexity ramps up and back down over 10s */
+static u32 msm_vidc_test_trace_ramp(u32 frame)
+{
+	u32 pos = frame % 300;
+
+	return 6000 + 40 * (pos < 150 ? pos : 300 - pos);
+}
+
+/* a quiet scene cuts to a busy one and back every 5s */
+static u32 msm_vidc_test_trace_scene_cut(u32 frame)
+{
+	return (frame / 150) % 2 ? 12000 : 6000;
+}
+
+static const struct msm_vidc_test_trace msm_vidc_test_traces[] = {
+	{ "steady",    msm_vidc_test_trace_steady    },
+	{ "gop",       msm_vidc_test_trace_gop       },
+	{ "ramp",      msm_vidc_test_trace_ramp      },
+	{ "scene_cut", msm_vidc_test_trace_scene_cut },
+};
+
+struct msm_vidc_test_replay {
+	u32 misses;
+	u64 avg_freq;
+};
+
+/* msm_vidc_set_clocks() for a single session */
+static u64 msm_vidc_test_pick_clock(struct msm_vidc_power *power)
+{
+	int i, size = ARRAY_SIZE(msm_vidc_test_clks);
+
+	for (i = size - 1; i >= 0; i--)
+		if (msm_vidc_test_clks[i] >= power->min_freq)
+			break;
+	if (i < 0)
+		i = 0;
+	if (power->dcvs_flags & MSM_VIDC_DCVS_INCR && i > 0)
+		i--;
+	else if (power->dcvs_flags & MSM_VIDC_DCVS_DECR && i < size - 1)
+		i++;
+
+	return msm_vidc_test_clks[i];
+}
+
+/*
+ * Replay a trace through one governor. Frames are queued every frame
+ * period and decoded in order at the clock voted when they were
+ * queued. The firmware keeps min_count - 1 buffers for reference, plus
+ * the queued frames it has not decoded yet. A frame misses its deadline
+ * when it is not decoded within two frame periods of being queued, the
+ * point at which the client's display slot has passed.
+ */
+static void msm_vidc_test_replay(const struct msm_vidc_test_trace *trace,
+	bool predictive, u64 calc_freq, u64 *finish,
+	struct msm_vidc_test_replay *out)
+{
+	struct msm_vidc_power power;
+	u64 period_ns = NSEC_PER_SEC / 30, arrival, start, clk = 0, freq_sum = 0;
+	u32 i, done = 0, pending;
+
+	msm_vidc_test_dcvs_init(&power);
+	out->misses = 0;
+
+	for (i = 0; i < MSM_VIDC_TEST_FRAMES; i++) {
+		arrival = i * period_ns;
+
+		/* frame completions up to now, as seen in handle_output_buffer */
+		for (; done < i && finish[done] <= arrival; done++)
+			msm_vidc_dcvs_history_add(&power.dcvs_hist, finish[done],
+				done && done * period_ns <= finish[done - 1]);
+		pending = i - done;
+
+		/* msm_vidc_scale_clocks() */
+		if (i < DCVS_WINDOW) {
+			power.min_freq = MSM_VIDC_TEST_MAX_FREQ;
+			power.dcvs_flags = 0;
+		} else {
+			power.min_freq = calc_freq;
+			if (predictive)
+				msm_vidc_dcvs_predictive(&power, true,
+					power.min_threshold + pending, 30, clk,
+					MSM_VIDC_TEST_MAX_FREQ);
+			else
+				msm_vidc_dcvs_reactive(&power, true,
+					power.min_threshold + pending);
+		}
+		clk = msm_vidc_test_pick_clock(&power);
+		freq_sum += clk;
+
+		start = i && finish[i - 1] > arrival ? finish[i - 1] : arrival;
+		finish[i] = start + div64_u64((u64)trace->kcycles(i) * 1000 *
+			NSEC_PER_SEC, clk);
+		if (finish[i] > arrival + 2 * period_ns)
+			out->misses++;
+	}
+
+	out->avg_freq = div_u64(freq_sum, MSM_VIDC_TEST_FRAMES);
+}
+
+/*
+ * Replay each trace through both governors, with calc_freq at the
+ * trace's average load, and report deadline misses against the average
+ * clock. Neither governor may miss on a steady stream and the predictive
+ * one may not miss more than the reactive one.
+ */
+static void msm_vidc_test_dcvs_trace_replay(struct kunit *test)
+{
+	const struct msm_vidc_test_trace *trace;
+	struct msm_vidc_test_replay reactive, predictive;
+	u64 *finish, calc_freq;
+	u32 t, i;
+
+	finish = kunit_kcalloc(test, MSM_VIDC_TEST_FRAMES, sizeof(*finish),
+		GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, finish);
+
+	for (t = 0; t < ARRAY_SIZE(msm_vidc_test_traces); t++) {
+		trace = &msm_vidc_test_traces[t];
+
+		calc_freq = 0;
+		for (i = 0; i < MSM_VIDC_TEST_FRAMES; i++)
+			calc_freq += trace->kcycles(i);
+		calc_freq = div_u64(calc_freq * 1000 * 30, MSM_VIDC_TEST_FRAMES);
+
+		msm_vidc_test_replay(trace, false, calc_freq, finish, &reactive);
+		msm_vidc_test_replay(trace, true, calc_freq, finish, &predictive);
+
+		kunit_info(test, "%-9s calc %llu MHz: reactive %u misses avg %llu MHz, predictive %u misses avg %llu MHz\n",
+			trace->name, div_u64(calc_freq, 1000000),
+			reactive.misses, div_u64(reactive.avg_freq, 1000000),
+			predictive.misses, div_u64(predictive.avg_freq, 1000000));
+
+		KUNIT_EXPECT_LE(test, predictive.misses, reactive.misses);
+		if (trace->kcycles == msm_vidc_test_trace_steady) {
+			KUNIT_EXPECT_EQ(test, reactive.misses, 0U);
+			KUNIT_EXPECT_EQ(test, predictive.misses, 0U);
+		}
+	}
+}
+
+static struct kunit_case msm_vidc_dcvs_test_cases[] = {
+	KUNIT_CASE(msm_vidc_test_dcvs_forecast_steady),
+	KUNIT_CASE(msm_vidc_test_dcvs_forecast_ramp),
+	KUNIT_CASE(msm_vidc_test_dcvs_history_backlog),
+	KUNIT_CASE(msm_vidc_test_dcvs_predictive_hysteresis),
+	KUNIT_CASE(msm_vidc_test_dcvs_predict_two_sessions),
+	KUNIT_CASE(msm_vidc_test_dcvs_predict_limits),
+	KUNIT_CASE(msm_vidc_test_dcvs_trace_replay),
+	{}
+};
+
+static struct kunit_suite msm_vidc_dcvs_test_suite = {
+	.name = "msm_vidc_dcvs",
+	.test_cases = msm_vidc_dcvs_test_cases,
+};
+
+kunit_test_suite(msm_vidc_dcvs_test_suite);
+
+MODULE_DESCRIPTION("Video driver dcvs governor KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+
+#include "msm_vidc_core.h"
+#include "msm_vidc_inst.h"
+#include "msm_vidc_internal.h"
+#include "venus_hfi.h"
+
+#define MSM_VIDC_TEST_Q_WORDS    256
+#define MSM_VIDC_TEST_PKT_WORDS  16
+
+/*
+ * Fake firmware behind the command queue: every doorbell is counted and,
+ * unless firmware is stalled, consumes the queue up to the write index and
+ * checks that packets arrive whole and in order.
+ */
+struct msm_vidc_hfi_test_ctx {
+	struct msm_vidc_core core;
+	struct msm_vidc_inst inst;
+	struct hfi_queue_header hdr;
+	u32 words[MSM_VIDC_TEST_Q_WORDS];
+	u32 pkt[MSM_VIDC_TEST_PKT_WORDS];
+	struct msm_vidc_core_capability caps[CORE_CAP_MAX];
+	struct kunit *test;
+	bool fw_stalled;
+	u32 doorbells;
+	u32 next_seq;
+	u32 consumed;
+};
+
+static void msm_vidc_test_fw_drain(struct msm_vidc_hfi_test_ctx *ctx)
+{
+	u32 read_idx = ctx->hdr.qhdr_read_idx, words, k;
+
+	while (read_idx != ctx->hdr.qhdr_write_idx) {
+		words = ctx->words[read_idx] >> 2;
+		KUNIT_EXPECT_EQ(ctx->test, (u32)MSM_VIDC_TEST_PKT_WORDS, words);
+		if (words != MSM_VIDC_TEST_PKT_WORDS)
+			break;
+		for (k = 1; k < words; k++)
+			KUNIT_EXPECT_EQ(ctx->test, (ctx->next_seq << 8) | k,
+				ctx->words[(read_idx + k) % MSM_VIDC_TEST_Q_WORDS]);
+		read_idx = (read_idx + words) % MSM_VIDC_TEST_Q_WORDS;
+		ctx->next_seq++;
+		ctx->consumed++;
+	}
+	ctx->hdr.qhdr_read_idx = read_idx;
+}
+
+static int msm_vidc_test_raise_interrupt(struct msm_vidc_core *core)
+{
+	struct msm_vidc_hfi_test_ctx *ctx =
+		container_of(core, struct msm_vidc_hfi_test_ctx, core);
+
+	ctx->doorbells++;
+	if (!ctx->fw_stalled)
+		msm_vidc_test_fw_drain(ctx);
+
+	return 0;
+}
+
+static struct msm_vidc_venus_ops msm_vidc_test_venus_ops = {
+	.raise_interrupt = msm_vidc_test_raise_interrupt,
+};
+
+static u32 msm_vidc_test_q_used(struct msm_vidc_hfi_test_ctx *ctx)
+{
+	return (ctx->hdr.qhdr_write_idx - ctx->hdr.qhdr_read_idx +
+		MSM_VIDC_TEST_Q_WORDS) % MSM_VIDC_TEST_Q_WORDS;
+}
+
+/* Packets carry their size in bytes first, then a per packet pattern */
+static int msm_vidc_test_write(struct msm_vidc_hfi_test_ctx *ctx, u32 seq)
+{
+	int rc;
+	u32 k;
+
+	ctx->pkt[0] = MSM_VIDC_TEST_PKT_WORDS * sizeof(u32);
+	for (k = 1; k < MSM_VIDC_TEST_PKT_WORDS; k++)
+		ctx->pkt[k] = (seq << 8) | k;
+
+	mutex_lock(&ctx->core.lock);
+	rc = __iface_cmdq_write_batched(&ctx->inst, ctx->pkt);
+	mutex_unlock(&ctx->core.lock);
+
+	return rc;
+}
+
+/* Everything queued in a batch goes out with a single doorbell at the end */
+static void msm_vidc_test_batch_one_doorbell(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx = test->priv;
+	u32 i;
+
+	venus_hfi_queue_buffer_batch_begin(&ctx->inst);
+	for (i = 0; i < 8; i++)
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_test_write(ctx, i));
+	KUNIT_EXPECT_EQ(test, 0U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 8U * MSM_VIDC_TEST_PKT_WORDS,
+		msm_vidc_test_q_used(ctx));
+
+	venus_hfi_queue_buffer_batch_end(&ctx->inst);
+	KUNIT_EXPECT_EQ(test, 1U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 8U, ctx->consumed);
+	KUNIT_EXPECT_EQ(test, 8U, ctx->inst.hfi_batch.packets);
+	KUNIT_EXPECT_EQ(test, 1U, ctx->inst.hfi_batch.doorbells);
+	KUNIT_EXPECT_FALSE(test, ctx->inst.hfi_batch.active);
+
+	/* ending again has nothing left to ring for */
+	venus_hfi_queue_buffer_batch_end(&ctx->inst);
+	KUNIT_EXPECT_EQ(test, 1U, ctx->doorbells);
+}
+
+/*
+ * The batch rings early once 3/4 of the queue is in use, here at the
+ * 12th packet, and packets written across the end of the queue still
+ * reach firmware intact.
+ */
+static void msm_vidc_test_batch_early_flush(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx = test->priv;
+	u32 i;
+
+	ctx->hdr.qhdr_read_idx = 200;
+	ctx->hdr.qhdr_write_idx = 200;
+
+	venus_hfi_queue_buffer_batch_begin(&ctx->inst);
+	for (i = 0; i < 20; i++) {
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_test_write(ctx, i));
+		KUNIT_EXPECT_EQ(test, i < 11 ? 0U : 1U, ctx->doorbells);
+		if (i == 10)
+			KUNIT_EXPECT_EQ(test, 176U, msm_vidc_test_q_used(ctx));
+		if (i == 11)
+			KUNIT_EXPECT_EQ(test, 0U, msm_vidc_test_q_used(ctx));
+	}
+	KUNIT_EXPECT_EQ(test, 12U, ctx->consumed);
+
+	venus_hfi_queue_buffer_batch_end(&ctx->inst);
+	KUNIT_EXPECT_EQ(test, 2U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 20U, ctx->consumed);
+	KUNIT_EXPECT_EQ(test, 20U, ctx->inst.hfi_batch.packets);
+	KUNIT_EXPECT_EQ(test, 2U, ctx->inst.hfi_batch.doorbells);
+}
+
+/*
+ * With firmware not consuming, every packet past 3/4 rings on its own and
+ * the packet that does not fit is refused rather than dropped silently.
+ */
+static void msm_vidc_test_batch_queue_full(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx = test->priv;
+	u32 i;
+
+	ctx->fw_stalled = true;
+	venus_hfi_queue_buffer_batch_begin(&ctx->inst);
+
+	/* the queue keeps one word free, so 15 packets of 16 words fit */
+	for (i = 0; i < 15; i++) {
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_test_write(ctx, i));
+		KUNIT_EXPECT_EQ(test, i < 11 ? 0U : i - 10, ctx->doorbells);
+	}
+	KUNIT_EXPECT_EQ(test, -ENOTEMPTY, msm_vidc_test_write(ctx, 15));
+	KUNIT_EXPECT_EQ(test, 1U, ctx->hdr.qhdr_tx_req);
+	KUNIT_EXPECT_EQ(test, 4U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 15U, ctx->inst.hfi_batch.packets);
+
+	/* once firmware catches up the retry goes through */
+	ctx->fw_stalled = false;
+	msm_vidc_test_fw_drain(ctx);
+	KUNIT_EXPECT_EQ(test, 0, msm_vidc_test_write(ctx, 15));
+	KUNIT_EXPECT_EQ(test, 0U, ctx->hdr.qhdr_tx_req);
+
+	venus_hfi_queue_buffer_batch_end(&ctx->inst);
+	KUNIT_EXPECT_EQ(test, 5U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 16U, ctx->consumed);
+}
+
+/* A failed write rings for what the batch already queued */
+static void msm_vidc_test_batch_write_fail(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx = test->priv;
+	u32 i;
+
+	venus_hfi_queue_buffer_batch_begin(&ctx->inst);
+	for (i = 0; i < 4; i++)
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_test_write(ctx, i));
+	KUNIT_EXPECT_EQ(test, 0U, ctx->doorbells);
+
+	ctx->core.state = MSM_VIDC_CORE_DEINIT;
+	KUNIT_EXPECT_EQ(test, -EINVAL, msm_vidc_test_write(ctx, 4));
+	KUNIT_EXPECT_EQ(test, 1U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 4U, ctx->consumed);
+	ctx->core.state = MSM_VIDC_CORE_INIT;
+
+	venus_hfi_queue_buffer_batch_end(&ctx->inst);
+	KUNIT_EXPECT_EQ(test, 1U, ctx->doorbells);
+	KUNIT_EXPECT_EQ(test, 4U, ctx->inst.hfi_batch.packets);
+}
+
+/* Outside a batch every packet still rings right away */
+static void msm_vidc_test_unbatched(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx = test->priv;
+	u32 i;
+
+	for (i = 0; i < 5; i++) {
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_test_write(ctx, i));
+		KUNIT_EXPECT_EQ(test, i + 1, ctx->doorbells);
+		KUNIT_EXPECT_EQ(test, i + 1, ctx->consumed);
+	}
+	KUNIT_EXPECT_EQ(test, 0U, ctx->inst.hfi_batch.packets);
+}
+
+static int msm_vidc_hfi_test_init(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx;
+	struct msm_vidc_iface_q_info *qinfo;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	mutex_init(&ctx->core.lock);
+	ctx->core.state = MSM_VIDC_CORE_INIT;
+	ctx->core.power_enabled = true;
+	/* software power collapse off, so writes never schedule pm work */
+	ctx->core.capabilities = ctx->caps;
+	ctx->core.venus_ops = &msm_vidc_test_venus_ops;
+
+	qinfo = &ctx->core.iface_queues[VIDC_IFACEQ_CMDQ_IDX];
+	qinfo->q_hdr = &ctx->hdr;
+	qinfo->q_array.align_virtual_addr = (u8 *)ctx->words;
+	qinfo->q_array.mem_size = sizeof(ctx->words);
+	ctx->hdr.qhdr_q_size = MSM_VIDC_TEST_Q_WORDS;
+
+	ctx->inst.core = &ctx->core;
+	strscpy(ctx->inst.debug_str, "vidc_test: ", sizeof(ctx->inst.debug_str));
+	ctx->test = test;
+	test->priv = ctx;
+
+	return 0;
+}
+
+static void msm_vidc_hfi_test_exit(struct kunit *test)
+{
+	struct msm_vidc_hfi_test_ctx *ctx = test->priv;
+
+	mutex_destroy(&ctx->core.lock);
+}
+
+static struct kunit_case msm_vidc_hfi_test_cases[] = {
+	KUNIT_CASE(msm_vidc_test_batch_one_doorbell),
+	KUNIT_CASE(msm_vidc_test_batch_early_flush),
+	KUNIT_CASE(msm_vidc_test_batch_queue_full),
+	KUNIT_CASE(msm_vidc_test_batch_write_fail),
+	KUNIT_CASE(msm_vidc_test_unbatched),
+	{}
+};
+
+static struct kunit_suite msm_vidc_hfi_test_suite = {
+	.name = "msm_vidc_hfi_batch",
+	.init = msm_vidc_hfi_test_init,
+	.exit = msm_vidc_hfi_test_exit,
+	.test_cases = msm_vidc_hfi_test_cases,
+};
+
+kunit_test_suite(msm_vidc_hfi_test_suite);
+
+MODULE_DESCRIPTION("Video driver HFI command queue batching KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,495 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/device.h>
+#include <linux/dma-buf.h>
+#include <linux/fdtable.h>
+#include <linux/module.h>
+#include <linux/scatterlist.h>
+
+#include "msm_vidc_core.h"
+#include "msm_vidc_driver.h"
+#include "msm_vidc_inst.h"
+#include "msm_vidc_internal.h"
+#include "msm_vidc_memory.h"
+
+#define MSM_VIDC_TEST_MAX_BUFS  48
+#define MSM_VIDC_TEST_IOVA_BASE 0x10000000
+#define MSM_VIDC_TEST_BUF_SIZE  (1024 * 1024)
+
+/*
+ * First iommu mappings need a context bank device and a qcom heap buffer,
+ * so the tests seed mappings on a plain device through their own dma_buf
+ * exporter and drive everything after that through the driver.
+ */
+struct msm_vidc_test_ctx {
+	struct msm_vidc_inst *inst;
+	struct device *dev;
+	struct dma_buf *dmabuf[MSM_VIDC_TEST_MAX_BUFS];
+	int fd[MSM_VIDC_TEST_MAX_BUFS];
+	u32 num_bufs;
+	u32 attached;
+	u32 released;
+	u32 next_iova;
+};
+
+static struct sg_table *msm_vidc_test_map_dma_buf(
+	struct dma_buf_attachment *attach, enum dma_data_direction dir)
+{
+	struct msm_vidc_test_ctx *ctx = attach->dmabuf->priv;
+	struct sg_table *table;
+
+	table = kzalloc(sizeof(*table), GFP_KERNEL);
+	if (!table)
+		return ERR_PTR(-ENOMEM);
+
+	if (sg_alloc_table(table, 1, GFP_KERNEL)) {
+		kfree(table);
+		return ERR_PTR(-ENOMEM);
+	}
+	sg_dma_address(table->sgl) = MSM_VIDC_TEST_IOVA_BASE + ctx->next_iova;
+	ctx->next_iova += MSM_VIDC_TEST_BUF_SIZE;
+	ctx->attached++;
+
+	return table;
+}
+
+static void msm_vidc_test_unmap_dma_buf(struct dma_buf_attachment *attach,
+	struct sg_table *table, enum dma_data_direction dir)
+{
+	struct msm_vidc_test_ctx *ctx = attach->dmabuf->priv;
+
+	sg_free_table(table);
+	kfree(table);
+	ctx->attached--;
+}
+
+static void msm_vidc_test_release(struct dma_buf *dmabuf)
+{
+	struct msm_vidc_test_ctx *ctx = dmabuf->priv;
+
+	ctx->released++;
+}
+
+static const struct dma_buf_ops msm_vidc_test_dma_buf_ops = {
+	.map_dma_buf = msm_vidc_test_map_dma_buf,
+	.unmap_dma_buf = msm_vidc_test_unmap_dma_buf,
+	.release = msm_vidc_test_release,
+};
+
+/* Client side of a buffer: an fd the driver resolves like a qbuf would */
+static u32 msm_vidc_test_new_buf(struct kunit *test, size_t size)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct dma_buf *dmabuf;
+	u32 i = ctx->num_bufs;
+
+	KUNIT_ASSERT_LT(test, i, (u32)MSM_VIDC_TEST_MAX_BUFS);
+
+	exp_info.ops = &msm_vidc_test_dma_buf_ops;
+	exp_info.size = size;
+	exp_info.flags = O_RDWR;
+	exp_info.priv = ctx;
+	dmabuf = dma_buf_export(&exp_info);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(dmabuf));
+
+	ctx->fd[i] = dma_buf_fd(dmabuf, O_CLOEXEC);
+	if (ctx->fd[i] < 0)
+		dma_buf_put(dmabuf);
+	KUNIT_ASSERT_GE(test, ctx->fd[i], 0);
+	ctx->dmabuf[i] = dmabuf;
+	ctx->num_bufs++;
+
+	return i;
+}
+
+static void msm_vidc_test_close_fds(struct msm_vidc_test_ctx *ctx)
+{
+	u32 i;
+
+	for (i = 0; i < ctx->num_bufs; i++) {
+		if (ctx->fd[i] >= 0)
+			close_fd(ctx->fd[i]);
+		ctx->fd[i] = -1;
+	}
+}
+
+static struct msm_memory_dmabuf *msm_vidc_test_tracked(
+	struct msm_vidc_inst *inst, struct dma_buf *dmabuf)
+{
+	struct msm_memory_dmabuf *buf;
+
+	hash_for_each_possible(inst->dmabuf_tracker, buf, node,
+			(unsigned long)dmabuf) {
+		if (buf->dmabuf == dmabuf)
+			return buf;
+	}
+
+	return NULL;
+}
+
+/*
+ * Leaves buffer @i mapped as msm_vidc_map_driver_buf() does on its first
+ * qbuf, including the cache reference for cached buffer types.
+ */
+static struct msm_vidc_map *msm_vidc_test_seed_map(struct kunit *test,
+	u32 i, enum msm_vidc_buffer_type type, bool cached)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_mappings *mappings;
+	struct msm_vidc_map *map;
+
+	mappings = msm_vidc_get_mappings(inst, type, __func__);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, mappings);
+	map = msm_memory_pool_alloc(inst, MSM_MEM_POOL_MAP);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, map);
+
+	map->type = type;
+	map->region = MSM_VIDC_NON_SECURE;
+	map->dmabuf = msm_vidc_memory_get_dmabuf(inst, ctx->fd[i]);
+	KUNIT_ASSERT_PTR_EQ(test, map->dmabuf, ctx->dmabuf[i]);
+
+	map->attach = dma_buf_attach(map->dmabuf, ctx->dev);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(map->attach));
+	map->table = dma_buf_map_attachment(map->attach, DMA_BIDIRECTIONAL);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(map->table));
+	map->device_addr = sg_dma_address(map->table->sgl);
+	map->refcount = cached ? 2 : 1;
+	map->skip_delayed_unmap = cached;
+
+	INIT_LIST_HEAD(&map->list);
+	list_add_tail(&map->list, &mappings->list);
+	hash_add(inst->map_tracker, &map->node, (unsigned long)map->dmabuf);
+
+	return map;
+}
+
+static void msm_vidc_test_set_buf(struct msm_vidc_test_ctx *ctx, u32 i,
+	enum msm_vidc_buffer_type type, struct msm_vidc_buffer *buf)
+{
+	memset(buf, 0, sizeof(*buf));
+	buf->type = type;
+	buf->fd = ctx->fd[i];
+	buf->dmabuf = ctx->dmabuf[i];
+}
+
+static u32 msm_vidc_test_count_maps(struct msm_vidc_inst *inst,
+	enum msm_vidc_buffer_type type)
+{
+	struct msm_vidc_mappings *mappings;
+	struct msm_vidc_map *map;
+	u32 count = 0;
+
+	mappings = msm_vidc_get_mappings(inst, type, __func__);
+	list_for_each_entry(map, &mappings->list, list)
+		count++;
+
+	return count;
+}
+
+static void msm_vidc_test_tracker_get_put(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_memory_dmabuf *tracked;
+	struct dma_buf *dmabuf;
+	u32 i, a, b;
+
+	a = msm_vidc_test_new_buf(test, MSM_VIDC_TEST_BUF_SIZE);
+	b = msm_vidc_test_new_buf(test, MSM_VIDC_TEST_BUF_SIZE);
+
+	/* the same fd twice shares one tracker entry */
+	for (i = 0; i < 2; i++) {
+		dmabuf = msm_vidc_memory_get_dmabuf(inst, ctx->fd[a]);
+		KUNIT_EXPECT_PTR_EQ(test, dmabuf, ctx->dmabuf[a]);
+	}
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_memory_get_dmabuf(inst, ctx->fd[b]),
+		ctx->dmabuf[b]);
+
+	tracked = msm_vidc_test_tracked(inst, ctx->dmabuf[a]);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, tracked);
+	KUNIT_EXPECT_EQ(test, 2U, tracked->refcount);
+	tracked = msm_vidc_test_tracked(inst, ctx->dmabuf[b]);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, tracked);
+	KUNIT_EXPECT_EQ(test, 1U, tracked->refcount);
+
+	/* the tracker keeps the dma_buf alive after the client closes it */
+	msm_vidc_test_close_fds(ctx);
+	KUNIT_EXPECT_EQ(test, 0U, ctx->released);
+
+	msm_vidc_memory_put_dmabuf(inst, ctx->dmabuf[a]);
+	KUNIT_EXPECT_EQ(test, 1U,
+		msm_vidc_test_tracked(inst, ctx->dmabuf[a])->refcount);
+	KUNIT_EXPECT_EQ(test, 0U, ctx->released);
+
+	msm_vidc_memory_put_dmabuf(inst, ctx->dmabuf[a]);
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_test_tracked(inst, ctx->dmabuf[a]),
+		NULL);
+	KUNIT_EXPECT_EQ(test, 1U, ctx->released);
+
+	/* unknown dma_buf is refused without touching other entries */
+	msm_vidc_memory_put_dmabuf(inst, ctx->dmabuf[a]);
+	KUNIT_EXPECT_EQ(test, 1U,
+		msm_vidc_test_tracked(inst, ctx->dmabuf[b])->refcount);
+
+	msm_vidc_memory_put_dmabuf(inst, ctx->dmabuf[b]);
+	KUNIT_EXPECT_EQ(test, 2U, ctx->released);
+}
+
+static void msm_vidc_test_map_lookup(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_map *maps[MSM_VIDC_TEST_MAX_BUFS], *meta;
+	u32 i;
+
+	inst->domain = MSM_VIDC_DECODER;
+	for (i = 0; i < MSM_VIDC_TEST_MAX_BUFS; i++) {
+		msm_vidc_test_new_buf(test, MSM_VIDC_TEST_BUF_SIZE);
+		maps[i] = msm_vidc_test_seed_map(test, i, MSM_VIDC_BUF_OUTPUT,
+			true);
+	}
+	/* the same dma_buf mapped for another buffer type */
+	meta = msm_vidc_test_seed_map(test, 0, MSM_VIDC_BUF_INPUT_META, true);
+
+	for (i = 0; i < MSM_VIDC_TEST_MAX_BUFS; i++)
+		KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+			MSM_VIDC_BUF_OUTPUT, ctx->dmabuf[i]), maps[i]);
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+		MSM_VIDC_BUF_INPUT_META, ctx->dmabuf[0]), meta);
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+		MSM_VIDC_BUF_INPUT_META, ctx->dmabuf[1]), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+		MSM_VIDC_BUF_INPUT, ctx->dmabuf[0]), NULL);
+
+	msm_vidc_test_close_fds(ctx);
+}
+
+/* dqbuf and requeue of a cached mapping reuse the same iommu mapping */
+static void msm_vidc_test_map_cached_requeue(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_buffer buf;
+	struct msm_vidc_map *map;
+	u32 i, loop;
+
+	inst->domain = MSM_VIDC_ENCODER;
+	i = msm_vidc_test_new_buf(test, MSM_VIDC_TEST_BUF_SIZE);
+	map = msm_vidc_test_seed_map(test, i, MSM_VIDC_BUF_INPUT, true);
+	msm_vidc_test_set_buf(ctx, i, MSM_VIDC_BUF_INPUT, &buf);
+
+	for (loop = 0; loop < 4; loop++) {
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_driver_buf(inst, &buf));
+		KUNIT_EXPECT_EQ(test, 1U, map->refcount);
+		KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+			MSM_VIDC_BUF_INPUT, ctx->dmabuf[i]), map);
+
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_map_driver_buf(inst, &buf));
+		KUNIT_EXPECT_EQ(test, 2U, map->refcount);
+		KUNIT_EXPECT_EQ(test, map->device_addr, buf.device_addr);
+		KUNIT_EXPECT_EQ(test, 1U, ctx->attached);
+	}
+	KUNIT_EXPECT_EQ(test, 1U, msm_vidc_test_count_maps(inst,
+		MSM_VIDC_BUF_INPUT));
+
+	msm_vidc_test_close_fds(ctx);
+	KUNIT_EXPECT_EQ(test, 0U, ctx->released);
+}
+
+/* without the cache reference the last unmap detaches and drops the buf */
+static void msm_vidc_test_map_uncached_unmap(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_buffer buf;
+	u32 i;
+
+	inst->domain = MSM_VIDC_DECODER;
+	i = msm_vidc_test_new_buf(test, MSM_VIDC_TEST_BUF_SIZE);
+	msm_vidc_test_seed_map(test, i, MSM_VIDC_BUF_OUTPUT_META, false);
+	msm_vidc_test_set_buf(ctx, i, MSM_VIDC_BUF_OUTPUT_META, &buf);
+	msm_vidc_test_close_fds(ctx);
+
+	KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_driver_buf(inst, &buf));
+	KUNIT_EXPECT_EQ(test, 0U, ctx->attached);
+	KUNIT_EXPECT_EQ(test, 1U, ctx->released);
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+		MSM_VIDC_BUF_OUTPUT_META, buf.dmabuf), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, msm_vidc_test_tracked(inst, buf.dmabuf),
+		NULL);
+	KUNIT_EXPECT_EQ(test, 0U, msm_vidc_test_count_maps(inst,
+		MSM_VIDC_BUF_OUTPUT_META));
+}
+
+/* queued buffers are never evicted, stale ones go in mapping order */
+static void msm_vidc_test_stale_evict_count(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_map *maps[MSM_VIDC_TEST_MAX_BUFS];
+	u32 i, queued = 4, extra = 8;
+	u32 total = MAX_MAP_CACHE_COUNT + queued + extra;
+	struct msm_vidc_buffer buf;
+
+	KUNIT_ASSERT_LE(test, total, (u32)MSM_VIDC_TEST_MAX_BUFS);
+	inst->domain = MSM_VIDC_ENCODER;
+
+	for (i = 0; i < total; i++) {
+		msm_vidc_test_new_buf(test, MSM_VIDC_TEST_BUF_SIZE);
+		maps[i] = msm_vidc_test_seed_map(test, i, MSM_VIDC_BUF_INPUT,
+			true);
+		/* the first few are still with the driver/fw */
+		if (i < queued)
+			continue;
+		msm_vidc_test_set_buf(ctx, i, MSM_VIDC_BUF_INPUT, &buf);
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_driver_buf(inst, &buf));
+	}
+	msm_vidc_test_close_fds(ctx);
+
+	/* other buffer types are left alone */
+	KUNIT_EXPECT_EQ(test, 0, msm_vidc_unmap_stale_mappings(inst,
+		MSM_VIDC_BUF_OUTPUT_META));
+	KUNIT_EXPECT_EQ(test, total, ctx->attached);
+
+	KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_stale_mappings(inst,
+		MSM_VIDC_BUF_INPUT));
+	KUNIT_EXPECT_EQ(test, total - extra, ctx->attached);
+	KUNIT_EXPECT_EQ(test, extra, ctx->released);
+	KUNIT_EXPECT_EQ(test, total - extra, msm_vidc_test_count_maps(inst,
+		MSM_VIDC_BUF_INPUT));
+
+	for (i = 0; i < total; i++) {
+		if (i >= queued && i < queued + extra)
+			KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+				MSM_VIDC_BUF_INPUT, ctx->dmabuf[i]), NULL);
+		else
+			KUNIT_EXPECT_PTR_EQ(test, msm_vidc_find_map(inst,
+				MSM_VIDC_BUF_INPUT, ctx->dmabuf[i]), maps[i]);
+	}
+
+	/* a second pass has nothing more to do */
+	KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_stale_mappings(inst,
+		MSM_VIDC_BUF_INPUT));
+	KUNIT_EXPECT_EQ(test, total - extra, ctx->attached);
+}
+
+/* few but large stale buffers are bounded by the pinned size */
+static void msm_vidc_test_stale_evict_size(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_buffer buf;
+	size_t size = 16 * 1024 * 1024;
+	u32 i, total = 20, keep = MAX_MAP_CACHE_SIZE / size;
+
+	inst->domain = MSM_VIDC_ENCODER;
+	for (i = 0; i < total; i++) {
+		msm_vidc_test_new_buf(test, size);
+		msm_vidc_test_seed_map(test, i, MSM_VIDC_BUF_INPUT, true);
+		msm_vidc_test_set_buf(ctx, i, MSM_VIDC_BUF_INPUT, &buf);
+		KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_driver_buf(inst, &buf));
+	}
+	msm_vidc_test_close_fds(ctx);
+
+	KUNIT_ASSERT_LT(test, total, (u32)MAX_MAP_CACHE_COUNT);
+	KUNIT_ASSERT_EQ(test, 0, msm_vidc_unmap_stale_mappings(inst,
+		MSM_VIDC_BUF_INPUT));
+	KUNIT_EXPECT_EQ(test, keep, ctx->attached);
+	KUNIT_EXPECT_EQ(test, total - keep, ctx->released);
+	for (i = 0; i < total; i++)
+		KUNIT_EXPECT_EQ(test, i >= total - keep,
+			msm_vidc_find_map(inst, MSM_VIDC_BUF_INPUT,
+			ctx->dmabuf[i]) != NULL);
+}
+
+static int msm_vidc_memory_test_init(struct kunit *test)
+{
+	struct msm_vidc_test_ctx *ctx;
+	struct msm_vidc_inst *inst;
+	u32 i;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+	inst = kunit_kzalloc(test, sizeof(*inst), GFP_KERNEL);
+	if (!inst)
+		return -ENOMEM;
+	inst->core = kunit_kzalloc(test, sizeof(*inst->core), GFP_KERNEL);
+	if (!inst->core)
+		return -ENOMEM;
+
+	strscpy(inst->debug_str, "vidc_test: ", sizeof(inst->debug_str));
+	if (msm_memory_pools_init(inst))
+		return -EINVAL;
+	hash_init(inst->dmabuf_tracker);
+	hash_init(inst->map_tracker);
+	INIT_LIST_HEAD(&inst->mappings.input.list);
+	INIT_LIST_HEAD(&inst->mappings.output.list);
+	INIT_LIST_HEAD(&inst->mappings.input_meta.list);
+	INIT_LIST_HEAD(&inst->mappings.output_meta.list);
+
+	ctx->dev = root_device_register("msm_vidc_test");
+	if (IS_ERR(ctx->dev)) {
+		msm_memory_pools_deinit(inst);
+		return PTR_ERR(ctx->dev);
+	}
+	for (i = 0; i < MSM_VIDC_TEST_MAX_BUFS; i++)
+		ctx->fd[i] = -1;
+	ctx->inst = inst;
+	test->priv = ctx;
+
+	return 0;
+}
+
+static void msm_vidc_memory_test_exit(struct kunit *test)
+{
+	static const enum msm_vidc_buffer_type types[] = {
+		MSM_VIDC_BUF_INPUT, MSM_VIDC_BUF_OUTPUT,
+		MSM_VIDC_BUF_INPUT_META, MSM_VIDC_BUF_OUTPUT_META,
+	};
+	struct msm_vidc_test_ctx *ctx = test->priv;
+	struct msm_vidc_inst *inst = ctx->inst;
+	struct msm_vidc_mappings *mappings;
+	struct msm_vidc_map *map, *dummy;
+	struct msm_memory_dmabuf *dbuf;
+	struct hlist_node *dummy_node;
+	u32 i;
+
+	/* same teardown as session close */
+	for (i = 0; i < ARRAY_SIZE(types); i++) {
+		mappings = msm_vidc_get_mappings(inst, types[i], __func__);
+		list_for_each_entry_safe(map, dummy, &mappings->list, list)
+			msm_vidc_memory_unmap_completely(inst, map);
+	}
+	hash_for_each_safe(inst->dmabuf_tracker, i, dummy_node, dbuf, node)
+		msm_vidc_memory_put_dmabuf_completely(inst, dbuf);
+
+	msm_vidc_test_close_fds(ctx);
+	msm_memory_pools_deinit(inst);
+	root_device_unregister(ctx->dev);
+}
+
+static struct kunit_case msm_vidc_memory_test_cases[] = {
+	KUNIT_CASE(msm_vidc_test_tracker_get_put),
+	KUNIT_CASE(msm_vidc_test_map_lookup),
+	KUNIT_CASE(msm_vidc_test_map_cached_requeue),
+	KUNIT_CASE(msm_vidc_test_map_uncached_unmap),
+	KUNIT_CASE(msm_vidc_test_stale_evict_count),
+	KUNIT_CASE(msm_vidc_test_stale_evict_size),
+	{}
+};
+
+static struct kunit_suite msm_vidc_memory_test_suite = {
+	.name = "msm_vidc_memory",
+	.init = msm_vidc_memory_test_init,
+	.exit = msm_vidc_memory_test_exit,
+	.test_cases = msm_vidc_memory_test_cases,
+};
+
+kunit_test_suite(msm_vidc_memory_test_suite);
+
+MODULE_DESCRIPTION("Video driver buffer tracking and mapping KUnit tests");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,441 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+#include "msm_vidc_internal.h"
+#include "msm_vidc_power_iris3.h"
+
+#define MSM_VIDC_TEST_MAX_CLKS     5
+#define MSM_VIDC_TEST_BENCH_LOOPS  20
+/* UBWC statistics a session votes with before firmware reports any */
+#define MSM_VIDC_TEST_CR           (1 << 16)
+#define MSM_VIDC_TEST_CF           (4 << 16)
+
+/*
+ * Clock model inputs of each platform: cycle counts from its capability
+ * table, clock plan from its device tree (crow's from clock_data_crow),
+ * highest rate first like allowed_clks_tbl.
+ */
+struct msm_vidc_test_platform {
+	const char *name;
+	u64 clks[MSM_VIDC_TEST_MAX_CLKS];
+	u32 num_clks;
+	u32 pipes;
+	u32 mb_cycles_vsp;
+	u32 mb_cycles_vsp_vp9;
+	u32 mb_cycles_vpp_enc;
+	u32 mb_cycles_vpp_dec;
+	u32 mb_cycles_fw;
+	u32 mb_cycles_fw_vpp_enc;
+	u32 mb_cycles_fw_vpp_dec;
+	bool av1;
+};
+
+static const struct msm_vidc_test_platform msm_vidc_test_platforms[] = {
+	{
+		.name = "kalama",
+		.clks = {533333333, 444000000, 366000000, 338000000, 240000000},
+		.num_clks = 5,
+		.pipes = 4,
+		.mb_cycles_vsp = 25,
+		.mb_cycles_vsp_vp9 = 60,
+		.mb_cycles_vpp_enc = 675,
+		.mb_cycles_vpp_dec = 200,
+		.mb_cycles_fw = 489583,
+		.mb_cycles_fw_vpp_enc = 48405,
+		.mb_cycles_fw_vpp_dec = 66234,
+		.av1 = true,
+	},
+	{
+		.name = "waipio",
+		.clks = {444000000, 366000000, 338000000, 240000000},
+		.num_clks = 4,
+		.pipes = 4,
+		.mb_cycles_vsp = 25,
+		.mb_cycles_vsp_vp9 = 60,
+		.mb_cycles_vpp_enc = 675,
+		.mb_cycles_vpp_dec = 200,
+		.mb_cycles_fw = 326389,
+		.mb_cycles_fw_vpp_enc = 44156,
+		.mb_cycles_fw_vpp_dec = 44156,
+	},
+	{
+		.name = "crow",
+		.clks = {384000000, 366000000, 270000000, 165000000},
+		.num_clks = 4,
+		.pipes = 1,
+		.mb_cycles_vsp = 25,
+		.mb_cycles_vsp_vp9 = 60,
+		.mb_cycles_vpp_enc = 675,
+		.mb_cycles_vpp_dec = 200,
+		.mb_cycles_fw = 436000,
+		.mb_cycles_fw_vpp_enc = 166667,
+		.mb_cycles_fw_vpp_dec = 166667,
+	},
+	{
+		.name = "anorak",
+		.clks = {533333333, 444000000, 366000000, 338000000, 240000000},
+		.num_clks = 5,
+		.pipes = 4,
+		.mb_cycles_vsp = 25,
+		.mb_cycles_vsp_vp9 = 60,
+		.mb_cycles_vpp_enc = 675,
+		.mb_cycles_vpp_dec = 200,
+		.mb_cycles_fw = 489583,
+		.mb_cycles_fw_vpp_enc = 48405,
+		.mb_cycles_fw_vpp_dec = 66234,
+		.av1 = true,
+	},
+};
+
+struct msm_vidc_test_session {
+	enum msm_vidc_domain_type domain;
+	enum msm_vidc_codec_type codec;
+	const char *name;
+};
+
+static const struct msm_vidc_test_session msm_vidc_test_sessions[] = {
+	{MSM_VIDC_DECODER, MSM_VIDC_H264, "dec h264"},
+	{MSM_VIDC_DECODER, MSM_VIDC_HEVC, "dec hevc"},
+	{MSM_VIDC_DECODER, MSM_VIDC_VP9,  "dec vp9 "},
+	{MSM_VIDC_DECODER, MSM_VIDC_AV1,  "dec av1 "},
+	{MSM_VIDC_ENCODER, MSM_VIDC_H264, "enc h264"},
+	{MSM_VIDC_ENCODER, MSM_VIDC_HEVC, "enc hevc"},
+};
+
+static const struct {
+	u32 width;
+	u32 height;
+} msm_vidc_test_res[] = {
+	{1280, 720}, {1920, 1080}, {3840, 2160}, {7680, 4320},
+};
+
+static const u32 msm_vidc_test_fps[] = {30, 60, 120};
+static const u32 msm_vidc_test_depth[] = {8, 10};
+static const u32 msm_vidc_test_sessions_n[] = {1, 2, 4};
+
+/* about 0.25 bits per pixel, a typical camera or streaming bitrate */
+static u32 msm_vidc_test_frame_bytes(u32 width, u32 height)
+{
+	return width * height / 32;
+}
+
+static void msm_vidc_test_fill_freq(const struct msm_vidc_test_platform *plat,
+	const struct msm_vidc_test_session *s, u32 width, u32 height, u32 fps,
+	u32 depth, struct msm_vidc_freq_params *p)
+{
+	bool enc = s->domain == MSM_VIDC_ENCODER;
+
+	memset(p, 0, sizeof(*p));
+	p->max_freq = plat->clks[0];
+	p->nom_freq = plat->num_clks >= 2 ? plat->clks[1] : 0;
+	p->domain = s->domain;
+	p->codec = s->codec;
+	p->width = width;
+	p->height = height;
+	p->mbpf = DIV_ROUND_UP(width, 16) * DIV_ROUND_UP(height, 16);
+	p->fps = fps;
+	p->data_size = msm_vidc_test_frame_bytes(width, height);
+	p->mb_cycles_fw = plat->mb_cycles_fw;
+	p->mb_cycles_fw_vpp = enc ? plat->mb_cycles_fw_vpp_enc :
+		plat->mb_cycles_fw_vpp_dec;
+	p->mb_cycles_vpp = enc ? plat->mb_cycles_vpp_enc :
+		plat->mb_cycles_vpp_dec;
+	p->mb_cycles_vsp = !enc && (s->codec == MSM_VIDC_VP9 ||
+		s->codec == MSM_VIDC_AV1) ? plat->mb_cycles_vsp_vp9 :
+		plat->mb_cycles_vsp;
+	p->pipe = plat->pipes;
+	p->stage = MSM_VIDC_STAGE_2;
+	p->bit_rate = p->data_size * 8 * fps;
+	p->frame_rate = fps;
+	p->operating_rate = fps;
+	p->entropy_mode = V4L2_MPEG_VIDEO_H264_ENTROPY_MODE_CABAC;
+	p->hevc_10bit = !enc && s->codec == MSM_VIDC_HEVC && depth == 10;
+	p->realtime = 1;
+}
+
+static void msm_vidc_test_fill_bw(const struct msm_vidc_test_platform *plat,
+	const struct msm_vidc_test_session *s, u32 width, u32 height, u32 fps,
+	u32 depth, struct vidc_bus_vote_data *d)
+{
+	memset(d, 0, sizeof(*d));
+	d->domain = s->domain;
+	d->codec = s->codec;
+	d->power_mode = VIDC_POWER_NORMAL;
+	d->color_formats[0] = depth == 10 ? MSM_VIDC_FMT_TP10C :
+		MSM_VIDC_FMT_NV12C;
+	d->num_formats = 1;
+	d->input_width = d->output_width = width;
+	d->input_height = d->output_height = height;
+	d->bitrate = msm_vidc_test_frame_bytes(width, height) * 8 * fps;
+	d->compression_ratio = MSM_VIDC_TEST_CR;
+	d->complexity_factor = MSM_VIDC_TEST_CF;
+	d->input_cr = MSM_VIDC_TEST_CR;
+	d->lcu_size = s->codec == MSM_VIDC_H264 ? 16 :
+		s->codec == MSM_VIDC_AV1 ? 64 : 32;
+	d->fps = fps;
+	d->work_mode = MSM_VIDC_STAGE_2;
+	d->use_sys_cache = true;
+	d->num_vpp_pipes = plat->pipes;
+}
+
+/* Lowest rate of the plan that covers freq, like msm_vidc_set_clocks() */
+static u64 msm_vidc_test_pick_clk(const struct msm_vidc_test_platform *plat,
+	u64 freq)
+{
+	int i;
+
+	for (i = plat->num_clks - 1; i >= 0; i--)
+		if (plat->clks[i] >= freq)
+			return plat->clks[i];
+
+	return plat->clks[0];
+}
+
+static bool msm_vidc_test_row_valid(const struct msm_vidc_test_platform *plat,
+	const struct msm_vidc_test_session *s, u32 width, u32 height, u32 fps,
+	u32 depth)
+{
+	if (s->codec == MSM_VIDC_AV1 && !plat->av1)
+		return false;
+	if (depth == 10 && s->codec == MSM_VIDC_H264)
+		return false;
+	/* nothing past 4K at 120 or 8K at 30 is admitted by these platforms */
+	return (u64)width * height * fps <= 3840ULL * 2160 * 120;
+}
+
+/* 1080p h264 cabac realtime decode on a kalama like clock table */
+static void msm_vidc_test_freq_params_dec(struct msm_vidc_freq_params *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->max_freq = 533000000;
+	p->nom_freq = 444000000;
+	p->domain = MSM_VIDC_DECODER;
+	p->codec = MSM_VIDC_H264;
+	p->width = 1920;
+	p->height = 1080;
+	p->mbpf = 8160;
+	p->fps = 30;
+	p->data_size = 100000;
+	p->mb_cycles_fw = 489583;
+	p->mb_cycles_fw_vpp = 66234;
+	p->mb_cycles_vpp = 200;
+	p->mb_cycles_vsp = 25;
+	p->pipe = 4;
+	p->stage = MSM_VIDC_STAGE_2;
+	p->entropy_mode = V4L2_MPEG_VIDEO_H264_ENTROPY_MODE_CABAC;
+	p->realtime = 1;
+}
+
+static void msm_vidc_test_freq_decoder(struct kunit *test)
+{
+	struct msm_vidc_freq_params p;
+
+	msm_vidc_test_freq_params_dec(&p);
+	/* vsp bound: 24Mbps * 1.35 * 1.05 + 244800 mbs/s * 25 */
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_freq_params_iris3(&p), 40140000ULL);
+	/* same inputs, same answer */
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_freq_params_iris3(&p), 40140000ULL);
+}
+
+static void msm_vidc_test_freq_nom_limit(struct kunit *test)
+{
+	struct msm_vidc_freq_params p;
+
+	msm_vidc_test_freq_params_dec(&p);
+	p.data_size = 2000000;
+	/* realtime sessions are limited to NOM */
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_freq_params_iris3(&p), p.nom_freq);
+
+	/* non realtime sessions may go past it */
+	p.realtime = 0;
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_freq_params_iris3(&p), 686520000ULL);
+}
+
+static void msm_vidc_test_freq_invalid(struct kunit *test)
+{
+	struct msm_vidc_freq_params p;
+
+	msm_vidc_test_freq_params_dec(&p);
+	p.pipe = 0;
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_freq_params_iris3(&p), 0ULL);
+
+	p.pipe = 4;
+	p.domain = 0;
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_freq_params_iris3(&p), p.max_freq);
+}
+
+static void msm_vidc_test_bw_decoder(struct kunit *test)
+{
+	const struct msm_vidc_test_platform *plat = &msm_vidc_test_platforms[0];
+	const struct msm_vidc_test_session *s = &msm_vidc_test_sessions[1];
+	struct vidc_bus_vote_data d8, d10, again;
+
+	msm_vidc_test_fill_bw(plat, s, 1920, 1080, 30, 8, &d8);
+	msm_vidc_calc_bw_params_iris3(&d8);
+	KUNIT_EXPECT_GT(test, d8.calc_bw_ddr, 0ULL);
+
+	/* the model only reads the vote data */
+	msm_vidc_test_fill_bw(plat, s, 1920, 1080, 30, 8, &again);
+	msm_vidc_calc_bw_params_iris3(&again);
+	KUNIT_EXPECT_EQ(test, 0, memcmp(&d8, &again, sizeof(d8)));
+
+	/* 10 bit reference frames take more DDR bandwidth */
+	msm_vidc_test_fill_bw(plat, s, 1920, 1080, 30, 10, &d10);
+	msm_vidc_calc_bw_params_iris3(&d10);
+	KUNIT_EXPECT_GT(test, d10.calc_bw_ddr, d8.calc_bw_ddr);
+
+	d8.domain = 0;
+	d8.calc_bw_ddr = 0;
+	KUNIT_EXPECT_EQ(test, msm_vidc_calc_bw_params_iris3(&d8), 0ULL);
+	KUNIT_EXPECT_EQ(test, d8.calc_bw_ddr, 0ULL);
+}
+
+/* One sweep row per fps and concurrency for a session shape */
+static u32 msm_vidc_test_sweep_fps(struct kunit *test,
+	const struct msm_vidc_test_platform *plat,
+	const struct msm_vidc_test_session *s, u32 w, u32 h, u32 depth)
+{
+	struct msm_vidc_freq_params p;
+	struct vidc_bus_vote_data d;
+	u64 freq, prev_freq = 0, total;
+	u32 f, n, fps, count, rows = 0;
+
+	for (f = 0; f < ARRAY_SIZE(msm_vidc_test_fps); f++) {
+		fps = msm_vidc_test_fps[f];
+		if (!msm_vidc_test_row_valid(plat, s, w, h, fps, depth))
+			continue;
+
+		msm_vidc_test_fill_freq(plat, s, w, h, fps, depth, &p);
+		freq = msm_vidc_calc_freq_params_iris3(&p);
+		msm_vidc_test_fill_bw(plat, s, w, h, fps, depth, &d);
+		msm_vidc_calc_bw_params_iris3(&d);
+
+		KUNIT_EXPECT_GT(test, freq, 0ULL);
+		KUNIT_EXPECT_GT(test, d.calc_bw_ddr, 0ULL);
+		/* more frames never need a lower clock */
+		KUNIT_EXPECT_GE(test, freq, prev_freq);
+		/* realtime sessions other than AV1 stay at NOM */
+		if (s->codec != MSM_VIDC_AV1)
+			KUNIT_EXPECT_LE(test, freq, p.nom_freq);
+		prev_freq = freq;
+
+		for (n = 0; n < ARRAY_SIZE(msm_vidc_test_sessions_n); n++) {
+			count = msm_vidc_test_sessions_n[n];
+			total = freq * count;
+			kunit_info(test,
+				"%-6s %s %4ux%-4u %3ufps %2ubit x%u: freq %llu clk %llu%s ddr %llu llcc %llu kbps\n",
+				plat->name, s->name, w, h, fps, depth, count,
+				freq, msm_vidc_test_pick_clk(plat, total),
+				total > plat->clks[0] ? " (over)" : "",
+				d.calc_bw_ddr * count, d.calc_bw_llcc * count);
+			rows++;
+		}
+	}
+
+	return rows;
+}
+
+/*
+ * Sweep of codec, resolution, fps, bit depth and concurrency over each
+ * platform. Every row logs the per session frequency, the clock rate the
+ * core would pick for all sessions together and the summed DDR/LLCC
+ * votes, so a model change shows up as a diff of the test log.
+ */
+static void msm_vidc_test_platform_sweep(struct kunit *test)
+{
+	const struct msm_vidc_test_platform *plat;
+	const struct msm_vidc_test_session *s;
+	u32 pl, si, r, b, rows = 0;
+
+	for (pl = 0; pl < ARRAY_SIZE(msm_vidc_test_platforms); pl++) {
+		plat = &msm_vidc_test_platforms[pl];
+		for (si = 0; si < ARRAY_SIZE(msm_vidc_test_sessions); si++) {
+			s = &msm_vidc_test_sessions[si];
+			for (r = 0; r < ARRAY_SIZE(msm_vidc_test_res); r++) {
+				for (b = 0; b < ARRAY_SIZE(msm_vidc_test_depth); b++)
+					rows += msm_vidc_test_sweep_fps(test,
+						plat, s,
+						msm_vidc_test_res[r].width,
+						msm_vidc_test_res[r].height,
+						msm_vidc_test_depth[b]);
+			}
+		}
+	}
+	KUNIT_EXPECT_GT(test, rows, 0U);
+	kunit_info(test, "%u sweep rows\n", rows);
+}
+
+/*
+ * Time per model run over the sweep, next to the cost of the memo check
+ * msm_vidc_scale_power() does instead when the session inputs are
+ * unchanged.
+ */
+static void msm_vidc_test_power_bench(struct kunit *test)
+{
+	const struct msm_vidc_test_platform *plat = &msm_vidc_test_platforms[0];
+	const struct msm_vidc_test_session *s;
+	struct msm_vidc_freq_params p, memo_p;
+	struct vidc_bus_vote_data d, memo_d;
+	u64 start, freq_ns = 0, bw_ns = 0, memo_ns = 0;
+	u32 si, r, loop, calls = 0, misses = 0;
+
+	for (loop = 0; loop < MSM_VIDC_TEST_BENCH_LOOPS; loop++) {
+		for (si = 0; si < ARRAY_SIZE(msm_vidc_test_sessions); si++) {
+			s = &msm_vidc_test_sessions[si];
+			for (r = 0; r < ARRAY_SIZE(msm_vidc_test_res); r++) {
+				msm_vidc_test_fill_freq(plat, s,
+					msm_vidc_test_res[r].width,
+					msm_vidc_test_res[r].height, 30, 8, &p);
+				msm_vidc_test_fill_bw(plat, s,
+					msm_vidc_test_res[r].width,
+					msm_vidc_test_res[r].height, 30, 8, &d);
+				memcpy(&memo_p, &p, sizeof(p));
+
+				start = ktime_get_ns();
+				msm_vidc_calc_freq_params_iris3(&p);
+				freq_ns += ktime_get_ns() - start;
+
+				start = ktime_get_ns();
+				msm_vidc_calc_bw_params_iris3(&d);
+				bw_ns += ktime_get_ns() - start;
+				memcpy(&memo_d, &d, sizeof(d));
+
+				start = ktime_get_ns();
+				if (memcmp(&p, &memo_p, sizeof(p)) ||
+					memcmp(&d, &memo_d, sizeof(d)))
+					misses++;
+				memo_ns += ktime_get_ns() - start;
+				calls++;
+			}
+		}
+	}
+
+	KUNIT_EXPECT_EQ(test, 0U, misses);
+	kunit_info(test, "per call: freq model %llu ns, bw model %llu ns, memo hit %llu ns\n",
+		div_u64(freq_ns, calls), div_u64(bw_ns, calls),
+		div_u64(memo_ns, calls));
+}
+
+static struct kunit_case msm_vidc_power_test_cases[] = {
+	KUNIT_CASE(msm_vidc_test_freq_decoder),
+	KUNIT_CASE(msm_vidc_test_freq_nom_limit),
+	KUNIT_CASE(msm_vidc_test_freq_invalid),
+	KUNIT_CASE(msm_vidc_test_bw_decoder),
+	KUNIT_CASE(msm_vidc_test_platform_sweep),
+	KUNIT_CASE(msm_vidc_test_power_bench),
+	{}
+};
+
+static struct kunit_suite msm_vidc_power_test_suite = {
+	.name = "msm_vidc_power_iris3",
+	.test_cases = msm_vidc_power_test_cases,
+};
+
+kunit_test_suite(msm_vidc_power_test_suite);
+
+MODULE_DESCRIPTION("Video driver iris3 clock and bandwidth model KUnit tests");
+MODULE_LICENSE("GPL v2");